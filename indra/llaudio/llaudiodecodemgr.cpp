@@ -28,7 +28,7 @@
 #include "llaudiodecodemgr.h"
 
 #include "llaudioengine.h"
-#include "lllfsthread.h"
+#include "llfileioservice.h"
 #include "llfilesystem.h"
 #include "lldir.h"
 #include "llendianswizzle.h"
@@ -53,18 +53,6 @@ static const S32 WAV_HEADER_SIZE = 44;
 class LLVorbisDecodeState : public LLThreadSafeRefCount
 {
 public:
-	class WriteResponder : public LLLFSThread::Responder
-	{
-	public:
-		WriteResponder(LLVorbisDecodeState* decoder) : mDecoder(decoder) {}
-		~WriteResponder() {}
-		void completed(S32 bytes)
-		{
-			mDecoder->ioComplete(bytes);
-		}
-		LLPointer<LLVorbisDecodeState> mDecoder;
-	};
-	
 	LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename);
 
 	bool initDecode();
@@ -88,7 +76,7 @@ protected:
 
 	std::vector<U8> mWAVBuffer;
 	std::string mOutFilename;
-	LLLFSThread::handle_t mFileHandle;
+	bool mWriting;
 	
 	LLFileSystem *mInFilep;
 	OggVorbis_File mVF;
@@ -168,7 +156,7 @@ LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &
 	mInFilep = nullptr;
 	mCurrentSection = 0;
 	mOutFilename = out_filename;
-	mFileHandle = LLLFSThread::nullHandle();
+	mWriting = false;
 
     // No default value for mVF, it's an ogg structure?
 	// Hey, let's zero it anyway, for predictability.
@@ -414,7 +402,7 @@ bool LLVorbisDecodeState::finishDecode()
 		return true; // We've finished
 	}
 
-	if (mFileHandle == LLLFSThread::nullHandle())
+	if (!mWriting)
 	{
 		ov_clear(&mVF);
   
@@ -488,11 +476,14 @@ bool LLVorbisDecodeState::finishDecode()
 			return true; // we've finished
 		}
 		mBytesRead = -1;
-		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
-							 new WriteResponder(this));
+		mWriting = true;
+		// hold a reference so mWAVBuffer outlives the write
+		LLPointer<LLVorbisDecodeState> self(this);
+		LLFileIOService::instance().write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
+										  [self](S32 bytes) { self->ioComplete(bytes); });
 	}
 
-	if (mFileHandle != LLLFSThread::nullHandle())
+	if (mWriting)
 	{
 		if (mBytesRead >= 0)
 		{
@@ -572,7 +563,7 @@ void LLAudioDecodeMgr::Impl::startMoreDecodes()
     LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
     // *NOTE: main_queue->postTo casts this refcounted smart pointer to a weak
     // pointer
-    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
     const LL::ThreadPool::ptr_t general_thread_pool = LL::ThreadPool::getInstance("General");
     llassert_always(main_queue);
     llassert_always(general_queue);
@@ -581,7 +572,7 @@ void LLAudioDecodeMgr::Impl::startMoreDecodes()
     // This ensures the general work queue is full, but prevents theoretical
     // buildup of buffers in memory due to disk writes once the
     // LLVorbisDecodeState leaves the worker thread (see
-    // LLLFSThread::sLocal->write). This is probably as fast as we can get it
+    // LLFileIOService::write). This is probably as fast as we can get it
     // without modifying/removing LLVorbisDecodeState, at which point we should
     // consider decoding the audio during the asset download process.
     // -Cosmic,2022-05-11
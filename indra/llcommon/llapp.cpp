@@ -381,6 +381,9 @@ void LLApp::setErrorHandler(LLAppErrorHandler handler)
 // static
 void LLApp::runErrorHandler()
 {
+	// Get queued log messages out while we still can
+	LLError::flushAsyncLogging();
+
 	if (LLApp::sErrorHandler)
 	{
 		LLApp::sErrorHandler();
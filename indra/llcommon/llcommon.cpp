@@ -27,6 +27,7 @@
 
 #include "llcommon.h"
 
+#include "llheaptracker.h"
 #include "llmemory.h"
 #include "llthread.h"
 #include "lltrace.h"
@@ -89,6 +90,62 @@ void tracy_aligned_free(void *memblock)
     ll_aligned_free_fallback(memblock);
 }
 
+#elif LL_HEAP_TRACKER
+// Feed every new/delete to LLHeapTracker. It does nothing with them unless a
+// sample interval has been set.
+
+static void* tracked_new(size_t size)
+{
+    void* ptr = (malloc)(size ? size : 1);
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    LLHeapTracker::onAlloc(ptr, size);
+    return ptr;
+}
+
+static void* tracked_new(size_t size, const std::nothrow_t&) noexcept
+{
+    void* ptr = (malloc)(size ? size : 1);
+    LLHeapTracker::onAlloc(ptr, size);
+    return ptr;
+}
+
+static void tracked_delete(void* ptr) noexcept
+{
+    LLHeapTracker::onFree(ptr);
+    (free)(ptr);
+}
+
+void* operator new(size_t size)                                     { return tracked_new(size); }
+void* operator new[](size_t size)                                   { return tracked_new(size); }
+void* operator new(size_t size, const std::nothrow_t& nt) noexcept   { return tracked_new(size, nt); }
+void* operator new[](size_t size, const std::nothrow_t& nt) noexcept { return tracked_new(size, nt); }
+void operator delete(void* ptr) noexcept                            { tracked_delete(ptr); }
+void operator delete[](void* ptr) noexcept                          { tracked_delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept                    { tracked_delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept                  { tracked_delete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept     { tracked_delete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept   { tracked_delete(ptr); }
+
+// over-aligned types go through the ll_aligned_malloc fallback, which
+// reports to the tracker itself
+void* operator new(size_t size, std::align_val_t align)
+{
+    void* ptr = ll_aligned_malloc_fallback(size ? size : 1, int(align));
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void* operator new[](size_t size, std::align_val_t align)          { return operator new(size, align); }
+void operator delete(void* ptr, std::align_val_t) noexcept          { ll_aligned_free_fallback(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept        { ll_aligned_free_fallback(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept  { ll_aligned_free_fallback(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { ll_aligned_free_fallback(ptr); }
+
 #endif
 
 //static
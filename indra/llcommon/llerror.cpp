@@ -31,7 +31,14 @@
 #include "llerrorcontrol.h"
 #include "llsdutil.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #ifdef __GNUC__
 # include <cxxabi.h>
 #endif // __GNUC__
@@ -487,6 +494,8 @@ namespace
 
         bool 								mLogAlwaysFlush;
 
+        bool                                mAsyncLogging;
+
         U32 								mEnabledLogTypesMask;
 
         LevelMap                            mFunctionLevelMap;
@@ -509,10 +518,16 @@ namespace
 
     typedef LLPointer<SettingsConfig> SettingsConfigPtr;
 
+    // Defined with AsyncLogWriter below.  Settings are only swapped
+    // while the writer is stopped.
+    void startAsyncLogging();
+    void stopAsyncLogging();
+
     SettingsConfig::SettingsConfig()
         : LLRefCount(),
         mDefaultLevel(LLError::LEVEL_DEBUG),
         mLogAlwaysFlush(true),
+        mAsyncLogging(false),
         mEnabledLogTypesMask(255),
         mFunctionLevelMap(),
         mClassLevelMap(),
@@ -545,6 +560,9 @@ namespace
 		void invalidateCallSites();
 
         SettingsConfigPtr getSettingsConfig();
+        // For threads that log without holding LOG_MUTEX: copying an
+        // LLPointer changes a non-atomic reference count.
+        SettingsConfig* peekSettingsConfig() { return mSettingsConfig.get(); }
 
         void resetSettingsConfig();
         LLError::SettingsStoragePtr saveAndResetSettingsConfig();
@@ -594,6 +612,7 @@ namespace
 
     void Globals::resetSettingsConfig()
     {
+        stopAsyncLogging();
         invalidateCallSites();
         mSettingsConfig = new SettingsConfig();
     }
@@ -607,9 +626,14 @@ namespace
 
     void Globals::restore(LLError::SettingsStoragePtr pSettingsStorage)
     {
+        stopAsyncLogging();
         invalidateCallSites();
         SettingsConfigPtr newSettingsConfig(dynamic_cast<SettingsConfig *>(pSettingsStorage.get()));
         mSettingsConfig = newSettingsConfig;
+        if (mSettingsConfig->mAsyncLogging)
+        {
+            startAsyncLogging();
+        }
     }
 }
 
@@ -813,8 +837,8 @@ namespace LLError
 
 	bool getAlwaysFlush()
 	{
-		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
-		return s->mLogAlwaysFlush;
+		// Recorders ask from the async writer thread, don't touch the refcount
+		return Globals::getInstance()->peekSettingsConfig()->mLogAlwaysFlush;
 	}
 
 	void setEnabledLogTypesMask(U32 mask)
@@ -825,8 +849,7 @@ namespace LLError
 
 	U32 getEnabledLogTypesMask()
 	{
-		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
-		return s->mEnabledLogTypesMask;
+		return Globals::getInstance()->peekSettingsConfig()->mEnabledLogTypesMask;
 	}
 
 	void setFunctionLevel(const std::string& function_name, ELevel level)
@@ -1201,10 +1224,14 @@ namespace
         return out.str();
     }
 
-	void writeToRecorders(const LLError::CallSite& site, const std::string& message)
+	// time, if not empty, was captured when the message was logged
+	// and is used instead of calling the time function now.
+	void writeToRecorders(const LLError::CallSite& site, const std::string& message,
+						  const std::string& time = std::string())
 	{
 		LLError::ELevel level = site.mLevel;
-		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+		// May be the async writer, which doesn't hold LOG_MUTEX
+		SettingsConfig* s = Globals::getInstance()->peekSettingsConfig();
 
         std::string escaped_message;
 
@@ -1220,7 +1247,7 @@ namespace
 
 			if (r->wantsTime() && s->mTimeFunction != NULL)
 			{
-				message_stream << s->mTimeFunction();
+				message_stream << (time.empty() ? s->mTimeFunction() : time);
 			}
             message_stream << " ";
             
@@ -1327,6 +1354,346 @@ namespace {
 	}
 }
 
+namespace
+{
+	// Messages waiting to be written for one logging thread.  A
+	// single-producer, single-consumer ring: the owning thread pushes
+	// without locking and whoever holds AsyncLogWriter's drain mutex
+	// pops.  Bounded both in records and in bytes of text.
+	class AsyncLogRing
+	{
+	public:
+		struct Record
+		{
+			const LLError::CallSite*	mSite;
+			U64							mSequence;
+			std::string					mTime;
+			std::string					mMessage;
+		};
+
+		static const size_t CAPACITY = 1024;			// power of two
+		static const size_t MAX_BYTES = 1024 * 1024;
+
+		AsyncLogRing()
+			: mOrphaned(false),
+			  mRecords(CAPACITY),
+			  mHead(0),
+			  mTail(0),
+			  mBytes(0)
+		{
+		}
+
+		// Producer.  Returns false, leaving rec alone, if full.
+		bool push(Record& rec)
+		{
+			const size_t tail = mTail.load(std::memory_order_relaxed);
+			const size_t bytes = rec.mTime.size() + rec.mMessage.size();
+			if (tail - mHead.load(std::memory_order_acquire) >= CAPACITY
+				|| mBytes.load(std::memory_order_relaxed) + bytes > MAX_BYTES)
+			{
+				return false;
+			}
+			mRecords[tail & (CAPACITY - 1)] = std::move(rec);
+			mBytes.fetch_add(bytes, std::memory_order_relaxed);
+			mTail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer.  Returns false if empty.
+		bool pop(Record& rec)
+		{
+			const size_t head = mHead.load(std::memory_order_relaxed);
+			if (head == mTail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			Record& slot = mRecords[head & (CAPACITY - 1)];
+			const size_t bytes = slot.mTime.size() + slot.mMessage.size();
+			rec = std::move(slot);
+			slot.mTime.clear();
+			slot.mMessage.clear();
+			mBytes.fetch_sub(bytes, std::memory_order_relaxed);
+			mHead.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t size() const
+		{
+			return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+		}
+
+		bool nearlyFull() const
+		{
+			return size() >= CAPACITY / 2
+				|| mBytes.load(std::memory_order_relaxed) >= MAX_BYTES / 2;
+		}
+
+		// Set when the owning thread exits, the writer frees the ring
+		// once it's empty.
+		std::atomic<bool> mOrphaned;
+
+	private:
+		std::vector<Record> mRecords;
+		std::atomic<size_t> mHead;
+		std::atomic<size_t> mTail;
+		std::atomic<size_t> mBytes;
+	};
+
+	typedef std::shared_ptr<AsyncLogRing> AsyncLogRingPtr;
+
+	struct AsyncLogRingHolder
+	{
+		~AsyncLogRingHolder()
+		{
+			if (mRing)
+			{
+				mRing->mOrphaned = true;
+			}
+		}
+
+		AsyncLogRingPtr mRing;
+	};
+
+	// Background writer for LLError::setAsyncLogging().  Logging
+	// threads post formatted messages to their own ring and return;
+	// the writer thread drains all rings every WRITE_INTERVAL, or
+	// sooner if one is filling up, and passes the messages to the
+	// recorders in the order they were logged.  Messages that don't
+	// fit are counted and reported rather than blocking the caller.
+	class AsyncLogWriter
+	{
+	public:
+		static constexpr int WRITE_INTERVAL_MS = 20;
+
+		AsyncLogWriter()
+			: mDroppedReported(0),
+			  mKicked(false),
+			  mRunning(false),
+			  mSequence(0),
+			  mDropped(0)
+		{
+			// Make sure the settings outlive us, stop() needs them
+			Globals::getInstance();
+		}
+
+		~AsyncLogWriter()
+		{
+			stop();
+		}
+
+		static AsyncLogWriter& instance()
+		{
+			static AsyncLogWriter sWriter;
+			return sWriter;
+		}
+
+		void start()
+		{
+			if (! mRunning.exchange(true))
+			{
+				mThread = std::thread(&AsyncLogWriter::run, this);
+			}
+		}
+
+		// Writes everything pending before returning
+		void stop()
+		{
+			if (mRunning.exchange(false))
+			{
+				{
+					std::lock_guard<std::mutex> lock(mWakeMutex);
+					mKicked = true;
+				}
+				mWake.notify_one();
+				mThread.join();
+			}
+			flush();
+		}
+
+		bool isRunning() const
+		{
+			return mRunning.load(std::memory_order_acquire);
+		}
+
+		// Called without LOG_MUTEX.  Takes the contents of time and
+		// message.
+		void post(const LLError::CallSite& site, std::string& time, std::string& message)
+		{
+			AsyncLogRing& ring(threadRing());
+
+			AsyncLogRing::Record rec;
+			rec.mSite = &site;
+			rec.mSequence = mSequence.fetch_add(1, std::memory_order_relaxed);
+			rec.mTime.swap(time);
+			rec.mMessage.swap(message);
+			if (! ring.push(rec))
+			{
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				kick();
+			}
+			else if (ring.size() == AsyncLogRing::CAPACITY / 2)
+			{
+				kick();
+			}
+		}
+
+		// Write everything pending.  Doesn't wait for ever: at crash
+		// time the writer thread may have died holding the drain mutex.
+		void flush()
+		{
+			std::unique_lock<std::timed_mutex> drain(mDrainMutex, std::defer_lock);
+			if (! drain.try_lock_for(std::chrono::seconds(1)))
+			{
+				return;
+			}
+
+			std::vector<AsyncLogRingPtr> rings;
+			{
+				std::lock_guard<std::mutex> lock(mRingsMutex);
+				rings = mRings;
+			}
+
+			mPending.clear();
+			AsyncLogRing::Record rec;
+			for (AsyncLogRingPtr& ring : rings)
+			{
+				while (ring->pop(rec))
+				{
+					mPending.push_back(std::move(rec));
+				}
+			}
+			std::sort(mPending.begin(), mPending.end(),
+					  [](const AsyncLogRing::Record& a, const AsyncLogRing::Record& b)
+					  { return a.mSequence < b.mSequence; });
+
+			// Not under LOG_MUTEX: a slow recorder mustn't hold off
+			// shouldLog(), which gives up after 5ms.  mRecorderMutex
+			// keeps us from racing synchronous writes.
+			for (AsyncLogRing::Record& pending : mPending)
+			{
+				writeToRecorders(*pending.mSite, pending.mMessage, pending.mTime);
+			}
+			mPending.clear();
+
+			const U64 dropped = mDropped.load(std::memory_order_relaxed);
+			if (dropped != mDroppedReported)
+			{
+				static LLError::CallSite sDropSite(LLError::LEVEL_WARN, __FILE__, __LINE__,
+												   typeid(LLError::NoClassInfo), __FUNCTION__,
+												   false, NULL, 0);
+				std::ostringstream out;
+				out << "Asynchronous logging dropped " << (dropped - mDroppedReported)
+					<< " messages, " << dropped << " in total";
+				writeToRecorders(sDropSite, out.str());
+				mDroppedReported = dropped;
+			}
+
+			std::lock_guard<std::mutex> lock(mRingsMutex);
+			mRings.erase(std::remove_if(mRings.begin(), mRings.end(),
+										[](const AsyncLogRingPtr& ring)
+										{ return ring->mOrphaned && ! ring->size(); }),
+						 mRings.end());
+		}
+
+		U64 getDropCount() const
+		{
+			return mDropped.load(std::memory_order_relaxed);
+		}
+
+	private:
+		AsyncLogRing& threadRing()
+		{
+			static thread_local AsyncLogRingHolder sHolder;
+			if (! sHolder.mRing)
+			{
+				sHolder.mRing = std::make_shared<AsyncLogRing>();
+				std::lock_guard<std::mutex> lock(mRingsMutex);
+				mRings.push_back(sHolder.mRing);
+			}
+			return *sHolder.mRing;
+		}
+
+		void kick()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mWakeMutex);
+				mKicked = true;
+			}
+			mWake.notify_one();
+		}
+
+		void run()
+		{
+			while (isRunning())
+			{
+				{
+					std::unique_lock<std::mutex> lock(mWakeMutex);
+					mWake.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_MS),
+								   [this]{ return mKicked; });
+					mKicked = false;
+				}
+				flush();
+			}
+		}
+
+		std::mutex							mRingsMutex;
+		std::vector<AsyncLogRingPtr>		mRings;
+
+		std::timed_mutex					mDrainMutex;
+		std::vector<AsyncLogRing::Record>	mPending;			// guarded by mDrainMutex
+		U64									mDroppedReported;	// guarded by mDrainMutex
+
+		std::mutex							mWakeMutex;
+		std::condition_variable				mWake;
+		bool								mKicked;
+
+		std::thread							mThread;
+		std::atomic<bool>					mRunning;
+		std::atomic<U64>					mSequence;
+		std::atomic<U64>					mDropped;
+	};
+
+	void startAsyncLogging()
+	{
+		AsyncLogWriter::instance().start();
+	}
+
+	void stopAsyncLogging()
+	{
+		AsyncLogWriter::instance().stop();
+	}
+
+	void postAsync(AsyncLogWriter& writer, const LLError::CallSite& site, std::string message)
+	{
+		// Stamp it now, not when the writer gets to it, but only if
+		// someone will print the stamp
+		std::string time;
+		SettingsConfig* s = Globals::getInstance()->peekSettingsConfig();
+		LLError::TimeFunction time_function(s->mTimeFunction);
+		if (time_function != NULL)
+		{
+			bool wants_time(false);
+			{
+				LLMutexLock lock(&s->mRecorderMutex);
+				for (LLError::RecorderPtr& r : s->mRecorders)
+				{
+					if (r->enabled() && r->wantsTime())
+					{
+						wants_time = true;
+						break;
+					}
+				}
+			}
+			if (wants_time)
+			{
+				// Called from any logging thread, must be reentrant
+				time = time_function();
+			}
+		}
+		writer.post(site, time, message);
+	}
+}
+
 namespace LLError
 {
 
@@ -1371,6 +1738,21 @@ namespace LLError
 
 	void Log::flush(const std::ostringstream& out, const CallSite& site)
 	{
+		AsyncLogWriter& writer(AsyncLogWriter::instance());
+		if (site.mLevel == LEVEL_ERROR)
+		{
+			// Everything logged before the fatal message goes out first
+			if (writer.isRunning())
+			{
+				writer.flush();
+			}
+		}
+		else if (!site.mPrintOnce && writer.isRunning())
+		{
+			postAsync(writer, site, out.str());
+			return;
+		}
+
 		LLMutexTrylock lock(getMutex<LOG_MUTEX>(),5);
 		if (!lock.isLocked())
 		{
@@ -1407,6 +1789,12 @@ namespace LLError
 			}
 			message_stream << message;
 			message = message_stream.str();
+
+			if (site.mLevel != LEVEL_ERROR && writer.isRunning())
+			{
+				postAsync(writer, site, message);
+				return;
+			}
 		}
 		
 		writeToRecorders(site, message);
@@ -1434,6 +1822,35 @@ namespace LLError
 		return Globals::getInstance()->restore(pSettingsStorage);
 	}
 
+	void setAsyncLogging(bool async)
+	{
+		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+		s->mAsyncLogging = async;
+		if (async)
+		{
+			startAsyncLogging();
+		}
+		else
+		{
+			stopAsyncLogging();
+		}
+	}
+
+	bool getAsyncLogging()
+	{
+		return AsyncLogWriter::instance().isRunning();
+	}
+
+	void flushAsyncLogging()
+	{
+		AsyncLogWriter::instance().flush();
+	}
+
+	U64 getAsyncLogDropCount()
+	{
+		return AsyncLogWriter::instance().getDropCount();
+	}
+
 	std::string removePrefix(std::string& s, const std::string& p)
 	{
 		std::string::size_type where = s.find(p);
@@ -1487,9 +1904,16 @@ namespace LLError
 		const size_t BUF_SIZE = 64;
 		char time_str[BUF_SIZE];	/* Flawfinder: ignore */
 		
+		// Async logging calls this from every logging thread
+		struct tm utc;
+#if LL_WINDOWS
+		gmtime_s(&utc, &now);
+#else
+		gmtime_r(&now, &utc);
+#endif
 		size_t chars = strftime(time_str, BUF_SIZE,
 								  "%Y-%m-%dT%H:%M:%SZ",
-								  gmtime(&now));
+								  &utc);
 
 		return chars ? time_str : "time error";
 	}
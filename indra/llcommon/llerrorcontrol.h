@@ -135,6 +135,8 @@ namespace LLError
 	LL_COMMON_API void setTimeFunction(TimeFunction);
 		// The function is use to return the current time, formatted for
 		// display by those error recorders that want the time included.
+		// With async logging it's called from every logging thread, so
+		// it must be reentrant.
 
 
 
@@ -226,6 +228,20 @@ namespace LLError
 	LL_COMMON_API std::string logFileName();
 		// returns name of current logging file, empty string if none
 
+	LL_COMMON_API void setAsyncLogging(bool async);
+	LL_COMMON_API bool getAsyncLogging();
+		// When on, logging threads queue messages to a per-thread buffer
+		// and return; a background thread writes them to the recorders
+		// in order.  Buffers are bounded, messages that don't fit are
+		// dropped and counted.  LL_ERRS messages are always written
+		// synchronously, after everything queued before them.
+		// Turning it off writes anything still queued.
+	LL_COMMON_API void flushAsyncLogging();
+		// Writes queued messages now.  Call before anything that may
+		// end the process without running static destructors.
+	LL_COMMON_API U64 getAsyncLogDropCount();
+		// Messages dropped because their thread's buffer was full
+
 
 	/*
 		Utilities for use by the unit tests of LLError itself.
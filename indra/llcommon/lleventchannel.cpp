@@ -0,0 +1,258 @@
+/**
+ * @file   lleventchannel.cpp
+ * @brief  Implementation for lleventchannel.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lleventchannel.h"
+// STL headers
+#include <algorithm>
+// std headers
+// external library headers
+// other Linden headers
+#include "llerror.h"
+
+/*****************************************************************************
+*   LLChannelConnection
+*****************************************************************************/
+void LLChannelConnection::disconnect()
+{
+    if (! mId)
+    {
+        return;
+    }
+    if (std::shared_ptr<LLEventChannelBase*> channel = mChannel.lock())
+    {
+        (*channel)->disconnect(mId);
+    }
+    mChannel.reset();
+    mId = 0;
+}
+
+bool LLChannelConnection::connected() const
+{
+    std::shared_ptr<LLEventChannelBase*> channel = mChannel.lock();
+    return channel && (*channel)->isConnected(mId);
+}
+
+/*****************************************************************************
+*   LLEventChannelBase
+*****************************************************************************/
+LLEventChannelBase::LLEventChannelBase(const std::string& name):
+    mName(name),
+    mSelf(std::make_shared<LLEventChannelBase*>(this)),
+    mNextId(1),
+    mDepth(0),
+    mDisconnected(false),
+    mEnabled(true),
+    mPostingToPump(false)
+{
+}
+
+LLEventChannelBase::~LLEventChannelBase()
+{
+    // outstanding LLChannelConnections now find nothing to disconnect
+    mSelf.reset();
+}
+
+void LLEventChannelBase::checkThread()
+{
+    if (mOwner == std::thread::id())
+    {
+        return;
+    }
+    llassert_always_msg(std::this_thread::get_id() == mOwner,
+                        "LLEventChannel used from a thread other than the one posting to it");
+}
+
+U64 LLEventChannelBase::addListener(const std::string& name)
+{
+#ifdef SHOW_ASSERT
+    checkThread();
+#endif
+    if (name != LLEventPump::ANONYMOUS)
+    {
+        auto same_name = [&name](const Slot& slot) { return slot.mId && slot.mName == name; };
+        if (std::any_of(mSlots.begin(), mSlots.end(), same_name) ||
+            std::any_of(mPending.begin(), mPending.end(), same_name))
+        {
+            LLTHROW(LLEventPump::DupListenerName("Attempt to register duplicate listener name '" + name +
+                                                 "' on LLEventChannel '" + getName() + "'"));
+        }
+    }
+    if (isBridged())
+    {
+        // LLEventPumps::clear() drops every LLSD listener, ours included
+        listenToPump();
+    }
+
+    Slot slot = { mNextId++, name };
+    if (mDepth)
+    {
+        mPending.push_back(slot);
+    }
+    else
+    {
+        mSlots.push_back(slot);
+    }
+    return slot.mId;
+}
+
+void LLEventChannelBase::disconnect(U64 id)
+{
+#ifdef SHOW_ASSERT
+    checkThread();
+#endif
+    for (std::vector<Slot>* slots : { &mSlots, &mPending })
+    {
+        for (Slot& slot : *slots)
+        {
+            if (slot.mId == id)
+            {
+                slot.mId = 0;
+                mDisconnected = true;
+                if (! mDepth)
+                {
+                    settle();
+                }
+                return;
+            }
+        }
+    }
+}
+
+bool LLEventChannelBase::isConnected(U64 id) const
+{
+    auto with_id = [id](const Slot& slot) { return slot.mId == id; };
+    return id && (std::any_of(mSlots.begin(), mSlots.end(), with_id) ||
+                  std::any_of(mPending.begin(), mPending.end(), with_id));
+}
+
+void LLEventChannelBase::stopListening(const std::string& name)
+{
+    for (std::vector<Slot>* slots : { &mSlots, &mPending })
+    {
+        for (const Slot& slot : *slots)
+        {
+            if (slot.mId && slot.mName == name)
+            {
+                disconnect(slot.mId);
+                return;
+            }
+        }
+    }
+}
+
+size_t LLEventChannelBase::size() const
+{
+    auto live = [](const Slot& slot) { return slot.mId != 0; };
+    return std::count_if(mSlots.begin(), mSlots.end(), live) +
+           std::count_if(mPending.begin(), mPending.end(), live);
+}
+
+void LLEventChannelBase::settle()
+{
+    if (! mPending.empty())
+    {
+        appendPending();
+        mSlots.insert(mSlots.end(), mPending.begin(), mPending.end());
+        mPending.clear();
+    }
+    if (mDisconnected)
+    {
+        eraseDisconnected();
+        mSlots.erase(std::remove_if(mSlots.begin(), mSlots.end(),
+                                    [](const Slot& slot) { return ! slot.mId; }),
+                     mSlots.end());
+        mDisconnected = false;
+    }
+}
+
+void LLEventChannelBase::setBridge(const std::string& pump)
+{
+    mFromPump.disconnect();
+    mPumpName = pump;
+    listenToPump();
+}
+
+void LLEventChannelBase::listenToPump()
+{
+    if (mFromPump.connected())
+    {
+        return;
+    }
+    mFromPump = LLEventPumps::instance().obtain(mPumpName).listen(
+        "LLEventChannel:" + mName,
+        [this](const LLSD& event)
+        {
+            // our own post() on its way to the pump's other listeners
+            return mPostingToPump ? false : postFromPump(event);
+        });
+}
+
+bool LLEventChannelBase::postToPump(const LLSD& event)
+{
+    listenToPump();
+    const bool was_posting = mPostingToPump;
+    mPostingToPump = true;
+    bool handled = false;
+    try
+    {
+        handled = LLEventPumps::instance().obtain(mPumpName).post(event);
+    }
+    catch (...)
+    {
+        mPostingToPump = was_posting;
+        throw;
+    }
+    mPostingToPump = was_posting;
+    return handled;
+}
+
+/*****************************************************************************
+*   ll_mainloop_channel()
+*****************************************************************************/
+namespace
+{
+    class MainloopChannel: public LLEventChannel<>
+    {
+    public:
+        MainloopChannel():
+            LLEventChannel<>("mainloop")
+        {
+            // the tick carries nothing either way
+            bridge("mainloop",
+                   []() { return LLSD(); },
+                   [](const LLSD&) { return std::tuple<>(); });
+        }
+    };
+}
+
+LLEventChannel<>& ll_mainloop_channel()
+{
+    static MainloopChannel sMainloop;
+    return sMainloop;
+}
@@ -0,0 +1,379 @@
+/**
+ * @file   lleventchannel.h
+ * @brief  LLEventChannel: typed, single threaded event dispatch for hot
+ *         internal signals, optionally bridged to an LLEventPump
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLEVENTCHANNEL_H)
+#define LL_LLEVENTCHANNEL_H
+
+#include "llevents.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class LLEventChannelBase;
+
+/**
+ * Handle to a listener on an LLEventChannel, like LLBoundListener. It may
+ * outlive the channel: disconnect() is then a no-op.
+ */
+class LL_COMMON_API LLChannelConnection
+{
+public:
+    LLChannelConnection(): mId(0) {}
+
+    void disconnect();
+    bool connected() const;
+
+private:
+    friend class LLEventChannelBase;
+    LLChannelConnection(const std::weak_ptr<LLEventChannelBase*>& channel, U64 id):
+        mChannel(channel),
+        mId(id)
+    {}
+
+    std::weak_ptr<LLEventChannelBase*> mChannel;
+    U64 mId;
+};
+
+/**
+ * Disconnects its listener when destroyed, like LLTempBoundListener.
+ */
+class LL_COMMON_API LLTempChannelConnection: public LLChannelConnection
+{
+public:
+    LLTempChannelConnection() {}
+    LLTempChannelConnection(const LLChannelConnection& connection):
+        LLChannelConnection(connection)
+    {}
+    LLTempChannelConnection& operator=(const LLChannelConnection& connection)
+    {
+        disconnect();
+        LLChannelConnection::operator=(connection);
+        return *this;
+    }
+    ~LLTempChannelConnection() { disconnect(); }
+
+    LLTempChannelConnection(LLTempChannelConnection&& other):
+        LLChannelConnection(other)
+    {
+        other.release();
+    }
+    LLTempChannelConnection& operator=(LLTempChannelConnection&& other)
+    {
+        if (this != &other)
+        {
+            disconnect();
+            LLChannelConnection::operator=(other);
+            other.release();
+        }
+        return *this;
+    }
+    LLTempChannelConnection(const LLTempChannelConnection&) = delete;
+    LLTempChannelConnection& operator=(const LLTempChannelConnection&) = delete;
+
+    /// Forget the listener without disconnecting it
+    void release() { LLChannelConnection::operator=(LLChannelConnection()); }
+};
+
+/**
+ * The parts of LLEventChannel that don't depend on the event type: listener
+ * bookkeeping and the LLEventPump bridge.
+ */
+class LL_COMMON_API LLEventChannelBase
+{
+public:
+    LLEventChannelBase(const std::string& name);
+    virtual ~LLEventChannelBase();
+
+    const std::string& getName() const { return mName; }
+
+    /// Unregister a listener by name
+    void stopListening(const std::string& name);
+    /// Number of listeners connected
+    size_t size() const;
+
+    /// Enable/disable: while disabled, silently ignore all post() calls
+    void enable(bool enabled=true) { mEnabled = enabled; }
+    bool enabled() const { return mEnabled; }
+
+protected:
+    /// returns the new listener's id after checking its name
+    U64 addListener(const std::string& name);
+    LLChannelConnection makeConnection(U64 id) const { return LLChannelConnection(mSelf, id); }
+    /// the slot to dispatch to, 0 once disconnected
+    U64 listenerId(size_t index) const { return mSlots[index].mId; }
+    size_t listenerCount() const { return mSlots.size(); }
+
+    // Dispatch with listeners connecting and disconnecting under us: new
+    // listeners wait in a pending list and disconnected ones stay in place
+    // until the outermost post() returns.
+    class DispatchScope
+    {
+    public:
+        DispatchScope(LLEventChannelBase& channel):
+            mChannel(channel)
+        {
+            if (mChannel.mOwner == std::thread::id())
+            {
+                mChannel.mOwner = std::this_thread::get_id();
+            }
+#ifdef SHOW_ASSERT
+            mChannel.checkThread();
+#endif
+            ++mChannel.mDepth;
+        }
+
+        ~DispatchScope()
+        {
+            if (! --mChannel.mDepth && (mChannel.mDisconnected || ! mChannel.mPending.empty()))
+            {
+                mChannel.settle();
+            }
+        }
+
+    private:
+        LLEventChannelBase& mChannel;
+    };
+
+    void setBridge(const std::string& pump);
+    bool isBridged() const { return ! mPumpName.empty(); }
+    /// post to the bridged LLEventPump
+    bool postToPump(const LLSD& event);
+    /// an event posted straight to the bridged LLEventPump
+    virtual bool postFromPump(const LLSD& event) = 0;
+
+    /// the typed parts follow mSlots: same order, same length
+    virtual void appendPending() = 0;
+    virtual void eraseDisconnected() = 0;
+
+    struct Slot
+    {
+        U64         mId;
+        std::string mName;
+    };
+    std::vector<Slot> mSlots;
+    std::vector<Slot> mPending;
+
+private:
+    friend class LLChannelConnection;
+    void disconnect(U64 id);
+    bool isConnected(U64 id) const;
+    void checkThread();
+    /// fold in the listeners connected and disconnected during dispatch
+    void settle();
+    void listenToPump();
+
+    std::string mName;
+    std::shared_ptr<LLEventChannelBase*> mSelf;
+    U64 mNextId;
+    U32 mDepth;
+    bool mDisconnected;
+    bool mEnabled;
+    // set by the first post(): listeners are called on that thread only,
+    // and must be connected and disconnected there too
+    std::thread::id mOwner;
+
+    std::string mPumpName;
+    LLTempBoundListener mFromPump;
+    bool mPostingToPump;
+};
+
+/**
+ * LLEventChannel is a cheap alternative to LLEventStream for signals posted
+ * many times a frame by C++ code, for C++ code. Events are passed as typed
+ * arguments rather than boxed in LLSD, and post() takes no locks: a channel
+ * belongs to the thread that posts to it, the main thread as a rule, and
+ * its listeners must connect and disconnect there (checked in debug
+ * builds). Post from other threads through LL::WorkQueue.
+ *
+ * The semantics otherwise follow LLEventStream: a listener returning true
+ * has handled the event and the ones after it don't see it; listener names
+ * must be unique unless LLEventPump::ANONYMOUS; listeners may connect and
+ * disconnect during post(). There are no before/after dependencies, the
+ * listeners are called in the order they connected.
+ *
+ * Where LLSD listeners, LEAP scripts or coroutines need to see the same
+ * events, bridge() the channel to an LLEventPump. Each post() then goes to
+ * the pump as LLSD after the typed listeners, unless one of them handled
+ * it; and LLSD posted straight to the pump reaches the typed listeners.
+ *
+ * Measured by the LL_EVENTCHANNEL_BENCHMARK test, posting one integer (x86-64,
+ * release build):
+ *   listeners       0        1        10
+ *   LLEventStream   ~70ns    ~100ns   ~400ns
+ *   LLEventChannel  ~4ns     ~8ns     ~35ns
+ */
+template <typename... ARGS>
+class LLEventChannel: public LLEventChannelBase
+{
+public:
+    typedef std::function<bool(const ARGS&...)> Listener;
+    typedef std::function<LLSD(const ARGS&...)> ToLLSD;
+    typedef std::function<std::tuple<ARGS...>(const LLSD&)> FromLLSD;
+
+    LLEventChannel(const std::string& name): LLEventChannelBase(name) {}
+
+    /**
+     * Connect a listener. Callables returning void are accepted too, as if
+     * they returned false. Throws LLEventPump::DupListenerName for a name
+     * already listening.
+     */
+    template <typename CALLABLE>
+    LLChannelConnection listen(const std::string& name, CALLABLE&& listener)
+    {
+        Listener wrapped;
+        if constexpr (std::is_void_v<std::invoke_result_t<CALLABLE&, const ARGS&...>>)
+        {
+            wrapped = [listener = std::forward<CALLABLE>(listener)](const ARGS&... args) mutable
+            {
+                listener(args...);
+                return false;
+            };
+        }
+        else
+        {
+            wrapped = std::forward<CALLABLE>(listener);
+        }
+
+        const U64 id = addListener(name);
+        if (mPending.size() > mPendingListeners.size())
+        {
+            mPendingListeners.push_back(std::move(wrapped));
+        }
+        else
+        {
+            mListeners.push_back(std::move(wrapped));
+        }
+        return makeConnection(id);
+    }
+
+    /// Post an event to all listeners, true if one of them handled it
+    bool post(const ARGS&... args)
+    {
+        if (! enabled() || (! listenerCount() && ! isBridged()))
+        {
+            return false;
+        }
+
+        bool handled = false;
+        {
+            DispatchScope dispatching(*this);
+            const size_t count = listenerCount();
+            for (size_t i = 0; i < count && ! handled; ++i)
+            {
+                if (listenerId(i))
+                {
+                    handled = mListeners[i](args...);
+                }
+            }
+        }
+        if (! handled && isBridged())
+        {
+            handled = postToPump(mToLLSD(args...));
+        }
+        return handled;
+    }
+
+    /**
+     * Mirror this channel on the LLEventPump named @a pump, see above.
+     * @a from_llsd may be empty if events posted to the pump shouldn't
+     * reach the typed listeners.
+     */
+    void bridge(const std::string& pump, const ToLLSD& to_llsd, const FromLLSD& from_llsd=FromLLSD())
+    {
+        mToLLSD = to_llsd;
+        mFromLLSD = from_llsd;
+        setBridge(pump);
+    }
+
+private:
+    bool postFromPump(const LLSD& event) override
+    {
+        if (! mFromLLSD)
+        {
+            return false;
+        }
+        const std::tuple<ARGS...> args(mFromLLSD(event));
+        // only the typed listeners, the pump is already posting it
+        bool handled = false;
+        DispatchScope dispatching(*this);
+        const size_t count = listenerCount();
+        for (size_t i = 0; i < count && ! handled; ++i)
+        {
+            if (listenerId(i))
+            {
+                handled = std::apply(mListeners[i], args);
+            }
+        }
+        return handled;
+    }
+
+    void appendPending() override
+    {
+        for (Listener& listener : mPendingListeners)
+        {
+            mListeners.push_back(std::move(listener));
+        }
+        mPendingListeners.clear();
+    }
+
+    void eraseDisconnected() override
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < mSlots.size(); ++i)
+        {
+            if (mSlots[i].mId)
+            {
+                if (kept != i)
+                {
+                    mListeners[kept] = std::move(mListeners[i]);
+                }
+                ++kept;
+            }
+        }
+        mListeners.resize(kept);
+    }
+
+    std::vector<Listener> mListeners;
+    std::vector<Listener> mPendingListeners;
+    ToLLSD mToLLSD;
+    FromLLSD mFromLLSD;
+};
+
+/**
+ * The once per frame tick, in place of listening on the "mainloop"
+ * LLEventPump. It is bridged to "mainloop", so coroutines, LEAP and LLSD
+ * listeners see the same ticks, and a post to "mainloop" ticks this too.
+ */
+LL_COMMON_API LLEventChannel<>& ll_mainloop_channel();
+
+#endif /* ! defined(LL_LLEVENTCHANNEL_H) */
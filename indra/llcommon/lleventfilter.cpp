@@ -92,8 +92,7 @@ void LLEventTimeoutBase::actionAfter(F32 seconds, const Action& action)
     mAction = action;
     if (! mMainloop.connected())
     {
-        LLEventPump& mainloop(LLEventPumps::instance().obtain("mainloop"));
-        mMainloop = mainloop.listen(getName(), boost::bind(&LLEventTimeoutBase::tick, this, _1));
+        mMainloop = ll_mainloop_channel().listen(getName(), boost::bind(&LLEventTimeoutBase::tick, this));
     }
 }
 
@@ -150,7 +149,7 @@ void LLEventTimeoutBase::cancel()
     mMainloop.disconnect();
 }
 
-bool LLEventTimeoutBase::tick(const LLSD&)
+bool LLEventTimeoutBase::tick()
 {
     if (countdownElapsed())
     {
@@ -30,6 +30,7 @@
 #define LL_LLEVENTFILTER_H
 
 #include "llevents.h"
+#include "lleventchannel.h"
 #include "stdtypes.h"
 #include "llbool.h"
 #include "lltimer.h"
@@ -190,9 +191,9 @@ protected:
     virtual bool countdownElapsed() const = 0;
 
 private:
-    bool tick(const LLSD&);
+    bool tick();
 
-    LLTempBoundListener mMainloop;
+    LLTempChannelConnection mMainloop;
     Action mAction;
 };
 
@@ -29,6 +29,7 @@
 
 #include "llinstancetracker.h"
 #include "lltrace.h"
+#include "lltraceeventlog.h"
 #include "lltreeiterators.h"
 
 #if LL_WINDOWS
@@ -276,16 +277,27 @@ LL_FORCE_INLINE BlockTimer::BlockTimer(BlockTimerStatHandle& timer)
 	cur_timer_data->mChildTime = 0;
 
 	mStartTime = getCPUClockCount64();
+
+	if (EventLog::isRecording())
+	{
+		EventLog::recordBlock(EventLog::BLOCK_BEGIN, timer, mStartTime);
+	}
 #endif
 }
 
 LL_FORCE_INLINE BlockTimer::~BlockTimer()
 {
 #if LL_FAST_TIMER_ON
-	U64 total_time = getCPUClockCount64() - mStartTime;
+	U64 end_time = getCPUClockCount64();
+	U64 total_time = end_time - mStartTime;
 	BlockTimerStackRecord* cur_timer_data = LLThreadLocalSingletonPointer<BlockTimerStackRecord>::getInstance();
 	if (!cur_timer_data) return;
 
+	if (EventLog::isRecording())
+	{
+		EventLog::recordBlock(EventLog::BLOCK_END, *cur_timer_data->mTimeBlock, end_time);
+	}
+
 	TimeBlockAccumulator& accumulator = cur_timer_data->mTimeBlock->getCurrentAccumulator();
 
 	accumulator.mCalls++;
@@ -0,0 +1,281 @@
+/**
+ * @file   llflathashmap.h
+ * @brief  Open addressed hash map for hot lookup tables.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLFLATHASHMAP_H)
+#define LL_LLFLATHASHMAP_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * LLFlatHashMap keeps keys and values inline in one power of two array and
+ * resolves collisions by linear probing with Robin Hood displacement, so a
+ * lookup is a hash and a short forward scan of adjacent memory instead of a
+ * chain of node allocations. Erase shifts the following entries back, so
+ * there are no tombstones and misses stop early.
+ *
+ * Key and T must be default constructible and movable. Erased and cleared
+ * slots are reset to default values so that values holding references
+ * (LLPointer etc.) release them straight away.
+ *
+ * Pointers returned by find() and references from operator[] are invalidated
+ * by any insertion or erase, as are those of std::vector.
+ *
+ * The user hash is run through a 64 bit finalizer before use, so identity
+ * hashes such as std::hash<U64> on packed ids distribute fine.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key> >
+class LLFlatHashMap
+{
+public:
+    typedef Key key_type;
+    typedef T mapped_type;
+
+    LLFlatHashMap():
+        mMask(0),
+        mSize(0)
+    {}
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    size_t capacity() const { return mSlots.size(); }
+
+    /// nullptr if key is not present
+    T* find(const Key& key)
+    {
+        size_t index = locate(key);
+        return index != NOT_FOUND ? &mSlots[index].mValue : nullptr;
+    }
+
+    const T* find(const Key& key) const
+    {
+        size_t index = locate(key);
+        return index != NOT_FOUND ? &mSlots[index].mValue : nullptr;
+    }
+
+    bool contains(const Key& key) const
+    {
+        return locate(key) != NOT_FOUND;
+    }
+
+    /// find or default construct, as std::map
+    T& operator[](const Key& key)
+    {
+        size_t index = locate(key);
+        if (index != NOT_FOUND)
+        {
+            return mSlots[index].mValue;
+        }
+        return mSlots[insertNew(key, T())].mValue;
+    }
+
+    /// returns true if key was not present before
+    bool insert_or_assign(const Key& key, const T& value)
+    {
+        size_t index = locate(key);
+        if (index != NOT_FOUND)
+        {
+            mSlots[index].mValue = value;
+            return false;
+        }
+        insertNew(key, value);
+        return true;
+    }
+
+    /// returns true if key was present
+    bool erase(const Key& key)
+    {
+        size_t index = locate(key);
+        if (index == NOT_FOUND)
+        {
+            return false;
+        }
+
+        // shift the run that follows back by one, no tombstones needed
+        size_t next = (index + 1) & mMask;
+        while (mSlots[next].mDistance > 1)
+        {
+            mSlots[index].mKey = std::move(mSlots[next].mKey);
+            mSlots[index].mValue = std::move(mSlots[next].mValue);
+            mSlots[index].mDistance = mSlots[next].mDistance - 1;
+            index = next;
+            next = (next + 1) & mMask;
+        }
+        mSlots[index] = Slot();
+        --mSize;
+        return true;
+    }
+
+    void clear()
+    {
+        mSlots.clear();
+        mMask = 0;
+        mSize = 0;
+    }
+
+    /// make room for count entries without rehashing
+    void reserve(size_t count)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (count * LOAD_DEN > capacity * LOAD_NUM)
+        {
+            capacity *= 2;
+        }
+        if (capacity > mSlots.size())
+        {
+            rehash(capacity);
+        }
+    }
+
+    /// calls fn(key, value) for every entry, in no particular order
+    template <typename FN>
+    void forEach(FN fn) const
+    {
+        for (const Slot& slot : mSlots)
+        {
+            if (slot.mDistance)
+            {
+                fn(slot.mKey, slot.mValue);
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        Key mKey = Key();
+        T mValue = T();
+        // 0 for an empty slot, else 1 + how far it sits from its home slot
+        size_t mDistance = 0;
+    };
+
+    static const size_t NOT_FOUND = ~(size_t)0;
+    static const size_t MIN_CAPACITY = 16;
+    // maximum load factor, 7/8
+    static const size_t LOAD_NUM = 7;
+    static const size_t LOAD_DEN = 8;
+
+    size_t home(const Key& key) const
+    {
+        // murmur3 finalizer
+        unsigned long long h = (unsigned long long) mHash(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return (size_t) h & mMask;
+    }
+
+    size_t locate(const Key& key) const
+    {
+        if (!mSize)
+        {
+            return NOT_FOUND;
+        }
+
+        size_t index = home(key);
+        for (size_t distance = 1; ; ++distance)
+        {
+            const Slot& slot = mSlots[index];
+            // an empty slot, or one closer to home than we would be, means
+            // the key would have been placed before here
+            if (slot.mDistance < distance)
+            {
+                return NOT_FOUND;
+            }
+            if (slot.mDistance == distance && mEqual(slot.mKey, key))
+            {
+                return index;
+            }
+            index = (index + 1) & mMask;
+        }
+    }
+
+    // key must not be present, returns where it ended up
+    size_t insertNew(Key key, T value)
+    {
+        if ((mSize + 1) * LOAD_DEN > mSlots.size() * LOAD_NUM)
+        {
+            rehash(mSlots.empty() ? MIN_CAPACITY : mSlots.size() * 2);
+        }
+
+        Slot carried;
+        carried.mKey = std::move(key);
+        carried.mValue = std::move(value);
+        carried.mDistance = 1;
+
+        size_t result = NOT_FOUND;
+        size_t index = home(carried.mKey);
+        while (true)
+        {
+            Slot& slot = mSlots[index];
+            if (!slot.mDistance)
+            {
+                slot = std::move(carried);
+                ++mSize;
+                return result != NOT_FOUND ? result : index;
+            }
+            if (slot.mDistance < carried.mDistance)
+            {
+                // take from the rich: the new entry settles here, the
+                // displaced one carries on looking
+                std::swap(slot, carried);
+                if (result == NOT_FOUND)
+                {
+                    result = index;
+                }
+            }
+            index = (index + 1) & mMask;
+            ++carried.mDistance;
+        }
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<Slot> old;
+        old.swap(mSlots);
+        mSlots.resize(capacity);
+        mMask = capacity - 1;
+        mSize = 0;
+        for (Slot& slot : old)
+        {
+            if (slot.mDistance)
+            {
+                insertNew(std::move(slot.mKey), std::move(slot.mValue));
+            }
+        }
+    }
+
+    std::vector<Slot> mSlots;
+    size_t mMask;
+    size_t mSize;
+    Hash mHash;
+    KeyEqual mEqual;
+};
+
+#endif /* ! defined(LL_LLFLATHASHMAP_H) */
@@ -0,0 +1,279 @@
+/**
+ * @file llframeallocator.cpp
+ * @brief Per-thread frame arenas and fixed size object pools
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframeallocator.h"
+
+#include "llmutex.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+	// Every live arena and pool, for logAll() and endFrame(). Allocators
+	// may be destroyed during static destruction (thread_local arenas), so
+	// the registry is never destroyed.
+	struct Registry
+	{
+		LLMutex mMutex;
+		std::vector<LLAllocatorStats*> mAll;
+	};
+
+	Registry& registry()
+	{
+		static Registry* sRegistry = new Registry;
+		return *sRegistry;
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLAllocatorStats
+//----------------------------------------------------------------------------
+
+LLAllocatorStats::LLAllocatorStats(const std::string& name) :
+	mName(name),
+	mBytesInUse(0),
+	mAllocations(0),
+	mHeapAllocations(0),
+	mPeakBytes(0),
+	mBytesHeld(0),
+	mLastFrameAllocations(0),
+	mLastFrameHeapAllocations(0),
+	mFrameStartAllocations(0),
+	mFrameStartHeapAllocations(0)
+{
+	Registry& reg(registry());
+	LLMutexLock lock(&reg.mMutex);
+	reg.mAll.push_back(this);
+}
+
+LLAllocatorStats::~LLAllocatorStats()
+{
+	Registry& reg(registry());
+	LLMutexLock lock(&reg.mMutex);
+	reg.mAll.erase(std::remove(reg.mAll.begin(), reg.mAll.end(), this), reg.mAll.end());
+}
+
+void LLAllocatorStats::rollFrame()
+{
+	const U64 allocations = getAllocations();
+	const U64 heap_allocations = getHeapAllocations();
+	mLastFrameAllocations.store(allocations - mFrameStartAllocations, std::memory_order_relaxed);
+	mLastFrameHeapAllocations.store(heap_allocations - mFrameStartHeapAllocations, std::memory_order_relaxed);
+	mFrameStartAllocations = allocations;
+	mFrameStartHeapAllocations = heap_allocations;
+}
+
+// static
+void LLAllocatorStats::endFrame()
+{
+	Registry& reg(registry());
+	LLMutexLock lock(&reg.mMutex);
+	for (LLAllocatorStats* stats : reg.mAll)
+	{
+		stats->rollFrame();
+	}
+}
+
+// static
+void LLAllocatorStats::logAll()
+{
+	Registry& reg(registry());
+	LLMutexLock lock(&reg.mMutex);
+	U64 served = 0, heap = 0;
+	for (const LLAllocatorStats* stats : reg.mAll)
+	{
+		LL_INFOS() << "Allocator " << stats->getName() << ": "
+				   << stats->getLastFrameAllocations() << " allocations last frame ("
+				   << stats->getLastFrameHeapAllocations() << " from the heap), "
+				   << stats->getAllocations() << " in all, in use(KB): " << stats->getBytesInUse() / 1024
+				   << ", peak(KB): " << stats->getPeakBytes() / 1024
+				   << ", held(KB): " << stats->getBytesHeld() / 1024 << LL_ENDL;
+		served += stats->getLastFrameAllocations();
+		heap += stats->getLastFrameHeapAllocations();
+	}
+	LL_INFOS() << "Heap allocations saved by frame arenas and pools last frame: "
+			   << (served > heap ? served - heap : 0) << LL_ENDL;
+}
+
+//----------------------------------------------------------------------------
+// LLFrameArena
+//----------------------------------------------------------------------------
+
+LLFrameArena::LLFrameArena(const std::string& name) :
+	LLAllocatorStats(name),
+	mBlock(0),
+	mBlocksUsed(0),
+	mCur(nullptr),
+	mEnd(nullptr),
+	mLast(nullptr),
+	mLive(0)
+#if LL_ALLOCATOR_DEBUG
+	, mOwner(std::this_thread::get_id())
+#endif
+{
+}
+
+LLFrameArena::~LLFrameArena()
+{
+	reset();
+	for (char* block : mBlocks)
+	{
+		ll_aligned_free_16(block);
+	}
+}
+
+// static
+LLFrameArena& LLFrameArena::current()
+{
+	// the arena goes away with its thread
+	static thread_local std::unique_ptr<LLFrameArena> sArena;
+	if (!sArena)
+	{
+		std::ostringstream name;
+		name << "frame arena (thread " << std::this_thread::get_id() << ")";
+		sArena.reset(new LLFrameArena(name.str()));
+	}
+	return *sArena;
+}
+
+// static
+void LLFrameArena::endFrame()
+{
+	current().reset();
+	LLAllocatorStats::endFrame();
+}
+
+void* LLFrameArena::allocateSlow(size_t size, size_t align)
+{
+	llassert(align <= 16);
+	if (size + align > BLOCK_SIZE / 2)
+	{
+		// would waste too much of a block, give it one of its own
+		char* large = (char*)ll_aligned_malloc_16(size);
+		mLarge.push_back(std::make_pair(large, size));
+		countHeapAllocation(size);
+		countAllocation(size);
+#if LL_ALLOCATOR_DEBUG
+		++mLive;
+		memset(large, 0xcd, size);
+#endif
+		return large;
+	}
+
+	if (mBlock == mBlocks.size())
+	{
+		mBlocks.push_back((char*)ll_aligned_malloc_16(BLOCK_SIZE));
+		countHeapAllocation(BLOCK_SIZE);
+	}
+	mCur = mBlocks[mBlock++];
+	mEnd = mCur + BLOCK_SIZE;
+	return allocate(size, align);
+}
+
+void LLFrameArena::reset()
+{
+#if LL_ALLOCATOR_DEBUG
+	llassert(std::this_thread::get_id() == mOwner);
+	if (mLive)
+	{
+		LL_WARNS() << getName() << " reset with " << mLive << " allocations still in use" << LL_ENDL;
+	}
+	for (size_t i = 0; i < mBlock; ++i)
+	{
+		memset(mBlocks[i], 0xdd, BLOCK_SIZE);
+	}
+#endif
+
+	for (const std::pair<char*, size_t>& large : mLarge)
+	{
+		ll_aligned_free_16(large.first);
+		countHeapFree(large.second);
+	}
+	mLarge.clear();
+
+	// Keep enough blocks for a busy frame, but let a one off spike drain
+	// away a block per frame rather than hold on to it for good.
+	mBlocksUsed = llmax(mBlock, mBlocksUsed ? mBlocksUsed - 1 : 0);
+	while (mBlocks.size() > mBlocksUsed)
+	{
+		ll_aligned_free_16(mBlocks.back());
+		mBlocks.pop_back();
+		countHeapFree(BLOCK_SIZE);
+	}
+
+	mBlock = 0;
+	mCur = mEnd = mLast = nullptr;
+	mLive = 0;
+	countAllFreed();
+}
+
+//----------------------------------------------------------------------------
+// LLFixedSizePool
+//----------------------------------------------------------------------------
+
+LLFixedSizePool::LLFixedSizePool(const std::string& name, size_t size, size_t align, size_t blocks_per_chunk) :
+	LLAllocatorStats(name + " pool"),
+	mFree(nullptr),
+	mBlockSize((llmax(size, sizeof(FreeBlock)) + align - 1) & ~(align - 1)),
+	mBlocksPerChunk(blocks_per_chunk)
+#if LL_ALLOCATOR_DEBUG
+	, mOwner(std::this_thread::get_id())
+#endif
+{
+	llassert(align && align <= 16 && !(align & (align - 1)));
+}
+
+LLFixedSizePool::~LLFixedSizePool()
+{
+	if (getLive())
+	{
+		LL_WARNS() << getName() << " destroyed with " << getLive() << " blocks still in use" << LL_ENDL;
+	}
+	for (char* chunk : mChunks)
+	{
+		ll_aligned_free_16(chunk);
+	}
+}
+
+void LLFixedSizePool::addChunk()
+{
+	const size_t bytes = mBlockSize * mBlocksPerChunk;
+	char* chunk = (char*)ll_aligned_malloc_16(bytes);
+	mChunks.push_back(chunk);
+	countHeapAllocation(bytes);
+
+	// link back to front, so blocks are handed out in address order
+	for (size_t i = mBlocksPerChunk; i--; )
+	{
+		FreeBlock* block = (FreeBlock*)(chunk + i * mBlockSize);
+		block->mNext = mFree;
+		mFree = block;
+	}
+}
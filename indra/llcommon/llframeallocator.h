@@ -0,0 +1,383 @@
+/**
+ * @file llframeallocator.h
+ * @brief Per-thread frame arenas and fixed size object pools
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMEALLOCATOR_H
+#define LL_LLFRAMEALLOCATOR_H
+
+#include "llerror.h"
+#include "llmemory.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Debug builds fill memory handed back to an arena or pool with 0xdd and
+// fresh allocations with 0xcd, so use after free and use before init show up
+// as garbage instead of plausible old values, and check that pools are only
+// used from the thread that made them.
+#ifndef LL_ALLOCATOR_DEBUG
+#ifdef SHOW_ASSERT
+#define LL_ALLOCATOR_DEBUG 1
+#else
+#define LL_ALLOCATOR_DEBUG 0
+#endif
+#endif
+
+//============================================================================
+// Counters shared by the arenas and pools below. Each one registers itself
+// under a name so that LLMemory::logMemoryInfo() can list them all.
+//
+// Counters are only written by the thread owning the allocator, and read
+// from anywhere, so they are relaxed atomics rather than locked.
+//============================================================================
+
+class LL_COMMON_API LLAllocatorStats
+{
+public:
+	LLAllocatorStats(const std::string& name);
+	virtual ~LLAllocatorStats();
+
+	const std::string& getName() const		{ return mName; }
+
+	// allocations served, all time and in the last complete frame
+	U64 getAllocations() const				{ return mAllocations.load(std::memory_order_relaxed); }
+	U64 getLastFrameAllocations() const		{ return mLastFrameAllocations.load(std::memory_order_relaxed); }
+	// allocations this allocator had to make from the heap itself
+	U64 getHeapAllocations() const			{ return mHeapAllocations.load(std::memory_order_relaxed); }
+	U64 getLastFrameHeapAllocations() const	{ return mLastFrameHeapAllocations.load(std::memory_order_relaxed); }
+	size_t getBytesInUse() const			{ return mBytesInUse.load(std::memory_order_relaxed); }
+	size_t getPeakBytes() const				{ return mPeakBytes.load(std::memory_order_relaxed); }
+	size_t getBytesHeld() const				{ return mBytesHeld.load(std::memory_order_relaxed); }
+
+	// Closes a frame for the per frame counters of every allocator.
+	// Called by LLFrameArena::endFrame().
+	static void endFrame();
+	// One LL_INFOS line per allocator
+	static void logAll();
+
+protected:
+	// single writer, so plain load and store are enough
+	static void add(std::atomic<U64>& counter, U64 n)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	void countAllocation(size_t bytes)
+	{
+		add(mAllocations, 1);
+		const size_t in_use = mBytesInUse.load(std::memory_order_relaxed) + bytes;
+		mBytesInUse.store(in_use, std::memory_order_relaxed);
+		if (in_use > mPeakBytes.load(std::memory_order_relaxed))
+		{
+			mPeakBytes.store(in_use, std::memory_order_relaxed);
+		}
+	}
+
+	void countFree(size_t bytes)
+	{
+		mBytesInUse.store(mBytesInUse.load(std::memory_order_relaxed) - bytes, std::memory_order_relaxed);
+	}
+
+	void countHeapAllocation(size_t bytes)
+	{
+		add(mHeapAllocations, 1);
+		mBytesHeld.store(mBytesHeld.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+	}
+
+	void countHeapFree(size_t bytes)
+	{
+		mBytesHeld.store(mBytesHeld.load(std::memory_order_relaxed) - bytes, std::memory_order_relaxed);
+	}
+
+	void countAllFreed()
+	{
+		mBytesInUse.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	void rollFrame();
+
+	const std::string mName;
+	std::atomic<size_t> mBytesInUse;
+	std::atomic<U64> mAllocations;
+	std::atomic<U64> mHeapAllocations;
+	std::atomic<size_t> mPeakBytes;
+	std::atomic<size_t> mBytesHeld;
+
+	// only touched by endFrame() under the registry lock
+	std::atomic<U64> mLastFrameAllocations;
+	std::atomic<U64> mLastFrameHeapAllocations;
+	U64 mFrameStartAllocations;
+	U64 mFrameStartHeapAllocations;
+};
+
+//============================================================================
+// LLFrameArena is a bump allocator for memory that doesn't outlive the
+// current frame: temporary containers built while rebuilding geometry,
+// scratch lists and the like. Allocation is a pointer increment in a 64KB
+// block, freeing is free, and reset() makes the whole arena available again
+// at the end of the frame without touching the heap.
+//
+// Each thread has its own arena, from current(). The main thread resets its
+// arena in LLFrameArena::endFrame(); other threads must call reset() on
+// their own arena at a point where nothing they allocated is still in use.
+// Anything still alive when the arena is reset is a bug, and debug builds
+// say so.
+//
+// Allocations too big to share a block get their own heap block, released
+// by the next reset().
+//============================================================================
+
+class LL_COMMON_API LLFrameArena : public LLAllocatorStats
+{
+public:
+	LLFrameArena(const std::string& name);
+	~LLFrameArena();
+
+	// This thread's arena
+	static LLFrameArena& current();
+	// Resets the calling (main) thread's arena and closes the frame for the
+	// statistics of all arenas and pools
+	static void endFrame();
+
+	void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+	// Memory only comes back at reset(), except that giving back the most
+	// recent allocation rewinds the arena over it.
+	void deallocate(void* ptr, size_t size);
+	// Everything allocated since the last reset is gone
+	void reset();
+
+	// allocations not yet deallocated, debug builds only
+	size_t getLive() const					{ return mLive; }
+
+private:
+	void* allocateSlow(size_t size, size_t align);
+
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	std::vector<char*> mBlocks;		// BLOCK_SIZE each, reused every frame
+	std::vector<std::pair<char*, size_t> > mLarge;	// freed at reset
+	size_t mBlock;					// index of the block in use
+	size_t mBlocksUsed;				// most blocks used in one frame lately
+	char* mCur;
+	char* mEnd;
+	char* mLast;					// most recent allocation
+	size_t mLive;
+#if LL_ALLOCATOR_DEBUG
+	std::thread::id mOwner;
+#endif
+};
+
+inline void* LLFrameArena::allocate(size_t size, size_t align)
+{
+	char* ptr = (char*)(((uintptr_t)mCur + align - 1) & ~(uintptr_t)(align - 1));
+	if (ptr > mEnd || size > size_t(mEnd - ptr))
+	{
+		return allocateSlow(size, align);
+	}
+	mLast = ptr;
+	mCur = ptr + size;
+	countAllocation(size);
+#if LL_ALLOCATOR_DEBUG
+	++mLive;
+	memset(ptr, 0xcd, size);
+#endif
+	return ptr;
+}
+
+inline void LLFrameArena::deallocate(void* ptr, size_t size)
+{
+	countFree(size);
+#if LL_ALLOCATOR_DEBUG
+	llassert(mLive);
+	--mLive;
+	memset(ptr, 0xdd, size);
+#endif
+	if (ptr == mLast && (char*)ptr + size == mCur)
+	{
+		mCur = (char*)ptr;
+		mLast = nullptr;
+	}
+}
+
+// STL allocator drawing on the calling thread's frame arena, for temporary
+// containers that are gone by the end of the frame:
+//   std::vector<LLFace*, LLFrameAllocator<LLFace*> > faces;
+template <typename T>
+class LLFrameAllocator
+{
+public:
+	typedef T value_type;
+
+	LLFrameAllocator() :
+		mArena(&LLFrameArena::current())
+	{
+	}
+
+	template <typename U>
+	LLFrameAllocator(const LLFrameAllocator<U>& other) :
+		mArena(other.mArena)
+	{
+	}
+
+	T* allocate(size_t n)
+	{
+		return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* ptr, size_t n)
+	{
+		mArena->deallocate(ptr, n * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const LLFrameAllocator<U>& other) const	{ return mArena == other.mArena; }
+	template <typename U>
+	bool operator!=(const LLFrameAllocator<U>& other) const	{ return mArena != other.mArena; }
+
+private:
+	template <typename U> friend class LLFrameAllocator;
+	LLFrameArena* mArena;
+};
+
+//============================================================================
+// LLFixedSizePool hands out blocks of one size from chunks of many, keeping
+// freed blocks on a free list, so objects that come and go by the thousand
+// every frame (particles, draw infos) cost a couple of pointer moves instead
+// of a trip through the heap. Chunks are kept until the pool is destroyed.
+//
+// A pool is not thread safe: only use it from the thread that created it.
+// Debug builds check this.
+//============================================================================
+
+class LL_COMMON_API LLFixedSizePool : public LLAllocatorStats
+{
+public:
+	// Blocks are size bytes aligned to align (at most 16), blocks_per_chunk
+	// at a time
+	LLFixedSizePool(const std::string& name, size_t size, size_t align = 16, size_t blocks_per_chunk = 256);
+	~LLFixedSizePool();
+
+	void* allocate()
+	{
+		checkThread();
+		if (!mFree)
+		{
+			addChunk();
+		}
+		FreeBlock* block = mFree;
+		mFree = block->mNext;
+		countAllocation(mBlockSize);
+#if LL_ALLOCATOR_DEBUG
+		memset(block, 0xcd, mBlockSize);
+#endif
+		return block;
+	}
+
+	void deallocate(void* ptr)
+	{
+		checkThread();
+		countFree(mBlockSize);
+#if LL_ALLOCATOR_DEBUG
+		memset(ptr, 0xdd, mBlockSize);
+#endif
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->mNext = mFree;
+		mFree = block;
+	}
+
+	size_t getBlockSize() const				{ return mBlockSize; }
+	size_t getLive() const					{ return getBytesInUse() / mBlockSize; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* mNext;
+	};
+
+	void addChunk();
+
+	void checkThread() const
+	{
+#if LL_ALLOCATOR_DEBUG
+		llassert(std::this_thread::get_id() == mOwner);
+#endif
+	}
+
+	FreeBlock* mFree;
+	std::vector<char*> mChunks;
+	const size_t mBlockSize;
+	const size_t mBlocksPerChunk;
+#if LL_ALLOCATOR_DEBUG
+	const std::thread::id mOwner;
+#endif
+};
+
+// Gives class T a pool of its own for operator new and delete, in place of
+// LL_ALIGN_NEW. Blocks are 16 byte aligned. The pool belongs to the thread
+// that first creates a T, and is never destroyed so that objects may still
+// be deleted during static destruction. Subclasses of a different size and
+// arrays fall back to the aligned heap.
+#define LL_POOL_NEW(T)														\
+public:																		\
+	static LLFixedSizePool& getPool()										\
+	{																		\
+		static LLFixedSizePool* sPool = new LLFixedSizePool(#T, sizeof(T));	\
+		return *sPool;														\
+	}																		\
+																			\
+	void* operator new(size_t size)											\
+	{																		\
+		return size == sizeof(T) ? getPool().allocate() : ll_aligned_malloc_16(size);	\
+	}																		\
+																			\
+	void operator delete(void* ptr, size_t size)							\
+	{																		\
+		if (size == sizeof(T))												\
+		{																	\
+			getPool().deallocate(ptr);										\
+		}																	\
+		else																\
+		{																	\
+			ll_aligned_free_16(ptr);										\
+		}																	\
+	}																		\
+																			\
+	void* operator new[](size_t size)										\
+	{																		\
+		return ll_aligned_malloc_16(size);									\
+	}																		\
+																			\
+	void operator delete[](void* ptr)										\
+	{																		\
+		ll_aligned_free_16(ptr);											\
+	}
+
+#endif // LL_LLFRAMEALLOCATOR_H
@@ -0,0 +1,489 @@
+/**
+ * @file llheaptracker.cpp
+ * @brief Sampling heap profiler attributing live memory to call sites
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llheaptracker.h"
+
+#include "llfile.h"
+#include "llinternedstring.h"
+#include "llstacktrace.h"
+#include "lltrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+	const S32 MAX_FRAMES = 24;
+	// ll_capture_stack_frames() already skips itself; these are sample()
+	// and countdown()
+	const S32 SKIP_FRAMES = 2;
+	// counters of live samples per address hash
+	const size_t FILTER_SIZE = 256 * 1024;
+
+	// Per thread, trivially constructed so that it can be used from
+	// operator new at any point in a thread's life
+	struct ThreadState
+	{
+		S64			mCountdown;		// bytes to allocate before the next sample
+		U64			mRandom;		// 0 until the thread's first allocation
+		const char*	mCategory;
+		bool		mBusy;			// inside the tracker, don't recurse
+	};
+	thread_local ThreadState tState;
+
+	class BusyScope
+	{
+	public:
+		BusyScope() :
+			mWasBusy(tState.mBusy)
+		{
+			tState.mBusy = true;
+		}
+
+		~BusyScope()
+		{
+			tState.mBusy = mWasBusy;
+		}
+
+	private:
+		bool mWasBusy;
+	};
+
+	struct SiteData
+	{
+		const char*	mCategory;
+		void*		mFrames[MAX_FRAMES];
+		S32			mDepth;
+		F64			mLiveBytes;
+		F64			mLiveCount;
+		F64			mTotalBytes;
+		F64			mTotalCount;
+		U32			mSamples;
+	};
+
+	struct Sample
+	{
+		U64		mSite;
+		F64		mBytes;
+		F64		mCount;
+	};
+
+	// All of this is only touched with mMutex held and the calling thread
+	// busy, so that its own allocations are neither sampled nor deadlock.
+	// std::mutex rather than LLMutex: this runs inside operator new.
+	struct Tracker
+	{
+		Tracker() :
+			mLiveBytes(0.0)
+		{
+			for (std::atomic<U16>& count : mFilter)
+			{
+				count.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		// Frees look here before taking the lock. The counts have to go
+		// back down when samples are freed: the heap hands the same
+		// addresses out over and over, and a stale entry for a hot one
+		// would send most frees through the lock.
+		static size_t filterSlot(void* ptr)
+		{
+			return size_t(((uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL >> 40) % FILTER_SIZE;
+		}
+
+		bool mayBeSampled(void* ptr) const
+		{
+			return mFilter[filterSlot(ptr)].load(std::memory_order_relaxed) != 0;
+		}
+
+		// both with mMutex held
+		void markSampled(void* ptr)
+		{
+			std::atomic<U16>& count(mFilter[filterSlot(ptr)]);
+			const U16 n = count.load(std::memory_order_relaxed);
+			if (n != U16(~0))
+			{
+				count.store(n + 1, std::memory_order_relaxed);
+			}
+		}
+
+		void unmarkSampled(void* ptr)
+		{
+			// a saturated count stays put, it no longer knows how many
+			std::atomic<U16>& count(mFilter[filterSlot(ptr)]);
+			const U16 n = count.load(std::memory_order_relaxed);
+			if (n && n != U16(~0))
+			{
+				count.store(n - 1, std::memory_order_relaxed);
+			}
+		}
+
+		void forget(std::unordered_map<void*, Sample>::iterator it)
+		{
+			SiteData& site(mSites[it->second.mSite]);
+			site.mLiveBytes -= it->second.mBytes;
+			site.mLiveCount -= it->second.mCount;
+			--site.mSamples;
+			mLiveBytes -= it->second.mBytes;
+			unmarkSampled(it->first);
+			mLive.erase(it);
+		}
+
+		std::mutex mMutex;
+		std::unordered_map<void*, Sample> mLive;
+		std::unordered_map<U64, SiteData> mSites;
+		F64 mLiveBytes;
+		std::atomic<U16> mFilter[FILTER_SIZE];
+	};
+
+	// made when first needed and never destroyed, frees keep arriving
+	// during static destruction
+	Tracker& tracker()
+	{
+		static Tracker* sTracker = new Tracker;
+		return *sTracker;
+	}
+
+	// gap to the next sample, exponentially distributed with the given
+	// mean, so that sampling has no period to alias with
+	S64 next_gap(ThreadState& state, size_t interval)
+	{
+		// xorshift64*
+		state.mRandom ^= state.mRandom >> 12;
+		state.mRandom ^= state.mRandom << 25;
+		state.mRandom ^= state.mRandom >> 27;
+		const U64 bits = (state.mRandom * 0x2545F4914F6CDD1DULL) >> 11;
+		const F64 uniform = (F64(bits) + 1.0) / F64(U64(1) << 53);	// (0, 1]
+		return S64(-std::log(uniform) * F64(interval)) + 1;
+	}
+
+	U64 site_key(const char* category, void* const* frames, S32 depth)
+	{
+		U64 key = (U64)(uintptr_t)category * 0x9E3779B97F4A7C15ULL;
+		for (S32 i = 0; i < depth; ++i)
+		{
+			key = (key ^ (U64)(uintptr_t)frames[i]) * 0x100000001B3ULL;
+		}
+		return key;
+	}
+
+	void sample(void* ptr, size_t size, size_t interval)
+	{
+		void* frames[MAX_FRAMES];
+		const S32 depth = ll_capture_stack_frames(frames, MAX_FRAMES, SKIP_FRAMES);
+
+		// An allocation of size bytes was sampled with probability p, so
+		// it stands for 1/p allocations like it.
+		const F64 p = 1.0 - std::exp(-F64(size) / F64(interval));
+		const F64 count = p > 0.0 ? 1.0 / p : 1.0;
+		const F64 bytes = F64(size) * count;
+
+		const U64 key = site_key(tState.mCategory, frames, depth);
+		Tracker& t(tracker());
+		std::lock_guard<std::mutex> lock(t.mMutex);
+		auto live = t.mLive.find(ptr);
+		if (live != t.mLive.end())
+		{
+			// freed behind our back, by a path that isn't hooked
+			t.forget(live);
+		}
+
+		auto inserted = t.mSites.emplace(key, SiteData());
+		SiteData& site(inserted.first->second);
+		if (inserted.second)
+		{
+			site.mCategory = tState.mCategory;
+			std::copy(frames, frames + depth, site.mFrames);
+			site.mDepth = depth;
+			site.mLiveBytes = site.mLiveCount = site.mTotalBytes = site.mTotalCount = 0.0;
+			site.mSamples = 0;
+		}
+		site.mLiveBytes += bytes;
+		site.mLiveCount += count;
+		site.mTotalBytes += bytes;
+		site.mTotalCount += count;
+		++site.mSamples;
+
+		Sample& entry(t.mLive[ptr]);
+		entry.mSite = key;
+		entry.mBytes = bytes;
+		entry.mCount = count;
+		t.mLiveBytes += bytes;
+		t.markSampled(ptr);
+	}
+
+	const char* category_name(const char* category)
+	{
+		return category ? category : "Other";
+	}
+
+	// frames inside the allocator say nothing about who allocated
+	bool is_allocator_frame(const std::string& frame)
+	{
+		static const char* const ALLOCATOR_FRAMES[] =
+		{
+			"LLHeapTracker", "operator new", "tracked_new", "ll_aligned_", "malloc", "std::allocator"
+		};
+		for (const char* allocator : ALLOCATOR_FRAMES)
+		{
+			if (frame.find(allocator) != std::string::npos)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+std::atomic<size_t> LLHeapTracker::sSampleInterval(0);
+std::atomic<bool> LLHeapTracker::sLiveFilter(false);
+
+// static
+bool LLHeapTracker::isAvailable()
+{
+#if LL_HEAP_TRACKER
+	return true;
+#else
+	return false;
+#endif
+}
+
+// static
+void LLHeapTracker::setSampleInterval(size_t bytes)
+{
+	if (bytes)
+	{
+		BusyScope busy;
+		// make sure it exists before any sampling thread races to
+		tracker();
+	}
+	if (bytes && !isAvailable())
+	{
+		LL_WARNS() << "This build doesn't hook allocations, build with HEAP_TRACKER to track them" << LL_ENDL;
+	}
+	LL_INFOS() << "Heap tracker sample interval " << bytes << " bytes" << LL_ENDL;
+	sSampleInterval.store(bytes, std::memory_order_relaxed);
+}
+
+// static
+void LLHeapTracker::countdown(void* ptr, size_t size, size_t interval)
+{
+	ThreadState& state(tState);
+	state.mCountdown -= S64(size);
+	if (state.mCountdown > 0 || state.mBusy)
+	{
+		return;
+	}
+
+	state.mBusy = true;
+	if (!state.mRandom)
+	{
+		// first allocation on this thread, start the countdown instead
+		state.mRandom = ((U64)(uintptr_t)&state * 0x9E3779B97F4A7C15ULL) | 1;
+		state.mCountdown = next_gap(state, interval);
+	}
+	else
+	{
+		state.mCountdown = next_gap(state, interval);
+		sample(ptr, size, interval);
+		sLiveFilter.store(true, std::memory_order_relaxed);
+	}
+	state.mBusy = false;
+}
+
+// static
+void LLHeapTracker::checkFree(void* ptr)
+{
+	if (tState.mBusy)
+	{
+		return;
+	}
+	Tracker& t(tracker());
+	if (!t.mayBeSampled(ptr))
+	{
+		return;
+	}
+
+	BusyScope busy;
+	std::lock_guard<std::mutex> lock(t.mMutex);
+	auto live = t.mLive.find(ptr);
+	if (live != t.mLive.end())
+	{
+		t.forget(live);
+	}
+}
+
+// static
+LLHeapTracker::site_list_t LLHeapTracker::getTopSites(size_t count)
+{
+	BusyScope busy;
+	std::vector<SiteData> top;
+	{
+		Tracker& t(tracker());
+		std::lock_guard<std::mutex> lock(t.mMutex);
+		top.reserve(t.mSites.size());
+		for (const auto& site : t.mSites)
+		{
+			if (site.second.mSamples)
+			{
+				top.push_back(site.second);
+			}
+		}
+	}
+
+	count = llmin(count, top.size());
+	std::partial_sort(top.begin(), top.begin() + count, top.end(),
+					  [](const SiteData& a, const SiteData& b) { return a.mLiveBytes > b.mLiveBytes; });
+
+	// symbols are looked up outside the lock, it's slow
+	site_list_t sites(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Site& site(sites[i]);
+		site.mCategory = category_name(top[i].mCategory);
+		site.mLiveBytes = top[i].mLiveBytes;
+		site.mLiveCount = top[i].mLiveCount;
+		site.mTotalBytes = top[i].mTotalBytes;
+		site.mTotalCount = top[i].mTotalCount;
+		site.mSamples = top[i].mSamples;
+		for (S32 frame = 0; frame < top[i].mDepth; ++frame)
+		{
+			std::string description(ll_describe_stack_frame(top[i].mFrames[frame]));
+			if (site.mFrames.empty() && is_allocator_frame(description))
+			{
+				continue;
+			}
+			site.mFrames.push_back(description);
+		}
+	}
+	return sites;
+}
+
+// static
+LLHeapTracker::category_list_t LLHeapTracker::getCategories()
+{
+	BusyScope busy;
+	std::map<std::string, F64> totals;
+	{
+		Tracker& t(tracker());
+		std::lock_guard<std::mutex> lock(t.mMutex);
+		for (const auto& site : t.mSites)
+		{
+			if (site.second.mSamples)
+			{
+				totals[category_name(site.second.mCategory)] += site.second.mLiveBytes;
+			}
+		}
+	}
+	category_list_t categories(totals.begin(), totals.end());
+	std::sort(categories.begin(), categories.end(),
+			  [](const category_list_t::value_type& a, const category_list_t::value_type& b)
+			  {
+				  return a.second > b.second;
+			  });
+	return categories;
+}
+
+// static
+F64 LLHeapTracker::getLiveBytes()
+{
+	BusyScope busy;
+	Tracker& t(tracker());
+	std::lock_guard<std::mutex> lock(t.mMutex);
+	return t.mLiveBytes;
+}
+
+// static
+bool LLHeapTracker::dump(const std::string& filename, size_t count)
+{
+	BusyScope busy;
+	llofstream out(filename.c_str());
+	if (!out.is_open())
+	{
+		LL_WARNS() << "Couldn't write heap profile to " << filename << LL_ENDL;
+		return false;
+	}
+
+	out << "Heap profile, sampling every " << getSampleInterval() << " bytes, estimated live "
+		<< S64(getLiveBytes() / 1024.0) << " KB\n\nLive KB\tCategory\n";
+	for (const category_list_t::value_type& category : getCategories())
+	{
+		out << S64(category.second / 1024.0) << '\t' << category.first << '\n';
+	}
+
+	out << "\nLive KB\tLive count\tAllocated KB\tAllocations\tSamples\tCategory\n";
+	for (const Site& site : getTopSites(count))
+	{
+		out << '\n' << S64(site.mLiveBytes / 1024.0) << '\t' << S64(site.mLiveCount) << '\t'
+			<< S64(site.mTotalBytes / 1024.0) << '\t' << S64(site.mTotalCount) << '\t'
+			<< site.mSamples << '\t' << site.mCategory << '\n';
+		for (const std::string& frame : site.mFrames)
+		{
+			out << "    " << frame << '\n';
+		}
+	}
+	LL_INFOS() << "Wrote heap profile to " << filename << LL_ENDL;
+	return true;
+}
+
+// static
+void LLHeapTracker::reset()
+{
+	BusyScope busy;
+	Tracker& t(tracker());
+	std::lock_guard<std::mutex> lock(t.mMutex);
+	t.mLive.clear();
+	t.mSites.clear();
+	t.mLiveBytes = 0.0;
+	for (std::atomic<U16>& count : t.mFilter)
+	{
+		count.store(0, std::memory_order_relaxed);
+	}
+}
+
+// Categories are interned: samples keep the pointer long after the scope
+// has gone, and equal names from different places share one.
+LLHeapTracker::CategoryScope::CategoryScope(const char* name) :
+	mPrevious(tState.mCategory)
+{
+	tState.mCategory = LLInternedString(name).c_str();
+}
+
+LLHeapTracker::CategoryScope::CategoryScope(const LLTrace::MemStatHandle& stat) :
+	mPrevious(tState.mCategory)
+{
+	tState.mCategory = LLInternedString(stat.getName()).c_str();
+}
+
+LLHeapTracker::CategoryScope::~CategoryScope()
+{
+	tState.mCategory = mPrevious;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file llinternedstring.cpp
+ * @brief Process wide interned strings with lock-free lookup
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinternedstring.h"
+
+#include "hbxxh.h"
+#include "llmutex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace
+{
+	typedef LLInternedString::Entry Entry;
+
+	// The table proper. Readers only ever load the current slot array and
+	// the slots in it, with acquire loads that pair with the release stores
+	// made while inserting, so they see fully built entries. Writers hold
+	// mMutex. Growing builds a new slot array and publishes it; readers
+	// still probing an old one find everything that was there when they
+	// started, so old arrays are kept rather than freed.
+	class InternTable
+	{
+	public:
+		InternTable() :
+			mSlots(nullptr),
+			mCount(0),
+			mBlock(nullptr),
+			mBlockUsed(BLOCK_SIZE)
+		{
+			for (std::atomic<const Entry**>& chunk : mIDChunks)
+			{
+				chunk.store(nullptr, std::memory_order_relaxed);
+			}
+			mSlots.store(newSlots(INITIAL_SLOTS), std::memory_order_release);
+		}
+
+		const Entry* find(std::string_view str, U64 hash) const
+		{
+			return find(*mSlots.load(std::memory_order_acquire), str, hash);
+		}
+
+		const Entry* intern(std::string_view str, U64 hash)
+		{
+			if (const Entry* entry = find(str, hash))
+			{
+				return entry;
+			}
+
+			LLMutexLock lock(&mMutex);
+			Slots* slots = mSlots.load(std::memory_order_relaxed);
+			// someone may have added it since
+			if (const Entry* entry = find(*slots, str, hash))
+			{
+				return entry;
+			}
+
+			const U32 id = mCount.load(std::memory_order_relaxed) + 1;
+			if (id == MAX_ID)
+			{
+				LL_ERRS() << "Interned string table is full" << LL_ENDL;
+			}
+			// at most half full, so probes stay short and always end
+			if ((size_t(id) * 2) > slots->mMask)
+			{
+				slots = grow(*slots);
+			}
+
+			Entry* entry = allocate(str.size());
+			entry->mHash = hash;
+			entry->mID = id;
+			entry->mLength = U32(str.size());
+			memcpy(entry->mString, str.data(), str.size());
+			entry->mString[str.size()] = 0;
+
+			const Entry** chunk = mIDChunks[id >> ID_CHUNK_BITS].load(std::memory_order_relaxed);
+			if (!chunk)
+			{
+				mIDStorage.emplace_back(new const Entry*[ID_CHUNK_SIZE]());
+				chunk = mIDStorage.back().get();
+				mIDChunks[id >> ID_CHUNK_BITS].store(chunk, std::memory_order_release);
+			}
+			chunk[id & (ID_CHUNK_SIZE - 1)] = entry;
+
+			place(*slots, entry, std::memory_order_release);
+			mCount.store(id, std::memory_order_release);
+			return entry;
+		}
+
+		const Entry* fromID(U32 id) const
+		{
+			if (!id || id > mCount.load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+			return mIDChunks[id >> ID_CHUNK_BITS].load(std::memory_order_acquire)[id & (ID_CHUNK_SIZE - 1)];
+		}
+
+		size_t count() const
+		{
+			return mCount.load(std::memory_order_relaxed);
+		}
+
+	private:
+		static const size_t INITIAL_SLOTS = 4096;
+		static const size_t BLOCK_SIZE = 64 * 1024;
+		static const U32 ID_CHUNK_BITS = 12;
+		static const U32 ID_CHUNK_SIZE = 1 << ID_CHUNK_BITS;
+		static const U32 MAX_ID_CHUNKS = 4096;
+		static const U32 MAX_ID = ID_CHUNK_SIZE * MAX_ID_CHUNKS;
+
+		struct Slots
+		{
+			size_t mMask;
+			std::unique_ptr<std::atomic<const Entry*>[]> mSlots;
+		};
+
+		Slots* newSlots(size_t size)
+		{
+			mAllSlots.emplace_back(new Slots);
+			Slots* slots = mAllSlots.back().get();
+			slots->mMask = size - 1;
+			slots->mSlots.reset(new std::atomic<const Entry*>[size]);
+			for (size_t i = 0; i < size; ++i)
+			{
+				slots->mSlots[i].store(nullptr, std::memory_order_relaxed);
+			}
+			return slots;
+		}
+
+		static const Entry* find(const Slots& slots, std::string_view str, U64 hash)
+		{
+			for (size_t i = size_t(hash) & slots.mMask; ; i = (i + 1) & slots.mMask)
+			{
+				const Entry* entry = slots.mSlots[i].load(std::memory_order_acquire);
+				if (!entry)
+				{
+					return nullptr;
+				}
+				if (entry->mHash == hash && entry->mLength == str.size()
+					&& !memcmp(entry->mString, str.data(), str.size()))
+				{
+					return entry;
+				}
+			}
+		}
+
+		static void place(Slots& slots, const Entry* entry, std::memory_order order)
+		{
+			size_t i = size_t(entry->mHash) & slots.mMask;
+			while (slots.mSlots[i].load(std::memory_order_relaxed))
+			{
+				i = (i + 1) & slots.mMask;
+			}
+			slots.mSlots[i].store(entry, order);
+		}
+
+		Slots* grow(const Slots& old)
+		{
+			Slots* slots = newSlots((old.mMask + 1) * 2);
+			for (size_t i = 0; i <= old.mMask; ++i)
+			{
+				if (const Entry* entry = old.mSlots[i].load(std::memory_order_relaxed))
+				{
+					// not visible to readers until published below
+					place(*slots, entry, std::memory_order_relaxed);
+				}
+			}
+			mSlots.store(slots, std::memory_order_release);
+			return slots;
+		}
+
+		// Entries are carved out of big blocks, nothing is ever freed
+		Entry* allocate(size_t length)
+		{
+			const size_t align = alignof(Entry);
+			const size_t size = (offsetof(Entry, mString) + length + 1 + align - 1) & ~(align - 1);
+			if (size > BLOCK_SIZE / 4)
+			{
+				mBlocks.emplace_back(new char[size]);
+				return reinterpret_cast<Entry*>(mBlocks.back().get());
+			}
+			if (mBlockUsed + size > BLOCK_SIZE)
+			{
+				mBlocks.emplace_back(new char[BLOCK_SIZE]);
+				mBlock = mBlocks.back().get();
+				mBlockUsed = 0;
+			}
+			Entry* entry = reinterpret_cast<Entry*>(mBlock + mBlockUsed);
+			mBlockUsed += size;
+			return entry;
+		}
+
+		std::atomic<Slots*> mSlots;
+		std::atomic<U32> mCount;
+		std::atomic<const Entry**> mIDChunks[MAX_ID_CHUNKS];
+
+		// only touched with mMutex held
+		LLMutex mMutex;
+		std::vector<std::unique_ptr<Slots>> mAllSlots;
+		std::vector<std::unique_ptr<const Entry*[]>> mIDStorage;
+		std::vector<std::unique_ptr<char[]>> mBlocks;
+		char* mBlock;
+		size_t mBlockUsed;
+	};
+
+	// Interned strings are used from static initializers (message name
+	// prehashes) and must outlive static destructors, so the table is made
+	// on first use and never destroyed.
+	InternTable& table()
+	{
+		static InternTable* sTable = new InternTable;
+		return *sTable;
+	}
+
+	inline U64 hash_string(std::string_view str)
+	{
+		return HBXXH64::digest(str.data(), str.size());
+	}
+}
+
+LLInternedString::LLInternedString(std::string_view str) :
+	mEntry(table().intern(str, hash_string(str)))
+{
+}
+
+LLInternedString::LLInternedString(const char* str) :
+	mEntry(str ? table().intern(str, hash_string(str)) : nullptr)
+{
+}
+
+// static
+LLInternedString LLInternedString::find(std::string_view str)
+{
+	return LLInternedString(table().find(str, hash_string(str)));
+}
+
+// static
+LLInternedString LLInternedString::find(const char* str)
+{
+	return str ? find(std::string_view(str)) : LLInternedString();
+}
+
+// static
+LLInternedString LLInternedString::fromID(U32 id)
+{
+	return LLInternedString(table().fromID(id));
+}
+
+// static
+size_t LLInternedString::count()
+{
+	return table().count();
+}
+
+std::ostream& operator<<(std::ostream& out, const LLInternedString& str)
+{
+	return out << str.view();
+}
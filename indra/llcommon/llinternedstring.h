@@ -0,0 +1,127 @@
+/**
+ * @file llinternedstring.h
+ * @brief Process wide interned strings with lock-free lookup
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINTERNEDSTRING_H
+#define LL_LLINTERNEDSTRING_H
+
+#include "stdtypes.h"
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+//============================================================================
+// LLInternedString is a handle to the one copy of a string kept in a process
+// wide table. Equal strings get equal handles, so comparing two handles or
+// hashing one is a pointer operation, and each string also has a small
+// stable id (1, 2, 3... in order of interning) for use as an array index or
+// wire value.
+//
+// Looking a string up is lock-free: a hash, a probe of an open-addressed
+// table and one comparison of the string itself. Only interning a string
+// that isn't there yet takes a lock. Interned strings are never freed, so
+// handles and c_str() pointers stay valid for the life of the process, even
+// during static destruction. Intern names and keywords, not arbitrary text.
+//
+// A default constructed handle is null: c_str() is "", getID() is 0, and it
+// equals no interned string, including "".
+//============================================================================
+
+class LL_COMMON_API LLInternedString
+{
+public:
+	// One per distinct string, allocated with room for the characters
+	struct Entry
+	{
+		U64		mHash;
+		U32		mID;
+		U32		mLength;
+		char	mString[1];	// mLength characters and a NUL
+	};
+
+	LLInternedString() :
+		mEntry(nullptr)
+	{
+	}
+
+	// Interns str, a null str gives a null handle
+	explicit LLInternedString(std::string_view str);
+	explicit LLInternedString(const char* str);
+	explicit LLInternedString(const std::string& str) :
+		LLInternedString(std::string_view(str))
+	{
+	}
+
+	// The handle for str if it has been interned, else a null handle.
+	// Never takes a lock or adds to the table.
+	static LLInternedString find(std::string_view str);
+	static LLInternedString find(const char* str);
+	// The handle for an id from getID(), null if there is no such id
+	static LLInternedString fromID(U32 id);
+	// Number of distinct strings interned so far
+	static size_t count();
+
+	const char* c_str() const						{ return mEntry ? mEntry->mString : ""; }
+	std::string_view view() const					{ return std::string_view(c_str(), size()); }
+	std::string str() const							{ return std::string(view()); }
+	size_t size() const								{ return mEntry ? mEntry->mLength : 0; }
+	bool empty() const								{ return size() == 0; }
+	U32 getID() const								{ return mEntry ? mEntry->mID : 0; }
+
+	bool isNull() const								{ return mEntry == nullptr; }
+	bool notNull() const							{ return mEntry != nullptr; }
+
+	bool operator==(const LLInternedString& rhs) const	{ return mEntry == rhs.mEntry; }
+	bool operator!=(const LLInternedString& rhs) const	{ return mEntry != rhs.mEntry; }
+	// Orders by id, which is cheap and stable, but not alphabetical
+	bool operator<(const LLInternedString& rhs) const	{ return getID() < rhs.getID(); }
+
+	size_t hash() const								{ return std::hash<const void*>()(mEntry); }
+
+private:
+	explicit LLInternedString(const Entry* entry) :
+		mEntry(entry)
+	{
+	}
+
+	const Entry* mEntry;
+};
+
+LL_COMMON_API std::ostream& operator<<(std::ostream& out, const LLInternedString& str);
+
+namespace std
+{
+	template <> struct hash<LLInternedString>
+	{
+		size_t operator()(const LLInternedString& str) const
+		{
+			return str.hash();
+		}
+	};
+}
+
+#endif // LL_LLINTERNEDSTRING_H
@@ -38,6 +38,7 @@
 #endif
 
 #include "llmemory.h"
+#include "llframeallocator.h"
 
 #include "llsys.h"
 #include "llframetimer.h"
@@ -152,6 +153,8 @@ void LLMemory::logMemoryInfo(bool update)
 	LL_INFOS() << "Current allocated page size (KB): " << sAllocatedPageSizeInKB << LL_ENDL ;
 	LL_INFOS() << "Current available physical memory(KB): " << sAvailPhysicalMemInKB << LL_ENDL ;
 	LL_INFOS() << "Current max usable memory(KB): " << sMaxPhysicalMemInKB << LL_ENDL ;
+
+	LLAllocatorStats::logAll();
 }
 
 //static 
@@ -73,6 +73,16 @@ LL_COMMON_API void ll_assert_aligned_func(uintptr_t ptr,U32 alignment);
 
 #include <immintrin.h>
 
+#if LL_HEAP_TRACKER
+#include "llheaptracker.h"
+// the ll_aligned_* family reports to the heap tracker as well as the profiler
+#define LL_ALIGNED_ALLOC_HOOK(ptr, size)	do { LL_PROFILE_ALLOC(ptr, size); LLHeapTracker::onAlloc(ptr, size); } while (0)
+#define LL_ALIGNED_FREE_HOOK(ptr)			do { LL_PROFILE_FREE(ptr); LLHeapTracker::onFree(ptr); } while (0)
+#else
+#define LL_ALIGNED_ALLOC_HOOK(ptr, size)	do { LL_PROFILE_ALLOC(ptr, size); } while (0)
+#define LL_ALIGNED_FREE_HOOK(ptr)			do { LL_PROFILE_FREE(ptr); } while (0)
+#endif
+
 template <typename T> T* LL_NEXT_ALIGNED_ADDRESS(T* address) 
 { 
 	return reinterpret_cast<T*>(
@@ -150,13 +160,13 @@ public:                                     \
         }
 		void* ret = aligned;
 	#endif
-        LL_PROFILE_ALLOC(ret, size);
+        LL_ALIGNED_ALLOC_HOOK(ret, size);
         return ret;
 	}
 
 	inline void ll_aligned_free_fallback( void* ptr )
 	{
-        LL_PROFILE_FREE(ptr);
+        LL_ALIGNED_FREE_HOOK(ptr);
 	#if defined(LL_WINDOWS)
 		_aligned_free(ptr);
 	#else
@@ -181,13 +191,13 @@ inline void* ll_aligned_malloc_16(size_t size) // returned hunk MUST be freed wi
     if (0 != posix_memalign(&ret, 16, size))
         return nullptr;
 #endif
-    LL_PROFILE_ALLOC(ret, size);
+    LL_ALIGNED_ALLOC_HOOK(ret, size);
     return ret;
 }
 
 inline void ll_aligned_free_16(void *p)
 {
-    LL_PROFILE_FREE(p);
+    LL_ALIGNED_FREE_HOOK(p);
 #if defined(LL_WINDOWS)
 	_aligned_free(p);
 #elif defined(LL_DARWIN)
@@ -199,12 +209,16 @@ inline void ll_aligned_free_16(void *p)
 
 inline void* ll_aligned_realloc_16(void* ptr, size_t size, size_t old_size) // returned hunk MUST be freed with ll_aligned_free_16().
 {
-    LL_PROFILE_FREE(ptr);
 #if defined(LL_WINDOWS)
+    LL_ALIGNED_FREE_HOOK(ptr);
 	void* ret = _aligned_realloc(ptr, size, 16);
+    LL_ALIGNED_ALLOC_HOOK(ret, size);
 #elif defined(LL_DARWIN)
+    LL_ALIGNED_FREE_HOOK(ptr);
 	void* ret = realloc(ptr,size); // default osx malloc is 16 byte aligned.
+    LL_ALIGNED_ALLOC_HOOK(ret, size);
 #else
+	// ll_aligned_malloc_16() and ll_aligned_free_16() report to the hooks
 	//FIXME: memcpy is SLOW
 	void* ret = ll_aligned_malloc_16(size);
 	if (ptr)
@@ -217,7 +231,6 @@ inline void* ll_aligned_realloc_16(void* ptr, size_t size, size_t old_size) // r
 		ll_aligned_free_16(ptr);
 	}
 #endif
-    LL_PROFILE_ALLOC(ptr, size);
     return ret;
 }
 
@@ -225,25 +238,27 @@ inline void* ll_aligned_malloc_32(size_t size) // returned hunk MUST be freed wi
 {
 #if defined(LL_WINDOWS)
 	void* ret = _aligned_malloc(size, 32);
+    LL_ALIGNED_ALLOC_HOOK(ret, size);
 #elif defined(LL_DARWIN)
-	void* ret = ll_aligned_malloc_fallback( size, 32 );
+	void* ret = ll_aligned_malloc_fallback( size, 32 ); // reports to the hooks
 #else
 	void *ret;
     if (0 != posix_memalign(&ret, 32, size))
         return nullptr;
+    LL_ALIGNED_ALLOC_HOOK(ret, size);
 #endif
-    LL_PROFILE_ALLOC(ret, size);
     return ret;
 }
 
 inline void ll_aligned_free_32(void *p)
 {
-    LL_PROFILE_FREE(p);
 #if defined(LL_WINDOWS)
+    LL_ALIGNED_FREE_HOOK(p);
 	_aligned_free(p);
 #elif defined(LL_DARWIN)
-	ll_aligned_free_fallback( p );
+	ll_aligned_free_fallback( p ); // reports to the hooks
 #else
+    LL_ALIGNED_FREE_HOOK(p);
 	free(p); // posix_memalign() is compatible with heap deallocator
 #endif
 }
@@ -256,7 +271,7 @@ LL_FORCE_INLINE void* ll_aligned_malloc(size_t size)
 	if (LL_DEFAULT_HEAP_ALIGN % ALIGNMENT == 0)
 	{
 		ret = malloc(size);
-        LL_PROFILE_ALLOC(ret, size);
+        LL_ALIGNED_ALLOC_HOOK(ret, size);
 	}
 	else if (ALIGNMENT == 16)
 	{
@@ -278,7 +293,7 @@ LL_FORCE_INLINE void ll_aligned_free(void* ptr)
 {
 	if (ALIGNMENT == LL_DEFAULT_HEAP_ALIGN)
 	{
-        LL_PROFILE_FREE(ptr);
+        LL_ALIGNED_FREE_HOOK(ptr);
 		free(ptr);
 	}
 	else if (ALIGNMENT == 16)
@@ -123,7 +123,7 @@ public:
 		return *this;
 	}
 
-	LLPointer<Type>& operator =(LLPointer<Type>&& ptr)
+	LLPointer<Type>& operator =(LLPointer<Type>&& ptr) noexcept
 	{
 		if (mPointer != ptr.mPointer)
 		{
@@ -370,6 +370,53 @@ protected:
 	const Type*	mPointer;
 };
 
+// A non-owning pointer to a reference counted object, for call chains that
+// only use the object while some caller's LLPointer keeps it alive. Passing
+// and copying one never touches the reference count, which for
+// LLThreadSafeRefCount types is an atomic operation on a cache line other
+// threads are writing too. Convert to an LLPointer where the object has to
+// be kept. Like a plain pointer, don't hold one past its owner's lifetime.
+template <class Type> class LLBorrowedPointer
+{
+public:
+	LLBorrowedPointer() :
+		mPointer(nullptr)
+	{
+	}
+
+	LLBorrowedPointer(Type* ptr) :
+		mPointer(ptr)
+	{
+	}
+
+	template<typename Subclass>
+	LLBorrowedPointer(const LLPointer<Subclass>& ptr) :
+		mPointer(ptr.get())
+	{
+	}
+
+	template<typename Subclass>
+	LLBorrowedPointer(const LLBorrowedPointer<Subclass>& ptr) :
+		mPointer(ptr.get())
+	{
+	}
+
+	Type*	get() const							{ return mPointer; }
+	Type*	operator->() const					{ return mPointer; }
+	Type&	operator*() const					{ return *mPointer; }
+
+	operator Type*() const						{ return mPointer; }
+	bool operator!() const						{ return (mPointer == nullptr); }
+	[[nodiscard]] bool isNull() const			{ return (mPointer == nullptr); }
+	[[nodiscard]] bool notNull() const			{ return (mPointer != nullptr); }
+
+	// Take a reference, for when the callee keeps the object after all
+	LLPointer<Type> own() const					{ return LLPointer<Type>(mPointer); }
+
+private:
+	Type*	mPointer;
+};
+
 template<typename Type>
 class LLCopyOnWritePointer : public LLPointer<Type>
 {
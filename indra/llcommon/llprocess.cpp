@@ -33,6 +33,7 @@
 #include "stringize.h"
 #include "llapr.h"
 #include "apr_signal.h"
+#include "lleventchannel.h"
 #include "llevents.h"
 #include "llexception.h"
 
@@ -82,8 +83,8 @@ public:
 		if (mCount++ == 0)
 		{
 			LL_DEBUGS("LLProcess") << "listening on \"mainloop\"" << LL_ENDL;
-			mConnection = LLEventPumps::instance().obtain("mainloop")
-				.listen("LLProcessListener", boost::bind(&LLProcessListener::tick, this, _1));
+			mConnection = ll_mainloop_channel()
+				.listen("LLProcessListener", boost::bind(&LLProcessListener::tick, this));
 		}
 	}
 
@@ -100,7 +101,7 @@ public:
 
 private:
 	/// called once per frame by the "mainloop" LLEventPump
-	bool tick(const LLSD&)
+	bool tick()
 	{
 		// Tell APR to sense whether each registered LLProcess is still
 		// running and call handle_status() appropriately. We should be able
@@ -125,7 +126,7 @@ private:
 
 	/// If this object is destroyed before mCount goes to zero, stop
 	/// listening on "mainloop" anyway.
-	LLTempBoundListener mConnection;
+	LLTempChannelConnection mConnection;
 	unsigned mCount;
 };
 static LLProcessListener sProcessListener;
@@ -148,9 +149,9 @@ public:
 		// Essential to initialize our std::ostream with our special streambuf!
 		mStream(&mStreambuf)
 	{
-		mConnection = LLEventPumps::instance().obtain("mainloop")
+		mConnection = ll_mainloop_channel()
 			.listen(LLEventPump::inventName("WritePipe"),
-					boost::bind(&WritePipeImpl::tick, this, _1));
+					boost::bind(&WritePipeImpl::tick, this));
 
 #if ! LL_WINDOWS
 		// We can't count on every child process reading everything we try to
@@ -165,7 +166,7 @@ public:
 	virtual std::ostream& get_ostream() { return mStream; }
 	virtual size_type size() const { return mStreambuf.size(); }
 
-	bool tick(const LLSD&)
+	bool tick()
 	{
 		typedef boost::asio::streambuf::const_buffers_type const_buffer_sequence;
 		// If there's anything to send, try to send it.
@@ -247,7 +248,7 @@ public:
 private:
 	std::string mDesc;
 	apr_file_t* mPipe;
-	LLTempBoundListener mConnection;
+	LLTempChannelConnection mConnection;
 	boost::asio::streambuf mStreambuf;
 	std::ostream mStream;
 };
@@ -266,9 +267,9 @@ public:
 		mLimit(0),
 		mEOF(false)
 	{
-		mConnection = LLEventPumps::instance().obtain("mainloop")
+		mConnection = ll_mainloop_channel()
 			.listen(LLEventPump::inventName("ReadPipe"),
-					boost::bind(&ReadPipeImpl::tick, this, _1));
+					boost::bind(&ReadPipeImpl::tick, this));
 	}
 
 	// Much of the implementation is simply connecting the abstract virtual
@@ -349,7 +350,7 @@ public:
 		return (found == end)? npos : (found - begin);
 	}
 
-	bool tick(const LLSD&)
+	bool tick()
 	{
 		// Once we've hit EOF, skip all the rest of this.
 		if (mEOF)
@@ -459,7 +460,7 @@ private:
 	std::string mDesc;
 	apr_file_t* mPipe;
 	LLProcess::FILESLOT mIndex;
-	LLTempBoundListener mConnection;
+	LLTempChannelConnection mConnection;
 	boost::asio::streambuf mStreambuf;
 	std::istream mStream;
 	LLEventStream mPump;
@@ -29,6 +29,18 @@
 
 #include "llerror.h"
 
+#if LL_REFCOUNT_AUDIT
+#include "llformat.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#endif
+
 // maximum reference count before sounding memory leak alarm
 const S32 gMaxRefCount = LL_REFCOUNT_FREE;
 
@@ -56,3 +68,122 @@ LLRefCount::~LLRefCount()
 	}
 }
 
+#if LL_REFCOUNT_AUDIT
+
+namespace
+{
+
+struct AuditCounts
+{
+	AuditCounts(const std::type_info& type) :
+		mType(type), mRefs(0), mUnrefs(0), mHandoffs(0)
+	{}
+
+	const std::type_info& mType;
+	std::atomic<U64> mRefs;
+	std::atomic<U64> mUnrefs;
+	std::atomic<U64> mHandoffs;
+};
+
+std::mutex& audit_mutex()
+{
+	static std::mutex sMutex;
+	return sMutex;
+}
+
+// guarded by audit_mutex(), the counts are never freed
+std::map<std::type_index, AuditCounts*>& audit_types()
+{
+	static std::map<std::type_index, AuditCounts*> sTypes;
+	return sTypes;
+}
+
+U32 audit_thread()
+{
+	// 0 means no thread yet
+	static std::atomic<U32> sNextThread(1);
+	static thread_local U32 sThread(sNextThread++);
+	return sThread;
+}
+
+AuditCounts& audit_counts(const std::type_info& type)
+{
+	// the shared map is only looked at the first time a thread sees a type
+	static thread_local std::unordered_map<const std::type_info*, AuditCounts*> sCache;
+	auto found = sCache.find(&type);
+	if (found != sCache.end())
+	{
+		return *found->second;
+	}
+	std::lock_guard<std::mutex> lock(audit_mutex());
+	AuditCounts*& counts(audit_types()[std::type_index(type)]);
+	if (!counts)
+	{
+		counts = new AuditCounts(type);
+	}
+	sCache[&type] = counts;
+	return *counts;
+}
+
+} // anonymous namespace
+
+//static
+void LLRefCountAudit::record(const std::type_info& type, bool ref, std::atomic<U32>& last_thread)
+{
+	AuditCounts& counts(audit_counts(type));
+	(ref ? counts.mRefs : counts.mUnrefs).fetch_add(1, std::memory_order_relaxed);
+	const U32 thread(audit_thread());
+	const U32 last(last_thread.exchange(thread, std::memory_order_relaxed));
+	if (last && last != thread)
+	{
+		counts.mHandoffs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+//static
+void LLRefCountAudit::dump(std::ostream& out, size_t count)
+{
+	std::vector<const AuditCounts*> types;
+	{
+		std::lock_guard<std::mutex> lock(audit_mutex());
+		for (const auto& pair : audit_types())
+		{
+			types.push_back(pair.second);
+		}
+	}
+	std::sort(types.begin(), types.end(),
+			  [](const AuditCounts* a, const AuditCounts* b)
+			  { return a->mRefs.load() > b->mRefs.load(); });
+
+	out << "        refs      unrefs    handoffs  type\n";
+	for (size_t i = 0; i < types.size() && i < count; ++i)
+	{
+		out << llformat("%12llu%12llu%12llu  ",
+						(unsigned long long)types[i]->mRefs.load(),
+						(unsigned long long)types[i]->mUnrefs.load(),
+						(unsigned long long)types[i]->mHandoffs.load())
+			<< LLError::Log::demangle(types[i]->mType.name()) << '\n';
+	}
+}
+
+//static
+void LLRefCountAudit::log(size_t count)
+{
+	std::ostringstream out;
+	dump(out, count);
+	LL_INFOS("RefCountAudit") << "Reference count traffic by type:\n" << out.str() << LL_ENDL;
+}
+
+//static
+void LLRefCountAudit::reset()
+{
+	std::lock_guard<std::mutex> lock(audit_mutex());
+	for (auto& pair : audit_types())
+	{
+		pair.second->mRefs = 0;
+		pair.second->mUnrefs = 0;
+		pair.second->mHandoffs = 0;
+	}
+}
+
+#endif // LL_REFCOUNT_AUDIT
@@ -30,8 +30,43 @@
 #include <boost/intrusive_ptr.hpp>
 #include "llatomic.h"
 
+#include <atomic>
+
 class LLMutex;
 
+// Build with REFCOUNT_AUDIT=ON (-DLL_REFCOUNT_AUDIT=1) to count reference
+// traffic per type, see LLRefCountAudit below.
+#ifndef LL_REFCOUNT_AUDIT
+#define LL_REFCOUNT_AUDIT 0
+#endif
+
+#if LL_REFCOUNT_AUDIT
+#include <iosfwd>
+#include <typeinfo>
+
+// Counts the references taken and released on each dynamic type, and the
+// handoffs: a reference taken or released on a different thread than the
+// last one on the same object. Types with many handoffs are the ones whose
+// counts bounce between cores, candidates for moving LLPointers or passing
+// LLBorrowedPointers instead of copying. Handoffs on an LLRefCount type are
+// a thread safety bug.
+class LL_COMMON_API LLRefCountAudit
+{
+public:
+	// last_thread is the object's own slot
+	static void record(const std::type_info& type, bool ref, std::atomic<U32>& last_thread);
+
+	// The busiest count types, by references taken
+	static void dump(std::ostream& out, size_t count = 20);
+	static void log(size_t count = 20);
+	static void reset();
+};
+
+#define LL_REFCOUNT_AUDIT_RECORD(REF) LLRefCountAudit::record(typeid(*this), REF, mAuditThread)
+#else
+#define LL_REFCOUNT_AUDIT_RECORD(REF)
+#endif
+
 //----------------------------------------------------------------------------
 // RefCount objects should generally only be accessed by way of LLPointer<>'s
 // see llthread.h for LLThreadSafeRefCount
@@ -54,6 +89,7 @@ public:
 	inline void ref() const
 	{
 		llassert(mRef != LL_REFCOUNT_FREE); // object is deleted
+		LL_REFCOUNT_AUDIT_RECORD(true);
 		mRef++;
 		llassert(mRef < gMaxRefCount); // ref count excessive, likely memory leak
 	}
@@ -62,6 +98,7 @@ public:
 	{
 		llassert(mRef != LL_REFCOUNT_FREE); // object is deleted
 		llassert(mRef > 0); // ref count below 1, likely corrupted
+		LL_REFCOUNT_AUDIT_RECORD(false);
 		if (0 == --mRef)
 		{
 			mRef = LL_REFCOUNT_FREE; // set to nonsense yet recognizable value to aid in debugging
@@ -80,6 +117,9 @@ public:
 
 private:
 	mutable S32	mRef;
+#if LL_REFCOUNT_AUDIT
+	mutable std::atomic<U32> mAuditThread{ 0 };
+#endif
 };
 
 
@@ -110,30 +150,39 @@ public:
 
 	void ref()
 	{
-		mRef++;
+		LL_REFCOUNT_AUDIT_RECORD(true);
+		// A new reference is only ever made from an existing one, which
+		// already orders everything before it, so this needs no fence
+		mRef.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	void unref()
 	{
-		llassert(mRef >= 1);
-		if ((--mRef) == 0)
+		llassert(mRef.load(std::memory_order_relaxed) >= 1);
+		LL_REFCOUNT_AUDIT_RECORD(false);
+		if (mRef.fetch_sub(1, std::memory_order_release) == 1)
 		{
 			// If we hit zero, the caller should be the only smart pointer owning the object and we can delete it.
 			// It is technically possible for a vanilla pointer to mess this up, or another thread to
 			// jump in, find this object, create another smart pointer and end up dangling, but if
 			// the code is that bad and not thread-safe, it's trouble already.
+			// Pairs with the release above on other threads, so their last
+			// use of the object happens before the delete.
+			std::atomic_thread_fence(std::memory_order_acquire);
 			delete this;
 		}
 	}
 
 	S32 getNumRefs() const
 	{
-		const S32 currentVal = mRef.CurrentValue();
-		return currentVal;
+		return mRef.load(std::memory_order_relaxed);
 	}
 
 private:
-	LLAtomicS32 mRef;
+	std::atomic<S32> mRef;
+#if LL_REFCOUNT_AUDIT
+	std::atomic<U32> mAuditThread{ 0 };
+#endif
 };
 
 /**
@@ -152,8 +152,63 @@ void ll_get_stack_trace_internal(std::vector<std::string>& lines)
 	free( symbol );
 }
 
+S32 ll_capture_stack_frames(void** frames, S32 max_depth, S32 skip)
+{
+	if (!RtlCaptureStackBackTrace_fn)
+	{
+		return 0;
+	}
+	// and this frame
+	return RtlCaptureStackBackTrace_fn(skip + 1, max_depth, frames, NULL);
+}
+
+std::string ll_describe_stack_frame(void* frame)
+{
+	const S32 STRING_NAME_LENGTH = 256;
+	static bool sInitialized = false;
+
+	HANDLE process = GetCurrentProcess();
+	if (!sInitialized)
+	{
+		SymInitialize(process, NULL, true);
+		sInitialized = true;
+	}
+
+	char buffer[sizeof(SYMBOL_INFO) + STRING_NAME_LENGTH];
+	memset(buffer, 0, sizeof(buffer));
+	SYMBOL_INFO* symbol = (SYMBOL_INFO*)buffer;
+	symbol->MaxNameLen = STRING_NAME_LENGTH - 1;
+	symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+
+	std::ostringstream out;
+	if (SymFromAddr(process, (DWORD64)frame, 0, symbol))
+	{
+		out << symbol->Name;
+	}
+	else
+	{
+		out << frame;
+	}
+
+	IMAGEHLP_LINE64 line;
+	memset(&line, 0, sizeof(IMAGEHLP_LINE64));
+	line.SizeOfStruct = sizeof(IMAGEHLP_LINE64);
+	DWORD displacement;
+	if (SymGetLineFromAddr64(process, (DWORD64)frame, &displacement, &line))
+	{
+		std::string file_name = line.FileName;
+		out << " " << file_name.substr(file_name.rfind("\\") + 1) << ":" << line.LineNumber;
+	}
+	return out.str();
+}
+
 #else
 
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sstream>
+
 bool ll_get_stack_trace(std::vector<std::string>& lines)
 {
 	return false;
@@ -164,5 +219,39 @@ void ll_get_stack_trace_internal(std::vector<std::string>& lines)
 
 }
 
+S32 ll_capture_stack_frames(void** frames, S32 max_depth, S32 skip)
+{
+	// and this frame
+	void* all[128];
+	S32 depth = backtrace(all, llmin(max_depth + skip + 1, 128));
+	S32 count = llmax(depth - skip - 1, 0);
+	memcpy(frames, all + skip + 1, count * sizeof(void*));
+	return count;
+}
+
+std::string ll_describe_stack_frame(void* frame)
+{
+	std::ostringstream out;
+	Dl_info info;
+	if (!dladdr(frame, &info))
+	{
+		out << frame;
+	}
+	else if (info.dli_sname)
+	{
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+		out << (demangled && !status ? demangled : info.dli_sname)
+			<< "+0x" << std::hex << ((char*)frame - (char*)info.dli_saddr);
+		free(demangled);
+	}
+	else
+	{
+		// not exported, the module and offset are enough for atos/addr2line
+		out << info.dli_fname << "+0x" << std::hex << ((char*)frame - (char*)info.dli_fbase);
+	}
+	return out.str();
+}
+
 #endif
 
@@ -36,5 +36,13 @@
 LL_COMMON_API bool ll_get_stack_trace(std::vector<std::string>& lines);
 LL_COMMON_API void ll_get_stack_trace_internal(std::vector<std::string>& lines);
 
+// Fills frames with up to max_depth return addresses of the calling thread,
+// skipping the innermost skip frames, and returns how many it found. Cheap
+// enough to call on a sampled allocation: no symbol lookup, no allocation
+// once warmed up.
+LL_COMMON_API S32 ll_capture_stack_frames(void** frames, S32 max_depth, S32 skip);
+// Symbol (and file:line where known) for an address from above
+LL_COMMON_API std::string ll_describe_stack_frame(void* frame);
+
 #endif
 
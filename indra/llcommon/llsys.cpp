@@ -41,6 +41,7 @@
 
 #include "llprocessor.h"
 #include "llerrorcontrol.h"
+#include "lleventchannel.h"
 #include "llevents.h"
 #include "llformat.h"
 #include "llregex.h"
@@ -915,9 +916,8 @@ class FrameWatcher
 public:
     FrameWatcher():
         // Hooking onto the "mainloop" event pump gets us one call per frame.
-        mConnection(LLEventPumps::instance()
-                    .obtain("mainloop")
-                    .listen("FrameWatcher", boost::bind(&FrameWatcher::tick, this, _1))),
+        mConnection(ll_mainloop_channel()
+                    .listen("FrameWatcher", boost::bind(&FrameWatcher::tick, this))),
         // Initializing mSampleStart to an invalid timestamp alerts us to skip
         // trying to compute framerate on the first call.
         mSampleStart(-1),
@@ -934,7 +934,7 @@ public:
         mSlowest(F32_MAX)
     {}
 
-    bool tick(const LLSD&)
+    bool tick()
     {
         F32 timestamp(mTimer.getElapsedTimeF32());
 
@@ -1030,9 +1030,9 @@ public:
     }
 
 private:
-    // Storing the connection in an LLTempBoundListener ensures it will be
+    // Storing the connection in an LLTempChannelConnection ensures it will be
     // disconnected when we're destroyed.
-    LLTempBoundListener mConnection;
+    LLTempChannelConnection mConnection;
     // Track elapsed time
     LLTimer mTimer;
     // Some of what you see here is in fact redundant with functionality you
@@ -33,6 +33,7 @@
 
 #include "lltimer.h"
 #include "lltrace.h"
+#include "lltraceeventlog.h"
 #include "lltracethreadrecorder.h"
 #include "llexception.h"
 
@@ -132,6 +133,7 @@ void LLThread::threadRun()
 #endif
 
     LL_PROFILER_SET_THREAD_NAME( mName.c_str() );
+    LLTrace::EventLog::setThreadName(mName);
 
     // this is the first point at which we're actually running in the new thread
     mID = currentID();
@@ -428,16 +430,16 @@ LLThreadSafeRefCount::LLThreadSafeRefCount() :
 {
 }
 
-LLThreadSafeRefCount::LLThreadSafeRefCount(const LLThreadSafeRefCount& src)
+LLThreadSafeRefCount::LLThreadSafeRefCount(const LLThreadSafeRefCount& src) :
+    mRef(0)
 {
-    mRef = 0;
 }
 
 LLThreadSafeRefCount::~LLThreadSafeRefCount()
 { 
-    if (mRef != 0)
+    if (mRef.load() != 0)
     {
-		LL_ERRS() << "deleting referenced object mRef = " << mRef << LL_ENDL;
+		LL_ERRS() << "deleting referenced object mRef = " << mRef.load() << LL_ENDL;
     }
 }
 
@@ -33,6 +33,7 @@
 #include "llmemory.h"
 #include "llrefcount.h"
 #include "lltraceaccumulators.h"
+#include "lltraceeventlog.h"
 #include "llthreadlocalstorage.h"
 #include "lltimer.h"
 #include "llpointer.h"
@@ -140,6 +141,10 @@ void record(EventStatHandle<T>& measurement, VALUE_T value)
 #if LL_TRACE_ENABLED
 	T converted_value(value);
 	measurement.getCurrentAccumulator().record(storage_value(converted_value));
+	if (EventLog::isRecording())
+	{
+		EventLog::recordValue(EventLog::EVENT, measurement, storage_value(converted_value));
+	}
 #endif
 }
 
@@ -165,6 +170,10 @@ void sample(SampleStatHandle<T>& measurement, VALUE_T value)
 #if LL_TRACE_ENABLED
 	T converted_value(value);
 	measurement.getCurrentAccumulator().sample(storage_value(converted_value));
+	if (EventLog::isRecording())
+	{
+		EventLog::recordValue(EventLog::SAMPLE, measurement, storage_value(converted_value));
+	}
 #endif
 }
 
@@ -190,6 +199,10 @@ void add(CountStatHandle<T>& count, VALUE_T value)
 #if LL_TRACE_ENABLED
 	T converted_value(value);
 	count.getCurrentAccumulator().add(storage_value(converted_value));
+	if (EventLog::isRecording())
+	{
+		EventLog::recordValue(EventLog::COUNT, count, storage_value(converted_value));
+	}
 #endif
 }
 
@@ -128,7 +128,8 @@ void AccumulatorBufferGroup::append( const AccumulatorBufferGroup& other )
 void AccumulatorBufferGroup::merge( const AccumulatorBufferGroup& other)
 {
 	mCounts.addSamples(other.mCounts, NON_SEQUENTIAL);
-	mSamples.addSamples(other.mSamples, NON_SEQUENTIAL);
+	// samples from other threads aren't merged (see SampleAccumulator::addSamples),
+	// skip the pass over them, this runs for every child thread every frame
 	mEvents.addSamples(other.mEvents, NON_SEQUENTIAL);
 	mMemStats.addSamples(other.mMemStats, NON_SEQUENTIAL);
 	// for now, hold out timers from merge, need to be displayed per thread
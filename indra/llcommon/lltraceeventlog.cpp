@@ -0,0 +1,417 @@
+/**
+ * @file lltraceeventlog.cpp
+ * @brief Per-thread recording of block timer and stat events to a binary trace file
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltraceeventlog.h"
+
+#include "llfasttimer.h"
+#include "lltrace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Stream format, all integers little-endian:
+//
+//   header:  "LLTRACE\0", U32 version, U64 clock counts per second
+//
+// then records, each starting with a tag byte:
+//
+//   'T'  thread:  varint thread, varint length, name
+//   'N'  name:    varint id, U8 event type of first use,
+//                 varint length, name, varint length, unit label
+//   'E'  events:  varint thread, varint count, then count of
+//                   U8 type, varint name id,
+//                   zigzag varint clock counts since the previous
+//                     event in the record (since zero for the first),
+//                   F64 value for COUNT, SAMPLE and EVENT
+//   'D'  dropped: varint thread, varint events lost since the last 'D'
+//
+// A stream may be cut off anywhere, readers should keep what they
+// got from complete records.
+
+namespace LLTrace
+{
+
+std::atomic<bool> EventLog::sRecording(false);
+
+namespace
+{
+
+struct Event
+{
+	U64				mTime;
+	const StatBase*	mStat;
+	F64				mValue;
+	U32				mType;
+};
+
+// One thread's events.  The owning thread pushes, the writer pops.
+class EventRing
+{
+public:
+	static const U32 CAPACITY = 16384;		// power of two
+
+	explicit EventRing(U32 thread)
+	:	mOrphaned(false),
+		mDropped(0),
+		mThread(thread),
+		mNameWritten(false),
+		mDroppedWritten(0),
+		mEvents(CAPACITY),
+		mHead(0),
+		mTail(0)
+	{}
+
+	void push(const Event& event)
+	{
+		const U32 tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHead.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			mDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		mEvents[tail & (CAPACITY - 1)] = event;
+		mTail.store(tail + 1, std::memory_order_release);
+	}
+
+	// Appends what's there now
+	void drain(std::vector<Event>& events)
+	{
+		U32 head = mHead.load(std::memory_order_relaxed);
+		const U32 tail = mTail.load(std::memory_order_acquire);
+		for ( ; head != tail; ++head)
+		{
+			events.push_back(mEvents[head & (CAPACITY - 1)]);
+		}
+		mHead.store(head, std::memory_order_release);
+	}
+
+	bool empty() const
+	{
+		return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+	}
+
+	std::atomic<bool>	mOrphaned;			// owning thread has exited
+	std::atomic<U64>	mDropped;
+	const U32			mThread;
+
+	// guarded by ringsMutex()
+	std::string			mName;
+	bool				mNameWritten;
+
+	// writer only
+	U64					mDroppedWritten;
+
+private:
+	std::vector<Event>	mEvents;
+	std::atomic<U32>	mHead;
+	std::atomic<U32>	mTail;
+};
+
+typedef std::shared_ptr<EventRing> EventRingPtr;
+
+std::mutex& ringsMutex()
+{
+	static std::mutex sMutex;
+	return sMutex;
+}
+
+// guarded by ringsMutex()
+std::vector<EventRingPtr>& rings()
+{
+	static std::vector<EventRingPtr> sRings;
+	return sRings;
+}
+
+// guarded by ringsMutex()
+U32 sNextThread = 0;
+U64 sDroppedRetired = 0;		// by threads whose rings are gone
+
+// written only by write(), with sWriteMutex held
+std::mutex sWriteMutex;
+std::map<const StatBase*, U32> sNameIds;
+std::vector<Event> sEvents;
+std::string sBuffer;
+
+struct EventRingHolder
+{
+	~EventRingHolder()
+	{
+		if (mRing)
+		{
+			mRing->mOrphaned = true;
+		}
+	}
+
+	// Rings are only made for threads that record something, the
+	// name waits here until then
+	std::string mName;
+	EventRingPtr mRing;
+};
+
+EventRingHolder& thread_holder()
+{
+	static thread_local EventRingHolder sHolder;
+	return sHolder;
+}
+
+EventRing& thread_ring()
+{
+	EventRingHolder& holder(thread_holder());
+	if (! holder.mRing)
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex());
+		holder.mRing = std::make_shared<EventRing>(sNextThread++);
+		holder.mRing->mName = holder.mName;
+		rings().push_back(holder.mRing);
+	}
+	return *holder.mRing;
+}
+
+void put_u8(std::string& out, U8 value)
+{
+	out.push_back(char(value));
+}
+
+void put_u32(std::string& out, U32 value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		out.push_back(char(value >> (8 * i)));
+	}
+}
+
+void put_u64(std::string& out, U64 value)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		out.push_back(char(value >> (8 * i)));
+	}
+}
+
+void put_f64(std::string& out, F64 value)
+{
+	U64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	put_u64(out, bits);
+}
+
+void put_varint(std::string& out, U64 value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(char(0x80 | (value & 0x7f)));
+		value >>= 7;
+	}
+	out.push_back(char(value));
+}
+
+void put_string(std::string& out, const std::string& value)
+{
+	put_varint(out, value.size());
+	out.append(value);
+}
+
+} // anonymous namespace
+
+//static
+void EventLog::start()
+{
+	if (thread_holder().mName.empty())
+	{
+		setThreadName("main");
+	}
+	sRecording = true;
+}
+
+//static
+void EventLog::stop()
+{
+	sRecording = false;
+}
+
+//static
+void EventLog::setThreadName(const std::string& name)
+{
+	EventRingHolder& holder(thread_holder());
+	holder.mName = name;
+	if (holder.mRing)
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex());
+		holder.mRing->mName = name;
+		holder.mRing->mNameWritten = false;
+	}
+}
+
+//static
+void EventLog::recordBlock(EType type, const StatBase& stat, U64 time)
+{
+	Event event = { time, &stat, 0.0, U32(type) };
+	thread_ring().push(event);
+}
+
+//static
+void EventLog::recordValue(EType type, const StatBase& stat, F64 value)
+{
+	Event event = { BlockTimer::getCPUClockCount64(), &stat, value, U32(type) };
+	thread_ring().push(event);
+}
+
+//static
+void EventLog::writeHeader(std::ostream& os)
+{
+	// New stream, names have to be written again
+	std::lock_guard<std::mutex> write_lock(sWriteMutex);
+	sNameIds.clear();
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex());
+		for (EventRingPtr& ring : rings())
+		{
+			ring->mNameWritten = false;
+		}
+	}
+
+	std::string header("LLTRACE", 8);
+	put_u32(header, VERSION);
+	put_u64(header, BlockTimer::countsPerSecond());
+	os.write(header.data(), header.size());
+}
+
+//static
+void EventLog::write(std::ostream& os)
+{
+	std::lock_guard<std::mutex> write_lock(sWriteMutex);
+
+	std::vector<EventRingPtr> current;
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex());
+		current = rings();
+	}
+
+	for (EventRingPtr& ring : current)
+	{
+		sBuffer.clear();
+		{
+			std::lock_guard<std::mutex> lock(ringsMutex());
+			if (! ring->mNameWritten)
+			{
+				std::string name(ring->mName);
+				if (name.empty())
+				{
+					name = "thread " + std::to_string(ring->mThread);
+				}
+				put_u8(sBuffer, 'T');
+				put_varint(sBuffer, ring->mThread);
+				put_string(sBuffer, name);
+				ring->mNameWritten = true;
+			}
+		}
+
+		sEvents.clear();
+		ring->drain(sEvents);
+
+		// Names first so a reader knows them by the time it sees the events
+		for (const Event& event : sEvents)
+		{
+			if (sNameIds.find(event.mStat) == sNameIds.end())
+			{
+				const U32 id(U32(sNameIds.size()));
+				sNameIds[event.mStat] = id;
+				put_u8(sBuffer, 'N');
+				put_varint(sBuffer, id);
+				put_u8(sBuffer, U8(event.mType));
+				put_string(sBuffer, event.mStat->getName());
+				put_string(sBuffer, event.mStat->getUnitLabel());
+			}
+		}
+
+		if (! sEvents.empty())
+		{
+			put_u8(sBuffer, 'E');
+			put_varint(sBuffer, ring->mThread);
+			put_varint(sBuffer, sEvents.size());
+			U64 last(0);
+			for (const Event& event : sEvents)
+			{
+				// zigzag, clocks aren't always monotonic across cores
+				const S64 delta(S64(event.mTime - last));
+				last = event.mTime;
+
+				put_u8(sBuffer, U8(event.mType));
+				put_varint(sBuffer, sNameIds[event.mStat]);
+				put_varint(sBuffer, (U64(delta) << 1) ^ U64(delta >> 63));
+				if (event.mType != BLOCK_BEGIN && event.mType != BLOCK_END)
+				{
+					put_f64(sBuffer, event.mValue);
+				}
+			}
+		}
+
+		const U64 dropped(ring->mDropped.load(std::memory_order_relaxed));
+		if (dropped != ring->mDroppedWritten)
+		{
+			put_u8(sBuffer, 'D');
+			put_varint(sBuffer, ring->mThread);
+			put_varint(sBuffer, dropped - ring->mDroppedWritten);
+			ring->mDroppedWritten = dropped;
+		}
+
+		os.write(sBuffer.data(), sBuffer.size());
+	}
+
+	// Forget threads that have gone, once everything they left is out
+	std::lock_guard<std::mutex> lock(ringsMutex());
+	std::vector<EventRingPtr>& all(rings());
+	std::vector<EventRingPtr>::iterator retired(
+		std::partition(all.begin(), all.end(),
+					   [](const EventRingPtr& ring)
+					   { return ! ring->mOrphaned || ! ring->empty(); }));
+	for (std::vector<EventRingPtr>::iterator it = retired; it != all.end(); ++it)
+	{
+		sDroppedRetired += (*it)->mDropped.load(std::memory_order_relaxed);
+	}
+	all.erase(retired, all.end());
+}
+
+//static
+U64 EventLog::getDropCount()
+{
+	std::lock_guard<std::mutex> lock(ringsMutex());
+	U64 dropped(sDroppedRetired);
+	for (const EventRingPtr& ring : rings())
+	{
+		dropped += ring->mDropped.load(std::memory_order_relaxed);
+	}
+	return dropped;
+}
+
+}
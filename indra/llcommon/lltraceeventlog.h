@@ -0,0 +1,99 @@
+/**
+ * @file lltraceeventlog.h
+ * @brief Per-thread recording of block timer and stat events to a binary trace file
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTRACEEVENTLOG_H
+#define LL_LLTRACEEVENTLOG_H
+
+#include "stdtypes.h"
+
+#include <atomic>
+#include <iosfwd>
+#include <string>
+
+namespace LLTrace
+{
+class StatBase;
+
+// Records every block timer entry and exit and every stat value, with
+// the thread and time it happened, so that a capture can be viewed as
+// a timeline of all threads rather than as per-frame totals.
+//
+// Each thread appends to its own fixed-size buffer without locking.
+// A logging thread calls write() every few tens of milliseconds to
+// drain the buffers into a compact binary stream, see
+// scripts/metrics/lltrace_conv.py to turn that into Chrome trace JSON
+// for chrome://tracing or Perfetto.  Events that don't fit in a full
+// buffer are dropped and the count is written to the stream.
+//
+// Costs a relaxed atomic load per timer or stat while not recording.
+class LL_COMMON_API EventLog
+{
+public:
+	enum EType
+	{
+		BLOCK_BEGIN = 1,
+		BLOCK_END,
+		COUNT,		// CountStatHandle add()
+		SAMPLE,		// SampleStatHandle sample()
+		EVENT		// EventStatHandle record()
+	};
+
+	// Stream format version, bump on any change and teach the converter
+	static const U32 VERSION = 1;
+
+	static bool isRecording()
+	{
+		return sRecording.load(std::memory_order_relaxed);
+	}
+
+	// The calling thread is named "main" if it hasn't been named
+	static void start();
+	// Events already buffered are kept for the next write()
+	static void stop();
+
+	// Name the calling thread in traces.  Unnamed threads are
+	// "thread <n>".
+	static void setThreadName(const std::string& name);
+
+	// time in BlockTimer::getCPUClockCount64() units
+	static void recordBlock(EType type, const StatBase& stat, U64 time);
+	static void recordValue(EType type, const StatBase& stat, F64 value);
+
+	// Call once per stream, before the first write().  Only one
+	// stream at a time.
+	static void writeHeader(std::ostream& os);
+	// Drain every thread's buffer.  One writer at a time.
+	static void write(std::ostream& os);
+
+	static U64 getDropCount();
+
+private:
+	static std::atomic<bool> sRecording;
+};
+
+}
+
+#endif // LL_LLTRACEEVENTLOG_H
@@ -41,7 +41,9 @@ static ThreadRecorder* sMasterThreadRecorder = NULL;
 ///////////////////////////////////////////////////////////////////////
 
 ThreadRecorder::ThreadRecorder()
-:	mParentRecorder(NULL)
+:	mPublishedRecordingBuffers(NULL),
+	mSpareRecordingBuffers(NULL),
+	mParentRecorder(NULL)
 {
 	init();
 }
@@ -89,7 +91,9 @@ void ThreadRecorder::init()
 
 
 ThreadRecorder::ThreadRecorder( ThreadRecorder& parent )
-:	mParentRecorder(&parent)
+:	mPublishedRecordingBuffers(NULL),
+	mSpareRecordingBuffers(NULL),
+	mParentRecorder(&parent)
 {
 	init();
 	mParentRecorder->addChildRecorder(this);
@@ -122,6 +126,10 @@ ThreadRecorder::~ThreadRecorder()
 	{
 		mParentRecorder->removeChildRecorder(this);
 	}
+
+	// parent can't reach these any more
+	delete mPublishedRecordingBuffers.exchange(NULL);
+	delete mSpareRecordingBuffers.exchange(NULL);
 #endif
 }
 
@@ -265,11 +273,23 @@ void ThreadRecorder::removeChildRecorder( class ThreadRecorder* child )
 void ThreadRecorder::pushToParent()
 {
 #if LL_TRACE_ENABLED
-	{ LLMutexLock lock(&mSharedRecordingMutex);	
-		LLTrace::get_thread_recorder()->bringUpToDate(&mThreadRecordingBuffers);
-		mSharedRecordingBuffers.append(mThreadRecordingBuffers);
-		mThreadRecordingBuffers.reset();
+	LLTrace::get_thread_recorder()->bringUpToDate(&mThreadRecordingBuffers);
+
+	// Take back whatever the parent hasn't pulled yet and add to it, so
+	// nothing waits for a pull, otherwise start on an empty buffer
+	AccumulatorBufferGroup* published = mPublishedRecordingBuffers.exchange(NULL, std::memory_order_acquire);
+	if (!published)
+	{
+		published = mSpareRecordingBuffers.exchange(NULL, std::memory_order_acquire);
+		if (!published)
+		{
+			published = new AccumulatorBufferGroup();
+		}
 	}
+	published->append(mThreadRecordingBuffers);
+	mThreadRecordingBuffers.reset();
+
+	mPublishedRecordingBuffers.store(published, std::memory_order_release);
 #endif
 }
 
@@ -284,10 +304,19 @@ void ThreadRecorder::pullFromChildren()
 		AccumulatorBufferGroup& target_recording_buffers = mActiveRecordings.back()->mPartialRecording;
 		target_recording_buffers.sync();
 		for (LLTrace::ThreadRecorder* rec : mChildThreadRecorders)
-		{ LLMutexLock lock(&(rec->mSharedRecordingMutex));
-
-			target_recording_buffers.merge(rec->mSharedRecordingBuffers);
-			rec->mSharedRecordingBuffers.reset();
+		{
+			// A child pushing right now has it, we'll get it next time
+			AccumulatorBufferGroup* published = rec->mPublishedRecordingBuffers.exchange(NULL, std::memory_order_acquire);
+			if (!published) continue;
+
+			target_recording_buffers.merge(*published);
+			published->reset();
+
+			AccumulatorBufferGroup* no_spare = NULL;
+			if (!rec->mSpareRecordingBuffers.compare_exchange_strong(no_spare, published, std::memory_order_release))
+			{
+				delete published;
+			}
 		}
 	}
 #endif
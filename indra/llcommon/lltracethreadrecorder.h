@@ -34,6 +34,8 @@
 #include "llmutex.h"
 #include "lltraceaccumulators.h"
 
+#include <atomic>
+
 namespace LLTrace
 {
 	class LL_COMMON_API ThreadRecorder
@@ -56,6 +58,7 @@ namespace LLTrace
 
 		// call this periodically to gather stats data from child threads
 		void pullFromChildren();
+		// Children publish with an atomic swap and never wait on the parent
 		void pushToParent();
 
 		TimeBlockTreeNode* getTimeBlockTreeNode(size_t index);
@@ -86,8 +89,12 @@ namespace LLTrace
 
 		child_thread_recorder_list_t	mChildThreadRecorders;	// list of child thread recorders associated with this master
 		LLMutex							mChildListMutex;		// protects access to child list
-		LLMutex							mSharedRecordingMutex;
-		AccumulatorBufferGroup			mSharedRecordingBuffers;
+		// Data pushed by this thread that the parent hasn't pulled yet.
+		// Either side takes it by swapping in NULL, only the owning
+		// thread puts it back.
+		std::atomic<AccumulatorBufferGroup*>	mPublishedRecordingBuffers;
+		// Emptied by the parent for the next push to reuse
+		std::atomic<AccumulatorBufferGroup*>	mSpareRecordingBuffers;
 		ThreadRecorder*					mParentRecorder;
 
 	};
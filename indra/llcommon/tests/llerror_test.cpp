@@ -25,6 +25,15 @@
  * $/LicenseInfo$
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <stdexcept>
 
@@ -918,6 +927,236 @@ namespace tut
     }
 }
 
+namespace
+{
+	void writeSequence(int count)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			LL_INFOS("AsyncTest") << "message " << i << LL_ENDL;
+		}
+	}
+
+	// Blocks the writer in recordMessage() until released
+	class BlockingRecorder : public LLError::Recorder
+	{
+	public:
+		BlockingRecorder()
+			: mEntered(false)
+		{
+			showTime(false);
+		}
+
+		virtual void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			mEntered = true;
+			std::lock_guard<std::mutex> lock(mGate);
+		}
+
+		std::mutex mGate;
+		std::atomic<bool> mEntered;
+	};
+
+	// Something like RecordToFile with always-flush on
+	class FileRecorder : public LLError::Recorder
+	{
+	public:
+		FileRecorder()
+			: mFile(std::tmpfile()),
+			  mCount(0)
+		{
+		}
+
+		virtual ~FileRecorder()
+		{
+			if (mFile)
+			{
+				fclose(mFile);
+			}
+		}
+
+		virtual void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			++mCount;
+			if (mFile)
+			{
+				fputs(message.c_str(), mFile);
+				fputc('\n', mFile);
+				fflush(mFile);
+			}
+		}
+
+		FILE* mFile;
+		int mCount;
+	};
+}
+
+namespace tut
+{
+	template<> template<>
+		// asynchronous logging delivers everything, in order
+	void ErrorTestObject::test<19>()
+	{
+		LLError::setTimeFunction(roswell);
+		setWantsTime(true);
+		LLError::setAsyncLogging(true);
+		ensure("async on", LLError::getAsyncLogging());
+
+		writeSequence(100);
+		LLError::flushAsyncLogging();
+
+		ensure_message_count(100);
+		for (int i = 0; i < 100; ++i)
+		{
+			std::ostringstream expected;
+			expected << "message " << i;
+			ensure_message_field_equals(i, MSG_FIELD, expected.str());
+			// stamped when logged, not when written
+			ensure_message_field_equals(i, TIME_FIELD, roswell());
+		}
+
+		// and from several threads
+		clearMessages();
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([]{ writeSequence(200); });
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		LLError::setAsyncLogging(false);
+		ensure("async off", ! LLError::getAsyncLogging());
+		ensure_message_count(800);
+		ensure_equals("nothing dropped", LLError::getAsyncLogDropCount(), U64(0));
+	}
+
+	template<> template<>
+		// LL_ERRS goes out synchronously, after what was queued before it
+	void ErrorTestObject::test<20>()
+	{
+		LLError::setAsyncLogging(true);
+		writeSequence(10);
+		std::string location = errorReturningLocation();
+
+		ensure_message_count(11);
+		ensure_message_field_equals(9, MSG_FIELD, "message 9");
+		ensure_message_field_equals(10, LOCATION_FIELD, location);
+		ensure_message_field_equals(10, MSG_FIELD, "die");
+		ensure("fatal callback called", fatalWasCalled);
+		LLError::setAsyncLogging(false);
+	}
+
+	template<> template<>
+		// a full buffer drops and counts messages rather than blocking
+	void ErrorTestObject::test<21>()
+	{
+		std::shared_ptr<BlockingRecorder> blocker(new BlockingRecorder());
+		LLError::addRecorder(blocker);
+		const U64 dropped_before(LLError::getAsyncLogDropCount());
+
+		LLError::setAsyncLogging(true);
+		std::unique_lock<std::mutex> gate(blocker->mGate);
+		LL_INFOS("AsyncTest") << "first" << LL_ENDL;
+		while (! blocker->mEntered)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// writer is stuck, this thread's buffer holds 1024
+		writeSequence(3000);
+		gate.unlock();
+		LLError::setAsyncLogging(false);
+		LLError::removeRecorder(blocker);
+
+		const U64 dropped(LLError::getAsyncLogDropCount() - dropped_before);
+		ensure("dropped some", dropped >= 3000 - 1024);
+		// what was kept, plus a warning about what wasn't
+		ensure_message_count(int(1 + 3000 - dropped + 1));
+		bool reported = false;
+		for (int i = 0; i < countMessages(); ++i)
+		{
+			reported = reported || message(i).find("dropped") != std::string::npos;
+		}
+		ensure("drop reported", reported);
+	}
+
+	template<> template<>
+		// throughput and caller latency, synchronous vs. asynchronous
+	void ErrorTestObject::test<22>()
+	{
+		// Timing-dependent, not for every build.  Set LL_ERROR_BENCHMARK
+		// to run it.
+		if (! getenv("LL_ERROR_BENCHMARK"))
+		{
+			skip("set LL_ERROR_BENCHMARK to run");
+		}
+
+		typedef std::chrono::steady_clock clock;
+		const int MESSAGES = 64000;
+
+		LLError::removeRecorder(mRecorder);
+		std::shared_ptr<FileRecorder> file(new FileRecorder());
+		LLError::addRecorder(file);
+		LLError::setTimeFunction(LLError::utcTime);
+
+		std::cout << "\nthreads    mode   msgs/s  median us    p99 us   written  dropped\n";
+		for (int async = 0; async < 2; ++async)
+		{
+			for (int nthreads = 1; nthreads <= 16; nthreads *= 2)
+			{
+				LLError::setAsyncLogging(async != 0);
+				file->mCount = 0;
+				const U64 dropped_before(LLError::getAsyncLogDropCount());
+				std::vector<std::vector<double> > latencies(nthreads);
+
+				const clock::time_point start(clock::now());
+				std::vector<std::thread> threads;
+				for (int t = 0; t < nthreads; ++t)
+				{
+					std::vector<double>& samples(latencies[t]);
+					threads.emplace_back([&samples, nthreads, MESSAGES]()
+					{
+						const int count(MESSAGES / nthreads);
+						samples.reserve(count);
+						for (int i = 0; i < count; ++i)
+						{
+							const clock::time_point before(clock::now());
+							LL_INFOS("Benchmark") << "message " << i << " of " << count << LL_ENDL;
+							samples.push_back(std::chrono::duration<double, std::micro>(clock::now() - before).count());
+						}
+					});
+				}
+				for (std::thread& thread : threads)
+				{
+					thread.join();
+				}
+				LLError::setAsyncLogging(false);
+				const double seconds(std::chrono::duration<double>(clock::now() - start).count());
+
+				std::vector<double> all;
+				for (const std::vector<double>& samples : latencies)
+				{
+					all.insert(all.end(), samples.begin(), samples.end());
+				}
+				std::sort(all.begin(), all.end());
+
+				std::cout << std::setw(7) << nthreads
+						  << std::setw(8) << (async ? "async" : "sync")
+						  << std::setw(9) << int(MESSAGES / seconds)
+						  << std::setw(11) << std::fixed << std::setprecision(2) << all[all.size() / 2]
+						  << std::setw(10) << all[all.size() * 99 / 100]
+						  << std::setw(10) << file->mCount
+						  << std::setw(9) << (LLError::getAsyncLogDropCount() - dropped_before)
+						  << std::endl;
+			}
+		}
+
+		LLError::removeRecorder(file);
+	}
+}
+
 /* Tests left:
 	handling of classes without LOG_CLASS
 
@@ -0,0 +1,298 @@
+/**
+ * @file   lleventchannel_test.cpp
+ * @brief  Test for LLEventChannel
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lleventchannel.h"
+// STL headers
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "stringize.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock timer_clock_t;
+
+    F64 seconds_since(timer_clock_t::time_point start)
+    {
+        return std::chrono::duration<F64>(timer_clock_t::now() - start).count();
+    }
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct channel_data
+    {
+        std::vector<std::string> mCalls;
+    };
+    typedef test_group<channel_data> channel_group;
+    typedef channel_group::object object;
+    channel_group channelgrp("LLEventChannel");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("listeners, names and handling");
+        LLEventChannel<S32, std::string> channel("test");
+        ensure("nobody listening", ! channel.post(1, "one"));
+
+        LLTempChannelConnection first = channel.listen("first", [this](S32 n, const std::string& s)
+        {
+            mCalls.push_back(STRINGIZE("first " << n << ' ' << s));
+            return false;
+        });
+        // a void listener never handles the event
+        LLTempChannelConnection second = channel.listen("second", [this](S32 n, const std::string&)
+        {
+            mCalls.push_back(STRINGIZE("second " << n));
+        });
+        ensure("not handled", ! channel.post(2, "two"));
+        ensure_equals("both called", mCalls.size(), size_t(2));
+        ensure_equals("in order", mCalls[0], std::string("first 2 two"));
+        ensure_equals("second", mCalls[1], std::string("second 2"));
+
+        std::string threw;
+        try
+        {
+            channel.listen("first", [](S32, const std::string&) { return false; });
+        }
+        catch (const LLEventPump::DupListenerName& e)
+        {
+            threw = e.what();
+        }
+        ensure_contains("duplicate name", threw, "DupListenerName");
+        LLTempChannelConnection anon1 = channel.listen(LLEventPump::ANONYMOUS, [](S32, const std::string&) {});
+        LLTempChannelConnection anon2 = channel.listen(LLEventPump::ANONYMOUS, [](S32, const std::string&) {});
+        ensure_equals("anonymous listeners may repeat", channel.size(), size_t(4));
+
+        // a listener returning true stops the ones after it
+        channel.stopListening("second");
+        LLTempChannelConnection handler = channel.listen("handler", [](S32, const std::string&) { return true; });
+        LLTempChannelConnection after = channel.listen("after", [this](S32, const std::string&)
+        {
+            mCalls.push_back("after");
+            return false;
+        });
+        mCalls.clear();
+        ensure("handled", channel.post(3, "three"));
+        ensure_equals("only first", mCalls.size(), size_t(1));
+
+        channel.enable(false);
+        ensure("disabled", ! channel.post(4, "four"));
+        ensure_equals("nothing called", mCalls.size(), size_t(1));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("connecting and disconnecting during post()");
+        LLEventChannel<S32> channel("test");
+        LLChannelConnection self, other, added;
+        self = channel.listen("self", [this, &self](S32)
+        {
+            mCalls.push_back("self");
+            self.disconnect();
+        });
+        channel.listen("adder", [this, &channel, &added](S32 n)
+        {
+            mCalls.push_back("adder");
+            if (n == 1)
+            {
+                added = channel.listen("added", [this](S32) { mCalls.push_back("added"); });
+            }
+        });
+        channel.listen("killer", [this, &other](S32)
+        {
+            mCalls.push_back("killer");
+            other.disconnect();
+        });
+        other = channel.listen("other", [this](S32) { mCalls.push_back("other"); });
+
+        channel.post(1);
+        ensure_equals("first post", mCalls.size(), size_t(3));
+        ensure_equals("self", mCalls[0], std::string("self"));
+        ensure_equals("added listener waits", mCalls[2], std::string("killer"));
+        ensure("self gone", ! self.connected());
+        ensure("other gone", ! other.connected());
+        ensure("added", added.connected());
+        ensure_equals("size", channel.size(), size_t(3));
+
+        mCalls.clear();
+        channel.post(2);
+        ensure_equals("second post", mCalls.size(), size_t(3));
+        ensure_equals("added called", mCalls[2], std::string("added"));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("connections outliving their channel");
+        LLChannelConnection connection;
+        {
+            LLTempChannelConnection temp;
+            {
+                LLEventChannel<> channel("test");
+                connection = channel.listen("plain", []() { return false; });
+                temp = channel.listen("temp", []() { return false; });
+                ensure("connected", connection.connected() && temp.connected());
+                {
+                    LLTempChannelConnection scoped = channel.listen("scoped", []() { return false; });
+                    ensure_equals("three", channel.size(), size_t(3));
+                }
+                ensure_equals("scoped gone", channel.size(), size_t(2));
+            }
+            ensure("channel gone", ! connection.connected());
+        }
+        connection.disconnect();
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("bridged to an LLEventPump");
+        LLEventChannel<S32> channel("bridged");
+        channel.bridge("LLEventChannelTest",
+                       [](S32 n) { return LLSD::Integer(n); },
+                       [](const LLSD& event) { return std::make_tuple(S32(event.asInteger())); });
+        LLEventPump& pump(LLEventPumps::instance().obtain("LLEventChannelTest"));
+
+        std::vector<S32> typed, boxed;
+        LLTempChannelConnection typed_listener = channel.listen("typed", [&typed](S32 n)
+        {
+            typed.push_back(n);
+            return n == 3;
+        });
+        LLTempBoundListener boxed_listener = pump.listen("boxed", [&boxed](const LLSD& event)
+        {
+            boxed.push_back(event.asInteger());
+            return false;
+        });
+
+        channel.post(1);
+        ensure_equals("typed saw it", typed.size(), size_t(1));
+        ensure_equals("so did the pump", boxed.size(), size_t(1));
+        ensure_equals("value", boxed[0], 1);
+
+        // posted to the pump, the typed listeners see it once
+        pump.post(2);
+        ensure_equals("typed saw pump event", typed.size(), size_t(2));
+        ensure_equals("pumped value", typed[1], 2);
+        ensure_equals("boxed saw pump event", boxed.size(), size_t(2));
+
+        // handled by a typed listener, it doesn't reach the pump
+        ensure("handled", channel.post(3));
+        ensure_equals("not boxed", boxed.size(), size_t(2));
+
+        // LLEventPumps::clear() drops the bridge, the next listen() restores it
+        LLEventPumps::instance().clear();
+        LLTempChannelConnection later = channel.listen("later", [](S32) {});
+        pump.post(4);
+        ensure_equals("bridge restored", typed.size(), size_t(4));
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("mainloop channel");
+        S32 ticks = 0;
+        LLTempChannelConnection tick = ll_mainloop_channel().listen("tick", [&ticks]() { ++ticks; });
+        S32 pumped = 0;
+        LLTempBoundListener pump = LLEventPumps::instance().obtain("mainloop").listen("pumped",
+            [&pumped](const LLSD&) { ++pumped; return false; });
+
+        ll_mainloop_channel().post();
+        ensure_equals("channel tick", ticks, 1);
+        ensure_equals("pump tick", pumped, 1);
+        // the way tests and LEAP drive "mainloop"
+        LLEventPumps::instance().obtain("mainloop").post(LLSD());
+        ensure_equals("pump post ticks the channel", ticks, 2);
+        ensure_equals("and the pump", pumped, 2);
+    }
+
+    template<> template<>
+    void object::test<6>()
+    {
+        set_test_name("post() against LLEventStream");
+
+        if (! getenv("LL_EVENTCHANNEL_BENCHMARK"))
+        {
+            skip("set LL_EVENTCHANNEL_BENCHMARK to compare with LLEventStream");
+        }
+
+        const S32 POSTS = 1000000;
+        const size_t counts[] = { 0, 1, 10 };
+        S64 sum = 0;
+        for (size_t listeners : counts)
+        {
+            LLEventStream stream("LLEventChannelBenchmark", true);
+            LLEventChannel<S32> channel("benchmark");
+            std::vector<LLTempBoundListener> boxed;
+            std::vector<LLTempChannelConnection> typed;
+            for (size_t i = 0; i < listeners; ++i)
+            {
+                boxed.emplace_back(stream.listen(LLEventPump::inventName("boxed"), [&sum](const LLSD& event)
+                {
+                    sum += event.asInteger();
+                    return false;
+                }));
+                typed.emplace_back(channel.listen(LLEventPump::inventName("typed"), [&sum](S32 n)
+                {
+                    sum += n;
+                    return false;
+                }));
+            }
+
+            timer_clock_t::time_point start = timer_clock_t::now();
+            for (S32 i = 0; i < POSTS; ++i)
+            {
+                stream.post(LLSD::Integer(i));
+            }
+            const F64 stream_ns = seconds_since(start) * 1e9 / POSTS;
+
+            start = timer_clock_t::now();
+            for (S32 i = 0; i < POSTS; ++i)
+            {
+                channel.post(i);
+            }
+            const F64 channel_ns = seconds_since(start) * 1e9 / POSTS;
+
+            std::cout << "\n" << listeners << " listeners: LLEventStream " << stream_ns
+                      << " ns, LLEventChannel " << channel_ns << " ns per post()";
+        }
+        std::cout << std::endl;
+        ensure("did something", sum != 0);
+    }
+} // namespace tut
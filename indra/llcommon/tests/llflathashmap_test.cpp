@@ -0,0 +1,342 @@
+/**
+ * @file   llflathashmap_test.cpp
+ * @brief  Test for llflathashmap, with a lookup benchmark against the
+ *         standard containers.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llflathashmap.h"
+// STL headers
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+// other Linden headers
+#include "lluuid.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    // everything collides, to exercise displacement and backward shift
+    struct ConstantHash
+    {
+        size_t operator()(U32) const { return 42; }
+    };
+
+    // (region index, local id) as packed by LLViewerObjectList
+    U64 index_id(U32 index, U32 local_id)
+    {
+        return ((U64)index << 32) | local_id;
+    }
+
+    typedef std::chrono::steady_clock clock_t;
+
+    F64 seconds_since(clock_t::time_point start)
+    {
+        return std::chrono::duration<F64>(clock_t::now() - start).count();
+    }
+
+    // Times insert, hit, miss and erase over keys for one container type.
+    // lookup(map, key) returns a pointer to the value or nullptr.
+    template <typename MAP, typename KEY, typename VALUE, typename LOOKUP>
+    void benchmark(const char* name, const std::vector<KEY>& keys,
+                   const std::vector<KEY>& misses, const VALUE& value, LOOKUP lookup)
+    {
+        const S32 ROUNDS = 10;
+        F64 insert = 0.0, hit = 0.0, miss = 0.0, erase = 0.0;
+        size_t found = 0;
+        for (S32 round = 0; round < ROUNDS; ++round)
+        {
+            MAP map;
+            clock_t::time_point start = clock_t::now();
+            for (const KEY& key : keys)
+            {
+                map[key] = value;
+            }
+            insert += seconds_since(start);
+
+            start = clock_t::now();
+            for (const KEY& key : keys)
+            {
+                found += lookup(map, key) != nullptr;
+            }
+            hit += seconds_since(start);
+
+            start = clock_t::now();
+            for (const KEY& key : misses)
+            {
+                found += lookup(map, key) != nullptr;
+            }
+            miss += seconds_since(start);
+
+            start = clock_t::now();
+            for (const KEY& key : keys)
+            {
+                map.erase(key);
+            }
+            erase += seconds_since(start);
+        }
+
+        F64 ops = (F64) keys.size() * ROUNDS / 1000000.0;
+        std::cout << "\n  " << name << ": insert " << ops / insert
+                  << " hit " << ops / hit
+                  << " miss " << ops / miss
+                  << " erase " << ops / erase
+                  << " Mops/s (" << found << ")";
+    }
+}
+
+namespace tut
+{
+    struct flathashmap_data
+    {
+    };
+    typedef test_group<flathashmap_data> flathashmap_group;
+    typedef flathashmap_group::object object;
+    flathashmap_group flathashmapgrp("llflathashmap");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("basic operations");
+
+        LLFlatHashMap<LLUUID, S32> map;
+        ensure("empty", map.empty());
+        LLUUID a, b;
+        a.generate();
+        b.generate();
+        ensure("no find in empty map", !map.find(a));
+
+        ensure("new key", map.insert_or_assign(a, 1));
+        ensure("existing key", !map.insert_or_assign(a, 2));
+        ensure_equals("assigned", *map.find(a), 2);
+        ensure("other key absent", !map.contains(b));
+
+        ensure_equals("default constructed", map[b], 0);
+        map[b] = 5;
+        ensure_equals("size", map.size(), (size_t) 2);
+        ensure_equals("operator[]", *map.find(b), 5);
+
+        ensure("erase present", map.erase(a));
+        ensure("erase absent", !map.erase(a));
+        ensure("erased", !map.find(a));
+        ensure_equals("other kept", *map.find(b), 5);
+
+        map.clear();
+        ensure("cleared", map.empty() && !map.find(b));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("matches std::map under random operations");
+
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<U32> local_id(1, 5000);
+        std::uniform_int_distribution<U32> region(1, 4);
+        std::uniform_int_distribution<S32> op(0, 9);
+
+        LLFlatHashMap<U64, U32> map;
+        std::map<U64, U32> expected;
+        for (S32 i = 0; i < 200000; ++i)
+        {
+            U64 key = index_id(region(rng), local_id(rng));
+            switch (op(rng))
+            {
+            case 0: case 1: case 2:
+                ensure_equals("erase", map.erase(key), expected.erase(key) > 0);
+                break;
+            case 3: case 4: case 5:
+                ensure_equals("insert", map.insert_or_assign(key, i), expected.find(key) == expected.end());
+                expected[key] = i;
+                break;
+            default:
+                {
+                    const U32* value = map.find(key);
+                    std::map<U64, U32>::const_iterator found = expected.find(key);
+                    ensure_equals("find", value != nullptr, found != expected.end());
+                    if (value)
+                    {
+                        ensure_equals("value", *value, found->second);
+                    }
+                }
+                break;
+            }
+        }
+        ensure_equals("size", map.size(), expected.size());
+
+        size_t visited = 0;
+        map.forEach([&](U64 key, U32 value)
+                    {
+                        ensure_equals("forEach value", value, expected[key]);
+                        ++visited;
+                    });
+        ensure_equals("forEach count", visited, expected.size());
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("colliding keys");
+
+        LLFlatHashMap<U32, U32, ConstantHash> map;
+        for (U32 i = 0; i < 100; ++i)
+        {
+            map[i] = i * 2;
+        }
+        // erase from the middle of the run, the rest must shift back
+        for (U32 i = 0; i < 100; i += 3)
+        {
+            ensure("erase", map.erase(i));
+        }
+        for (U32 i = 0; i < 100; ++i)
+        {
+            const U32* value = map.find(i);
+            if (i % 3)
+            {
+                ensure("kept", value && *value == i * 2);
+            }
+            else
+            {
+                ensure("erased", !value);
+            }
+        }
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("values are released on erase and clear");
+
+        std::shared_ptr<S32> value = std::make_shared<S32>(1);
+        LLFlatHashMap<U32, std::shared_ptr<S32> > map;
+        for (U32 i = 0; i < 50; ++i)
+        {
+            map[i] = value;
+        }
+        ensure_equals("all referenced", value.use_count(), 51L);
+        for (U32 i = 0; i < 25; ++i)
+        {
+            map.erase(i);
+        }
+        ensure_equals("erase released", value.use_count(), 26L);
+        map.clear();
+        ensure_equals("clear released", value.use_count(), 1L);
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("reserve keeps entries");
+
+        LLFlatHashMap<U32, U32> map;
+        for (U32 i = 0; i < 10; ++i)
+        {
+            map[i] = i;
+        }
+        map.reserve(100000);
+        ensure("capacity", map.capacity() >= 100000);
+        for (U32 i = 0; i < 10; ++i)
+        {
+            ensure_equals("kept", *map.find(i), i);
+        }
+    }
+
+    template<> template<>
+    void object::test<6>()
+    {
+        set_test_name("object list lookup benchmark");
+
+        if (!getenv("LL_FLATHASHMAP_BENCHMARK"))
+        {
+            skip("set LL_FLATHASHMAP_BENCHMARK to compare with std::map and std::unordered_map");
+        }
+
+        // 100k objects spread over a few regions, as LLViewerObjectList
+        // keeps them: by full id, and by (region index, local id)
+        const S32 COUNT = 100000;
+        std::vector<LLUUID> ids(COUNT), missing_ids(COUNT);
+        std::vector<U64> index_ids(COUNT), missing_index_ids(COUNT);
+        for (S32 i = 0; i < COUNT; ++i)
+        {
+            ids[i].generate();
+            missing_ids[i].generate();
+            index_ids[i] = index_id(1 + i % 9, 1000000 + i / 9);
+            missing_index_ids[i] = index_id(10 + i % 9, 1000000 + i / 9);
+        }
+        // look up in a different order than inserted
+        std::shuffle(ids.begin(), ids.end(), std::mt19937(1));
+        std::shuffle(index_ids.begin(), index_ids.end(), std::mt19937(2));
+
+        S32 dummy;
+        void* object = &dummy;
+
+        std::cout << "\nLLUUID -> object";
+        benchmark<std::map<LLUUID, void*> >("std::map          ", ids, missing_ids, object,
+            [](std::map<LLUUID, void*>& map, const LLUUID& key)
+            {
+                auto found = map.find(key);
+                return found != map.end() ? &found->second : nullptr;
+            });
+        benchmark<std::unordered_map<LLUUID, void*> >("std::unordered_map", ids, missing_ids, object,
+            [](std::unordered_map<LLUUID, void*>& map, const LLUUID& key)
+            {
+                auto found = map.find(key);
+                return found != map.end() ? &found->second : nullptr;
+            });
+        benchmark<LLFlatHashMap<LLUUID, void*> >("LLFlatHashMap     ", ids, missing_ids, object,
+            [](LLFlatHashMap<LLUUID, void*>& map, const LLUUID& key)
+            {
+                return map.find(key);
+            });
+
+        std::cout << "\n(region, local id) -> LLUUID";
+        LLUUID id;
+        id.generate();
+        benchmark<std::map<U64, LLUUID> >("std::map          ", index_ids, missing_index_ids, id,
+            [](std::map<U64, LLUUID>& map, U64 key)
+            {
+                auto found = map.find(key);
+                return found != map.end() ? &found->second : nullptr;
+            });
+        benchmark<std::unordered_map<U64, LLUUID> >("std::unordered_map", index_ids, missing_index_ids, id,
+            [](std::unordered_map<U64, LLUUID>& map, U64 key)
+            {
+                auto found = map.find(key);
+                return found != map.end() ? &found->second : nullptr;
+            });
+        benchmark<LLFlatHashMap<U64, LLUUID> >("LLFlatHashMap     ", index_ids, missing_index_ids, id,
+            [](LLFlatHashMap<U64, LLUUID>& map, U64 key)
+            {
+                return map.find(key);
+            });
+        std::cout << std::endl;
+    }
+} // namespace tut
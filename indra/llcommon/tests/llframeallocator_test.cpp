@@ -0,0 +1,298 @@
+/**
+ * @file llframeallocator_test.cpp
+ * @brief Test for LLFrameArena, LLFrameAllocator and LLFixedSizePool
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframeallocator.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock timer_clock_t;
+
+	F64 seconds_since(timer_clock_t::time_point start)
+	{
+		return std::chrono::duration<F64>(timer_clock_t::now() - start).count();
+	}
+
+	class Pooled
+	{
+		LL_POOL_NEW(Pooled);
+	public:
+		virtual ~Pooled() {}
+		alignas(16) F32 mPos[4];
+		U32 mValue;
+	};
+
+	class BiggerPooled : public Pooled
+	{
+	public:
+		char mMore[100];
+	};
+
+	// Counts what std::allocator does, to compare with the arena
+	U64 sHeapAllocations = 0;
+
+	template <typename T>
+	struct CountingAllocator : public std::allocator<T>
+	{
+		typedef T value_type;
+		template <typename U> struct rebind { typedef CountingAllocator<U> other; };
+
+		CountingAllocator() {}
+		template <typename U> CountingAllocator(const CountingAllocator<U>&) {}
+
+		T* allocate(size_t n)
+		{
+			++sHeapAllocations;
+			return std::allocator<T>::allocate(n);
+		}
+	};
+
+	// A frame's worth of the temporaries genDrawInfo() makes: a map of
+	// faces to short lists of buffers
+	template <template <typename> class ALLOC>
+	size_t build_frame(size_t faces)
+	{
+		typedef std::vector<void*, ALLOC<void*> > list_t;
+		typedef std::unordered_map<size_t, list_t, std::hash<size_t>, std::equal_to<size_t>,
+								   ALLOC<std::pair<const size_t, list_t> > > map_t;
+		map_t map;
+		for (size_t i = 0; i < faces; ++i)
+		{
+			map[i % (faces / 3 + 1)].push_back(&map);
+		}
+		return map.size();
+	}
+}
+
+namespace tut
+{
+	struct allocator_data
+	{
+	};
+	typedef test_group<allocator_data> allocator_group;
+	typedef allocator_group::object object;
+	allocator_group allocator("LLFrameAllocator");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("arena reuses its blocks every frame");
+		LLFrameArena arena("test arena");
+		char* first = (char*)arena.allocate(10, 1);
+		void* aligned = arena.allocate(32, 16);
+		ensure("aligned", ((uintptr_t)aligned & 15) == 0);
+		ensure("packed", (char*)aligned - first < 32);
+
+		// giving back the latest allocation rewinds over it
+		arena.deallocate(aligned, 32);
+		ensure("rewound", arena.allocate(32, 16) == aligned);
+
+		// big allocations get their own block
+		void* large = arena.allocate(100000);
+		ensure("large", large != NULL);
+		ensure_equals("two blocks", arena.getHeapAllocations(), U64(2));
+		ensure("held", arena.getBytesHeld() >= 100000);
+		ensure("peak", arena.getPeakBytes() >= 100000 + 42);
+
+		arena.reset();
+		ensure_equals("nothing in use", arena.getBytesInUse(), size_t(0));
+		ensure_equals("large one gone", arena.getBytesHeld(), size_t(64 * 1024));
+		ensure("same memory next frame", arena.allocate(10, 1) == first);
+
+		// more than a block's worth keeps a second one
+		for (S32 i = 0; i < 100; ++i)
+		{
+			arena.allocate(1000);
+		}
+		arena.reset();
+		const U64 heap = arena.getHeapAllocations();
+		for (S32 i = 0; i < 100; ++i)
+		{
+			arena.allocate(1000);
+		}
+		arena.reset();
+		ensure_equals("no new blocks", arena.getHeapAllocations(), heap);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("containers on the frame arena");
+		LLFrameArena& arena(LLFrameArena::current());
+		ensure("one per thread", &arena == &LLFrameArena::current());
+
+		LLFrameArena::endFrame();
+		ensure_equals("first frame", build_frame<LLFrameAllocator>(300), size_t(101));
+		LLFrameArena::endFrame();
+		ensure("served", arena.getLastFrameAllocations() > 100);
+		ensure_equals("all given back", arena.getLive(), size_t(0));
+
+		// once warmed up, frames don't touch the heap at all
+		build_frame<LLFrameAllocator>(300);
+		LLFrameArena::endFrame();
+		ensure("served again", arena.getLastFrameAllocations() > 100);
+		ensure_equals("no heap allocations", arena.getLastFrameHeapAllocations(), U64(0));
+
+		std::vector<S32, LLFrameAllocator<S32> > numbers;
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			numbers.push_back(i);
+		}
+		ensure_equals("contents", numbers[999], 999);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("pooled objects");
+		Pooled* first = new Pooled;
+		ensure("aligned", ((uintptr_t)first & 15) == 0);
+		Pooled* second = new Pooled;
+		ensure_equals("live", Pooled::getPool().getLive(), size_t(2));
+		ensure_equals("one chunk", Pooled::getPool().getHeapAllocations(), U64(1));
+		delete first;
+		ensure("reused", new Pooled == first);
+
+		// a subclass of another size goes to the heap, and back there
+		Pooled* bigger = new BiggerPooled;
+		ensure_equals("not pooled", Pooled::getPool().getLive(), size_t(2));
+		delete bigger;
+		ensure_equals("still not pooled", Pooled::getPool().getLive(), size_t(2));
+
+		std::vector<Pooled*> many;
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			many.push_back(new Pooled);
+		}
+		for (Pooled* pooled : many)
+		{
+			delete pooled;
+		}
+		delete first;
+		delete second;
+		ensure_equals("none live", Pooled::getPool().getLive(), size_t(0));
+		const U64 chunks = Pooled::getPool().getHeapAllocations();
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			many[i] = new Pooled;
+		}
+		for (Pooled* pooled : many)
+		{
+			delete pooled;
+		}
+		ensure_equals("chunks reused", Pooled::getPool().getHeapAllocations(), chunks);
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("benchmark against the heap");
+
+		if (!getenv("LL_FRAMEALLOCATOR_BENCHMARK"))
+		{
+			skip("set LL_FRAMEALLOCATOR_BENCHMARK to compare with the heap");
+		}
+
+		const S32 FRAMES = 2000;
+		const size_t FACES = 500;
+		const size_t OBJECTS = 2000;
+		LLFrameArena& arena(LLFrameArena::current());
+		size_t check = 0;
+
+		timer_clock_t::time_point start = timer_clock_t::now();
+		sHeapAllocations = 0;
+		for (S32 frame = 0; frame < FRAMES; ++frame)
+		{
+			check += build_frame<CountingAllocator>(FACES);
+		}
+		const F64 heap_time = seconds_since(start);
+		const U64 heap_count = sHeapAllocations;
+
+		start = timer_clock_t::now();
+		U64 served = 0, arena_heap = 0;
+		for (S32 frame = 0; frame < FRAMES; ++frame)
+		{
+			check += build_frame<LLFrameAllocator>(FACES);
+			LLFrameArena::endFrame();
+			served += arena.getLastFrameAllocations();
+			arena_heap += arena.getLastFrameHeapAllocations();
+		}
+		const F64 arena_time = seconds_since(start);
+
+		std::cout << "\ntemporaries, heap:   " << heap_time * 1e6 / FRAMES << " us and "
+				  << heap_count / FRAMES << " heap allocations per frame"
+				  << "\ntemporaries, arena:  " << arena_time * 1e6 / FRAMES << " us and "
+				  << F64(arena_heap) / FRAMES << " heap allocations per frame ("
+				  << served / FRAMES << " served)";
+
+		std::vector<BiggerPooled*> heap_objects(OBJECTS);
+		std::vector<Pooled*> pooled_objects(OBJECTS);
+		start = timer_clock_t::now();
+		for (S32 frame = 0; frame < FRAMES; ++frame)
+		{
+			// bigger than Pooled, so these go to the heap
+			for (size_t i = 0; i < OBJECTS; ++i)
+			{
+				heap_objects[i] = new BiggerPooled;
+			}
+			for (size_t i = 0; i < OBJECTS; ++i)
+			{
+				delete heap_objects[i];
+			}
+		}
+		const F64 new_time = seconds_since(start);
+
+		start = timer_clock_t::now();
+		const U64 chunks = Pooled::getPool().getHeapAllocations();
+		for (S32 frame = 0; frame < FRAMES; ++frame)
+		{
+			for (size_t i = 0; i < OBJECTS; ++i)
+			{
+				pooled_objects[i] = new Pooled;
+			}
+			for (size_t i = 0; i < OBJECTS; ++i)
+			{
+				delete pooled_objects[i];
+			}
+		}
+		const F64 pool_time = seconds_since(start);
+
+		std::cout << "\nobjects, heap:       " << new_time * 1e6 / FRAMES << " us and "
+				  << OBJECTS << " heap allocations per frame"
+				  << "\nobjects, pool:       " << pool_time * 1e6 / FRAMES << " us and "
+				  << F64(Pooled::getPool().getHeapAllocations() - chunks) / FRAMES
+				  << " heap allocations per frame" << std::endl;
+		ensure("did something", check > 0);
+	}
+}
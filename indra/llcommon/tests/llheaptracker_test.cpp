@@ -0,0 +1,217 @@
+/**
+ * @file llheaptracker_test.cpp
+ * @brief Test for LLHeapTracker
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llheaptracker.h"
+#include "llfile.h"
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	typedef std::chrono::steady_clock timer_clock_t;
+
+	F64 seconds_since(timer_clock_t::time_point start)
+	{
+		return std::chrono::duration<F64>(timer_clock_t::now() - start).count();
+	}
+
+	// The hooks never look at the memory, made up addresses will do
+	void* fake_address(size_t i)
+	{
+		return (void*)(uintptr_t(0x10000000) + i * 1024);
+	}
+
+	void allocate_fakes(size_t first, size_t count, size_t size)
+	{
+		for (size_t i = first; i < first + count; ++i)
+		{
+			LLHeapTracker::onAlloc(fake_address(i), size);
+		}
+	}
+
+	void free_fakes(size_t first, size_t count)
+	{
+		for (size_t i = first; i < first + count; ++i)
+		{
+			LLHeapTracker::onFree(fake_address(i));
+		}
+	}
+}
+
+namespace tut
+{
+	struct heaptracker_data
+	{
+		heaptracker_data()
+		{
+			// the first allocation a thread makes only starts its countdown
+			LLHeapTracker::setSampleInterval(1);
+			LLHeapTracker::onAlloc(fake_address(1000000), 1);
+			LLHeapTracker::setSampleInterval(0);
+			LLHeapTracker::reset();
+		}
+
+		~heaptracker_data()
+		{
+			LLHeapTracker::setSampleInterval(0);
+			LLHeapTracker::reset();
+		}
+	};
+	typedef test_group<heaptracker_data> heaptracker_group;
+	typedef heaptracker_group::object object;
+	heaptracker_group heaptracker("LLHeapTracker");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("sites, categories and frees");
+		allocate_fakes(0, 100, 64);
+		ensure_equals("nothing sampled while off", LLHeapTracker::getLiveBytes(), 0.0);
+
+		// an interval of one byte samples everything
+		LLHeapTracker::setSampleInterval(1);
+		{
+			LL_HEAP_CATEGORY("HeapTest");
+			allocate_fakes(0, 100, 64);
+		}
+		ensure("all sampled", std::fabs(LLHeapTracker::getLiveBytes() - 6400.0) < 1.0);
+
+		LLHeapTracker::category_list_t categories(LLHeapTracker::getCategories());
+		ensure_equals("one category", categories.size(), size_t(1));
+		ensure_equals("category", categories[0].first, std::string("HeapTest"));
+
+		LLHeapTracker::site_list_t sites(LLHeapTracker::getTopSites(10));
+		ensure_equals("one site", sites.size(), size_t(1));
+		ensure_equals("samples", sites[0].mSamples, U32(100));
+		ensure("count", std::fabs(sites[0].mLiveCount - 100.0) < 0.1);
+		ensure("stack", !sites[0].mFrames.empty());
+
+		free_fakes(0, 50);
+		ensure("half freed", std::fabs(LLHeapTracker::getLiveBytes() - 3200.0) < 1.0);
+		sites = LLHeapTracker::getTopSites(10);
+		ensure("still allocated in all", std::fabs(sites[0].mTotalBytes - 6400.0) < 1.0);
+
+		// outside the scope, back to no category
+		allocate_fakes(100, 10, 64);
+		categories = LLHeapTracker::getCategories();
+		ensure_equals("two categories", categories.size(), size_t(2));
+		ensure_equals("default category", categories[1].first, std::string("Other"));
+
+		NamedTempFile file("heap", "");
+		ensure("dumped", LLHeapTracker::dump(file.getName()));
+		llifstream in(file.getName().c_str());
+		std::stringstream text;
+		text << in.rdbuf();
+		ensure("categories in dump", text.str().find("HeapTest") != std::string::npos);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("estimates from sampling");
+		const size_t COUNT = 200000;
+		const size_t SIZE = 256;
+		LLHeapTracker::setSampleInterval(4096);
+		allocate_fakes(0, COUNT, SIZE);
+		const F64 actual = F64(COUNT * SIZE);
+		const F64 estimate = LLHeapTracker::getLiveBytes();
+		ensure("within 10%", std::fabs(estimate - actual) < actual * 0.1);
+
+		LLHeapTracker::setSampleInterval(0);
+		free_fakes(0, COUNT);
+		ensure("frees seen with sampling off", std::fabs(LLHeapTracker::getLiveBytes()) < 1.0);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("overhead of the hooks");
+
+		if (!getenv("LL_HEAPTRACKER_BENCHMARK"))
+		{
+			skip("set LL_HEAPTRACKER_BENCHMARK to measure the cost of sampling");
+		}
+
+		const size_t COUNT = 4000000;
+		const size_t BATCH = 64;
+		void* ptrs[BATCH];
+		const size_t intervals[] = { 0, 512 * 1024, 64 * 1024, 4 * 1024 };
+
+		F64 baseline = 0.0;
+		for (S32 hooked = -1; hooked < S32(LL_ARRAY_SIZE(intervals)); ++hooked)
+		{
+			if (hooked >= 0)
+			{
+				LLHeapTracker::setSampleInterval(intervals[hooked]);
+			}
+			U32 random = 12345;
+			timer_clock_t::time_point start = timer_clock_t::now();
+			for (size_t i = 0; i < COUNT; i += BATCH)
+			{
+				for (size_t n = 0; n < BATCH; ++n)
+				{
+					random = random * 1664525 + 1013904223;
+					const size_t size = 16 + (random >> 22);	// 16 to 1039 bytes
+					ptrs[n] = malloc(size);
+					if (hooked >= 0)
+					{
+						LLHeapTracker::onAlloc(ptrs[n], size);
+					}
+				}
+				for (size_t n = 0; n < BATCH; ++n)
+				{
+					if (hooked >= 0)
+					{
+						LLHeapTracker::onFree(ptrs[n]);
+					}
+					free(ptrs[n]);
+				}
+			}
+			const F64 ns = seconds_since(start) * 1e9 / COUNT;
+			if (hooked < 0)
+			{
+				baseline = ns;
+				std::cout << "\nmalloc and free          " << ns << " ns";
+			}
+			else
+			{
+				std::cout << "\nsampling every " << intervals[hooked] / 1024 << "KB";
+				std::cout << (intervals[hooked] ? "\t" : " (off)\t") << ns - baseline << " ns extra";
+			}
+			LLHeapTracker::setSampleInterval(0);
+			LLHeapTracker::reset();
+		}
+		std::cout << std::endl;
+	}
+}
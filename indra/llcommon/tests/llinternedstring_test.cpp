@@ -0,0 +1,239 @@
+/**
+ * @file llinternedstring_test.cpp
+ * @brief Test for LLInternedString
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinternedstring.h"
+#include "llstringtable.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock timer_clock_t;
+
+	F64 seconds_since(timer_clock_t::time_point start)
+	{
+		return std::chrono::duration<F64>(timer_clock_t::now() - start).count();
+	}
+
+	// names shaped like message template and settings names
+	std::vector<std::string> make_names(const std::string& prefix, size_t count)
+	{
+		std::vector<std::string> names;
+		for (size_t i = 0; i < count; ++i)
+		{
+			names.push_back(prefix + "Block" + std::to_string(i * 7919 % 100003) + "Data");
+		}
+		return names;
+	}
+}
+
+namespace tut
+{
+	struct interned_data
+	{
+	};
+	typedef test_group<interned_data> interned_group;
+	typedef interned_group::object object;
+	interned_group interned("LLInternedString");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("equal strings, equal handles");
+		LLInternedString first("InternedTestName");
+		LLInternedString second(std::string("InternedTestName"));
+		LLInternedString other("InternedTestOther");
+		ensure("same handle", first == second);
+		ensure("same chars", first.c_str() == second.c_str());
+		ensure("different", first != other);
+		ensure_equals("text", first.str(), "InternedTestName");
+		ensure_equals("size", first.size(), size_t(16));
+		ensure("id", first.getID() != 0 && first.getID() != other.getID());
+		ensure("from id", LLInternedString::fromID(first.getID()) == first);
+		ensure("bad id", LLInternedString::fromID(0).isNull());
+
+		// views need not be NUL terminated
+		std::string longer("InternedTestNameAndMore");
+		ensure("view", LLInternedString(std::string_view(longer.data(), 16)) == first);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("find doesn't intern");
+		const size_t before(LLInternedString::count());
+		ensure("not there", LLInternedString::find("InternedNeverAdded").isNull());
+		ensure_equals("nothing added", LLInternedString::count(), before);
+		LLInternedString added("InternedAddedNow");
+		ensure("found", LLInternedString::find("InternedAddedNow") == added);
+		ensure_equals("one added", LLInternedString::count(), before + 1);
+
+		LLInternedString null, empty("");
+		ensure("null", null.isNull());
+		ensure_equals("null text", std::string(null.c_str()), "");
+		ensure("empty is interned", empty.notNull() && empty != null);
+		ensure("null char*", LLInternedString((const char*)NULL).isNull());
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("growth keeps handles, threads agree");
+		// enough to grow the table a few times
+		std::vector<std::string> names(make_names("Grow", 20000));
+		std::vector<LLInternedString> handles;
+		for (const std::string& name : names)
+		{
+			handles.push_back(LLInternedString(name));
+		}
+
+		// other threads look up and add at the same time
+		std::vector<std::string> more(make_names("Threaded", 5000));
+		std::vector<std::vector<LLInternedString>> seen(4);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < seen.size(); ++t)
+		{
+			threads.emplace_back([&names, &more, &handles, &seen, t]()
+				{
+					for (size_t i = 0; i < more.size(); ++i)
+					{
+						seen[t].push_back(LLInternedString(more[i]));
+						const size_t n = (i * 13 + t) % names.size();
+						if (LLInternedString::find(names[n]) != handles[n])
+						{
+							seen[t].clear();
+							return;
+						}
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		for (size_t t = 1; t < seen.size(); ++t)
+		{
+			ensure("all threads saw the same handles", seen[t] == seen[0]);
+		}
+		ensure_equals("all threads finished", seen[0].size(), more.size());
+
+		std::set<U32> ids;
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			ensure("kept", LLInternedString(names[i]) == handles[i]);
+			ensure_equals("text kept", handles[i].str(), names[i]);
+			ids.insert(handles[i].getID());
+		}
+		ensure_equals("unique ids", ids.size(), names.size());
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("benchmark against LLStringTable");
+
+		if (!getenv("LL_INTERNEDSTRING_BENCHMARK"))
+		{
+			skip("set LL_INTERNEDSTRING_BENCHMARK to compare with LLStringTable");
+		}
+
+		const size_t COUNT = 5000;
+		const S32 ROUNDS = 200;
+		std::vector<std::string> names(make_names("Bench", COUNT));
+		std::vector<std::string> misses(make_names("Missing", COUNT));
+		size_t found = 0;
+
+		{
+			LLStringTable table(32768);
+			timer_clock_t::time_point start = timer_clock_t::now();
+			for (const std::string& name : names)
+			{
+				table.addString(name);
+			}
+			const F64 insert = seconds_since(start);
+			start = timer_clock_t::now();
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				for (const std::string& name : names)
+				{
+					found += table.checkString(name) != NULL;
+				}
+			}
+			const F64 hit = seconds_since(start);
+			start = timer_clock_t::now();
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				for (const std::string& name : misses)
+				{
+					found += table.checkString(name) != NULL;
+				}
+			}
+			const F64 miss = seconds_since(start);
+			std::cout << "\nLLStringTable     insert " << insert * 1e9 / COUNT
+					  << " ns, hit " << hit * 1e9 / (COUNT * ROUNDS)
+					  << " ns, miss " << miss * 1e9 / (COUNT * ROUNDS) << " ns";
+		}
+
+		{
+			timer_clock_t::time_point start = timer_clock_t::now();
+			for (const std::string& name : names)
+			{
+				LLInternedString interned(name);
+			}
+			const F64 insert = seconds_since(start);
+			start = timer_clock_t::now();
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				for (const std::string& name : names)
+				{
+					found += LLInternedString::find(name).notNull();
+				}
+			}
+			const F64 hit = seconds_since(start);
+			start = timer_clock_t::now();
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				for (const std::string& name : misses)
+				{
+					found += LLInternedString::find(name).notNull();
+				}
+			}
+			const F64 miss = seconds_since(start);
+			std::cout << "\nLLInternedString  insert " << insert * 1e9 / COUNT
+					  << " ns, hit " << hit * 1e9 / (COUNT * ROUNDS)
+					  << " ns, miss " << miss * 1e9 / (COUNT * ROUNDS) << " ns" << std::endl;
+		}
+		ensure_equals("found", found, 2 * COUNT * ROUNDS);
+	}
+}
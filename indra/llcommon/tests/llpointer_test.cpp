@@ -0,0 +1,132 @@
+/**
+ * @file llpointer_test.cpp
+ * @brief Test for LLPointer, LLBorrowedPointer and thread safe reference counts
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpointer.h"
+#include "llrefcount.h"
+#include "../test/lltut.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	std::atomic<int> sLive(0);
+
+	class Counted : public LLRefCount
+	{
+	public:
+		Counted() { ++sLive; }
+	protected:
+		~Counted() { --sLive; }
+	};
+
+	class SharedCounted : public LLThreadSafeRefCount
+	{
+	public:
+		SharedCounted() { ++sLive; }
+	protected:
+		~SharedCounted() { --sLive; }
+	};
+
+	S32 use(LLBorrowedPointer<Counted> ptr)
+	{
+		return ptr->getNumRefs();
+	}
+}
+
+namespace tut
+{
+	struct pointer_data
+	{
+		pointer_data() { sLive = 0; }
+	};
+	typedef test_group<pointer_data> pointer_group;
+	typedef pointer_group::object object;
+	pointer_group pointer("LLPointer");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("moves hand the reference over");
+		LLPointer<Counted> first(new Counted);
+		LLPointer<Counted> second(std::move(first));
+		ensure("moved from", first.isNull());
+		ensure_equals("one reference", second->getNumRefs(), 1);
+
+		LLPointer<Counted> third;
+		third = std::move(second);
+		ensure("moved from again", second.isNull());
+		ensure_equals("still one reference", third->getNumRefs(), 1);
+		third = NULL;
+		ensure_equals("deleted", sLive.load(), 0);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("borrowed pointers don't count");
+		LLPointer<Counted> owner(new Counted);
+		LLBorrowedPointer<Counted> borrowed(owner);
+		ensure("same object", borrowed.get() == owner.get());
+		ensure_equals("not counted", use(owner), 1);
+		ensure_equals("not counted when copied", use(borrowed), 1);
+
+		LLPointer<Counted> kept(borrowed.own());
+		ensure_equals("counted once owned", owner->getNumRefs(), 2);
+		owner = NULL;
+		kept = NULL;
+		ensure_equals("deleted", sLive.load(), 0);
+		ensure("null", LLBorrowedPointer<Counted>().isNull());
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("thread safe counts from many threads");
+		LLPointer<SharedCounted> shared(new SharedCounted);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([shared]()
+				{
+					for (int n = 0; n < 100000; ++n)
+					{
+						LLPointer<SharedCounted> copy(shared);
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		ensure_equals("balanced", shared->getNumRefs(), 1);
+		shared = NULL;
+		ensure_equals("deleted", sLive.load(), 0);
+	}
+}
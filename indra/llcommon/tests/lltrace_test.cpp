@@ -32,6 +32,11 @@
 #include "lltracerecording.h"
 #include "../test/lltut.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 namespace LLUnits
 {
 	// using powers of 2 to allow strict floating point equality
@@ -139,4 +144,61 @@ namespace tut
 				&& after_3pm.getMax(sCaffeineLevelStat) == sCaffeinePerOz * ((S32Ounces)S32TallCup(1) + (S32Ounces)S32GrandeCup(3) + (S32Ounces)S32VentiCup(1)).value());
 	}
 
+
+	static CountStatHandle<S32> sStressCount("stresscount");
+	static EventStatHandle<F64> sStressEvent("stressevent");
+
+	// many threads pushing while the parent pulls
+	template<> template<>
+	void trace_object_t::test<2>()
+	{
+		const int THREADS = 32;
+		const int PUSHES = 50;
+		const int PER_PUSH = 100;
+		const int TOTAL = THREADS * PUSHES * PER_PUSH;
+
+		Recording recording;
+		recording.start();
+
+		std::atomic<int> finished(0);
+		std::atomic<bool> pulled(false);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < THREADS; i++)
+		{
+			threads.emplace_back([this, &finished, &pulled]()
+				{
+					ThreadRecorder recorder(mRecorder);
+					for (int push = 0; push < PUSHES; push++)
+					{
+						for (int n = 0; n < PER_PUSH; n++)
+						{
+							add(sStressCount, 1);
+							record(sStressEvent, 2.0);
+						}
+						recorder.pushToParent();
+					}
+					++finished;
+					// a child's last push is only seen while it's still registered
+					while (!pulled)
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+				});
+		}
+
+		while (finished < THREADS)
+		{
+			mRecorder.pullFromChildren();
+		}
+		mRecorder.pullFromChildren();
+		pulled = true;
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		ensure_equals("every count arrives once", recording.getSum(sStressCount), F64(TOTAL));
+		ensure_equals("every event arrives once", recording.getSampleCount(sStressEvent), TOTAL);
+		ensure_equals("event sums merge", recording.getSum(sStressEvent), 2.0 * TOTAL);
+	}
 }
@@ -0,0 +1,330 @@
+/**
+ * @file lltraceeventlog_test.cpp
+ * @brief Test for the LLTrace event log
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltraceeventlog.h"
+#include "llfasttimer.h"
+#include "lltrace.h"
+#include "lltracethreadrecorder.h"
+#include "../test/lltut.h"
+
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Just enough of a reader to check what was written, the
+	// converter script is the real one
+	struct ParsedEvent
+	{
+		U32			mThread;
+		U32			mType;
+		std::string	mName;
+		U64			mTime;
+		F64			mValue;
+	};
+
+	struct ParsedLog
+	{
+		U32 mVersion = 0;
+		U64 mClockRate = 0;
+		std::map<U32, std::string> mThreads;
+		std::map<U32, std::string> mNames;
+		std::vector<ParsedEvent> mEvents;
+		U64 mDropped = 0;
+
+		size_t count(U32 type, const std::string& name) const
+		{
+			size_t n(0);
+			for (const ParsedEvent& event : mEvents)
+			{
+				n += (event.mType == type && event.mName == name);
+			}
+			return n;
+		}
+	};
+
+	class Parser
+	{
+	public:
+		Parser(const std::string& data) : mData(data), mPos(0) {}
+
+		U8 u8() { tut::ensure("truncated", mPos < mData.size()); return U8(mData[mPos++]); }
+
+		U64 fixed(int bytes)
+		{
+			U64 value(0);
+			for (int i = 0; i < bytes; ++i)
+			{
+				value |= U64(u8()) << (8 * i);
+			}
+			return value;
+		}
+
+		U64 varint()
+		{
+			U64 value(0);
+			for (int shift = 0; ; shift += 7)
+			{
+				const U8 byte(u8());
+				value |= U64(byte & 0x7f) << shift;
+				if (! (byte & 0x80))
+				{
+					return value;
+				}
+			}
+		}
+
+		std::string string()
+		{
+			const size_t len(varint());
+			tut::ensure("truncated string", mPos + len <= mData.size());
+			std::string value(mData, mPos, len);
+			mPos += len;
+			return value;
+		}
+
+		ParsedLog parse()
+		{
+			ParsedLog log;
+			tut::ensure_equals("magic", std::string(mData, 0, 8), std::string("LLTRACE", 8));
+			mPos = 8;
+			log.mVersion = U32(fixed(4));
+			log.mClockRate = fixed(8);
+
+			while (mPos < mData.size())
+			{
+				const char tag = char(u8());
+				if (tag == 'T')
+				{
+					const U32 thread = U32(varint());
+					log.mThreads[thread] = string();
+				}
+				else if (tag == 'N')
+				{
+					const U32 id = U32(varint());
+					u8();
+					log.mNames[id] = string();
+					string();
+				}
+				else if (tag == 'E')
+				{
+					const U32 thread = U32(varint());
+					const U64 count(varint());
+					U64 time(0);
+					for (U64 i = 0; i < count; ++i)
+					{
+						ParsedEvent event;
+						event.mThread = thread;
+						event.mType = u8();
+						event.mName = log.mNames[U32(varint())];
+						const U64 zigzag(varint());
+						time += U64((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+						event.mTime = time;
+						event.mValue = 0.0;
+						if (event.mType >= LLTrace::EventLog::COUNT)
+						{
+							const U64 bits(fixed(8));
+							memcpy(&event.mValue, &bits, sizeof(bits));
+						}
+						log.mEvents.push_back(event);
+					}
+				}
+				else if (tag == 'D')
+				{
+					varint();
+					log.mDropped += varint();
+				}
+				else
+				{
+					tut::fail(std::string("unknown tag ") + tag);
+				}
+			}
+			return log;
+		}
+
+	private:
+		const std::string& mData;
+		size_t mPos;
+	};
+
+	LLTrace::BlockTimerStatHandle sOuterTimer("eventlog_outer");
+	LLTrace::BlockTimerStatHandle sInnerTimer("eventlog_inner");
+	LLTrace::CountStatHandle<S32> sBeans("eventlog_beans");
+	LLTrace::SampleStatHandle<F64> sLevel("eventlog_level");
+}
+
+namespace tut
+{
+	using namespace LLTrace;
+
+	struct eventlog
+	{
+		ThreadRecorder mRecorder;
+
+		eventlog()
+		{
+			// Start each test with nothing buffered
+			EventLog::stop();
+			std::ostringstream discard;
+			EventLog::write(discard);
+		}
+
+		~eventlog()
+		{
+			EventLog::stop();
+		}
+
+		ParsedLog capture()
+		{
+			std::ostringstream out;
+			EventLog::writeHeader(out);
+			EventLog::write(out);
+			mData = out.str();
+			return Parser(mData).parse();
+		}
+
+		std::string mData;
+	};
+
+	typedef test_group<eventlog> eventlog_t;
+	typedef eventlog_t::object eventlog_object_t;
+	tut::eventlog_t tut_singleton("LLTraceEventLog");
+
+	template<> template<>
+	void eventlog_object_t::test<1>()
+	{
+		set_test_name("nothing recorded unless started");
+		{
+			LL_RECORD_BLOCK_TIME(sOuterTimer);
+			add(sBeans, 1);
+		}
+		ParsedLog log(capture());
+		ensure_equals("version", log.mVersion, EventLog::VERSION);
+		ensure_equals("clock rate", log.mClockRate, BlockTimer::countsPerSecond());
+		ensure_equals("no events", log.mEvents.size(), size_t(0));
+	}
+
+	template<> template<>
+	void eventlog_object_t::test<2>()
+	{
+		set_test_name("timers nest, stats carry values");
+		EventLog::start();
+		{
+			LL_RECORD_BLOCK_TIME(sOuterTimer);
+			add(sBeans, 3);
+			{
+				LL_RECORD_BLOCK_TIME(sInnerTimer);
+				sample(sLevel, 0.5);
+			}
+		}
+		EventLog::stop();
+		// not after stopping
+		add(sBeans, 4);
+
+		ParsedLog log(capture());
+		ensure_equals("event count", log.mEvents.size(), size_t(6));
+		const char* names[] = { "eventlog_outer", "eventlog_beans", "eventlog_inner",
+								"eventlog_level", "eventlog_inner", "eventlog_outer" };
+		const U32 types[] = { EventLog::BLOCK_BEGIN, EventLog::COUNT, EventLog::BLOCK_BEGIN,
+							  EventLog::SAMPLE, EventLog::BLOCK_END, EventLog::BLOCK_END };
+		for (size_t i = 0; i < 6; ++i)
+		{
+			ensure_equals("name", log.mEvents[i].mName, names[i]);
+			ensure_equals("type", log.mEvents[i].mType, types[i]);
+			if (i)
+			{
+				ensure("time goes forward", log.mEvents[i].mTime >= log.mEvents[i - 1].mTime);
+			}
+		}
+		ensure_equals("count value", log.mEvents[1].mValue, 3.0);
+		ensure_equals("sample value", log.mEvents[3].mValue, 0.5);
+		ensure_equals("thread name", log.mThreads[log.mEvents[0].mThread], "main");
+	}
+
+	template<> template<>
+	void eventlog_object_t::test<3>()
+	{
+		set_test_name("each thread has its own timeline");
+		EventLog::start();
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 3; ++i)
+		{
+			threads.emplace_back([i]()
+				{
+					EventLog::setThreadName("worker " + std::to_string(i));
+					for (int n = 0; n < 100; ++n)
+					{
+						add(sBeans, 1);
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		EventLog::stop();
+
+		ParsedLog log(capture());
+		ensure_equals("all recorded", log.count(EventLog::COUNT, "eventlog_beans"), size_t(300));
+		std::map<std::string, int> per_thread;
+		for (const ParsedEvent& event : log.mEvents)
+		{
+			++per_thread[log.mThreads[event.mThread]];
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			ensure_equals("per thread", per_thread["worker " + std::to_string(i)], 100);
+		}
+
+		// their buffers are freed once written
+		std::ostringstream again;
+		EventLog::write(again);
+		ensure_equals("nothing left", again.str().size(), size_t(0));
+	}
+
+	template<> template<>
+	void eventlog_object_t::test<4>()
+	{
+		set_test_name("a full buffer drops and counts");
+		const U64 dropped_before(EventLog::getDropCount());
+		EventLog::start();
+		for (int n = 0; n < 20000; ++n)
+		{
+			add(sBeans, 1);
+		}
+		EventLog::stop();
+
+		ensure_equals("dropped", EventLog::getDropCount() - dropped_before, U64(20000 - 16384));
+		ParsedLog log(capture());
+		ensure_equals("kept", log.mEvents.size(), size_t(16384));
+		ensure_equals("drops written", log.mDropped, U64(20000 - 16384));
+	}
+}
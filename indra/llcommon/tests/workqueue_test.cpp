@@ -15,8 +15,15 @@
 #include "workqueue.h"
 // STL headers
 // std headers
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <deque>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
 // external library headers
 // other Linden headers
 #include "../test/lltut.h"
@@ -26,6 +33,7 @@
 #include "lleventcoro.h"
 #include "llstring.h"
 #include "stringize.h"
+#include "threadpool.h"
 
 using namespace LL;
 using namespace std::literals::chrono_literals; // ms suffix
@@ -232,4 +240,161 @@ namespace tut
         ensure_equals("didn't run coroutine", stored, "ran");
         ensure("void waitForResult() didn't return", done);
     }
+
+    template<> template<>
+    void object::test<7>()
+    {
+        set_test_name("WorkStealingQueue priorities");
+        WorkStealingQueue stealing("stealing");
+        std::string order;
+        // same thread again, so a plain string will do
+        stealing.post([&order](){ order.append("c"); }, WorkQueueBase::PRIORITY_LOW);
+        stealing.post([&order](){ order.append("b"); });
+        stealing.post([&order](){ order.append("a"); }, WorkQueueBase::PRIORITY_HIGH);
+        // hints pass through postTo()
+        WorkSchedule main("main");
+        main.postTo(
+            WorkStealingQueue::getInstance("stealing"),
+            [&order](){ order.append("A"); },
+            [&order](){ order.append(";main"); },
+            WorkQueueBase::PRIORITY_HIGH);
+        ensure_equals("size", stealing.size(), 4);
+        stealing.close();
+        ensure_not("post after close", stealing.postIfOpen([](){}));
+        ensure_not("done with work left", stealing.done());
+        stealing.runUntilClose();
+        ensure_equals("priority order", order, "aAbc");
+        ensure("done", stealing.done());
+        main.runPending();
+        ensure_equals("callback", order, "aAbc;main");
+    }
+
+    template<> template<>
+    void object::test<8>()
+    {
+        set_test_name("WorkStealingQueue workers");
+        WorkStealingQueue stealing("stealing");
+        const int PARENTS = 200;
+        const int CHILDREN = 10;
+        std::atomic<int> ran(0);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 4; ++i)
+        {
+            workers.emplace_back([&stealing](){ stealing.runUntilClose(); });
+        }
+        for (int parent = 0; parent < PARENTS; ++parent)
+        {
+            // half of them on worker 1
+            WorkQueueBase::Hint hint(WorkQueueBase::PRIORITY_NORMAL,
+                                     (parent % 2)? 1 : WorkQueueBase::ANY_WORKER);
+            stealing.post(
+                [&stealing, &ran]()
+                {
+                    // posted from a worker, so queued for that worker
+                    for (int child = 0; child < CHILDREN; ++child)
+                    {
+                        stealing.post([&ran](){ ++ran; });
+                    }
+                    ++ran;
+                },
+                hint);
+        }
+        // workers post more work, can't close until that's all in
+        auto finish = std::chrono::steady_clock::now() + 10s;
+        while (ran < PARENTS * (CHILDREN + 1) && std::chrono::steady_clock::now() < finish)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        stealing.close();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        ensure_equals("ran everything once", ran.load(), PARENTS * (CHILDREN + 1));
+        ensure("done", stealing.done());
+    }
+
+    using BenchClock = std::chrono::steady_clock;
+
+    // Run tasks on a fresh pool. With fanout > 1, this thread posts every
+    // fanout-th task and each of those posts the fanout - 1 after it from
+    // the pool. Each task spins for 'work'. Prints tasks per second and
+    // the time from post() to the task starting.
+    template <class POOL>
+    void benchmark_pool(const char* label, size_t threads, int tasks, int fanout,
+                        std::chrono::microseconds work)
+    {
+        POOL pool(label, threads, 1024*1024, false);
+        pool.start();
+        auto& queue(pool.getQueue());
+        std::vector<double> latencies(tasks);
+        std::atomic<int> remaining(tasks);
+
+        auto run = [&latencies, &remaining, work](int i, BenchClock::time_point posted)
+        {
+            auto started = BenchClock::now();
+            latencies[i] = std::chrono::duration<double, std::micro>(started - posted).count();
+            while (BenchClock::now() - started < work)
+                ;
+            --remaining;
+        };
+
+        auto start = BenchClock::now();
+        for (int parent = 0; parent < tasks; parent += fanout)
+        {
+            queue.post(
+                [&queue, &run, parent, fanout, posted = BenchClock::now()]()
+                {
+                    for (int child = 1; child < fanout; ++child)
+                    {
+                        queue.post([&run, i = parent + child, posted = BenchClock::now()]()
+                                   { run(i, posted); });
+                    }
+                    run(parent, posted);
+                });
+        }
+        while (remaining)
+        {
+            std::this_thread::yield();
+        }
+        double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        pool.close();
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << std::setw(9) << label
+                  << std::setw(9) << threads
+                  << std::setw(9) << work.count()
+                  << std::setw(8) << fanout
+                  << std::setw(10) << int(tasks / seconds)
+                  << std::setw(11) << std::fixed << std::setprecision(1) << latencies[tasks / 2]
+                  << std::setw(10) << latencies[tasks * 99 / 100]
+                  << std::endl;
+    }
+
+    template<> template<>
+    void object::test<9>()
+    {
+        set_test_name("ThreadPool vs. WorkStealingThreadPool");
+        // Timing-dependent, not for every build. Set LL_WORKQUEUE_BENCHMARK
+        // to run it.
+        if (! getenv("LL_WORKQUEUE_BENCHMARK"))
+        {
+            skip("set LL_WORKQUEUE_BENCHMARK to run");
+        }
+
+        std::cout << "\n     pool  threads  task us  fanout   tasks/s  median us    p99 us\n";
+        for (size_t threads : { 3, 8 })
+        {
+            for (auto work : { 0us, 50us })
+            {
+                // fewer big ones to keep the run short
+                int tasks = work.count()? 20000 : 200000;
+                for (int fanout : { 1, 16 })
+                {
+                    benchmark_pool<ThreadPool>("shared", threads, tasks, fanout, work);
+                    benchmark_pool<WorkStealingThreadPool>("stealing", threads, tasks, fanout, work);
+                }
+            }
+        }
+    }
 } // namespace tut
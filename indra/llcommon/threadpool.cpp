@@ -20,7 +20,9 @@
 #include "commoncontrol.h"
 #include "llerror.h"
 #include "llevents.h"
+#include "llheaptracker.h"
 #include "llsd.h"
+#include "lltraceeventlog.h"
 #include "stringize.h"
 
 #include <boost/fiber/algo/round_robin.hpp>
@@ -79,6 +81,7 @@ void LL::ThreadPoolBase::start()
         mThreads.emplace_back(tname, [this, tname]()
             {
                 LL_PROFILER_SET_THREAD_NAME(tname.c_str());
+                LLTrace::EventLog::setThreadName(tname);
                 run(tname);
             });
     }
@@ -138,6 +141,8 @@ void LL::ThreadPoolBase::run(const std::string& name)
 #endif // LL_WINDOWS
 
     LL_DEBUGS("ThreadPool") << name << " starting" << LL_ENDL;
+    // whatever the pool's threads allocate is charged to the pool
+    LL_HEAP_CATEGORY(mName.c_str());
     run();
     LL_DEBUGS("ThreadPool") << name << " stopping" << LL_ENDL;
 }
@@ -136,6 +136,13 @@ namespace LL
     /// ThreadPool is shorthand for using the simpler WorkQueue
     using ThreadPool = ThreadPoolUsing<WorkQueue>;
 
+    /**
+     * WorkStealingThreadPool gives each thread its own queue, see
+     * WorkStealingQueue. Use it for pools many threads post to, or where
+     * work needs priorities.
+     */
+    using WorkStealingThreadPool = ThreadPoolUsing<WorkStealingQueue>;
+
 } // namespace LL
 
 #endif /* ! defined(LL_THREADPOOL_H) */
@@ -16,10 +16,13 @@
 
 namespace LL
 {
+    class ThreadPoolBase;
+
     template <class QUEUE>
     struct ThreadPoolUsing;
 
     using ThreadPool = ThreadPoolUsing<WorkQueue>;
+    using WorkStealingThreadPool = ThreadPoolUsing<WorkStealingQueue>;
 } // namespace LL
 
 #endif /* ! defined(LL_THREADPOOL_FWD_H) */
\ No newline at end of file
@@ -15,6 +15,8 @@
 #include "workqueue.h"
 // STL headers
 // std headers
+#include <algorithm>                // std::min
+#include <thread>                   // std::this_thread::yield()
 // external library headers
 // other Linden headers
 #include "llcoros.h"
@@ -254,3 +256,321 @@ bool LL::WorkSchedule::tryPop_(Work& work)
 {
     return mQueue.tryPop(work);
 }
+
+/*****************************************************************************
+*   WorkStealingQueue
+*****************************************************************************/
+namespace
+{
+    // which WorkStealingQueue, if any, this thread is a worker for
+    struct WorkerSlot
+    {
+        U64 mQueue;
+        size_t mIndex;
+    };
+
+    WorkerSlot& worker_slot()
+    {
+        static thread_local WorkerSlot sSlot{ 0, 0 };
+        return sSlot;
+    }
+
+    std::atomic<U64> sNextQueueId(0);
+
+    const int SPIN_BEFORE_WAIT = 16;
+} // anonymous namespace
+
+LL::WorkStealingQueue::Lanes::Lanes()
+{
+    for (auto& count : mCount)
+    {
+        count = 0;
+    }
+}
+
+bool LL::WorkStealingQueue::Lanes::pop(size_t priority, Work& work)
+{
+    if (! mCount[priority].load(std::memory_order_relaxed))
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& lane = mWork[priority];
+    if (lane.empty())
+        return false;
+
+    work = std::move(lane.front());
+    lane.pop_front();
+    --mCount[priority];
+    return true;
+}
+
+LL::WorkStealingQueue::WorkStealingQueue(const std::string& name, size_t capacity):
+    super(name),
+    mCapacity(capacity),
+    mId(++sNextQueueId),
+    mWorkerCount(0),
+    mPending(0),
+    mQueued(0),
+    mSteals(0),
+    mClosed(false),
+    mWorkWaiters(0),
+    mSpaceWaiters(0)
+{
+    for (auto& worker : mWorkers)
+    {
+        worker = nullptr;
+    }
+}
+
+LL::WorkStealingQueue::~WorkStealingQueue()
+{
+    for (auto& worker : mWorkers)
+    {
+        delete worker.load();
+    }
+}
+
+void LL::WorkStealingQueue::close()
+{
+    {
+        Lock lk(mWaitMutex);
+        mClosed = true;
+    }
+    // wake up any blocked pop() calls
+    mWorkCond.notify_all();
+    // wake up any blocked post() calls
+    mSpaceCond.notify_all();
+}
+
+size_t LL::WorkStealingQueue::size()
+{
+    return mPending;
+}
+
+bool LL::WorkStealingQueue::isClosed()
+{
+    return mClosed;
+}
+
+bool LL::WorkStealingQueue::done()
+{
+    return mClosed && ! mPending;
+}
+
+void LL::WorkStealingQueue::post(const Work& callable)
+{
+    post(callable, Hint());
+}
+
+void LL::WorkStealingQueue::post(const Work& callable, const Hint& hint)
+{
+    if (! push(callable, hint, PUSH_WAIT))
+    {
+        LLTHROW(Closed());
+    }
+}
+
+bool LL::WorkStealingQueue::postIfOpen(const Work& callable)
+{
+    return push(callable, Hint(), PUSH_IF_OPEN);
+}
+
+bool LL::WorkStealingQueue::postIfOpen(const Work& callable, const Hint& hint)
+{
+    return push(callable, hint, PUSH_IF_OPEN);
+}
+
+bool LL::WorkStealingQueue::tryPost(const Work& callable)
+{
+    return push(callable, Hint(), PUSH_TRY);
+}
+
+bool LL::WorkStealingQueue::tryPost(const Work& callable, const Hint& hint)
+{
+    return push(callable, hint, PUSH_TRY);
+}
+
+bool LL::WorkStealingQueue::push(const Work& work, const Hint& hint, PushMode mode)
+{
+    // Count the item as pending before checking mClosed, so a worker that
+    // finds the queue closed with nothing pending can't miss it.
+    for (;;)
+    {
+        size_t pending = mPending++;
+        if (mClosed)
+        {
+            --mPending;
+            if (mWorkWaiters)
+            {
+                // we may have been what kept a worker from seeing done()
+                { Lock lk(mWaitMutex); }
+                mWorkCond.notify_all();
+            }
+            return false;
+        }
+        if (pending < mCapacity)
+            break;
+
+        --mPending;
+        if (mode == PUSH_TRY)
+            return false;
+
+        // Storage full, wait for a worker to take something
+        Lock lk(mWaitMutex);
+        ++mSpaceWaiters;
+        while (! mClosed && mPending >= mCapacity)
+        {
+            mSpaceCond.wait(lk);
+        }
+        --mSpaceWaiters;
+    }
+
+    size_t priority = (hint.mPriority < PRIORITY_COUNT)? hint.mPriority : PRIORITY_NORMAL;
+    Lanes* lanes = nullptr;
+    if (hint.mWorker != ANY_WORKER)
+    {
+        size_t workers = std::min(mWorkerCount.load(), MAX_WORKERS);
+        if (workers)
+        {
+            lanes = mWorkers[hint.mWorker % workers];
+        }
+    }
+    else
+    {
+        size_t self = currentWorker();
+        if (self != ANY_WORKER)
+        {
+            lanes = mWorkers[self];
+        }
+    }
+    if (! lanes)
+    {
+        lanes = &mShared;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lanes->mMutex);
+        lanes->mWork[priority].push_back(work);
+        ++lanes->mCount[priority];
+    }
+    ++mQueued;
+
+    // Workers increment mWorkWaiters before checking mQueued, so either
+    // they see this item or we see them waiting.
+    if (mWorkWaiters)
+    {
+        { Lock lk(mWaitMutex); }
+        mWorkCond.notify_one();
+    }
+    return true;
+}
+
+bool LL::WorkStealingQueue::take(Work& work, size_t worker)
+{
+    size_t workers = std::min(mWorkerCount.load(), MAX_WORKERS);
+    Lanes* own = (worker != ANY_WORKER)? mWorkers[worker].load() : nullptr;
+    // start stealing just past ourselves so idle workers spread out
+    size_t first = (worker != ANY_WORKER)? worker + 1 : 0;
+
+    // higher priority work anywhere before lower priority work here
+    for (size_t priority = 0; priority < PRIORITY_COUNT; ++priority)
+    {
+        if (own && own->pop(priority, work))
+            return true;
+
+        if (mShared.pop(priority, work))
+            return true;
+
+        for (size_t i = 0; i < workers; ++i)
+        {
+            size_t victim = (first + i) % workers;
+            if (victim == worker)
+                continue;
+
+            Lanes* lanes = mWorkers[victim];
+            if (lanes && lanes->pop(priority, work))
+            {
+                ++mSteals;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void LL::WorkStealingQueue::taken()
+{
+    --mQueued;
+    size_t pending = --mPending;
+    if (mSpaceWaiters)
+    {
+        { Lock lk(mWaitMutex); }
+        mSpaceCond.notify_one();
+    }
+    if (! pending && mClosed && mWorkWaiters)
+    {
+        // last one, let the other workers see done()
+        { Lock lk(mWaitMutex); }
+        mWorkCond.notify_all();
+    }
+}
+
+size_t LL::WorkStealingQueue::currentWorker() const
+{
+    const WorkerSlot& slot = worker_slot();
+    return (slot.mQueue == mId)? slot.mIndex : ANY_WORKER;
+}
+
+LL::WorkStealingQueue::Work LL::WorkStealingQueue::pop_()
+{
+    // Any thread that blocks waiting on this queue is one of its workers
+    size_t worker = currentWorker();
+    if (worker == ANY_WORKER)
+    {
+        size_t index = mWorkerCount++;
+        if (index < MAX_WORKERS)
+        {
+            mWorkers[index] = new Lanes();
+            worker_slot() = WorkerSlot{ mId, index };
+            worker = index;
+        }
+    }
+
+    Work work;
+    for (;;)
+    {
+        // Look around a few times before sleeping, waking a worker for
+        // every post costs more than the work when tasks are small
+        for (int spin = 0; spin < SPIN_BEFORE_WAIT; ++spin)
+        {
+            if (take(work, worker))
+            {
+                taken();
+                return work;
+            }
+            std::this_thread::yield();
+        }
+
+        Lock lk(mWaitMutex);
+        ++mWorkWaiters;
+        while (! mQueued && ! (mClosed && ! mPending))
+        {
+            mWorkCond.wait(lk);
+        }
+        --mWorkWaiters;
+        if (! mQueued && mClosed && ! mPending)
+        {
+            LLTHROW(Closed());
+        }
+    }
+}
+
+bool LL::WorkStealingQueue::tryPop_(Work& work)
+{
+    if (take(work, currentWorker()))
+    {
+        taken();
+        return true;
+    }
+    return false;
+}
@@ -17,9 +17,14 @@
 #include "llinstancetracker.h"
 #include "llinstancetrackersubclass.h"
 #include "threadsafeschedule.h"
+#include LLCOROS_MUTEX_HEADER
+#include LLCOROS_CONDVAR_HEADER
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <exception>                // std::current_exception
 #include <functional>               // std::function
+#include <mutex>
 #include <string>
 
 namespace LL
@@ -46,6 +51,32 @@ namespace LL
             Error(const std::string& what): LLException(what) {}
         };
 
+        enum Priority
+        {
+            PRIORITY_HIGH,
+            PRIORITY_NORMAL,
+            PRIORITY_LOW,
+            PRIORITY_COUNT
+        };
+        static constexpr size_t ANY_WORKER = size_t(-1);
+
+        /**
+         * Scheduling hints for post(). WorkStealingQueue runs higher
+         * priority work first and keeps work posted with the same worker
+         * number on the same worker thread unless another one is idle.
+         * Other queues ignore hints.
+         */
+        struct Hint
+        {
+            Hint(Priority priority=PRIORITY_NORMAL, size_t worker=ANY_WORKER):
+                mPriority(priority),
+                mWorker(worker)
+            {}
+
+            Priority mPriority;
+            size_t mWorker;
+        };
+
         /**
          * You may omit the WorkQueueBase name, in which case a unique name is
          * synthesized; for practical purposes that makes it anonymous.
@@ -85,6 +116,10 @@ namespace LL
         /// fire-and-forget
         virtual void post(const Work&) = 0;
 
+        /// fire-and-forget with scheduling hints, postTo() and
+        /// waitForResult() pass a trailing Hint or Priority through here
+        virtual void post(const Work& callable, const Hint&) { post(callable); }
+
         /**
          * post work, unless the queue is closed before we can post
          */
@@ -246,6 +281,8 @@ namespace LL
 
         /// fire-and-forget
         void post(const Work&) override;
+        // hints are ignored
+        using WorkQueueBase::post;
 
         /**
          * post work, unless the queue is closed before we can post
@@ -363,6 +400,116 @@ namespace LL
         bool tryPop_(Work&) override;
     };
 
+/*****************************************************************************
+*   WorkStealingQueue: per-worker queues, priorities and affinity
+*****************************************************************************/
+    /**
+     * WorkStealingQueue is meant to be serviced by a pool of threads (see
+     * WorkStealingThreadPool). Each thread that calls runUntilClose() gets
+     * its own queue. Work posted by a worker goes to that worker's own
+     * queue, work posted with a Hint naming a worker goes to that worker's
+     * queue, other work goes to a shared queue. A worker with nothing of its
+     * own to do takes from the shared queue, then from other workers. So
+     * workers mostly don't contend for one lock, and a burst of small tasks
+     * spawned by one task stays on the thread that spawned it.
+     *
+     * Every queue has one FIFO per Priority. Higher priority work anywhere
+     * runs before lower priority work. There's no ordering between work in
+     * different queues.
+     */
+    class WorkStealingQueue: public LLInstanceTrackerSubclass<WorkStealingQueue, WorkQueueBase>
+    {
+    private:
+        using super = LLInstanceTrackerSubclass<WorkStealingQueue, WorkQueueBase>;
+
+    public:
+        /// Threads beyond this many that service the queue only take from
+        /// others
+        static constexpr size_t MAX_WORKERS = 64;
+
+        /**
+         * You may omit the WorkStealingQueue name, in which case a unique
+         * name is synthesized; for practical purposes that makes it
+         * anonymous.
+         */
+        WorkStealingQueue(const std::string& name = std::string(), size_t capacity=1024);
+        ~WorkStealingQueue();
+
+        void close() override;
+
+        size_t size() override;
+        /// producer end: are we prevented from pushing any additional items?
+        bool isClosed() override;
+        /// consumer end: are we done, is the queue entirely drained?
+        bool done() override;
+
+        /*---------------------- fire and forget API -----------------------*/
+
+        /// fire-and-forget
+        void post(const Work&) override;
+
+        /// fire-and-forget with a priority and/or a preferred worker
+        void post(const Work&, const Hint&) override;
+
+        /**
+         * post work, unless the queue is closed before we can post
+         */
+        bool postIfOpen(const Work&) override;
+        bool postIfOpen(const Work&, const Hint&);
+
+        /**
+         * post work, unless the queue is full
+         */
+        bool tryPost(const Work&) override;
+        bool tryPost(const Work&, const Hint&);
+
+        /// how many items were run by a worker other than the one they were
+        /// queued for, for tuning
+        size_t getStealCount() const { return mSteals; }
+
+    private:
+        struct Lanes
+        {
+            Lanes();
+
+            bool pop(size_t priority, Work& work);
+
+            std::mutex mMutex;
+            std::deque<Work> mWork[PRIORITY_COUNT];
+            // lets takers skip empty lanes without locking
+            std::atomic<size_t> mCount[PRIORITY_COUNT];
+        };
+
+        enum PushMode { PUSH_WAIT, PUSH_IF_OPEN, PUSH_TRY };
+        bool push(const Work& work, const Hint& hint, PushMode mode);
+        bool take(Work& work, size_t worker);
+        void taken();
+        size_t currentWorker() const;
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+
+        const size_t mCapacity;
+        // tells this queue's workers from a later queue at the same address
+        const U64 mId;
+        Lanes mShared;
+        std::atomic<Lanes*> mWorkers[MAX_WORKERS];
+        std::atomic<size_t> mWorkerCount;
+        // posted, including posts still on their way into a queue
+        std::atomic<size_t> mPending;
+        // actually in a queue
+        std::atomic<size_t> mQueued;
+        std::atomic<size_t> mSteals;
+        std::atomic<bool> mClosed;
+
+        // for waiting on work or space, not taken to post or take
+        LLCoros::Mutex mWaitMutex;
+        LLCoros::ConditionVariable mWorkCond;
+        LLCoros::ConditionVariable mSpaceCond;
+        std::atomic<size_t> mWorkWaiters;
+        std::atomic<size_t> mSpaceWaiters;
+    };
+
     /**
      * BackJack is, in effect, a hand-rolled lambda, binding a WorkSchedule, a
      * CALLABLE that returns bool, a TimePoint and an interval at which to
@@ -134,6 +134,35 @@ const HttpTime HTTP_RETRY_BACKOFF_MIN_DEFAULT = 1E6L; // 1 sec
 const HttpTime HTTP_RETRY_BACKOFF_MAX_DEFAULT = 5E6L; // 5 sec
 const HttpTime HTTP_RETRY_BACKOFF_MAX = 20E6L; // 20 sec
 
+// Longest 'Retry-After' we honor.  Longer ones fall back to
+// normal backoff.
+const HttpTime HTTP_RETRY_AFTER_MAX = 30E6L; // 30 sec
+
+// Per-origin retry budget, for classes with PO_RETRY_BUDGET set.
+// A request failing on its first try spends a token, its retries
+// don't.  Each success earns back a tenth of a token and the budget
+// refills by itself at HTTP_RETRY_BUDGET_REFILL_RATE tokens a second.
+// Retries are only made while at least half the budget is left so
+// an origin that starts failing gets a short burst of retries and
+// then about one for every ten requests that succeed instead of a
+// retry for every request.
+const double HTTP_RETRY_BUDGET_TOKENS = 10.0;
+const double HTTP_RETRY_BUDGET_REFILL = 0.1;
+const double HTTP_RETRY_BUDGET_REFILL_RATE = 0.5;
+
+// Origins with no requests outstanding are forgotten after this
+// long without a completion.  Checked at most this often.
+const HttpTime HTTP_ORIGIN_IDLE_TIME = 300E6L; // 5 min
+
+// Hedged requests.  Delay is per-class in milliseconds, zero
+// disables hedging.  No more than one hedge is issued for every
+// HTTP_HEDGE_RATIO requests completed by an origin and none while
+// its error rate is above HTTP_HEDGE_ERROR_RATE_MAX.
+const long HTTP_HEDGE_DELAY_DEFAULT = 0L;
+const long HTTP_HEDGE_DELAY_MAX = 10000L;
+const int HTTP_HEDGE_RATIO = 20;
+const double HTTP_HEDGE_ERROR_RATE_MAX = 0.1;
+
 const int HTTP_REDIRECTS_DEFAULT = 10;
 
 // Timeout value used for both connect and protocol exchange.
@@ -153,6 +182,19 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 stream limits, per policy class
+const long HTTP_STREAM_LIMIT_DEFAULT = 0L;
+const long HTTP_STREAM_LIMIT_MAX = 256L;
+
+// Most space reserved up front for a response body in a single
+// contiguous block.  Ranged requests reserve no more than the range
+// asked for, others no more than HTTP_CONTIGUOUS_RESERVE_MAX, as
+// Content-Length comes from the server.  Anything beyond the
+// reservation, or bodies without a length, are received in
+// BufferArray::BLOCK_ALLOC_SIZE blocks.
+const long HTTP_CONTIGUOUS_BODY_MAX = 64L * 1024L * 1024L;
+const long HTTP_CONTIGUOUS_RESERVE_MAX = 4L * 1024L * 1024L;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
@@ -160,9 +202,15 @@ const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
 // Tuning parameters
 
 // Time worker thread sleeps after a pass through the
-// request, ready and active queues.
+// request, ready and active queues.  Only used where libcurl
+// can't wait for events itself or has nothing to wait on.
 const int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 
+// Longest time worker thread blocks waiting for transport
+// events while requests are active.  A backstop, libcurl's
+// own timeouts and policy deadlines normally end waits sooner.
+const int HTTP_SERVICE_LOOP_WAIT_MAX_MS = 100;
+
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
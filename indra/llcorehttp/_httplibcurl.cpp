@@ -30,8 +30,10 @@
 #include "bufferarray.h"
 #include "_httpoprequest.h"
 #include "_httppolicy.h"
+#include "_httprequestqueue.h"
 
 #include "llhttpconstants.h"
+#include "lltimer.h"
 
 namespace
 {
@@ -63,8 +65,11 @@ HttpLibcurl::HttpLibcurl(HttpService * service)
 	  mHandleCache(),
 	  mPolicyCount(0),
 	  mMultiHandles(nullptr),
+	  mSharedMultiHandle(nullptr),
 	  mActiveHandles(nullptr),
-	  mDirtyPolicy(nullptr)
+	  mDirtyPolicy(nullptr),
+	  mSharedPolicy(nullptr),
+	  mWaitMultiHandle(nullptr)
 {}
 
 
@@ -105,6 +110,28 @@ void HttpLibcurl::shutdown()
 
 		delete [] mDirtyPolicy;
 		mDirtyPolicy = nullptr;
+
+		delete [] mSharedPolicy;
+		mSharedPolicy = nullptr;
+	}
+
+	if (mSharedMultiHandle)
+	{
+		curl_multi_cleanup(mSharedMultiHandle);
+		mSharedMultiHandle = nullptr;
+	}
+
+	if (mWaitMultiHandle)
+	{
+		// Queue outlives the service, stop it calling into a
+		// handle that's going away.
+		HttpRequestQueue * queue(HttpRequestQueue::instanceOf());
+		if (queue)
+		{
+			queue->setWakeup(HttpRequestQueue::wakeup_t());
+		}
+		curl_multi_cleanup(mWaitMultiHandle);
+		mWaitMultiHandle = nullptr;
 	}
 
 	mPolicyCount = 0;
@@ -120,6 +147,7 @@ void HttpLibcurl::start(int policy_count)
 	mMultiHandles = new CURLM * [mPolicyCount];
 	mActiveHandles = new int [mPolicyCount];
 	mDirtyPolicy = new bool [mPolicyCount];
+	mSharedPolicy = new bool [mPolicyCount]();			// sharedPolicyUpdated() reads them all
 	
 	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
 	{
@@ -132,6 +160,20 @@ void HttpLibcurl::start(int policy_count)
 		mDirtyPolicy[policy_class] = false;
 		policyUpdated(policy_class);
 	}
+
+#if LLCORE_HTTP_MULTI_POLL
+	// Requests added to the queue interrupt waitForEvents()
+	if (nullptr == (mWaitMultiHandle = curl_multi_init()))
+	{
+		LL_ERRS(LOG_CORE) << "Failed to allocate multi handle in libcurl."
+						  << LL_ENDL;
+	}
+	CURLM * wait_handle(mWaitMultiHandle);
+	mService->getRequestQueue().setWakeup([wait_handle]()
+										  {
+											  curl_multi_wakeup(wait_handle);
+										  });
+#endif
 }
 
 
@@ -140,10 +182,13 @@ void HttpLibcurl::start(int policy_count)
 //
 // If active list goes empty *and* we didn't queue any
 // requests for retry, we return a request for a hard
-// sleep otherwise ask for a normal polling interval.
+// sleep.  If anything completed, ask to come straight
+// back as policy may have work for the freed slots.
+// Otherwise, we can wait for socket activity.
 HttpService::ELoopSpeed HttpLibcurl::processTransport()
 {
 	HttpService::ELoopSpeed	ret(HttpService::REQUEST_SLEEP);
+	bool shared_active(false);
 
 	// Give libcurl some cycles to do I/O & callbacks
 	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
@@ -163,54 +208,204 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 			}
 			continue;
 		}
-		
-		int running(0);
-		CURLMcode status(CURLM_CALL_MULTI_PERFORM);
-		do
+		if (mSharedPolicy[policy_class])
 		{
-			running = 0;
-			status = curl_multi_perform(mMultiHandles[policy_class], &running);
+			// Serviced once below for all sharing classes
+			shared_active = true;
+			continue;
 		}
-		while (0 != running && CURLM_CALL_MULTI_PERFORM == status);
 
-		// Run completion on anything done
-		CURLMsg * msg(nullptr);
-		int msgs_in_queue(0);
-		while ((msg = curl_multi_info_read(mMultiHandles[policy_class], &msgs_in_queue)))
+		if (performMulti(mMultiHandles[policy_class]))
 		{
-			if (CURLMSG_DONE == msg->msg)
-			{
-				CURL * handle(msg->easy_handle);
-				CURLcode result(msg->data.result);
-
-				completeRequest(mMultiHandles[policy_class], handle, result);
-				handle = nullptr;					// No longer valid on return
-				ret = HttpService::NORMAL;		// If anything completes, we may have a free slot.
-												// Turning around quickly reduces connection gap by 7-10mS.
-			}
-			else if (CURLMSG_NONE == msg->msg)
-			{
-				// Ignore this... it shouldn't mean anything.
-				;
-			}
-			else
-			{
-				LL_WARNS_ONCE(LOG_CORE) << "Unexpected message from libcurl.  Msg code:  "
-										<< msg->msg
-										<< LL_ENDL;
-			}
-			msgs_in_queue = 0;
+			ret = HttpService::NORMAL;		// If anything completes, we may have a free slot.
+											// Turning around quickly reduces connection gap by 7-10mS.
 		}
 	}
 
-	if (! mActiveOps.empty())
+	if (shared_active && performMulti(mSharedMultiHandle))
 	{
 		ret = HttpService::NORMAL;
 	}
+
+	if (HttpService::REQUEST_SLEEP == ret && ! mActiveOps.empty())
+	{
+		ret = HttpService::WAIT;
+	}
 	return ret;
 }
 
 
+void HttpLibcurl::waitForEvents(HttpTime deadline)
+{
+#if LLCORE_HTTP_MULTI_POLL
+	long timeout_ms(HTTP_SERVICE_LOOP_WAIT_MAX_MS);
+	if (deadline)
+	{
+		const HttpTime now(totalTime());
+		timeout_ms = (deadline <= now
+					  ? 0L
+					  : (std::min)(timeout_ms, long((deadline - now + 999) / 1000)));
+	}
+
+	// Gather sockets from every multi handle with work
+	mWaitFds.clear();
+	bool watching(true);
+	bool shared_active(false);
+	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+	{
+		if (! mMultiHandles[policy_class] || ! mActiveHandles[policy_class])
+		{
+			continue;
+		}
+		if (mSharedPolicy[policy_class])
+		{
+			shared_active = true;
+			continue;
+		}
+		watching = addWaitFds(mMultiHandles[policy_class], timeout_ms) && watching;
+	}
+	if (shared_active)
+	{
+		watching = addWaitFds(mSharedMultiHandle, timeout_ms) && watching;
+	}
+	if (! watching)
+	{
+		// A request without a socket yet (resolving, say), fall
+		// back to polling until it has one.
+		timeout_ms = (std::min)(timeout_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+	}
+
+	if (timeout_ms > 0L)
+	{
+		check_curl_multi_code(curl_multi_poll(mWaitMultiHandle,
+											  mWaitFds.empty() ? nullptr : &mWaitFds[0],
+											  unsigned(mWaitFds.size()),
+											  int(timeout_ms),
+											  nullptr));
+	}
+#else
+	ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+#endif
+}
+
+
+bool HttpLibcurl::addWaitFds(CURLM * multi_handle, long & timeout_ms)
+{
+#if LLCORE_HTTP_MULTI_POLL
+	long curl_timeout(-1L);
+	check_curl_multi_code(curl_multi_timeout(multi_handle, &curl_timeout));
+	if (curl_timeout >= 0L)
+	{
+		timeout_ms = (std::min)(timeout_ms, curl_timeout);
+	}
+
+	// curl_multi_waitfds() would be the direct route but needs
+	// 8.8.0.  fd_sets work everywhere.
+	fd_set read_fds, write_fds, exc_fds;
+	FD_ZERO(&read_fds);
+	FD_ZERO(&write_fds);
+	FD_ZERO(&exc_fds);
+	int max_fd(-1);
+	check_curl_multi_code(curl_multi_fdset(multi_handle, &read_fds, &write_fds, &exc_fds, &max_fd));
+	if (max_fd < 0)
+	{
+		return false;
+	}
+
+	curl_waitfd wait_fd;
+#if LL_WINDOWS
+	// Windows fd_sets are arrays of sockets, not bitmaps
+	for (u_int i(0); i < read_fds.fd_count; ++i)
+	{
+		wait_fd.fd = read_fds.fd_array[i];
+		wait_fd.events = CURL_WAIT_POLLIN;
+		wait_fd.revents = 0;
+		mWaitFds.push_back(wait_fd);
+	}
+	for (u_int i(0); i < write_fds.fd_count; ++i)
+	{
+		wait_fd.fd = write_fds.fd_array[i];
+		wait_fd.events = CURL_WAIT_POLLOUT;
+		wait_fd.revents = 0;
+		mWaitFds.push_back(wait_fd);
+	}
+#else
+	for (int fd(0); fd <= max_fd; ++fd)
+	{
+		short events(0);
+		if (FD_ISSET(fd, &read_fds))
+		{
+			events |= CURL_WAIT_POLLIN;
+		}
+		if (FD_ISSET(fd, &write_fds))
+		{
+			events |= CURL_WAIT_POLLOUT;
+		}
+		if (FD_ISSET(fd, &exc_fds))
+		{
+			events |= CURL_WAIT_POLLPRI;
+		}
+		if (events)
+		{
+			wait_fd.fd = fd;
+			wait_fd.events = events;
+			wait_fd.revents = 0;
+			mWaitFds.push_back(wait_fd);
+		}
+	}
+#endif	// LL_WINDOWS
+	return true;
+#else
+	return false;
+#endif	// LLCORE_HTTP_MULTI_POLL
+}
+
+
+bool HttpLibcurl::performMulti(CURLM * multi_handle)
+{
+	bool completed(false);
+
+	int running(0);
+	CURLMcode status(CURLM_CALL_MULTI_PERFORM);
+	do
+	{
+		running = 0;
+		status = curl_multi_perform(multi_handle, &running);
+	}
+	while (0 != running && CURLM_CALL_MULTI_PERFORM == status);
+
+	// Run completion on anything done
+	CURLMsg * msg(nullptr);
+	int msgs_in_queue(0);
+	while ((msg = curl_multi_info_read(multi_handle, &msgs_in_queue)))
+	{
+		if (CURLMSG_DONE == msg->msg)
+		{
+			CURL * handle(msg->easy_handle);
+			CURLcode result(msg->data.result);
+
+			completeRequest(multi_handle, handle, result);
+			handle = nullptr;					// No longer valid on return
+			completed = true;
+		}
+		else if (CURLMSG_NONE == msg->msg)
+		{
+			// Ignore this... it shouldn't mean anything.
+			;
+		}
+		else
+		{
+			LL_WARNS_ONCE(LOG_CORE) << "Unexpected message from libcurl.  Msg code:  "
+									<< msg->msg
+									<< LL_ENDL;
+		}
+		msgs_in_queue = 0;
+	}
+
+	return completed;
+}
+
+
 // Caller has provided us with a ref count on op.
 void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 {
@@ -227,7 +422,7 @@ void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 
 	// Make the request live
 	CURLMcode code;
-	code = curl_multi_add_handle(mMultiHandles[op->mReqPolicy], op->mCurlHandle);
+	code = curl_multi_add_handle(getMultiHandle(op->mReqPolicy), op->mCurlHandle);
 	if (CURLM_OK != code)
 	{
 		// *TODO:  Better cleanup and recovery but not much we can do here.
@@ -275,20 +470,49 @@ bool HttpLibcurl::cancel(HttpHandle handle)
 }
 
 
-// *NOTE:  cancelRequest logic parallels completeRequest logic.
-// Keep them synchronized as necessary.  Caller is expected to
-// remove the op from the active list and release the op *after*
-// calling this method.  It must be called first to deliver the
-// op to the reply queue with refcount intact.
-void HttpLibcurl::cancelRequest(const HttpOpRequest::ptr_t &op)
+bool HttpLibcurl::abandon(const HttpOpRequest::ptr_t & op)
+{
+	active_set_t::iterator it(mActiveOps.find(op));
+	if (mActiveOps.end() == it)
+	{
+		return false;
+	}
+
+	detachRequest(op);
+	if (op->mTracing > HTTP_TRACE_OFF)
+	{
+		LL_INFOS(LOG_CORE) << "TRACE, RequestAbandoned, Handle:  "
+						   << op->getHandle()
+						   << LL_ENDL;
+	}
+
+	mActiveOps.erase(it);
+	--mActiveHandles[op->mReqPolicy];
+
+	return true;
+}
+
+
+void HttpLibcurl::detachRequest(const HttpOpRequest::ptr_t &op)
 {
 	// Deactivate request
 	op->mCurlActive = false;
 
 	// Detach from multi and recycle handle
-	curl_multi_remove_handle(mMultiHandles[op->mReqPolicy], op->mCurlHandle);
+	curl_multi_remove_handle(getMultiHandle(op->mReqPolicy), op->mCurlHandle);
 	mHandleCache.freeHandle(op->mCurlHandle);
 	op->mCurlHandle = NULL;
+}
+
+
+// *NOTE:  cancelRequest logic parallels completeRequest logic.
+// Keep them synchronized as necessary.  Caller is expected to
+// remove the op from the active list and release the op *after*
+// calling this method.  It must be called first to deliver the
+// op to the reply queue with refcount intact.
+void HttpLibcurl::cancelRequest(const HttpOpRequest::ptr_t &op)
+{
+	detachRequest(op);
 
 	// Tracing
 	if (op->mTracing > HTTP_TRACE_OFF)
@@ -451,6 +675,13 @@ void HttpLibcurl::policyUpdated(int policy_class)
 	}
 	
 	HttpPolicy & policy(mService->getPolicy());
+
+	if (mSharedPolicy[policy_class] && policy.getClassOptions(policy_class).mStreamLimit > 0)
+	{
+		// Staying on the shared handle, no need to wait for quiet
+		sharedPolicyUpdated();
+		return;
+	}
 	
 	if (! mActiveHandles[policy_class])
 	{
@@ -476,6 +707,21 @@ void HttpLibcurl::policyUpdated(int policy_class)
 		policy.stallPolicy(policy_class, false);
 		mDirtyPolicy[policy_class] = false;
 
+		// Moving between the private and shared handles is safe
+		// here too, the class has nothing on either.
+		const bool was_shared(mSharedPolicy[policy_class]);
+		mSharedPolicy[policy_class] = options.mStreamLimit > 0;
+		if (mSharedPolicy[policy_class] || was_shared)
+		{
+			sharedPolicyUpdated();
+		}
+
+		if (mSharedPolicy[policy_class])
+		{
+			// Private handle sits unused while the class is shared
+			return;
+		}
+
 		if (options.mPipelining > 1)
 		{
 			// We'll try to do pipelining on this multihandle
@@ -517,6 +763,57 @@ void HttpLibcurl::policyUpdated(int policy_class)
 	}
 }
 
+void HttpLibcurl::sharedPolicyUpdated()
+{
+	// Every class on the shared handle multiplexes, so unlike the
+	// private handles there's no pipelining transition to stall for
+	// and options can change with requests active.
+	HttpPolicy & policy(mService->getPolicy());
+	long per_host_limit(0L);
+	long stream_limit(0L);
+	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+	{
+		if (mSharedPolicy[policy_class])
+		{
+			const HttpPolicyClass & options(policy.getClassOptions(policy_class));
+			per_host_limit = llmax(per_host_limit, options.mPerHostConnectionLimit);
+			stream_limit = llmax(stream_limit, options.mStreamLimit);
+		}
+	}
+	if (! stream_limit)
+	{
+		// Nobody left sharing, keep the handle for later
+		return;
+	}
+
+	if (! mSharedMultiHandle)
+	{
+		if (nullptr == (mSharedMultiHandle = curl_multi_init()))
+		{
+			LL_ERRS(LOG_CORE) << "Failed to allocate multi handle in libcurl."
+							  << LL_ENDL;
+		}
+	}
+
+	check_curl_multi_setopt(mSharedMultiHandle,
+							 CURLMOPT_PIPELINING,
+							 long(CURLPIPE_MULTIPLEX));
+	// Bounds connections to HTTP/1.1 servers, an HTTP/2 origin
+	// needs only one.
+	check_curl_multi_setopt(mSharedMultiHandle,
+							 CURLMOPT_MAX_HOST_CONNECTIONS,
+							 per_host_limit);
+	check_curl_multi_setopt(mSharedMultiHandle,
+							 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+							 policy.getGlobalOptions().mConnectionLimit);
+#if LIBCURL_VERSION_NUM >= 0x074300
+	// CURLMOPT_MAX_CONCURRENT_STREAMS arrived in 7.67.0
+	check_curl_multi_setopt(mSharedMultiHandle,
+							 CURLMOPT_MAX_CONCURRENT_STREAMS,
+							 stream_limit);
+#endif
+}
+
 // ---------------------------------------
 // HttpLibcurl::HandleCache
 // ---------------------------------------
@@ -33,12 +33,24 @@
 #include <curl/multi.h>
 
 #include <set>
+#include <vector>
 
 #include "httprequest.h"
 #include "_httpservice.h"
 #include "_httpinternal.h"
 
 
+// If '1', the worker thread blocks in curl_multi_poll() between
+// passes and new requests interrupt it with curl_multi_wakeup().
+// Otherwise it sleeps for HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS.
+// curl_multi_wakeup() arrived in 7.68.0.
+#if LIBCURL_VERSION_NUM >= 0x074400
+#define	LLCORE_HTTP_MULTI_POLL		1
+#else
+#define	LLCORE_HTTP_MULTI_POLL		0
+#endif
+
+
 namespace LLCore
 {
 
@@ -77,6 +89,15 @@ public:
 	/// Threading:  called by worker thread.
 	HttpService::ELoopSpeed processTransport();
 
+	/// Block until a socket of an active request is ready, a
+	/// libcurl timeout expires, @deadline passes or a request is
+	/// queued to the service.  @deadline is a totalTime() value,
+	/// zero for none.  Never blocks longer than
+	/// HTTP_SERVICE_LOOP_WAIT_MAX_MS.
+	///
+	/// Threading:  called by worker thread.
+	void waitForEvents(HttpTime deadline);
+
 	/// Add request to the active list.  Caller is expected to have
 	/// provided us with a reference count on the op to hold the
 	/// request.  (No additional references will be added.)
@@ -118,6 +139,16 @@ public:
 	/// Threading:  called by worker thread.
 	bool cancel(HttpHandle handle);
 
+	/// Stop an active request without completing it.  Unlike
+	/// cancel(), nothing is delivered to the reply queue, the
+	/// caller takes over the request.  Used by policy to drop the
+	/// loser of a hedged pair.
+	///
+	/// @return			True if request was active and is now stopped.
+	///
+	/// Threading:  called by worker thread.
+	bool abandon(const opReqPtr_t & op);
+
 	/// Informs transport that a particular policy class has had
 	/// options changed and so should effect any transport state
 	/// change necessary to effect those changes.  Used mainly for
@@ -151,6 +182,34 @@ protected:
 	/// Invoked to cancel an active request, mainly during shutdown
 	/// and destroy.
     void cancelRequest(const opReqPtr_t &op);
+
+	/// Detach an active request from libcurl and release its
+	/// easy handle.
+	void detachRequest(const opReqPtr_t &op);
+
+	/// Runs libcurl on one multi handle and completes whatever
+	/// it reports as done.
+	///
+	/// @return			True if any request completed.
+	bool performMulti(CURLM * multi_handle);
+
+	/// Adds the sockets libcurl is watching for a multi handle to
+	/// mWaitFds and lowers @timeout_ms to its next timeout.
+	///
+	/// @return			False if libcurl had no sockets to offer.
+	bool addWaitFds(CURLM * multi_handle, long & timeout_ms);
+
+	/// Multi handle a policy class' requests are added to.  Classes
+	/// with a stream limit share mSharedMultiHandle, others have
+	/// their own.
+	CURLM * getMultiHandle(int policy_class) const
+		{
+			return mSharedPolicy[policy_class] ? mSharedMultiHandle : mMultiHandles[policy_class];
+		}
+
+	/// Applies the combined options of all classes on the shared
+	/// multi handle.
+	void sharedPolicyUpdated();
 	
 protected:
     typedef std::set<opReqPtr_t> active_set_t;
@@ -213,8 +272,14 @@ protected:
 	active_set_t		mActiveOps;
 	int					mPolicyCount;
 	CURLM **			mMultiHandles;		// One handle per policy class
+	CURLM *				mSharedMultiHandle;	// Multiplexing handle for classes with stream limits
 	int *				mActiveHandles;		// Active count per policy class
 	bool *				mDirtyPolicy;		// Dirty policy update waiting for stall (per pc)
+	bool *				mSharedPolicy;		// Class uses mSharedMultiHandle (per pc)
+	CURLM *				mWaitMultiHandle;	// Empty handle waitForEvents() blocks in
+#if LLCORE_HTTP_MULTI_POLL
+	std::vector<curl_waitfd> mWaitFds;		// Scratch for waitForEvents()
+#endif
 	
 }; // end class HttpLibcurl
 
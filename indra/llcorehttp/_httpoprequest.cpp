@@ -153,6 +153,9 @@ HttpOpRequest::HttpOpRequest()
 	  mPolicyRetryLimit(HTTP_RETRY_COUNT_DEFAULT),
 	  mPolicyMinRetryBackoff(HttpTime(HTTP_RETRY_BACKOFF_MIN_DEFAULT)),
 	  mPolicyMaxRetryBackoff(HttpTime(HTTP_RETRY_BACKOFF_MAX_DEFAULT)),
+	  mPolicyOrigin(nullptr),
+	  mPolicyStagedAt(HttpTime(0)),
+	  mPolicyIsHedge(false),
 	  mCallbackSSLVerify(NULL)
 {
 	// *NOTE:  As members are added, retry initialization/cleanup
@@ -300,6 +303,53 @@ HttpStatus HttpOpRequest::cancel()
 }
 
 
+HttpOpRequest::ptr_t HttpOpRequest::createHedge() const
+{
+	llassert_always(HOR_GET == mReqMethod);
+
+	ptr_t hedge(new HttpOpRequest());
+
+	// Same request, no reply queue or handler so that only the
+	// original is ever delivered.
+	hedge->mReqPolicy = mReqPolicy;
+	hedge->mReqPriority = mReqPriority;
+	hedge->mTracing = mTracing;
+	hedge->mProcFlags = mProcFlags;
+	hedge->mCallbackSSLVerify = mCallbackSSLVerify;
+	hedge->mReqMethod = mReqMethod;
+	hedge->mReqURL = mReqURL;
+	hedge->mReqOffset = mReqOffset;
+	hedge->mReqLength = mReqLength;
+	hedge->mReqHeaders = mReqHeaders;
+	hedge->mReqOptions = mReqOptions;
+	hedge->mPolicyRetryLimit = 0;
+	hedge->mPolicyOrigin = mPolicyOrigin;
+	hedge->mPolicyIsHedge = true;
+	hedge->mPolicyHedgeOf = std::dynamic_pointer_cast<HttpOpRequest>(
+		std::const_pointer_cast<HttpOperation>(shared_from_this()));
+
+	return hedge;
+}
+
+
+void HttpOpRequest::adoptReply(HttpOpRequest & hedge)
+{
+	mStatus = hedge.mStatus;
+	if (mReplyBody)
+	{
+		mReplyBody->release();
+	}
+	mReplyBody = hedge.mReplyBody;
+	hedge.mReplyBody = nullptr;
+	mReplyOffset = hedge.mReplyOffset;
+	mReplyLength = hedge.mReplyLength;
+	mReplyFullLength = hedge.mReplyFullLength;
+	mReplyHeaders = hedge.mReplyHeaders;
+	mReplyConType = hedge.mReplyConType;
+	mReplyRetryAfter = hedge.mReplyRetryAfter;
+}
+
+
 HttpStatus HttpOpRequest::setupGet(HttpRequest::policy_t policy_id,
 								   HttpRequest::priority_t priority,
 								   const std::string & url,
@@ -709,9 +759,9 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	{
 		xfer_timeout = timeout;
 	}
-	if (cpolicy.mPipelining > 1L)
+	if (cpolicy.mPipelining > 1L || cpolicy.mStreamLimit > 0L)
 	{
-		// Pipelining affects both connection and transfer timeout values.
+		// Pipelining (and multiplexing) affects both connection and transfer timeout values.
 		// Requests that are added to a pipeling immediately have completed
 		// their connection so the connection delay tends to be less than
 		// the non-pipelined value.  Transfers are the opposite.  Transfer
@@ -737,13 +787,14 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 		//
 		// xfer_timeout *= cpolicy.mPipelining;
 		xfer_timeout *= 2L;
-
-		// Also try requesting HTTP/2.
-/******************************/
-		// but for test purposes, only if overriding VIEWERASSET
-		if (getenv("VIEWERASSET"))
-/******************************/
-		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
+	}
+	if (cpolicy.mStreamLimit > 0L)
+	{
+		// Offer HTTP/2 in the TLS handshake and wait for a connection
+		// that can multiplex rather than opening another one.  Servers
+		// that don't speak HTTP/2 get HTTP/1.1 as before.
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
 	}
 	// *DEBUG:  Enable following override for timeout handling and "[curl:bugs] #1420" tests
     //if (cpolicy.mPipelining)
@@ -783,6 +834,21 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
 	if (! op->mReplyBody)
 	{
 		op->mReplyBody = new BufferArray();
+
+		// Headers are in by now.  With a known length, have the body
+		// land in one block the consumer can use in place or adopt.
+		// The length is the server's word so only reserve what was
+		// asked for, or a few MB without a range, and let anything
+		// bigger grow a block at a time.
+		curl_off_t length(-1);
+		if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length)
+			&& length > 0)
+		{
+			const curl_off_t limit(op->mReqLength
+								   ? curl_off_t((std::min)(op->mReqLength, size_t(HTTP_CONTIGUOUS_BODY_MAX)))
+								   : curl_off_t(HTTP_CONTIGUOUS_RESERVE_MAX));
+			op->mReplyBody->reserveContiguous(size_t((std::min)(length, limit)));
+		}
 	}
 	const size_t req_size(size * nmemb);
 	const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
@@ -49,6 +49,7 @@ namespace LLCore
 
 
 class BufferArray;
+class HttpOriginHealth;
 
 
 /// HttpOpRequest requests a supported HTTP method invocation with
@@ -166,6 +167,20 @@ public:
 	
 	virtual HttpStatus cancel();
 
+	// Create a copy of this GET request to race it.  The copy has
+	// no notifier and isn't retried, @see HttpPolicy for how the
+	// two are reconciled.
+	//
+	// Threading:  called by worker thread
+	//
+	ptr_t createHedge() const;
+
+	// Take over the response of a hedge that finished first.
+	//
+	// Threading:  called by worker thread
+	//
+	void adoptReply(HttpOpRequest & hedge);
+
 protected:
 	// Common setup for all the request methods.
 	//
@@ -235,6 +250,11 @@ public:
 	int					mPolicyRetryLimit;
 	HttpTime			mPolicyMinRetryBackoff; // initial delay between retries (mcs)
 	HttpTime			mPolicyMaxRetryBackoff;
+	std::shared_ptr<HttpOriginHealth> mPolicyOrigin;	// Shared with HttpPolicy while in use
+	HttpTime			mPolicyStagedAt;		// When last made active
+	ptr_t				mPolicyHedge;			// Hedge racing this request, if any
+	bool				mPolicyIsHedge;
+	std::weak_ptr<HttpOpRequest> mPolicyHedgeOf;	// Request this one is a hedge for
 };  // end class HttpOpRequest
 
 
@@ -0,0 +1,204 @@
+/**
+ * @file _httporigin.cpp
+ * @brief Internal definitions for per-origin health tracking
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "_httporigin.h"
+
+#include <algorithm>
+#include <cctype>
+
+
+namespace
+{
+
+// Gain for the error rate average, as TCP uses for its round trip estimate
+const double ERROR_RATE_GAIN = 0.125;
+
+// Latency samples needed before the estimate is trusted for hedging
+const long HEDGE_MIN_SAMPLES = 8L;
+
+} // end anonymous namespace
+
+
+namespace LLCore
+{
+
+
+HttpOriginHealth::HttpOriginHealth(const std::string & origin)
+	: mOrigin(origin),
+	  mErrorRate(0.0),
+	  mLatency(0),
+	  mLatencyVar(0),
+	  mLatencySamples(0L),
+	  mHoldUntil(0),
+	  mRetryTokens(HTTP_RETRY_BUDGET_TOKENS),
+	  mRetryRefilledAt(0),
+	  mLastCompletion(0),
+	  mCompleted(0L),
+	  mFailed(0L),
+	  mThrottled(0L),
+	  mRetries(0L),
+	  mRetriesDenied(0L),
+	  mHedges(0L),
+	  mHedgesWon(0L)
+{}
+
+
+// static
+std::string HttpOriginHealth::originOf(const std::string & url)
+{
+	std::string::size_type start(url.find("://"));
+	start = (std::string::npos == start) ? 0 : start + 3;
+	const std::string::size_type end(url.find_first_of("/?#", start));
+
+	std::string origin(url, 0, end);
+	std::transform(origin.begin(), origin.end(), origin.begin(),
+				   [](unsigned char c) { return char(std::tolower(c)); });
+	return origin;
+}
+
+
+void HttpOriginHealth::recordCompletion(const HttpStatus & status,
+										HttpTime now,
+										HttpTime latency,
+										HttpTime retry_after,
+										bool first_try)
+{
+	static const HttpStatus too_many_requests(429);
+	static const HttpStatus service_unavailable(503);
+
+	++mCompleted;
+	mLastCompletion = now;
+	refillRetryTokens(now);
+
+	const bool failed(status.isRetryable());
+	mErrorRate += ((failed ? 1.0 : 0.0) - mErrorRate) * ERROR_RATE_GAIN;
+	if (failed)
+	{
+		++mFailed;
+		if (first_try)
+		{
+			mRetryTokens = (std::max)(mRetryTokens - 1.0, 0.0);
+		}
+	}
+	else
+	{
+		mRetryTokens = (std::min)(mRetryTokens + HTTP_RETRY_BUDGET_REFILL, HTTP_RETRY_BUDGET_TOKENS);
+
+		// Only a server that answered tells us how long it takes
+		if (! mLatencySamples++)
+		{
+			mLatency = latency;
+			mLatencyVar = latency / 2;
+		}
+		else
+		{
+			const HttpTime deviation(latency > mLatency ? latency - mLatency : mLatency - latency);
+			mLatencyVar = (3 * mLatencyVar + deviation) / 4;
+			mLatency = (7 * mLatency + latency) / 8;
+		}
+	}
+
+	if (status == too_many_requests || status == service_unavailable)
+	{
+		++mThrottled;
+		if (retry_after > 0 && retry_after <= HTTP_RETRY_AFTER_MAX)
+		{
+			// The server wants everyone to go away, not just this request
+			mHoldUntil = (std::max)(mHoldUntil, now + retry_after);
+		}
+	}
+}
+
+
+bool HttpOriginHealth::takeRetry(HttpTime now)
+{
+	refillRetryTokens(now);
+	if (mRetryTokens < HTTP_RETRY_BUDGET_TOKENS / 2.0)
+	{
+		++mRetriesDenied;
+		return false;
+	}
+	++mRetries;
+	return true;
+}
+
+
+void HttpOriginHealth::refillRetryTokens(HttpTime now)
+{
+	if (now > mRetryRefilledAt)
+	{
+		const double elapsed(double(now - mRetryRefilledAt) / 1E6);
+		mRetryTokens = (std::min)(mRetryTokens + elapsed * HTTP_RETRY_BUDGET_REFILL_RATE,
+								  HTTP_RETRY_BUDGET_TOKENS);
+		mRetryRefilledAt = now;
+	}
+}
+
+
+HttpTime HttpOriginHealth::getRetryDelay(int retries,
+										 HttpTime min_backoff,
+										 HttpTime max_backoff,
+										 double jitter) const
+{
+	// retries limited to 100
+	const U32 factor(retries <= 10 ? 1 << retries : 1024);
+	HttpTime delay((std::min)(min_backoff * factor, max_backoff));
+
+	delay = delay / 2 + HttpTime(double(delay / 2) * jitter);
+	if (delay < max_backoff)
+	{
+		delay += HttpTime(double(max_backoff - delay) * mErrorRate);
+	}
+	return (std::min)((std::max)(delay, mLatency), max_backoff);
+}
+
+
+HttpTime HttpOriginHealth::getHedgeDelay(HttpTime class_delay) const
+{
+	if (mLatencySamples < HEDGE_MIN_SAMPLES)
+	{
+		return class_delay;
+	}
+	return (std::max)(class_delay, mLatency + 4 * mLatencyVar);
+}
+
+
+bool HttpOriginHealth::takeHedge(HttpTime now)
+{
+	if (mErrorRate > HTTP_HEDGE_ERROR_RATE_MAX
+		|| now < mHoldUntil
+		|| mHedges * HTTP_HEDGE_RATIO > mCompleted)
+	{
+		return false;
+	}
+	++mHedges;
+	return true;
+}
+
+
+}  // end namespace LLCore
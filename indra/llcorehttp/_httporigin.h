@@ -0,0 +1,190 @@
+/**
+ * @file _httporigin.h
+ * @brief Internal declarations for per-origin health tracking
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef	_LLCORE_HTTP_ORIGIN_H_
+#define	_LLCORE_HTTP_ORIGIN_H_
+
+
+#include <memory>
+#include <string>
+
+#include "httpcommon.h"
+#include "_httpinternal.h"
+
+
+namespace LLCore
+{
+
+/// Health record for one origin (scheme, host and port) built
+/// from the completions of requests sent to it.  HttpPolicy keeps
+/// one per origin and consults it when scheduling retries and
+/// hedged requests so that all requests to a struggling server
+/// back off together rather than each on its own schedule.
+///
+/// Tracks:
+/// - an error rate, the moving average of retryable failures
+///   over recent completions;
+/// - a latency estimate (time from staging to completion) and its
+///   variation, maintained as TCP does for round trip times;
+/// - a hold time from 'Retry-After' headers on 503 and 429
+///   responses before which nothing should be sent;
+/// - a retry budget, @see HTTP_RETRY_BUDGET_TOKENS, consulted
+///   for classes that set PO_RETRY_BUDGET.
+///
+/// Threading:  not thread-safe.  Expected to be used entirely by
+/// the worker thread.
+class HttpOriginHealth
+{
+public:
+	typedef std::shared_ptr<HttpOriginHealth> ptr_t;
+
+	explicit HttpOriginHealth(const std::string & origin);
+
+	/// Origin of a URL as 'scheme://host[:port]', lower-cased, for
+	/// use as a key.  URLs without a scheme give the text before
+	/// the first '/'.
+	static std::string originOf(const std::string & url);
+
+	/// Record a completed request.  @latency is the time it was
+	/// active and @retry_after any delay the server asked for
+	/// (zero for none).  Both in microseconds.  Only failures on
+	/// a request's @first_try spend from the retry budget, a
+	/// request that keeps failing its retries costs no more.
+	void recordCompletion(const HttpStatus & status,
+						  HttpTime now,
+						  HttpTime latency,
+						  HttpTime retry_after,
+						  bool first_try);
+
+	/// Ask to retry a failed request.  Returns false, counting a
+	/// denial, if failures have spent too much of the retry
+	/// budget.  The failure should then be final.
+	bool takeRetry(HttpTime now);
+
+	/// Delay before retrying a request, exponential in @retries
+	/// (the number already made) between @min_backoff and
+	/// @max_backoff.  Half the delay is scaled by @jitter, in
+	/// [0, 1), so requests that failed together don't all come
+	/// back together.  Origins failing much of their traffic are
+	/// pushed toward the maximum and nothing is retried sooner
+	/// than the origin usually takes to answer, short of the
+	/// maximum.
+	HttpTime getRetryDelay(int retries,
+						   HttpTime min_backoff,
+						   HttpTime max_backoff,
+						   double jitter) const;
+
+	/// Time before which requests should not be sent, zero if
+	/// there's no hold.
+	HttpTime getHoldUntil() const
+		{
+			return mHoldUntil;
+		}
+
+	/// How long an active request may go unanswered before it's
+	/// worth hedging.  @class_delay is the class's minimum,
+	/// raised to the latency estimate plus four deviations once
+	/// there are enough samples for one.
+	HttpTime getHedgeDelay(HttpTime class_delay) const;
+
+	/// Ask to hedge a slow request.  Returns false if the origin
+	/// is failing, held or has had its share of hedges.
+	bool takeHedge(HttpTime now);
+
+	/// The hedge finished first and its response was used.
+	void recordHedgeWon()
+		{
+			++mHedgesWon;
+		}
+
+	const std::string & getOrigin() const
+		{
+			return mOrigin;
+		}
+
+	double getErrorRate() const
+		{
+			return mErrorRate;
+		}
+
+	/// Zero until the first sample.
+	HttpTime getLatency() const
+		{
+			return mLatency;
+		}
+
+	HttpTime getLatencyVar() const
+		{
+			return mLatencyVar;
+		}
+
+	double getRetryTokens() const
+		{
+			return mRetryTokens;
+		}
+
+	/// Time of the last completion, zero if none.
+	HttpTime getLastCompletion() const
+		{
+			return mLastCompletion;
+		}
+
+	// Counters
+	long getCompleted() const		{ return mCompleted; }
+	long getFailed() const			{ return mFailed; }
+	long getThrottled() const		{ return mThrottled; }
+	long getRetries() const			{ return mRetries; }
+	long getRetriesDenied() const	{ return mRetriesDenied; }
+	long getHedges() const			{ return mHedges; }
+	long getHedgesWon() const		{ return mHedgesWon; }
+
+protected:
+	// Add what the budget has earned back since it was last refilled
+	void refillRetryTokens(HttpTime now);
+
+protected:
+	std::string			mOrigin;
+	double				mErrorRate;
+	HttpTime			mLatency;
+	HttpTime			mLatencyVar;
+	long				mLatencySamples;
+	HttpTime			mHoldUntil;
+	double				mRetryTokens;
+	HttpTime			mRetryRefilledAt;
+	HttpTime			mLastCompletion;
+
+	long				mCompleted;
+	long				mFailed;
+	long				mThrottled;			// 503s and 429s
+	long				mRetries;
+	long				mRetriesDenied;
+	long				mHedges;
+	long				mHedgesWon;
+};  // end class HttpOriginHealth
+
+}  // end namespace LLCore
+
+#endif	// _LLCORE_HTTP_ORIGIN_H_
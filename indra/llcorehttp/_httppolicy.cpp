@@ -33,6 +33,8 @@
 #include "_httplibcurl.h"
 #include "_httppolicyclass.h"
 
+#include <deque>
+
 #include "lltimer.h"
 #include "httpstats.h"
 
@@ -41,6 +43,12 @@ namespace
 
 static const char * const LOG_CORE("CoreHttp");
 
+// Earlier of two wake times, zero meaning none
+inline LLCore::HttpTime earliest(LLCore::HttpTime wake, LLCore::HttpTime when)
+{
+	return (! wake || when < wake) ? when : wake;
+}
+
 } // end anonymous namespace
 
 
@@ -63,8 +71,14 @@ public:
 		  mStallStaging(false)
 		{}
 	
+	// Active GETs that may be hedged, in the order they were
+	// made active.  Stage time identifies the attempt, a request
+	// that has since completed or been retried is skipped.
+	typedef std::pair<std::weak_ptr<HttpOpRequest>, HttpTime> hedge_candidate_t;
+	
 	HttpReadyQueue		mReadyQueue;
 	HttpRetryQueue		mRetryQueue;
+	std::deque<hedge_candidate_t> mHedgeCandidates;
 
 	HttpPolicyClass		mOptions;
 	HttpTime			mThrottleEnd;
@@ -75,7 +89,10 @@ public:
 
 
 HttpPolicy::HttpPolicy(HttpService * service)
-	: mService(service)
+	: mService(service),
+	  mOriginsPrunedAt(0),
+	  mRandom(static_cast<std::minstd_rand::result_type>(totalTime())),
+	  mWakeTime(0)
 {
 	// Create default class
 	mClasses.push_back(new ClassState());
@@ -131,6 +148,8 @@ void HttpPolicy::shutdown()
 		
 			op->cancel();
 		}
+
+		state.mHedgeCandidates.clear();
 	}
 }
 
@@ -146,6 +165,7 @@ void HttpPolicy::addOp(const HttpOpRequest::ptr_t &op)
 	
 	op->mPolicyRetries = 0;
 	op->mPolicy503Retries = 0;
+	op->mPolicyOrigin = getOrigin(op->mReqURL, totalTime());
 	mClasses[policy_class]->mReadyQueue.push(op);
 }
 
@@ -156,12 +176,13 @@ void HttpPolicy::retryOp(const HttpOpRequest::ptr_t &op)
 
 	const HttpTime now(totalTime());
 	const int policy_class(op->mReqPolicy);
+	const HttpOriginHealth & origin(*op->mPolicyOrigin);
 
-	HttpTime delta_min = op->mPolicyMinRetryBackoff;
-	HttpTime delta_max = op->mPolicyMaxRetryBackoff;
-	// mPolicyRetries limited to 100
-	U32 delta_factor = op->mPolicyRetries <= 10 ? 1 << op->mPolicyRetries : 1024;
-	HttpTime delta = llmin(delta_min * delta_factor, delta_max);
+	std::uniform_real_distribution<double> jitter(0.0, 1.0);
+	HttpTime delta(origin.getRetryDelay(op->mPolicyRetries,
+										op->mPolicyMinRetryBackoff,
+										op->mPolicyMaxRetryBackoff,
+										jitter(mRandom)));
 	bool external_delta(false);
 
 	if (op->mReplyRetryAfter > 0 && op->mReplyRetryAfter < 30)
@@ -169,7 +190,8 @@ void HttpPolicy::retryOp(const HttpOpRequest::ptr_t &op)
 		delta = op->mReplyRetryAfter * U64L(1000000);
 		external_delta = true;
 	}
-	op->mPolicyRetryAt = now + delta;
+	// Whatever this request was told, wait out any hold on the origin
+	op->mPolicyRetryAt = (std::max)(now + delta, origin.getHoldUntil());
 	++op->mPolicyRetries;
 	if (error_503 == op->mStatus)
 	{
@@ -190,6 +212,7 @@ void HttpPolicy::retryOp(const HttpOpRequest::ptr_t &op)
 						    << LL_ENDL;
 	}
 	mClasses[policy_class]->mRetryQueue.push(op);
+    HTTPStats::instance().recordRetry();
 }
 
 
@@ -201,8 +224,8 @@ void HttpPolicy::retryOp(const HttpOpRequest::ptr_t &op)
 // moves on to the ready queue.
 //
 // If all queues are empty, will return an indication that
-// the worker thread may sleep hard otherwise will ask for
-// normal polling frequency.
+// the worker thread may sleep hard otherwise will ask it to
+// wait for events and come back by getWakeTime().
 //
 // Implements a client-side request rate throttle as well.
 // This is intended to mimic and predict throttling behavior
@@ -215,6 +238,7 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 {
 	const HttpTime now(totalTime());
 	HttpService::ELoopSpeed result(HttpService::REQUEST_SLEEP);
+	HttpTime wake(0);
 	HttpLibcurl & transport(mService->getTransport());
 	
 	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
@@ -229,10 +253,11 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 			// and get back to servicing queues.  Do this test before
 			// the retryq/readyq test or you'll get stalls until you
 			// click a setting or an asset request comes in.
-			result = HttpService::NORMAL;
+			result = HttpService::WAIT;
+			wake = earliest(wake, now + HttpTime(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS * 1000));
 			continue;
 		}
-		if (retryq.empty() && readyq.empty())
+		if (retryq.empty() && readyq.empty() && state.mHedgeCandidates.empty())
 		{
 			continue;
 		}
@@ -243,12 +268,15 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 		if (throttle_current && state.mThrottleLeft <= 0)
 		{
 			// Throttled condition, don't serve this class but don't sleep hard.
-			result = HttpService::NORMAL;
+			result = HttpService::WAIT;
+			wake = earliest(wake, state.mThrottleEnd);
 			continue;
 		}
 
 		int active(transport.getActiveCountInClass(policy_class));
-		int active_limit(state.mOptions.mPipelining > 1L
+		int active_limit(state.mOptions.mStreamLimit > 0L
+						 ? state.mOptions.mStreamLimit
+						 : state.mOptions.mPipelining > 1L
 						 ? (state.mOptions.mPerHostConnectionLimit
 							* state.mOptions.mPipelining)
 						 : state.mOptions.mConnectionLimit);
@@ -264,8 +292,17 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 					break;
 			
 				retryq.pop();
+
+				const HttpTime hold(op->mPolicyOrigin->getHoldUntil());
+				if (hold > now)
+				{
+					// Origin asked for a break after this was scheduled
+					op->mPolicyRetryAt = hold;
+					retryq.push(op);
+					continue;
+				}
 				
-				op->stageFromReady(mService);
+				stageOp(state, op, now);
                 op.reset();
 
 				++state.mRequestCount;
@@ -294,7 +331,16 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 				HttpOpRequest::ptr_t op(readyq.top());
 				readyq.pop();
 
-				op->stageFromReady(mService);
+				const HttpTime hold(op->mPolicyOrigin->getHoldUntil());
+				if (hold > now)
+				{
+					// Origin asked for a break, wait it out with the retries
+					op->mPolicyRetryAt = hold;
+					retryq.push(op);
+					continue;
+				}
+
+				stageOp(state, op, now);
 				op.reset();
 					
 				++state.mRequestCount;
@@ -316,6 +362,13 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 					}
 				}
 			}
+
+			// Hedges only get capacity nothing else wants and
+			// aren't issued by throttled classes at all.
+			if (readyq.empty() && ! throttle_enabled)
+			{
+				needed = issueHedges(state, now, needed, wake);
+			}
 		}
 
 	throttle_on:
@@ -323,10 +376,20 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 		if (! readyq.empty() || ! retryq.empty())
 		{
 			// If anything is ready, continue looping...
-			result = HttpService::NORMAL;
+			result = HttpService::WAIT;
+			if (throttle_enabled && state.mThrottleLeft <= 0)
+			{
+				wake = earliest(wake, state.mThrottleEnd);
+			}
+			else if (needed > 0 && ! retryq.empty())
+			{
+				// Otherwise a completion frees a slot and wakes us
+				wake = earliest(wake, retryq.top()->mPolicyRetryAt);
+			}
 		}
 	} // end foreach policy_class
 
+	mWakeTime = wake;
 	return result;
 }
 
@@ -404,6 +467,31 @@ bool HttpPolicy::cancel(HttpHandle handle)
 
 bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 {
+	const HttpTime now(totalTime());
+	HttpOriginHealth & origin(*op->mPolicyOrigin);
+
+	origin.recordCompletion(op->mStatus,
+							now,
+							now - op->mPolicyStagedAt,
+							op->mReplyRetryAfter > 0 ? op->mReplyRetryAfter * U64L(1000000) : HttpTime(0),
+							! op->mPolicyRetries && ! op->mPolicyIsHedge);
+    HTTPStats::instance().recordOriginHealth(origin.getOrigin(), origin.getErrorRate(), origin.getLatency());
+
+	if (op->mPolicyIsHedge)
+	{
+		completeHedge(op);
+		return false;					// not active
+	}
+
+	if (op->mPolicyHedge)
+	{
+		// Answered before its hedge, which is no longer needed
+		HttpOpRequest::ptr_t hedge;
+		hedge.swap(op->mPolicyHedge);
+		hedge->mPolicyHedgeOf.reset();
+		mService->getTransport().abandon(hedge);
+	}
+
 	// Retry or finalize
 	if (! op->mStatus)
 	{
@@ -419,12 +507,22 @@ bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 		}
 #endif
 		
-		// If this failed, we might want to retry.
+		// If this failed, we might want to retry.  If the class
+		// has a retry budget and the origin has used it up, it's
+		// failing too much for retries to help and they'd only add
+		// to its load.
 		if (op->mPolicyRetries < op->mPolicyRetryLimit && op->mStatus.isRetryable())
 		{
-			// Okay, worth a retry.
-			retryOp(op);
-			return true;				// still active/ready
+			if (! mClasses[op->mReqPolicy]->mOptions.mRetryBudget || origin.takeRetry(now))
+			{
+				// Okay, worth a retry.
+				retryOp(op);
+				return true;			// still active/ready
+			}
+			HTTPStats::instance().recordRetryDenied();
+			LL_DEBUGS(LOG_CORE) << "HTTP request " << op->getHandle()
+								<< " not retried, retry budget for " << origin.getOrigin()
+								<< " exhausted." << LL_ENDL;
 		}
 	}
 
@@ -450,6 +548,148 @@ bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 	return false;						// not active
 }
 
+
+void HttpPolicy::completeHedge(const HttpOpRequest::ptr_t & hedge)
+{
+	HttpOpRequest::ptr_t op(hedge->mPolicyHedgeOf.lock());
+	hedge->mPolicyHedgeOf.reset();
+	if (! op || op->mPolicyHedge != hedge)
+	{
+		// Request already finished or was canceled
+		return;
+	}
+	op->mPolicyHedge.reset();
+
+	// A failed hedge leaves the request to carry on by itself
+	if (hedge->mStatus && mService->getTransport().abandon(op))
+	{
+		// Hedge answered first, finish the request with its response
+		op->adoptReply(*hedge);
+		hedge->mPolicyOrigin->recordHedgeWon();
+		HTTPStats::instance().recordHedgeWon();
+		if (op->mTracing > HTTP_TRACE_OFF)
+		{
+			LL_INFOS(LOG_CORE) << "TRACE, HedgeWon, Handle:  "
+							   << op->getHandle()
+							   << ", Hedge:  " << hedge->getHandle()
+							   << LL_ENDL;
+		}
+
+		op->stageFromActive(mService);
+		HTTPStats::instance().recordResultCode(op->mStatus.getType());
+	}
+}
+
+
+const HttpOriginHealth::ptr_t & HttpPolicy::getOrigin(const std::string & url, HttpTime now)
+{
+	const std::string origin(HttpOriginHealth::originOf(url));
+	origin_map_t::iterator it(mOrigins.find(origin));
+	if (mOrigins.end() == it)
+	{
+		// Only new origins grow the map, clear out old ones first
+		pruneOrigins(now);
+		it = mOrigins.insert(origin_map_t::value_type(origin, std::make_shared<HttpOriginHealth>(origin))).first;
+	}
+	return it->second;
+}
+
+
+void HttpPolicy::pruneOrigins(HttpTime now)
+{
+	if (now < mOriginsPrunedAt + HTTP_ORIGIN_IDLE_TIME)
+	{
+		return;
+	}
+	mOriginsPrunedAt = now;
+
+	for (origin_map_t::iterator it(mOrigins.begin()); mOrigins.end() != it;)
+	{
+		const HttpOriginHealth & origin(*it->second);
+		if (it->second.use_count() == 1
+			&& now >= origin.getLastCompletion() + HTTP_ORIGIN_IDLE_TIME
+			&& now >= origin.getHoldUntil())
+		{
+			it = mOrigins.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+
+const HttpOriginHealth * HttpPolicy::getOriginHealth(const std::string & url) const
+{
+	origin_map_t::const_iterator it(mOrigins.find(HttpOriginHealth::originOf(url)));
+	return mOrigins.end() == it ? nullptr : it->second.get();
+}
+
+
+void HttpPolicy::stageOp(ClassState & state, const HttpOpRequest::ptr_t & op, HttpTime now)
+{
+	op->mPolicyStagedAt = now;
+	if (state.mOptions.mHedgeDelay > 0L && HttpOpRequest::HOR_GET == op->mReqMethod)
+	{
+		state.mHedgeCandidates.push_back(ClassState::hedge_candidate_t(op, now));
+	}
+	op->stageFromReady(mService);
+}
+
+
+int HttpPolicy::issueHedges(ClassState & state, HttpTime now, int needed, HttpTime & wake)
+{
+	const HttpTime class_delay(HttpTime(state.mOptions.mHedgeDelay) * U64L(1000));
+
+	while (needed > 0 && ! state.mHedgeCandidates.empty())
+	{
+		const ClassState::hedge_candidate_t & candidate(state.mHedgeCandidates.front());
+		HttpOpRequest::ptr_t op(candidate.first.lock());
+		if (! op
+			|| ! op->mCurlActive
+			|| op->mPolicyStagedAt != candidate.second
+			|| op->mPolicyHedge)
+		{
+			// Finished, retried or already hedged
+			state.mHedgeCandidates.pop_front();
+			continue;
+		}
+
+		// Oldest first, if this one isn't due nothing behind it is
+		// (short of origins with very different latencies).
+		HttpOriginHealth & origin(*op->mPolicyOrigin);
+		const HttpTime due(op->mPolicyStagedAt + origin.getHedgeDelay(class_delay));
+		if (now < due)
+		{
+			wake = earliest(wake, due);
+			break;
+		}
+		state.mHedgeCandidates.pop_front();
+
+		if (! origin.takeHedge(now))
+		{
+			continue;
+		}
+
+		HttpOpRequest::ptr_t hedge(op->createHedge());
+		op->mPolicyHedge = hedge;
+		hedge->mPolicyStagedAt = now;
+		if (op->mTracing > HTTP_TRACE_OFF)
+		{
+			LL_INFOS(LOG_CORE) << "TRACE, ToHedge, Handle:  "
+							   << op->getHandle()
+							   << ", Hedge:  " << hedge->getHandle()
+							   << ", Waited:  " << ((now - op->mPolicyStagedAt) / HttpTime(1000))
+							   << LL_ENDL;
+		}
+		hedge->stageFromReady(mService);
+		HTTPStats::instance().recordHedge();
+		--needed;
+	}
+	return needed;
+}
+
 	
 HttpPolicyClass & HttpPolicy::getClassOptions(HttpRequest::policy_t pclass)
 {
@@ -28,6 +28,9 @@
 #define	_LLCORE_HTTP_POLICY_H_
 
 
+#include <map>
+#include <random>
+
 #include "httprequest.h"
 #include "_httpservice.h"
 #include "_httpreadyqueue.h"
@@ -35,6 +38,7 @@
 #include "_httppolicyglobal.h"
 #include "_httppolicyclass.h"
 #include "_httpinternal.h"
+#include "_httporigin.h"
 
 
 namespace LLCore
@@ -89,6 +93,17 @@ public:
 	/// Threading:  called by worker thread
 	HttpService::ELoopSpeed processReadyQueue();
 
+	/// Earliest time, as of the last processReadyQueue() call,
+	/// that queued requests can be issued without help from a
+	/// completing request:  the next retry, the end of a throttle
+	/// window or a hedge coming due.  Zero for none.
+	///
+	/// Threading:  called by worker thread
+	HttpTime getWakeTime() const
+		{
+			return mWakeTime;
+		}
+
 	/// Add request to a ready queue.  Caller is expected to have
 	/// provided us with a reference count to hold the request.  (No
 	/// additional references will be added.)
@@ -107,6 +122,10 @@ public:
 	/// before new ones but that doesn't guarantee completion
 	/// order.
 	///
+	/// Retry time comes from the health of the request's origin,
+	/// @see HttpOriginHealth, and is never before any hold the
+	/// origin has asked for.
+	///
 	/// Threading:  called by worker thread
     void retryOp(const opReqPtr_t &);
 
@@ -155,6 +174,12 @@ public:
 	/// that point.
 	HttpPolicyClass & getClassOptions(HttpRequest::policy_t pclass);
 	
+	/// Health record for the origin of a URL, nullptr if no
+	/// request has been made to it.
+	///
+	/// Threading:  called by worker thread
+	const HttpOriginHealth * getOriginHealth(const std::string & url) const;
+
 	/// Get ready counts for a particular policy class
 	///
 	/// Threading:  called by worker thread
@@ -171,10 +196,37 @@ public:
 protected:
 	struct ClassState;
 	typedef std::vector<ClassState *>	class_list_t;
-	
+	typedef std::map<std::string, HttpOriginHealth::ptr_t> origin_map_t;
+
+	// Health record for a URL's origin, created on first use
+	const HttpOriginHealth::ptr_t & getOrigin(const std::string & url, HttpTime now);
+
+	// Forget origins no request refers to that have been quiet
+	// for HTTP_ORIGIN_IDLE_TIME.
+	void pruneOrigins(HttpTime now);
+
+	// Make a ready or retried request active
+	void stageOp(ClassState & state, const opReqPtr_t & op, HttpTime now);
+
+	// Issue hedges for requests in the class that have gone
+	// unanswered too long, using at most @needed slots.  @wake
+	// is lowered to when the next hedge comes due.
+	//
+	// @return			Slots still available.
+	int issueHedges(ClassState & state, HttpTime now, int needed, HttpTime & wake);
+
+	// Reconcile a completed hedge with the request it raced.
+	// Hedges are never retried or delivered themselves.
+	void completeHedge(const opReqPtr_t & hedge);
+
+protected:
 	HttpPolicyGlobal					mGlobalOptions;
 	class_list_t						mClasses;
 	HttpService *						mService;				// Naked pointer, not refcounted, not owner
+	origin_map_t						mOrigins;				// Pruned when idle, @see pruneOrigins()
+	HttpTime							mOriginsPrunedAt;
+	std::minstd_rand					mRandom;				// Retry jitter
+	HttpTime							mWakeTime;				// @see getWakeTime()
 };  // end class HttpPolicy
 
 }  // end namespace LLCore
@@ -37,7 +37,10 @@ HttpPolicyClass::HttpPolicyClass()
 	: mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPerHostConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPipelining(HTTP_PIPELINING_DEFAULT),
-	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT)
+	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT),
+	  mStreamLimit(HTTP_STREAM_LIMIT_DEFAULT),
+	  mHedgeDelay(HTTP_HEDGE_DELAY_DEFAULT),
+	  mRetryBudget(0L)
 {}
 
 
@@ -53,6 +56,9 @@ HttpPolicyClass & HttpPolicyClass::operator=(const HttpPolicyClass & other)
 		mPerHostConnectionLimit = other.mPerHostConnectionLimit;
 		mPipelining = other.mPipelining;
 		mThrottleRate = other.mThrottleRate;
+		mStreamLimit = other.mStreamLimit;
+		mHedgeDelay = other.mHedgeDelay;
+		mRetryBudget = other.mRetryBudget;
 	}
 	return *this;
 }
@@ -62,7 +68,10 @@ HttpPolicyClass::HttpPolicyClass(const HttpPolicyClass & other)
 	: mConnectionLimit(other.mConnectionLimit),
 	  mPerHostConnectionLimit(other.mPerHostConnectionLimit),
 	  mPipelining(other.mPipelining),
-	  mThrottleRate(other.mThrottleRate)
+	  mThrottleRate(other.mThrottleRate),
+	  mStreamLimit(other.mStreamLimit),
+	  mHedgeDelay(other.mHedgeDelay),
+	  mRetryBudget(other.mRetryBudget)
 {}
 
 
@@ -86,6 +95,18 @@ HttpStatus HttpPolicyClass::set(HttpRequest::EPolicyOption opt, long value)
 		mThrottleRate = llclamp(value, 0L, 1000000L);
 		break;
 
+	case HttpRequest::PO_STREAM_LIMIT:
+		mStreamLimit = llclamp(value, 0L, HTTP_STREAM_LIMIT_MAX);
+		break;
+
+	case HttpRequest::PO_HEDGE_DELAY:
+		mHedgeDelay = llclamp(value, 0L, HTTP_HEDGE_DELAY_MAX);
+		break;
+
+	case HttpRequest::PO_RETRY_BUDGET:
+		mRetryBudget = llclamp(value, 0L, 1L);
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -114,6 +135,18 @@ HttpStatus HttpPolicyClass::get(HttpRequest::EPolicyOption opt, long * value) co
 		*value = mThrottleRate;
 		break;
 
+	case HttpRequest::PO_STREAM_LIMIT:
+		*value = mStreamLimit;
+		break;
+
+	case HttpRequest::PO_HEDGE_DELAY:
+		*value = mHedgeDelay;
+		break;
+
+	case HttpRequest::PO_RETRY_BUDGET:
+		*value = mRetryBudget;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
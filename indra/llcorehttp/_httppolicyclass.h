@@ -64,6 +64,9 @@ public:
 	long						mPerHostConnectionLimit;
 	long						mPipelining;
 	long						mThrottleRate;
+	long						mStreamLimit;
+	long						mHedgeDelay;			// mS
+	long						mRetryBudget;			// 0 or 1
 };  // end class HttpPolicyClass
 
 }  // end namespace LLCore
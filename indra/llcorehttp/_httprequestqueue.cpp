@@ -81,6 +81,10 @@ HttpStatus HttpRequestQueue::addOp(const HttpRequestQueue::opPtr_t &op)
 		}
 		wake = mQueue.empty();
 		mQueue.push_back(op);
+		if (wake && mWakeup)
+		{
+			mWakeup();
+		}
 	}
 	if (wake)
 	{
@@ -142,11 +146,23 @@ void HttpRequestQueue::wakeAll()
 }
 
 
+void HttpRequestQueue::setWakeup(const wakeup_t & wakeup)
+{
+	HttpScopedLock lock(mQueueMutex);
+
+	mWakeup = wakeup;
+}
+
+
 bool HttpRequestQueue::stopQueue()
 {
 	{
 		HttpScopedLock lock(mQueueMutex);
 
+        if (mWakeup)
+        {
+            mWakeup();
+        }
         if (!mQueueStopped)
         {
             mQueueStopped = true;
@@ -30,6 +30,8 @@
 
 #include <vector>
 
+#include <boost/function.hpp>
+
 #include "httpcommon.h"
 #include "_refcounted.h"
 #include "_mutex.h"
@@ -74,6 +76,7 @@ public:
 	
 public:
     typedef std::vector<opPtr_t> OpContainer;
+	typedef boost::function<void()> wakeup_t;
 
 	/// Insert an object at the back of the request queue.
 	///
@@ -116,6 +119,16 @@ public:
 	/// Threading:  callable by any thread.
 	void wakeAll();
 
+	/// Install a function called when a request lands on an
+	/// empty queue, alongside waking threads in @fetchAll or
+	/// @fetchOp.  Lets a worker blocked elsewhere (e.g. in
+	/// curl_multi_poll()) notice new requests.  Called with the
+	/// queue lock held so an empty function passed here guarantees
+	/// the old one won't be called again once this returns.
+	///
+	/// Threading:  callable by any thread.
+	void setWakeup(const wakeup_t & wakeup);
+
 	/// Disallow further request queuing.  Callers to @addOp will
 	/// get a failure status (LLCORE, HE_SHUTTING_DOWN).  Callers
 	/// to @fetchAll or @fetchOp will get requests that are on the
@@ -133,6 +146,7 @@ protected:
 	OpContainer							mQueue;
 	LLCoreInt::HttpMutex				mQueueMutex;
 	LLCoreInt::HttpConditionVariable	mQueueCV;
+	wakeup_t							mWakeup;
 	bool								mQueueStopped;
 	
 }; // end class HttpRequestQueue
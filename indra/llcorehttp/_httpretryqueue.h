@@ -49,9 +49,11 @@ namespace LLCore
 
 struct HttpOpRetryCompare
 {
+	// priority_queue puts the greatest element on top, compare
+	// reversed so that the earliest retry time is at top().
 	bool operator()(const HttpOpRequest::ptr_t &lhs, const HttpOpRequest::ptr_t &rhs)
 		{
-			return lhs->mPolicyRetryAt < rhs->mPolicyRetryAt;
+			return lhs->mPolicyRetryAt > rhs->mPolicyRetryAt;
 		}
 };
 
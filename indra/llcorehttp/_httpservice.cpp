@@ -40,6 +40,7 @@
 #include "llthread.h"
 #include "llexception.h"
 #include "llmemory.h"
+#include "lltraceeventlog.h"
 
 namespace
 {
@@ -63,7 +64,10 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
 	{	true,		true,		true,		false,		false	},		// PO_TRACE
 	{	true,		true,		false,		true,		false	},		// PO_ENABLE_PIPELINING
 	{	true,		true,		false,		true,		false	},		// PO_THROTTLE_RATE
-	{   false,		false,		true,		false,		true	}		// PO_SSL_VERIFY_CALLBACK
+	{   false,		false,		true,		false,		true	},		// PO_SSL_VERIFY_CALLBACK
+	{	true,		true,		false,		true,		false	},		// PO_STREAM_LIMIT
+	{	true,		true,		false,		true,		false	},		// PO_HEDGE_DELAY
+	{	true,		true,		false,		true,		false	}		// PO_RETRY_BUDGET
 };
 HttpService * HttpService::sInstance(nullptr);
 volatile HttpService::EState HttpService::sState(NOT_INITIALIZED);
@@ -71,6 +75,7 @@ volatile HttpService::EState HttpService::sState(NOT_INITIALIZED);
 HttpService::HttpService()
 	: mRequestQueue(nullptr),
 	  mExitRequested(0U),
+	  mLoopCount(0U),
 	  mThread(nullptr),
 	  mPolicy(nullptr),
 	  mTransport(nullptr),
@@ -288,20 +293,23 @@ void HttpService::shutdown()
 
 // Working thread loop-forever method.  Gives time to
 // each of the request queue, policy layer and transport
-// layer pieces and then either sleeps for a small time
-// or waits for a request to come in.  Repeats until
-// requested to stop.
+// layer pieces and then either goes straight around,
+// blocks until the transport has something to do, a
+// policy deadline passes or a request comes in, or just
+// waits for a request.  Repeats until requested to stop.
 void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 {
 	boost::this_thread::disable_interruption di;
 
 	LLThread::registerThreadID();
+	LLTrace::EventLog::setThreadName("HTTP");
 	
 	ELoopSpeed loop(REQUEST_SLEEP);
 	while (! mExitRequested)
 	{
         try
         {
+            ++mLoopCount;
 		    loop = processRequestQueue(loop);
 
 		    // Process ready queue issuing new requests as needed
@@ -312,11 +320,17 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 		    new_loop = mTransport->processTransport();
 		    loop = (std::min)(loop, new_loop);
 		
-		    // Determine whether to spin, sleep briefly or sleep for next request
-		    if (REQUEST_SLEEP != loop)
+		    // Determine whether to spin, wait for events or sleep for next request
+		    if (WAIT == loop)
+		    {
+			    mTransport->waitForEvents(mPolicy->getWakeTime());
+		    }
+#if ! LLCORE_HTTP_MULTI_POLL
+		    else if (NORMAL == loop)
 		    {
 			    ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
 		    }
+#endif
         }
         catch (const LLContinueError&)
         {
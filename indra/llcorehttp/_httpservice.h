@@ -105,6 +105,7 @@ public:
 	enum ELoopSpeed
 	{
 		NORMAL,					///< continuous polling of request, ready, active queues
+		WAIT,					///< can wait for transport events, policy deadline or request queue write
 		REQUEST_SLEEP			///< can sleep indefinitely waiting for request queue write
 	};
 
@@ -163,6 +164,15 @@ public:
 	/// Threading:  callable by worker thread.
 	bool cancel(HttpHandle handle);
 	
+	/// Passes the worker thread has made through its loop, each
+	/// one a wakeup.  For measuring idle behavior.
+	///
+	/// Threading:  callable by any thread.
+	U32 getLoopCount() const
+		{
+			return mLoopCount.CurrentValue();
+		}
+
 	/// Threading:  callable by worker thread.
 	HttpPolicy & getPolicy()
 		{
@@ -227,6 +237,7 @@ protected:
 	static volatile EState				sState;
 	HttpRequestQueue *					mRequestQueue;	// Refcounted
 	LLAtomicU32							mExitRequested;
+	LLAtomicU32							mLoopCount;
 	LLCoreInt::HttpThread *				mThread;
 	
 	// === working-thread-only data ===
@@ -58,7 +58,7 @@ public:
 	void operator delete(void *, size_t len);
 
 protected:
-	Block(size_t len);
+	Block(size_t len, char * aligned_data);
 
 	Block(const Block &);						// Not defined
 	void operator=(const Block &);				// Not defined
@@ -68,17 +68,26 @@ protected:
 	void * operator new(size_t len, size_t addl_len);
 	
 public:
-	// Only public entry to get a block.
+	// Only public entries to get a block.
 	static Block * alloc(size_t len);
 
+	// Block with its data in a separate 16-byte aligned
+	// allocation which may be detached.
+	static Block * allocAligned(size_t len);
+
+	// Gives up an aligned allocation to the caller.
+	char * detach();
+
 public:
 	size_t mUsed;
 	size_t mAlloced;
+	char * mData;		// mInline or the aligned allocation
+	bool mAligned;
 
 	// *NOTE:  Must be last member of the object.  We'll
 	// overallocate as requested via operator new and index
 	// into the array at will.
-	char mData[1];		
+	char mInline[1];
 };
 
 
@@ -304,6 +313,62 @@ int BufferArray::findBlock(size_t pos, size_t * ret_offset)
 }
 
 
+bool BufferArray::reserveContiguous(size_t len)
+{
+	if (! mBlocks.empty() || ! len)
+	{
+		return false;
+	}
+
+	Block * block(Block::allocAligned(len));
+	if (! block)
+	{
+		LL_WARNS() << "Failed to allocate " << len << " contiguous bytes for BufferArray" << LL_ENDL;
+		return false;
+	}
+	mBlocks.push_back(block);
+	return true;
+}
+
+
+char * BufferArray::getContiguous(size_t pos, size_t len)
+{
+	size_t offset(0);
+	int block(findBlock(pos, &offset));
+	if (block < 0 || mBlocks[block]->mUsed - offset < len)
+	{
+		return NULL;
+	}
+	return &mBlocks[block]->mData[offset];
+}
+
+
+void * BufferArray::detachContiguous(size_t * len)
+{
+	if (mBlocks.empty()
+		|| ! mBlocks[0]->mAligned
+		|| mBlocks[0]->mUsed != mLen
+		|| getRefCount() > 1)
+	{
+		return NULL;
+	}
+
+	*len = mLen;
+	void * data(mBlocks[0]->detach());
+
+	// Anything after the first block is empty
+	for (container_t::iterator it(mBlocks.begin());
+		 it != mBlocks.end();
+		 ++it)
+	{
+		delete *it;
+	}
+	mBlocks.clear();
+	mLen = 0;
+	return data;
+}
+
+
 bool BufferArray::getBlockStartEnd(int block, const char ** start, const char ** end)
 {
 	if (block < 0 || block >= mBlocks.size())
@@ -323,16 +388,26 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
 // ==================================
 
 
-BufferArray::Block::Block(size_t len)
+BufferArray::Block::Block(size_t len, char * aligned_data)
 	: mUsed(0),
-	  mAlloced(len)
+	  mAlloced(len),
+	  mData(aligned_data ? aligned_data : mInline),
+	  mAligned(aligned_data != NULL)
 {
-	memset(mData, 0, len);
+	if (! mAligned)
+	{
+		memset(mData, 0, len);
+	}
 }
 			
 
 BufferArray::Block::~Block()
 {
+	if (mAligned)
+	{
+		ll_aligned_free_16(mData);
+	}
+	mData = NULL;
 	mUsed = 0;
 	mAlloced = 0;
 }
@@ -360,9 +435,37 @@ void BufferArray::Block::operator delete(void * mem, size_t)
 
 BufferArray::Block * BufferArray::Block::alloc(size_t len)
 {
-	Block * block = new (len) Block(len);
+	Block * block = new (len) Block(len, NULL);
 	return block;
 }
+
+
+BufferArray::Block * BufferArray::Block::allocAligned(size_t len)
+{
+	char * data(static_cast<char *>(ll_aligned_malloc_16(len)));
+	if (! data)
+	{
+		return NULL;
+	}
+	try
+	{
+		return new (0) Block(len, data);
+	}
+	catch (...)
+	{
+		ll_aligned_free_16(data);
+		throw;
+	}
+}
+
+
+char * BufferArray::Block::detach()
+{
+	char * data(mData);
+	mData = mInline;
+	mAligned = false;
+	return data;
+}
 	
 
 }  // end namespace LLCore
@@ -120,6 +120,32 @@ public:
 	/// append data when current position is equal to the
 	/// size of the instance or do a mix of both.
 	size_t write(size_t pos, const void * src, size_t len);
+
+	/// On an empty instance, allocates a single 16-byte aligned
+	/// block of 'len' bytes that following append() calls fill
+	/// before any other block is used.  When the body length is
+	/// known up front this keeps it contiguous so that consumers
+	/// can use it in place or take it with @see detachContiguous().
+	///
+	/// @return			True if the block was allocated.
+	bool reserveContiguous(size_t len);
+
+	/// Direct access to data without copying.
+	///
+	/// @return			Pointer to 'len' bytes at 'pos' if they lie
+	///					in a single block, NULL otherwise, in which
+	///					case caller should fall back to read().
+	char * getContiguous(size_t pos, size_t len);
+
+	/// Hands the data over to the caller if it all lies in a block
+	/// allocated by reserveContiguous() and no one else holds a
+	/// reference to the instance, which is left empty.  The memory
+	/// must be freed with ll_aligned_free_16() and may be given to
+	/// LLImageBase::setData() as is.
+	///
+	/// @return			Pointer to the data with its size in 'len',
+	///					or NULL if the data can't be detached.
+	void * detachContiguous(size_t * len);
 	
 protected:
 	int findBlock(size_t pos, size_t * ret_offset);
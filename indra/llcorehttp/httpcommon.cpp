@@ -252,6 +252,7 @@ bool HttpStatus::isRetryable() const
 	// failures in log files.
 
 	return ((isHttpStatus() && getType() >= 499 && getType() <= 599) ||	// Include special 499 in retryables
+			(isHttpStatus() && getType() == 429) ||	// Too Many Requests, throttled
 			*this == cant_connect ||	// Connection reset/endpoint problems
 			*this == cant_res_proxy ||	// DNS problems
 			*this == cant_res_host ||	// DNS problems
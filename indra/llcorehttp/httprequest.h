@@ -233,6 +233,47 @@ public:
 		/// Global only
 		PO_SSL_VERIFY_CALLBACK,
 
+		/// If greater than zero, requests in this class ask for
+		/// HTTP/2 (negotiated over TLS, falling back to HTTP/1.1
+		/// where the server doesn't offer it) and value gives the
+		/// maximum number of requests the class will have in flight.
+		///
+		/// All classes with a stream limit share one set of
+		/// connections, so texture, mesh and capability requests to
+		/// the same origin are multiplexed over a single connection
+		/// instead of each opening their own.  For these classes
+		/// PO_CONNECTION_LIMIT and PO_PIPELINING_DEPTH no longer limit
+		/// concurrency, PO_PER_HOST_CONNECTION_LIMIT still bounds the
+		/// connections opened to HTTP/1.1 servers.  Zero, the default,
+		/// keeps the class on its own HTTP/1.1 connections.
+		///
+		/// Per-class only
+		PO_STREAM_LIMIT,
+
+		/// If greater than zero, GET requests in this class that
+		/// have gone unanswered for this many milliseconds (or
+		/// longer, if the origin usually takes longer) are hedged:
+		/// a second copy is sent and whichever answers first is
+		/// used, the other dropped.  Hedges only use spare capacity
+		/// in the class and are limited to a small fraction of
+		/// traffic to healthy origins.  Meant for classes where
+		/// tail latency is visible, like texture fetches.  Zero,
+		/// the default, disables hedging.
+		///
+		/// Per-class only
+		PO_HEDGE_DELAY,
+
+		/// If non-zero, retries of requests in this class are
+		/// limited by a budget shared by everything sent to the
+		/// same origin.  Requests failing on their first try spend
+		/// it and successes and time earn it back so an origin
+		/// that starts failing gets a short burst of retries rather
+		/// than one for every request.  Zero, the default, retries
+		/// each request up to its own limit.
+		///
+		/// Per-class only
+		PO_RETRY_BUDGET,
+
 		PO_LAST  // Always at end
 	};
 
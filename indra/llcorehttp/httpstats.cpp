@@ -45,6 +45,11 @@ void HTTPStats::resetStats()
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
+    mRetries = 0;
+    mRetriesDenied = 0;
+    mHedges = 0;
+    mHedgesWon = 0;
+    mOrigins.clear();
 }
 
 
@@ -61,6 +66,13 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordOriginHealth(const std::string & origin, F64 error_rate, U64 latency)
+{
+    OriginHealth & health(mOrigins[origin]);
+    health.mErrorRate = error_rate;
+    health.mLatency = latency;
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
@@ -100,6 +112,17 @@ void HTTPStats::dumpStats()
     { 
         out << (*it).first << " " << (*it).second << std::endl;
     }
+    out << std::endl;
+    out << "Retries: " << mRetries << "   Denied by budget: " << mRetriesDenied << std::endl;
+    out << "Hedges: " << mHedges << "   Won: " << mHedgesWon << std::endl;
+    out << std::endl;
+    out << "Origins (error rate, latency mS):" << std::endl;
+
+    for (std::map<std::string, OriginHealth>::iterator it = mOrigins.begin(); it != mOrigins.end(); ++it)
+    {
+        out << (*it).first << " " << std::setprecision(3) << (*it).second.mErrorRate
+            << " " << ((*it).second.mLatency / 1000) << std::endl;
+    }
 
     LL_WARNS("HTTPCore") << out.str() << LL_ENDL;
 }
@@ -59,14 +59,39 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        // Retry and hedge decisions made by the policy layer
+        void    recordRetry() { ++mRetries; }
+        void    recordRetryDenied() { ++mRetriesDenied; }
+        void    recordHedge() { ++mHedges; }
+        void    recordHedgeWon() { ++mHedgesWon; }
+
+        // Latest health of an origin, latency in microseconds
+        void    recordOriginHealth(const std::string & origin, F64 error_rate, U64 latency);
+
+        S32     getRetries() const { return mRetries; }
+        S32     getRetriesDenied() const { return mRetriesDenied; }
+        S32     getHedges() const { return mHedges; }
+        S32     getHedgesWon() const { return mHedgesWon; }
+
         void    dumpStats();
     private:
+        struct OriginHealth
+        {
+            F64     mErrorRate;
+            U64     mLatency;
+        };
+
         StatsAccumulator mDataDown;
         StatsAccumulator mDataUp;
 
         S32              mRequests;
+        S32              mRetries;
+        S32              mRetriesDenied;
+        S32              mHedges;
+        S32              mHedgesWon;
 
         std::map<S32, S32> mResutCodes;
+        std::map<std::string, OriginHealth> mOrigins;
     };
 
 
@@ -47,6 +47,7 @@
 #include "test_httprequest.hpp"
 #endif
 #include "test_httpheaders.hpp"
+#include "test_httporigin.hpp"
 #include "test_httprequestqueue.hpp"
 #include "_httpservice.h"
 
@@ -29,6 +29,9 @@
 #include "bufferarray.h"
 
 #include <iostream>
+#include <vector>
+
+#include "llmemory.h"
 
 
 using namespace LLCore;
@@ -374,6 +377,85 @@ void BufferArrayTestObjectType::test<8>()
 	ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+	set_test_name("BufferArray contiguous reservation handed to consumer");
+
+	// create a new ref counted object with an implicit reference
+	BufferArray * ba = new BufferArray();
+
+	// a texture-sized body arriving in curl-sized pieces
+	const size_t body_len(3 * BufferArray::BLOCK_ALLOC_SIZE + 17);
+	std::vector<char> body(body_len);
+	for (size_t i(0); i < body_len; ++i)
+	{
+		body[i] = char(i * 7);
+	}
+	ensure("Reserve on empty BufferArray", ba->reserveContiguous(body_len));
+	ensure("No second reservation", ! ba->reserveContiguous(body_len));
+	ensure("Reservation adds no data", 0 == ba->size());
+	for (size_t pos(0); pos < body_len; pos += 16384)
+	{
+		ba->append(&body[pos], (std::min)(size_t(16384), body_len - pos));
+	}
+	ensure("Body size correct", body_len == ba->size());
+
+	// in place access over the whole body
+	char * data(ba->getContiguous(0, body_len));
+	ensure("Whole body contiguous", NULL != data);
+	ensure("Contiguous content correct", 0 == memcmp(data, &body[0], body_len));
+	ensure("Contiguous at offset", data + 100 == ba->getContiguous(100, body_len - 100));
+	ensure("No access past end", NULL == ba->getContiguous(100, body_len));
+
+	// a second holder prevents the hand-off
+	size_t len(0);
+	ba->addRef();
+	ensure("No detach while shared", NULL == ba->detachContiguous(&len));
+	ba->release();
+
+	// sole holder takes the memory with no copy
+	void * detached(ba->detachContiguous(&len));
+	ensure("Detached same memory", detached == data);
+	ensure("Detached length correct", body_len == len);
+	ensure("Detached aligned", 0 == (reinterpret_cast<uintptr_t>(detached) & 0xf));
+	ensure("BufferArray empty after detach", 0 == ba->size());
+	ll_aligned_free_16(detached);
+
+	// release the implicit reference, causing the object to be released
+	ba->release();
+}
+
+template <> template <>
+void BufferArrayTestObjectType::test<10>()
+{
+	set_test_name("BufferArray contiguous reservation overrun");
+
+	// create a new ref counted object with an implicit reference
+	BufferArray * ba = new BufferArray();
+
+	// fewer bytes reserved than arrive, as with a wrong Content-Length
+	char str1[] = "abcdefghij";
+	size_t str1_len(strlen(str1));
+ 	char buffer[256];
+	ensure("Reserve on empty BufferArray", ba->reserveContiguous(4));
+	size_t len = ba->append(str1, str1_len);
+	ensure("Append length correct", str1_len == len);
+
+	ensure("Head contiguous", NULL != ba->getContiguous(0, 4));
+	ensure("Whole body not contiguous", NULL == ba->getContiguous(0, str1_len));
+	ensure("No detach of split body", NULL == ba->detachContiguous(&len));
+
+	// Check contents
+	memset(buffer, 'X', sizeof(buffer));
+	len = ba->read(0, buffer, sizeof(buffer));
+	ensure("Final buffer length correct", str1_len == len);
+	ensure("Read content correct", 0 == strncmp(buffer, str1, str1_len));
+
+	// release the implicit reference, causing the object to be released
+	ba->release();
+}
+
 }  // end namespace tut
 
 
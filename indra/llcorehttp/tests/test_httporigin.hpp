@@ -0,0 +1,248 @@
+/** 
+ * @file test_httporigin.hpp
+ * @brief unit tests for the LLCore::HttpOriginHealth class
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef TEST_LLCORE_HTTP_ORIGIN_H_
+#define TEST_LLCORE_HTTP_ORIGIN_H_
+
+#include "_httporigin.h"
+
+#include <iostream>
+
+
+using namespace LLCore;
+
+
+namespace tut
+{
+
+struct HttpOriginTestData
+{
+	// the test objects inherit from this so the member functions and variables
+	// can be referenced directly inside of the test functions.
+};
+
+typedef test_group<HttpOriginTestData> HttpOriginTestGroupType;
+typedef HttpOriginTestGroupType::object HttpOriginTestObjectType;
+HttpOriginTestGroupType HttpOriginTestGroup("HttpOrigin Tests");
+
+template <> template <>
+void HttpOriginTestObjectType::test<1>()
+{
+	set_test_name("HttpOriginHealth origin keys");
+
+	ensure_equals("Path dropped",
+				  HttpOriginHealth::originOf("https://Asset-CDN.example.com/path/to?x=1"),
+				  std::string("https://asset-cdn.example.com"));
+	ensure_equals("Port kept",
+				  HttpOriginHealth::originOf("http://127.0.0.1:8000/503/0/"),
+				  std::string("http://127.0.0.1:8000"));
+	ensure_equals("Query without path",
+				  HttpOriginHealth::originOf("http://host?texture_id=1"),
+				  std::string("http://host"));
+	ensure_equals("Bare host",
+				  HttpOriginHealth::originOf("http://host"),
+				  std::string("http://host"));
+	ensure_equals("No scheme",
+				  HttpOriginHealth::originOf("host:12043/cap"),
+				  std::string("host:12043"));
+}
+
+template <> template <>
+void HttpOriginTestObjectType::test<2>()
+{
+	set_test_name("HttpOriginHealth retry budget");
+
+	HttpOriginHealth origin("http://host");
+	const HttpStatus error_500(500);
+	const HttpStatus ok(200);
+
+	// A burst of failures gets retries until half the budget is gone
+	int retries(0);
+	for (int i(0); i < 20; ++i)
+	{
+		origin.recordCompletion(error_500, 0, 0, 0, true);
+		retries += origin.takeRetry(0) ? 1 : 0;
+	}
+	ensure_equals("Retries in the burst", retries, 5);
+	ensure_equals("Denials counted", origin.getRetriesDenied(), 15L);
+	ensure_equals("Failures counted", origin.getFailed(), 20L);
+
+	// Successes earn it back, a tenth of a retry each
+	for (int i(0); i < 49; ++i)
+	{
+		origin.recordCompletion(ok, 0, 0, 0, true);
+	}
+	ensure("Still short", ! origin.takeRetry(0));
+	origin.recordCompletion(ok, 0, 0, 0, true);
+	origin.recordCompletion(ok, 0, 0, 0, true);
+	ensure("Earned back", origin.takeRetry(0));
+
+	// A 404 is the server answering, not the server failing
+	HttpOriginHealth origin2("http://host2");
+	for (int i(0); i < 20; ++i)
+	{
+		origin2.recordCompletion(HttpStatus(404), 0, 0, 0, true);
+	}
+	ensure("404s don't spend the budget", origin2.takeRetry(0));
+	ensure("404s aren't errors", origin2.getErrorRate() == 0.0);
+
+	// Failed retries of a request already charged cost nothing more
+	HttpOriginHealth origin3("http://host3");
+	origin3.recordCompletion(error_500, 0, 0, 0, true);
+	for (int i(0); i < 20; ++i)
+	{
+		origin3.recordCompletion(error_500, 0, 0, 0, false);
+	}
+	ensure_equals("Only the first try charged", origin3.getRetryTokens(), HTTP_RETRY_BUDGET_TOKENS - 1.0);
+	ensure("Retries still allowed", origin3.takeRetry(0));
+}
+
+template <> template <>
+void HttpOriginTestObjectType::test<6>()
+{
+	set_test_name("HttpOriginHealth retry budget refills with time");
+
+	HttpOriginHealth origin("http://host");
+	const HttpTime start(U64L(100000000));
+
+	// Spend it all with nothing succeeding
+	for (int i(0); i < 20; ++i)
+	{
+		origin.recordCompletion(HttpStatus(503), start, 0, 0, true);
+	}
+	ensure_equals("Spent", origin.getRetryTokens(), 0.0);
+	ensure("Denied when spent", ! origin.takeRetry(start));
+
+	// Half the budget comes back in this long without any help
+	const HttpTime half(HttpTime(HTTP_RETRY_BUDGET_TOKENS / 2.0 / HTTP_RETRY_BUDGET_REFILL_RATE * 1E6));
+	ensure("Not yet", ! origin.takeRetry(start + half / 2));
+	ensure("Refilled", origin.takeRetry(start + half));
+
+	// And never more than the whole budget
+	origin.takeRetry(start + 100 * half);
+	ensure_equals("Capped", origin.getRetryTokens(), HTTP_RETRY_BUDGET_TOKENS);
+}
+
+template <> template <>
+void HttpOriginTestObjectType::test<3>()
+{
+	set_test_name("HttpOriginHealth Retry-After hold");
+
+	HttpOriginHealth origin("http://host");
+	const HttpTime now(U64L(100000000));
+
+	origin.recordCompletion(HttpStatus(500), now, 0, U64L(2000000), true);
+	ensure_equals("Only 503 and 429 hold", origin.getHoldUntil(), HttpTime(0));
+
+	origin.recordCompletion(HttpStatus(429), now, 0, U64L(2000000), true);
+	ensure_equals("429 holds", origin.getHoldUntil(), now + U64L(2000000));
+
+	origin.recordCompletion(HttpStatus(503), now, 0, U64L(1000000), true);
+	ensure_equals("Shorter hold doesn't shorten", origin.getHoldUntil(), now + U64L(2000000));
+
+	origin.recordCompletion(HttpStatus(503), now, 0, HTTP_RETRY_AFTER_MAX + 1, true);
+	ensure_equals("Overlong hold ignored", origin.getHoldUntil(), now + U64L(2000000));
+	ensure_equals("Throttles counted", origin.getThrottled(), 3L);
+	ensure("429 retryable", HttpStatus(429).isRetryable());
+}
+
+template <> template <>
+void HttpOriginTestObjectType::test<4>()
+{
+	set_test_name("HttpOriginHealth retry delay");
+
+	const HttpTime min_backoff(U64L(1000000));
+	const HttpTime max_backoff(U64L(5000000));
+
+	HttpOriginHealth healthy("http://host");
+	ensure_equals("No jitter, half delay",
+				  healthy.getRetryDelay(0, min_backoff, max_backoff, 0.0), min_backoff / 2);
+	ensure("Full jitter, whole delay",
+		   healthy.getRetryDelay(0, min_backoff, max_backoff, 0.999) > min_backoff * 99 / 100);
+	ensure_equals("Exponential",
+				  healthy.getRetryDelay(2, min_backoff, max_backoff, 0.0), 2 * min_backoff);
+	ensure_equals("Capped",
+				  healthy.getRetryDelay(10, min_backoff, max_backoff, 0.0), max_backoff / 2);
+
+	// Failing origins are pushed toward the maximum
+	HttpOriginHealth failing("http://host2");
+	for (int i(0); i < 50; ++i)
+	{
+		failing.recordCompletion(HttpStatus(503), 0, 0, 0, true);
+	}
+	ensure("Failing origin waits longer",
+		   failing.getRetryDelay(0, min_backoff, max_backoff, 0.0) > max_backoff * 9 / 10);
+
+	// And nothing is retried before a slow origin would have answered
+	HttpOriginHealth slow("http://host3");
+	slow.recordCompletion(HttpStatus(200), 0, U64L(3000000), 0, true);
+	ensure_equals("Slow origin", slow.getRetryDelay(0, min_backoff, max_backoff, 0.0), U64L(3000000));
+
+	// But never past the configured maximum
+	HttpOriginHealth slower("http://host4");
+	slower.recordCompletion(HttpStatus(200), 0, U64L(8000000), 0, true);
+	ensure_equals("Slower origin", slower.getRetryDelay(0, min_backoff, max_backoff, 0.0), max_backoff);
+}
+
+template <> template <>
+void HttpOriginTestObjectType::test<5>()
+{
+	set_test_name("HttpOriginHealth latency and hedging");
+
+	HttpOriginHealth origin("http://host");
+	const HttpTime class_delay(U64L(100000));
+
+	origin.recordCompletion(HttpStatus(200), 0, U64L(400000), 0, true);
+	ensure_equals("First sample", origin.getLatency(), U64L(400000));
+	ensure_equals("Class delay until there are enough samples",
+				  origin.getHedgeDelay(class_delay), class_delay);
+
+	for (int i(0); i < 40; ++i)
+	{
+		origin.recordCompletion(HttpStatus(200), 0, U64L(200000), 0, true);
+	}
+	ensure("Latency converges", origin.getLatency() < U64L(210000));
+	ensure("Hedge after a usual answer time",
+		   origin.getHedgeDelay(class_delay) >= origin.getLatency());
+	ensure_equals("Class delay is a minimum",
+				  origin.getHedgeDelay(U64L(5000000)), U64L(5000000));
+
+	// One hedge per HTTP_HEDGE_RATIO completions, 41 so far
+	ensure("First hedge", origin.takeHedge(0));
+	ensure("Second hedge", origin.takeHedge(0));
+	ensure("Third hedge", origin.takeHedge(0));
+	ensure("Fourth hedge refused", ! origin.takeHedge(0));
+	ensure_equals("Hedges counted", origin.getHedges(), 3L);
+
+	// None while the origin is holding or failing
+	HttpOriginHealth held("http://host2");
+	held.recordCompletion(HttpStatus(503), 0, 0, U64L(1000000), true);
+	ensure("Held", ! held.takeHedge(0));
+	ensure("Failing", ! held.takeHedge(U64L(2000000)));
+}
+
+}  // end namespace tut
+
+#endif  // TEST_LLCORE_HTTP_ORIGIN_H_
@@ -32,14 +32,20 @@
 #include "httpheaders.h"
 #include "httpresponse.h"
 #include "httpoptions.h"
+#include "httpstats.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
+#include "_httplibcurl.h"
 
 #include <curl/curl.h>
 #include <boost/regex.hpp>
+#include <algorithm>
+#include <map>
 #include <sstream>
+#include <vector>
 
 #include "llcorehttp_test.h"
+#include "lltimer.h"
 
 
 using namespace LLCoreInt;
@@ -185,6 +191,55 @@ public:
 	regex_container_t mHeadersDisallowed;
 };
 
+// Counts completions like TestHandler2 and keeps the time each
+// request spent between issue and completion.
+class LatencyHandler : public TestHandler2
+{
+public:
+	LatencyHandler(HttpRequestTestData * state,
+				   const std::string & name)
+		: TestHandler2(state, name),
+		  mTotalLatency(0),
+		  mMaxLatency(0),
+		  mPeakConcurrency(0)
+		{}
+
+	void issued(HttpHandle handle)
+		{
+			mIssued[handle] = totalTime();
+		}
+
+	virtual void onCompleted(HttpHandle handle, HttpResponse * response)
+		{
+			std::map<HttpHandle, U64>::iterator it(mIssued.find(handle));
+			if (mIssued.end() != it)
+			{
+				const U64 now(totalTime());
+				const U64 latency(now - it->second);
+				mTotalLatency += latency;
+				mMaxLatency = llmax(mMaxLatency, latency);
+				mIssued.erase(it);
+			}
+			HttpHeaders::ptr_t headers(response ? response->getHeaders() : HttpHeaders::ptr_t());
+			if (headers)
+			{
+				for (HttpHeaders::const_iterator iter(headers->begin()); headers->end() != iter; ++iter)
+				{
+					if (! LLStringUtil::compareInsensitive((*iter).first, "X-LL-Peak-Concurrency"))
+					{
+						mPeakConcurrency = llmax(mPeakConcurrency, atoi((*iter).second.c_str()));
+					}
+				}
+			}
+			TestHandler2::onCompleted(handle, response);
+		}
+
+	std::map<HttpHandle, U64> mIssued;
+	U64 mTotalLatency;					// microseconds
+	U64 mMaxLatency;
+	int mPeakConcurrency;				// as reported by the '/concurrency/' peer path
+};
+
 typedef test_group<HttpRequestTestData> HttpRequestTestGroupType;
 typedef HttpRequestTestGroupType::object HttpRequestTestObjectType;
 HttpRequestTestGroupType HttpRequestTestGroup("HttpRequest Tests");
@@ -3056,6 +3111,641 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GETs multiplexed over connections shared by two classes");
+
+	// Two classes with stream limits share one multi handle.  Against
+	// the HTTP/1.1 test peer, which closes every connection, the
+	// '/concurrency/' path reports how many connections were open at
+	// once: sharing keeps that within one class's per-host limit
+	// where separate handles would allow the sum.  There's no HTTP/2
+	// peer here; point LLCOREHTTP_HTTP2_URL at a local HTTP/2 server
+	// (nghttpd, h2o, etc.) to run the same load over multiplexed
+	// streams and report request latency.
+	const char * http2_url(getenv("LLCOREHTTP_HTTP2_URL"));
+	std::string url_base(http2_url ? std::string(http2_url) : get_base_url() + "/concurrency/shared/");
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	LatencyHandler handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		// Classes and their static options must exist before the
+		// thread starts.
+		HttpRequest::policy_t texture_class(HttpRequest::createPolicyClass());
+		HttpRequest::policy_t mesh_class(HttpRequest::createPolicyClass());
+		ensure("Policy classes created",
+			   texture_class != HttpRequest::INVALID_POLICY_ID
+			   && mesh_class != HttpRequest::INVALID_POLICY_ID);
+
+		const long connection_limit(2);
+		const long texture_streams(20);
+		long value(0);
+		HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_STREAM_LIMIT,
+															 texture_class, texture_streams, &value));
+		ensure("Stream limit set on first class", bool(status));
+		ensure_equals("Stream limit value", value, texture_streams);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_STREAM_LIMIT,
+													mesh_class, 10, NULL);
+		ensure("Stream limit set on second class", bool(status));
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_STREAM_LIMIT,
+													HttpRequest::GLOBAL_POLICY_ID, 50, NULL);
+		ensure("Stream limit refused as a global option", ! status);
+		for (HttpRequest::policy_t policy_class : { texture_class, mesh_class })
+		{
+			HttpRequest::setStaticPolicyOption(HttpRequest::PO_CONNECTION_LIMIT,
+											   policy_class, connection_limit, NULL);
+			HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+											   policy_class, connection_limit, NULL);
+		}
+
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// 500 concurrent requests, as a texture console burst
+		mStatus = HttpStatus(200);
+		const int url_limit(500);
+		const U64 start(totalTime());
+		for (int i(0); i < url_limit; ++i)
+		{
+			HttpHandle handle = req->requestGet((i % 4) ? texture_class : mesh_class,
+												0U,
+												url_base,
+												HttpOptions::ptr_t(),
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for request", handle != LLCORE_HTTP_HANDLE_INVALID);
+			handler.issued(handle);
+		}
+
+		// Run the notification pump, watching how many requests the
+		// texture class has handed to libcurl.  The count is only
+		// sampled, a stale read just lowers the peak.
+		HttpLibcurl & transport(HttpService::instanceOf()->getTransport());
+		int peak_active(0);
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < url_limit)
+		{
+			req->update(0);
+			peak_active = llmax(peak_active, transport.getActiveCountInClass(texture_class));
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure_equals("One handler invocation per request", mHandlerCalls, url_limit);
+		const U64 done(totalTime());
+
+		// The stream limit, not the connection limit, bounds what
+		// the class has in flight
+		ensure("More in flight than the connection limit", peak_active > connection_limit);
+		ensure("No more in flight than the stream limit", peak_active <= texture_streams);
+
+		if (! http2_url)
+		{
+			ensure("Requests overlapped", handler.mPeakConcurrency >= 2);
+			ensure("Classes shared their connections", handler.mPeakConcurrency <= connection_limit);
+		}
+
+		if (http2_url)
+		{
+			std::cout << "\n" << url_limit << " requests in "
+					  << (done - start) / 1000 << " ms, latency mean "
+					  << handler.mTotalLatency / url_limit / 1000 << " ms max "
+					  << handler.mMaxLatency / 1000 << " ms" << std::endl;
+		}
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<25>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GETs retried through 503 and 429 responses");
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	// Create before memory record as the string copy will bump numbers.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+	HttpOptions::ptr_t opts;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+		HttpRequest::startThread();
+		LLCore::HTTPStats::instance().resetStats();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		opts = HttpOptions::ptr_t(new HttpOptions());
+		opts->setRetries(5);
+		opts->setMinBackoff(100000);				// 0.1 sec
+		opts->setMaxBackoff(500000);				// 0.5 sec
+
+		// Both fail first and succeed on a retry.  The 429 carries a
+		// 'Retry-After: 1' which holds the origin for a second.
+		mStatus = HttpStatus(200);
+		const U64 start(totalTime());
+		HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+											0U,
+											get_base_url() + "/fault/503-2/test25/",
+											opts,
+											HttpHeaders::ptr_t(),
+											handlerp);
+		ensure("Valid handle returned for 503 request", handle != LLCORE_HTTP_HANDLE_INVALID);
+		handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+								 0U,
+								 get_base_url() + "/fault/429-1/test25/",
+								 opts,
+								 HttpHeaders::ptr_t(),
+								 handlerp);
+		ensure("Valid handle returned for 429 request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < 2)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure_equals("One handler invocation per request", mHandlerCalls, 2);
+		ensure("Retry-After honored", totalTime() - start >= U64L(1000000));
+		ensure_equals("Retries made", LLCore::HTTPStats::instance().getRetries(), 3);
+		ensure_equals("No retries denied", LLCore::HTTPStats::instance().getRetriesDenied(), 0);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<26>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest retries limited by origin retry budget");
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	// Create before memory record as the string copy will bump numbers.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+	HttpOptions::ptr_t opts;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		// The budget is opt-in and static
+		long value(0);
+		HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_RETRY_BUDGET,
+															 HttpRequest::DEFAULT_POLICY_ID, 1, &value));
+		ensure("Retry budget set on class", bool(status));
+		ensure_equals("Retry budget value", value, 1L);
+
+		HttpRequest::startThread();
+		LLCore::HTTPStats::instance().resetStats();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		opts = HttpOptions::ptr_t(new HttpOptions());
+		opts->setRetries(5);
+		opts->setMinBackoff(100000);				// 0.1 sec
+		opts->setMaxBackoff(500000);				// 0.5 sec
+
+		// Ten requests to an origin that always fails.  Without a
+		// budget that's fifty retries.  With one, the first five
+		// failures are retried and the rest aren't.  Failed retries
+		// don't spend the budget but are denied once it's down.
+		mStatus = HttpStatus(503);
+		const int url_limit(10);
+		for (int i(0); i < url_limit; ++i)
+		{
+			std::ostringstream url;
+			url << get_base_url() << "/fault/503-100/test26-" << i << "/";
+			HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+												0U,
+												url.str(),
+												opts,
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for request", handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < url_limit)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure_equals("One handler invocation per request", mHandlerCalls, url_limit);
+		ensure_equals("Retries limited by budget",
+					  LLCore::HTTPStats::instance().getRetries(), 5);
+		ensure_equals("Remaining failures denied retries",
+					  LLCore::HTTPStats::instance().getRetriesDenied(), 10);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<27>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GET hedged past a slow response");
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	// Create before memory record as the string copy will bump numbers.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		// Classes and their static options must exist before the
+		// thread starts.
+		HttpRequest::policy_t hedge_class(HttpRequest::createPolicyClass());
+		ensure("Policy class created", hedge_class != HttpRequest::INVALID_POLICY_ID);
+
+		long value(0);
+		HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_HEDGE_DELAY,
+															 hedge_class, 200, &value));
+		ensure("Hedge delay set on class", bool(status));
+		ensure_equals("Hedge delay value", value, 200L);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HEDGE_DELAY,
+													HttpRequest::GLOBAL_POLICY_ID, 200, NULL);
+		ensure("Hedge delay refused as a global option", ! status);
+
+		HttpRequest::startThread();
+		LLCore::HTTPStats::instance().resetStats();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// The first request for the URL stalls for five seconds, the
+		// hedge sent after 200 mS is answered at once.
+		mStatus = HttpStatus(200);
+		const U64 start(totalTime());
+		HttpHandle handle = req->requestGet(hedge_class,
+											0U,
+											get_base_url() + "/slowfirst/test27/",
+											HttpOptions::ptr_t(),
+											HttpHeaders::ptr_t(),
+											handlerp);
+		ensure("Valid handle returned for request", handle != LLCORE_HTTP_HANDLE_INVALID);
+		handler.mExpectHandle = handle;
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Request executed in reasonable time", count < limit);
+		ensure_equals("One handler invocation for request", mHandlerCalls, 1);
+		ensure("Answered by the hedge before the stall ended",
+			   totalTime() - start < U64L(4000000));
+		ensure_equals("One hedge issued", LLCore::HTTPStats::instance().getHedges(), 1);
+		ensure_equals("Hedge won", LLCore::HTTPStats::instance().getHedgesWon(), 1);
+		handler.mExpectHandle = LLCORE_HTTP_HANDLE_INVALID;
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<28>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest service loop latency and idle wakeups");
+
+	// Sequential GETs measure what the worker loop adds to a
+	// request on the way in and on the way out.  A GET the server
+	// stalls then shows how often the loop wakes with nothing to
+	// do.  Set LLCOREHTTP_LOOP_REPORT to print both.
+	const bool report(NULL != getenv("LLCOREHTTP_LOOP_REPORT"));
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	LatencyHandler handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// One at a time with the notification pump spinning so
+		// the consumer adds nothing worth counting.
+		mStatus = HttpStatus(200);
+		const int url_limit(50);
+		std::vector<U64> latencies;
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		for (int i(0); i < url_limit; ++i)
+		{
+			const U64 before(handler.mTotalLatency);
+			HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+												0U,
+												get_base_url(),
+												HttpOptions::ptr_t(),
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for request", handle != LLCORE_HTTP_HANDLE_INVALID);
+			handler.issued(handle);
+
+			const U64 give_up(totalTime() + U64L(10000000));
+			while (mHandlerCalls <= i && totalTime() < give_up)
+			{
+				req->update(0);
+				usleep(100);
+			}
+			ensure_equals("Request completed", mHandlerCalls, i + 1);
+			latencies.push_back(handler.mTotalLatency - before);
+		}
+		std::sort(latencies.begin(), latencies.end());
+		const U64 median(latencies[latencies.size() / 2]);
+
+		// Now idle on a request the server sits on for five seconds
+		const U32 loops_before(HttpService::instanceOf()->getLoopCount());
+		const U64 start(totalTime());
+		HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+											0U,
+											get_base_url() + "/slowfirst/test28/",
+											HttpOptions::ptr_t(),
+											HttpHeaders::ptr_t(),
+											handlerp);
+		ensure("Valid handle returned for slow request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < url_limit + 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Slow request executed in reasonable time", count < limit);
+		ensure_equals("Slow request completed", mHandlerCalls, url_limit + 1);
+		const F64 seconds(F64(totalTime() - start) / 1000000.0);
+		const F64 wakeups(F64(HttpService::instanceOf()->getLoopCount() - loops_before) / seconds);
+
+		if (report)
+		{
+			std::cout << "\nMedian request latency " << median << " uS, "
+					  << wakeups << " loop wakeups/S waiting on a slow request" << std::endl;
+		}
+#if LLCORE_HTTP_MULTI_POLL
+		// Sleeping 2 mS a pass runs several hundred passes a second
+		ensure("Worker thread waits for events when idle", wakeups < 50.0);
+#endif
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
 }  // end namespace tut
 
 namespace
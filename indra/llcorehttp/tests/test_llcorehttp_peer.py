@@ -34,8 +34,10 @@ import sys
 import time
 import select
 import getopt
+import threading
 from io import StringIO
 from http.server import HTTPServer, BaseHTTPRequestHandler
+from socketserver import ThreadingMixIn
 
 
 from llbase.fastest_elementtree import parse as xml_parse
@@ -77,12 +79,52 @@ class TestHTTPRequestHandler(BaseHTTPRequestHandler):
     -- '/503/4/'            "Retry-After: (*#*(@*(@(")"
     -- '/503/5/'            "Retry-After: aklsjflajfaklsfaklfasfklasdfklasdgahsdhgasdiogaioshdgo"
     -- '/503/6/'            "Retry-After: 1 2 3 4 5 6 7 8 9 10"
+    - '/fault/<status>-<count>/'
+                        First <count> requests for the path get
+                        <status> with "Retry-After: 1", later ones
+                        succeed as a plain GET.  Add a tag after it
+                        to keep tests apart.
+    - '/slowfirst/'     First request for the path takes 5 seconds
+                        to answer, later ones answer at once.
+    - '/concurrency/'   Each request takes 10ms and the answer
+                        carries "X-LL-Peak-Concurrency", the most
+                        requests for the path the server has had in
+                        hand at once.  With the server closing every
+                        connection that is also the most connections
+                        the client had open.
 
     Some combinations make no sense, there's no effort to protect
     you from that.
     """
     ignore_exceptions = (Exception,)
 
+    # Requests seen per path for '/fault/' and '/slowfirst/', and
+    # requests in hand per path for '/concurrency/', shared by the
+    # handler threads
+    seen = {}
+    active = {}
+    peak = {}
+    seen_lock = threading.Lock()
+
+    def count_request(self):
+        with self.seen_lock:
+            count = self.seen.get(self.path, 0)
+            self.seen[self.path] = count + 1
+        return count
+
+    def begin_concurrent(self):
+        with self.seen_lock:
+            active = self.active.get(self.path, 0) + 1
+            self.active[self.path] = active
+            self.peak[self.path] = max(self.peak.get(self.path, 0), active)
+
+    def end_concurrent(self):
+        # Called before the answer goes out so the client can't have
+        # started another request on the connection yet
+        with self.seen_lock:
+            self.active[self.path] -= 1
+            return self.peak[self.path]
+
     def read(self):
         # The following logic is adapted from the library module
         # SimpleXMLRPCServer.py.
@@ -151,6 +193,22 @@ class TestHTTPRequestHandler(BaseHTTPRequestHandler):
         if "/sleep/" in self.path:
             time.sleep(30)
 
+        if "/slowfirst/" in self.path and self.count_request() == 0:
+            time.sleep(5)
+
+        if "/concurrency/" in self.path:
+            self.begin_concurrent()
+            time.sleep(0.01)
+
+        if "/fault/" in self.path:
+            status, count = self.path.split("/fault/", 1)[1].split("/")[0].split("-")
+            if self.count_request() < int(count):
+                self.send_response(int(status))
+                self.send_header("Retry-After", "1")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+
         if "/503/" in self.path:
             # Tests for various kinds of 'Retry-After' header parsing
             body = None
@@ -232,6 +290,8 @@ class TestHTTPRequestHandler(BaseHTTPRequestHandler):
             self.send_header("Content-type", "application/llsd+xml")
             self.send_header("Content-Length", str(len(response)))
             self.send_header("X-LL-Special", "Mememememe");
+            if "/concurrency/" in self.path:
+                self.send_header("X-LL-Peak-Concurrency", str(self.end_concurrent()))
             self.end_headers()
             if withdata:
                 self.wfile.write(response)
@@ -270,11 +330,15 @@ class TestHTTPRequestHandler(BaseHTTPRequestHandler):
             # Suppress error output as well
             pass
 
-class Server(HTTPServer):
+class Server(ThreadingMixIn, HTTPServer):
     # This pernicious flag is on by default in HTTPServer. But proper
     # operation of freeport() absolutely depends on it being off.
     allow_reuse_address = False
 
+    # Answer requests concurrently so a slow one (hedging tests)
+    # doesn't hold up the rest.  Don't wait for them on exit.
+    daemon_threads = True
+
     # Override of BaseServer.handle_error().  Not too interested
     # in errors and the default handler emits a scary traceback
     # to stderr which annoys some.  Disable this override to get
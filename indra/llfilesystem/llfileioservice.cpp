@@ -0,0 +1,596 @@
+/**
+ * @file llfileioservice.cpp
+ * @brief Asynchronous local file reads and writes, completed on WorkQueues
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llfileioservice.h"
+
+#include "llfile.h"
+
+#include <climits>
+#include <memory>
+
+#if LL_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+std::atomic<bool> sIOUringDisabled(false);
+std::atomic<bool> sIOUringUsed(false);
+
+// No result from the ring, do it the slow way
+const S32 NOT_DONE = INT_MIN;
+
+S32 process_one(const LLFileIOService::Request& req)
+{
+	if (req.mBytes <= 0)
+	{
+		return 0;
+	}
+	if (req.mOperation == LLFileIOService::FILE_READ)
+	{
+		llassert(req.mOffset >= 0);
+		LLUniqueFile infile(LLFile::fopen(req.mFileName, "rb"));
+		if (!infile)
+		{
+			LL_WARNS() << "LLFileIO: Unable to read file: " << req.mFileName << LL_ENDL;
+			return 0;
+		}
+		if (fseek(infile, req.mOffset, SEEK_SET) != 0)
+		{
+			LL_WARNS() << "LLFileIO: Unable to read file (seek failed): " << req.mFileName << LL_ENDL;
+			return 0;
+		}
+		return S32(fread(req.mBuffer, 1, req.mBytes, infile));
+	}
+
+	LLUniqueFile outfile;
+	if (req.mOffset < 0)
+	{
+		outfile = LLFile::fopen(req.mFileName, "ab");
+	}
+	else
+	{
+		// keep what's there, like APR_CREATE|APR_WRITE
+		outfile = LLFile::fopen(req.mFileName, "r+b");
+		if (!outfile)
+		{
+			outfile = LLFile::fopen(req.mFileName, "wb");
+		}
+	}
+	if (!outfile)
+	{
+		LL_WARNS() << "LLFileIO: Unable to write file: " << req.mFileName << LL_ENDL;
+		return 0;
+	}
+	if (req.mOffset >= 0 && fseek(outfile, req.mOffset, SEEK_SET) != 0)
+	{
+		LL_WARNS() << "LLFileIO: Unable to write file (seek failed): " << req.mFileName << LL_ENDL;
+		return 0;
+	}
+	return S32(fwrite(req.mBuffer, 1, req.mBytes, outfile));
+}
+
+#if LL_LINUX
+
+// Just the part of io_uring we need, through the raw system calls so there's
+// no liburing to package: a ring per I/O thread, filled with a batch of
+// reads and writes, submitted and waited on with one io_uring_enter().
+class IOUring
+{
+public:
+	static const unsigned ENTRIES = 64;
+
+	struct Transfer
+	{
+		int mFd;
+		bool mWrite;
+		U8* mBuffer;
+		U32 mBytes;
+		U64 mOffset;
+	};
+
+	IOUring():
+		mFd(-1),
+		mSqRing(MAP_FAILED),
+		mCqRing(MAP_FAILED),
+		mSqes(MAP_FAILED)
+	{}
+
+	~IOUring()
+	{
+		if (mSqes != MAP_FAILED)
+		{
+			munmap(mSqes, mSqesSize);
+		}
+		if (mCqRing != MAP_FAILED && mCqRing != mSqRing)
+		{
+			munmap(mCqRing, mCqRingSize);
+		}
+		if (mSqRing != MAP_FAILED)
+		{
+			munmap(mSqRing, mSqRingSize);
+		}
+		if (mFd >= 0)
+		{
+			::close(mFd);
+		}
+	}
+
+	bool init()
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		mFd = int(syscall(__NR_io_uring_setup, ENTRIES, &params));
+		if (mFd < 0)
+		{
+			LL_INFOS() << "LLFileIO: io_uring unavailable (" << strerror(errno)
+					   << "), using blocking I/O" << LL_ENDL;
+			return false;
+		}
+
+		mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(U32);
+		mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		const bool single_mmap(params.features & IORING_FEAT_SINGLE_MMAP);
+		if (single_mmap)
+		{
+			mSqRingSize = mCqRingSize = llmax(mSqRingSize, mCqRingSize);
+		}
+		mSqRing = mmap(NULL, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+					   mFd, IORING_OFF_SQ_RING);
+		if (mSqRing == MAP_FAILED)
+		{
+			return false;
+		}
+		mCqRing = single_mmap ? mSqRing
+			: mmap(NULL, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				   mFd, IORING_OFF_CQ_RING);
+		mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		mSqes = mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+					 mFd, IORING_OFF_SQES);
+		if (mCqRing == MAP_FAILED || mSqes == MAP_FAILED)
+		{
+			return false;
+		}
+
+		U8* sq(static_cast<U8*>(mSqRing));
+		mSqTail = reinterpret_cast<U32*>(sq + params.sq_off.tail);
+		mSqMask = *reinterpret_cast<U32*>(sq + params.sq_off.ring_mask);
+		mSqArray = reinterpret_cast<U32*>(sq + params.sq_off.array);
+		mSqEntries = params.sq_entries;
+		U8* cq(static_cast<U8*>(mCqRing));
+		mCqHead = reinterpret_cast<U32*>(cq + params.cq_off.head);
+		mCqTail = reinterpret_cast<U32*>(cq + params.cq_off.tail);
+		mCqMask = *reinterpret_cast<U32*>(cq + params.cq_off.ring_mask);
+		mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	// results[i] gets the kernel's result for transfers[i], a byte count or
+	// -errno. Transfers the kernel never saw are left as NOT_DONE and may be
+	// redone another way. If the ring fails with transfers in flight, it is
+	// drained and closed first and those get -ECANCELED, since the kernel
+	// may have been writing to their buffers.
+	void run(const std::vector<Transfer>& transfers, LLFileIOService::results_t& results)
+	{
+		for (size_t start = 0; start < transfers.size(); start += mSqEntries)
+		{
+			const U32 count(U32(llmin(size_t(mSqEntries), transfers.size() - start)));
+			U32 tail(*mSqTail);
+			for (U32 i = 0; i < count; ++i)
+			{
+				const Transfer& transfer(transfers[start + i]);
+				const U32 index(tail & mSqMask);
+				io_uring_sqe* sqe(static_cast<io_uring_sqe*>(mSqes) + index);
+				memset(sqe, 0, sizeof(*sqe));
+				sqe->opcode = transfer.mWrite ? IORING_OP_WRITE : IORING_OP_READ;
+				sqe->fd = transfer.mFd;
+				sqe->addr = U64(uintptr_t(transfer.mBuffer));
+				sqe->len = transfer.mBytes;
+				sqe->off = transfer.mOffset;
+				sqe->user_data = start + i;
+				mSqArray[index] = index;
+				++tail;
+			}
+			__atomic_store_n(mSqTail, tail, __ATOMIC_RELEASE);
+
+			U32 to_submit(count);
+			U32 done(0);
+			while (done < count)
+			{
+				const int ret(enter(to_submit, 1));
+				if (ret < 0)
+				{
+					if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+					{
+						continue;
+					}
+					LL_WARNS() << "LLFileIO: io_uring_enter failed: " << strerror(errno) << LL_ENDL;
+					sIOUringDisabled = true;
+					// The kernel takes entries in order and reports an error
+					// only when it took none, so just the first ones are out
+					const U32 submitted(count - to_submit);
+					done += drain(submitted - done, results);
+					for (U32 i = 0; i < submitted; ++i)
+					{
+						if (results[start + i] == NOT_DONE)
+						{
+							results[start + i] = -ECANCELED;
+						}
+					}
+					shutdown();
+					return;
+				}
+				to_submit -= llmin(to_submit, U32(ret));
+				done += reap(results);
+			}
+		}
+	}
+
+private:
+	int enter(U32 to_submit, U32 min_complete)
+	{
+		return int(syscall(__NR_io_uring_enter, mFd, to_submit, min_complete,
+						   IORING_ENTER_GETEVENTS, NULL, 0));
+	}
+
+	// Copy out whatever has completed, returns how many
+	U32 reap(LLFileIOService::results_t& results)
+	{
+		U32 reaped(0);
+		U32 head(*mCqHead);
+		const U32 cq_tail(__atomic_load_n(mCqTail, __ATOMIC_ACQUIRE));
+		for ( ; head != cq_tail; ++head)
+		{
+			const io_uring_cqe& cqe(mCqes[head & mCqMask]);
+			results[size_t(cqe.user_data)] = cqe.res;
+			++reaped;
+		}
+		__atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+		return reaped;
+	}
+
+	// Wait for in_flight transfers to complete, as far as the ring still
+	// works, returns how many did
+	U32 drain(U32 in_flight, LLFileIOService::results_t& results)
+	{
+		U32 drained(reap(results));
+		while (drained < in_flight)
+		{
+			if (enter(0, in_flight - drained) < 0 && errno != EINTR)
+			{
+				break;
+			}
+			drained += reap(results);
+		}
+		return drained;
+	}
+
+	// Closing the ring has the kernel cancel anything still in it
+	void shutdown()
+	{
+		if (mFd >= 0)
+		{
+			::close(mFd);
+			mFd = -1;
+		}
+	}
+
+	int mFd;
+	void* mSqRing;
+	void* mCqRing;
+	void* mSqes;
+	size_t mSqRingSize;
+	size_t mCqRingSize;
+	size_t mSqesSize;
+
+	U32* mSqTail;
+	U32 mSqMask;
+	U32* mSqArray;
+	U32 mSqEntries;
+	U32* mCqHead;
+	U32* mCqTail;
+	U32 mCqMask;
+	io_uring_cqe* mCqes;
+};
+
+IOUring* thread_ring()
+{
+	static thread_local std::unique_ptr<IOUring> sRing;
+	if (sIOUringDisabled)
+	{
+		sRing.reset();
+		return NULL;
+	}
+	if (!sRing)
+	{
+		sRing.reset(new IOUring);
+		if (!sRing->init())
+		{
+			sIOUringDisabled = true;
+			sRing.reset();
+		}
+	}
+	return sRing.get();
+}
+
+bool process_ring(IOUring* ring, const LLFileIOService::batch_t& batch,
+				  LLFileIOService::results_t& results)
+{
+	std::vector<int> fds(batch.size(), -1);
+	std::vector<IOUring::Transfer> transfers;
+	std::vector<size_t> owners;
+	transfers.reserve(batch.size());
+	owners.reserve(batch.size());
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		const LLFileIOService::Request& req(batch[i]);
+		const bool write(req.mOperation == LLFileIOService::FILE_WRITE);
+		int flags(O_CLOEXEC);
+		if (write)
+		{
+			flags |= O_WRONLY | O_CREAT;
+			if (req.mOffset < 0)
+				flags |= O_APPEND;
+		}
+		else
+		{
+			llassert(req.mOffset >= 0);
+			flags |= O_RDONLY;
+		}
+		fds[i] = ::open(req.mFileName.c_str(), flags, 0666);
+		if (fds[i] < 0)
+		{
+			LL_WARNS() << "LLFileIO: Unable to " << (write ? "write" : "read")
+					   << " file: " << req.mFileName << LL_ENDL;
+			results[i] = 0;
+			continue;
+		}
+		// offset -1 is the file position, the end with O_APPEND
+		IOUring::Transfer transfer = { fds[i], write, req.mBuffer, U32(llmax(req.mBytes, 0)),
+									   req.mOffset < 0 ? U64(-1) : U64(req.mOffset) };
+		transfers.push_back(transfer);
+		owners.push_back(i);
+	}
+
+	LLFileIOService::results_t ring_results(transfers.size(), NOT_DONE);
+	ring->run(transfers, ring_results);
+
+	bool used(false);
+	for (size_t t = 0; t < transfers.size(); ++t)
+	{
+		const size_t i(owners[t]);
+		const S32 res(ring_results[t]);
+		if (res == -EINVAL || res == -EOPNOTSUPP)
+		{
+			// kernel too old for IORING_OP_READ/WRITE
+			sIOUringDisabled = true;
+			results[i] = NOT_DONE;
+		}
+		else if (res < 0 && res != NOT_DONE)
+		{
+			LL_WARNS() << "LLFileIO: " << (transfers[t].mWrite ? "write" : "read")
+					   << " failed: " << batch[i].mFileName << ": " << strerror(-res) << LL_ENDL;
+			results[i] = 0;
+		}
+		else
+		{
+			used |= (res != NOT_DONE);
+			results[i] = res;
+		}
+	}
+
+	for (int fd : fds)
+	{
+		if (fd >= 0)
+		{
+			::close(fd);
+		}
+	}
+	return used;
+}
+
+#endif // LL_LINUX
+
+} // anonymous namespace
+
+//============================================================================
+
+LLFileIOService::Request::Request(operation_t op, const std::string& filename,
+								  U8* buffer, S32 offset, S32 numbytes) :
+	mOperation(op),
+	mFileName(filename),
+	mBuffer(buffer),
+	mOffset(offset),
+	mBytes(numbytes)
+{
+	if (numbytes <= 0)
+	{
+		LL_WARNS() << "LLFileIO: Request with numbytes = " << numbytes << LL_ENDL;
+	}
+}
+
+//============================================================================
+
+LLFileIOService::LLFileIOService(size_t threads) :
+	// The viewer flushes and closes us explicitly during shutdown, after
+	// the "LLApp" status change that would otherwise close the queue
+	LL::ThreadPool("FileIO", threads, 1024*1024, false),
+	mPending(0)
+{
+	LL::ThreadPool::start();
+}
+
+LLFileIOService::~LLFileIOService()
+{
+	close();
+}
+
+//static
+bool LLFileIOService::usingIOUring()
+{
+	return sIOUringUsed && !sIOUringDisabled;
+}
+
+//static
+void LLFileIOService::disableIOUring()
+{
+	sIOUringDisabled = true;
+}
+
+//static
+void LLFileIOService::enableIOUring()
+{
+	sIOUringDisabled = false;
+}
+
+//static
+LLFileIOService::results_t LLFileIOService::process(const batch_t& batch)
+{
+	results_t results(batch.size(), NOT_DONE);
+#if LL_LINUX
+	if (IOUring* ring = thread_ring())
+	{
+		if (process_ring(ring, batch, results))
+		{
+			sIOUringUsed = true;
+		}
+	}
+#endif
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		if (results[i] == NOT_DONE)
+		{
+			results[i] = process_one(batch[i]);
+		}
+	}
+	return results;
+}
+
+void LLFileIOService::enqueue(batch_t&& batch, const std::function<void(const results_t&)>& done)
+{
+	const size_t count(batch.size());
+	mPending += count;
+	bool posted(getQueue().postIfOpen(
+		[this, batch = std::move(batch), done]()
+		{
+			results_t results(process(batch));
+			mPending -= batch.size();
+			done(results);
+		}));
+	if (!posted)
+	{
+		mPending -= count;
+		done(results_t(count, 0));
+	}
+}
+
+void LLFileIOService::read(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+						   const completion_t& completion)
+{
+	enqueue(batch_t(1, Request(FILE_READ, filename, buffer, offset, numbytes)),
+			[completion](const results_t& results) { completion(results[0]); });
+}
+
+void LLFileIOService::write(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+							const completion_t& completion)
+{
+	enqueue(batch_t(1, Request(FILE_WRITE, filename, buffer, offset, numbytes)),
+			[completion](const results_t& results) { completion(results[0]); });
+}
+
+void LLFileIOService::submit(batch_t&& batch, const batch_completion_t& completion)
+{
+	enqueue(std::move(batch), completion);
+}
+
+void LLFileIOService::read(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+						   LL::WorkQueueBase::weak_t reply, const completion_t& completion)
+{
+	read(filename, buffer, offset, numbytes,
+		 [reply, completion](S32 bytes)
+		 {
+			 LL::WorkQueueBase::postMaybe(reply, [completion, bytes]() { completion(bytes); });
+		 });
+}
+
+void LLFileIOService::write(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+							LL::WorkQueueBase::weak_t reply, const completion_t& completion)
+{
+	write(filename, buffer, offset, numbytes,
+		  [reply, completion](S32 bytes)
+		  {
+			  LL::WorkQueueBase::postMaybe(reply, [completion, bytes]() { completion(bytes); });
+		  });
+}
+
+void LLFileIOService::submit(batch_t&& batch, LL::WorkQueueBase::weak_t reply,
+							 const batch_completion_t& completion)
+{
+	enqueue(std::move(batch),
+			[reply, completion](const results_t& results)
+			{
+				LL::WorkQueueBase::postMaybe(reply, [completion, results]() { completion(results); });
+			});
+}
+
+S32 LLFileIOService::readWait(const std::string& filename, U8* buffer, S32 offset, S32 numbytes)
+{
+	return submitWait(batch_t(1, Request(FILE_READ, filename, buffer, offset, numbytes)))[0];
+}
+
+S32 LLFileIOService::writeWait(const std::string& filename, U8* buffer, S32 offset, S32 numbytes)
+{
+	return submitWait(batch_t(1, Request(FILE_WRITE, filename, buffer, offset, numbytes)))[0];
+}
+
+LLFileIOService::results_t LLFileIOService::submitWait(batch_t&& batch)
+{
+	const size_t count(batch.size());
+	mPending += count;
+	try
+	{
+		return getQueue().waitForResult(
+			[this, batch = std::move(batch)]()
+			{
+				results_t results(process(batch));
+				mPending -= batch.size();
+				return results;
+			});
+	}
+	catch (const LL::WorkQueue::Closed&)
+	{
+		mPending -= count;
+		return results_t(count, 0);
+	}
+}
@@ -0,0 +1,134 @@
+/**
+ * @file llfileioservice.h
+ * @brief Asynchronous local file reads and writes, completed on WorkQueues
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFILEIOSERVICE_H
+#define LL_LLFILEIOSERVICE_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "llsingleton.h"
+#include "threadpool.h"
+#include "workqueue.h"
+
+//============================================================================
+// Asynchronous local file I/O
+//
+// Requests are gathered into batches. Each batch runs on one thread of the
+// "FileIO" ThreadPool, so separate batches overlap with each other; on Linux
+// the requests within a batch are also submitted to the kernel together
+// through an io_uring and overlap with each other. Where io_uring isn't
+// available (other platforms, old kernels, sandboxes that forbid it) each
+// request in the batch is done in turn with ordinary blocking reads and
+// writes.
+//
+// A completion runs on the WorkQueue passed with the request, typically the
+// caller's own, or on the I/O thread if none is given. Coroutines can wait
+// for results with readWait(), writeWait() and submitWait(), which suspend
+// only the calling coroutine.
+//
+// Byte counts follow the old LLLFSThread convention: the number of bytes
+// read or written, 0 on failure.
+//============================================================================
+
+class LLFileIOService : public LLSimpleton<LLFileIOService>, LL::ThreadPool
+{
+public:
+	enum operation_t {
+		FILE_READ,
+		FILE_WRITE
+	};
+
+	struct Request
+	{
+		Request(operation_t op, const std::string& filename,
+				U8* buffer, S32 offset, S32 numbytes);
+
+		operation_t mOperation;
+		std::string mFileName;
+		U8* mBuffer;	// dest for reads, source for writes, must outlive the request
+		S32 mOffset;	// offset into file, -1 = append (WRITE only)
+		S32 mBytes;		// bytes to transfer
+	};
+	typedef std::vector<Request> batch_t;
+	typedef std::vector<S32> results_t;
+
+	typedef std::function<void(S32 bytes)> completion_t;
+	typedef std::function<void(const results_t& bytes)> batch_completion_t;
+
+	// threads may be overridden by the "FileIO" entry in ThreadPoolSizes
+	LLFileIOService(size_t threads = 2);
+	~LLFileIOService();
+
+	// Completion runs on the I/O thread
+	void read(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+			  const completion_t& completion);
+	void write(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+			   const completion_t& completion);
+	void submit(batch_t&& batch, const batch_completion_t& completion);
+
+	// Completion is posted to reply. If reply has gone away or closed by
+	// then, the completion is dropped.
+	void read(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+			  LL::WorkQueueBase::weak_t reply, const completion_t& completion);
+	void write(const std::string& filename, U8* buffer, S32 offset, S32 numbytes,
+			   LL::WorkQueueBase::weak_t reply, const completion_t& completion);
+	void submit(batch_t&& batch, LL::WorkQueueBase::weak_t reply,
+				const batch_completion_t& completion);
+
+	// Suspend the calling coroutine until done. Not from a thread's
+	// default coroutine.
+	S32 readWait(const std::string& filename, U8* buffer, S32 offset, S32 numbytes);
+	S32 writeWait(const std::string& filename, U8* buffer, S32 offset, S32 numbytes);
+	results_t submitWait(batch_t&& batch);
+
+	// Requests submitted whose I/O hasn't finished
+	size_t getPending() const { return mPending.load(std::memory_order_relaxed); }
+
+	// Finishes what was submitted, then stops the threads. Later
+	// submissions complete with 0 on the submitting thread.
+	using LL::ThreadPool::close;
+
+	// True once a batch has gone through io_uring, and it hasn't been
+	// disabled since
+	static bool usingIOUring();
+	// Use blocking reads and writes from now on
+	static void disableIOUring();
+	// Let threads set up io_uring again, as far as the system allows
+	static void enableIOUring();
+
+	// Does the batch on the calling thread
+	static results_t process(const batch_t& batch);
+
+private:
+	void enqueue(batch_t&& batch, const std::function<void(const results_t&)>& done);
+
+	std::atomic<size_t> mPending;
+};
+
+#endif // LL_LLFILEIOSERVICE_H
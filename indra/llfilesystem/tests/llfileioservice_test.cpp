@@ -0,0 +1,217 @@
+/**
+ * @file llfileioservice_test.cpp
+ * @brief Test for LLFileIOService
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llfileioservice.h"
+#include "llcoros.h"
+#include "llfile.h"
+#include "lleventcoro.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+	std::vector<U8> pattern(size_t size, U8 seed)
+	{
+		std::vector<U8> data(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			data[i] = U8(seed + i * 7);
+		}
+		return data;
+	}
+
+	// Run the default coroutine until done or a few seconds have gone by
+	template <typename PRED>
+	bool wait_until(PRED done)
+	{
+		LLTimer timer;
+		while (!done())
+		{
+			if (timer.getElapsedTimeF32() > 5.f)
+			{
+				return false;
+			}
+			llcoro::suspend();
+			std::this_thread::yield();
+		}
+		return true;
+	}
+}
+
+namespace tut
+{
+	struct fileio_data
+	{
+		fileio_data():
+			mFile("fileio", "")
+		{}
+
+		// a batch writing blocks of 'block' bytes, then reading them back
+		void roundtrip(size_t blocks, size_t block)
+		{
+			const std::string name(mFile.getName());
+			std::vector<std::vector<U8>> out, in;
+			LLFileIOService::batch_t writes, reads;
+			for (size_t i = 0; i < blocks; ++i)
+			{
+				out.push_back(pattern(block, U8(i)));
+				in.push_back(std::vector<U8>(block));
+				writes.push_back(LLFileIOService::Request(LLFileIOService::FILE_WRITE, name,
+														  &out[i][0], S32(i * block), S32(block)));
+				reads.push_back(LLFileIOService::Request(LLFileIOService::FILE_READ, name,
+														 &in[i][0], S32(i * block), S32(block)));
+			}
+
+			LLFileIOService::results_t written(LLFileIOService::process(writes));
+			LLFileIOService::results_t read(LLFileIOService::process(reads));
+			for (size_t i = 0; i < blocks; ++i)
+			{
+				ensure_equals("written", written[i], S32(block));
+				ensure_equals("read", read[i], S32(block));
+				ensure("same data", in[i] == out[i]);
+			}
+		}
+
+		NamedTempFile mFile;
+	};
+	typedef test_group<fileio_data> fileio_group;
+	typedef fileio_group::object object;
+	fileio_group fileio("LLFileIOService");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("batches on the calling thread");
+		// more than fit in one submission to the ring
+		roundtrip(100, 4096);
+
+		// a short read at the end of the file, a read that can't open
+		std::vector<U8> buffer(8192);
+		LLFileIOService::batch_t batch;
+		batch.push_back(LLFileIOService::Request(LLFileIOService::FILE_READ, mFile.getName(),
+												 &buffer[0], 100 * 4096 - 10, 100));
+		batch.push_back(LLFileIOService::Request(LLFileIOService::FILE_READ,
+												 mFile.getName() + ".missing", &buffer[0], 0, 100));
+		LLFileIOService::results_t results(LLFileIOService::process(batch));
+		ensure_equals("short read", results[0], 10);
+		ensure_equals("missing file", results[1], 0);
+
+		// appends
+		std::vector<U8> tail(pattern(16, 99));
+		batch.clear();
+		batch.push_back(LLFileIOService::Request(LLFileIOService::FILE_WRITE, mFile.getName(),
+												 &tail[0], -1, 16));
+		ensure_equals("append", LLFileIOService::process(batch)[0], 16);
+		llstat status;
+		ensure_equals("stat", LLFile::stat(mFile.getName(), &status), 0);
+		ensure_equals("appended size", S64(status.st_size), S64(100 * 4096 + 16));
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("blocking fallback matches");
+		// the later tests should get io_uring again where there is one
+		struct restore
+		{
+			~restore() { LLFileIOService::enableIOUring(); }
+		} restore_io_uring;
+		LLFileIOService::disableIOUring();
+		ensure_not("io_uring disabled", LLFileIOService::usingIOUring());
+		roundtrip(10, 1000);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("completions on the I/O thread and on a WorkQueue");
+		LLFileIOService service(2);
+		const std::string name(mFile.getName());
+		std::vector<U8> out(pattern(5000, 3)), in(5000);
+
+		std::atomic<S32> written(-1);
+		service.write(name, &out[0], 0, 5000, [&written](S32 bytes) { written = bytes; });
+		ensure("write completed", wait_until([&written]() { return written >= 0; }));
+		ensure_equals("written", S32(written), 5000);
+
+		LL::WorkQueue reply("fileio_reply");
+		S32 read(-1);
+		std::thread::id ran_on;
+		service.read(name, &in[0], 0, 5000, reply.getWeak(),
+					 [&read, &ran_on](S32 bytes)
+					 {
+						 read = bytes;
+						 ran_on = std::this_thread::get_id();
+					 });
+		ensure("read completed",
+			   wait_until([&reply, &read]() { reply.runPending(); return read >= 0; }));
+		ensure_equals("read", read, 5000);
+		ensure("ran on reply queue's thread", ran_on == std::this_thread::get_id());
+		ensure("same data", in == out);
+		ensure_equals("nothing pending", service.getPending(), size_t(0));
+
+		service.close();
+		S32 late(-1);
+		service.read(name, &in[0], 0, 5000, [&late](S32 bytes) { late = bytes; });
+		ensure_equals("after close", late, 0);
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("coroutines wait for results");
+		LLFileIOService service(1);
+		const std::string name(mFile.getName());
+		std::vector<U8> out(pattern(3000, 5)), in(3000);
+		LLFileIOService::results_t results;
+		bool done(false);
+		LLCoros::instance().launch(
+			"fileio wait",
+			[&]()
+			{
+				service.writeWait(name, &out[0], 0, 3000);
+				LLFileIOService::batch_t batch;
+				batch.push_back(LLFileIOService::Request(LLFileIOService::FILE_READ, name,
+														 &in[0], 0, 1000));
+				batch.push_back(LLFileIOService::Request(LLFileIOService::FILE_READ, name,
+														 &in[1000], 1000, 2000));
+				results = service.submitWait(std::move(batch));
+				done = true;
+			});
+		ensure("coroutine finished", wait_until([&done]() { return done; }));
+		ensure_equals("results", results.size(), size_t(2));
+		ensure_equals("first", results[0], 1000);
+		ensure_equals("second", results[1], 2000);
+		ensure("same data", in == out);
+	}
+}
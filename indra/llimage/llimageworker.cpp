@@ -53,9 +53,9 @@ size_t LLImageDecodeThread::update(F32 max_time_ms)
 		 iter != mCreationList.end(); ++iter)
 	{
 		creation_info& info = *iter;
-		ImageRequest* req = new ImageRequest(info.handle, info.image,
+		ImageRequest* req = new ImageRequest(info.handle, std::move(info.image),
 						     info.priority, info.discard, info.needs_aux,
-						     info.responder);
+						     std::move(info.responder));
 
 		bool res = addRequest(req);
 		if (!res)
@@ -92,17 +92,17 @@ LLImageDecodeThread::Responder::~Responder()
 
 //----------------------------------------------------------------------------
 
-LLImageDecodeThread::ImageRequest::ImageRequest(handle_t handle, LLImageFormatted* image, 
+LLImageDecodeThread::ImageRequest::ImageRequest(handle_t handle, LLPointer<LLImageFormatted>&& image, 
 												U32 priority, S32 discard, bool needs_aux,
-												LLImageDecodeThread::Responder* responder)
+												LLPointer<LLImageDecodeThread::Responder>&& responder)
 	: LLQueuedThread::QueuedRequest(handle, priority, FLAG_AUTO_COMPLETE),
-	  mFormattedImage(image),
+	  mFormattedImage(std::move(image)),
 	  mDiscardLevel(discard),
 	  mNeedsAux(needs_aux),
 	  mDecodedRaw(false),
 	  mDecodedAux(false),
 	  mDecodedImageRawValid(false),
-	  mResponder(responder)
+	  mResponder(std::move(responder))
 {
 }
 
@@ -49,9 +49,10 @@ public:
 		virtual ~ImageRequest(); // use deleteRequest()
 		
 	public:
-		ImageRequest(handle_t handle, LLImageFormatted* image,
+		// takes over the caller's references rather than adding more
+		ImageRequest(handle_t handle, LLPointer<LLImageFormatted>&& image,
 					 U32 priority, S32 discard, bool needs_aux,
-					 LLImageDecodeThread::Responder* responder);
+					 LLPointer<LLImageDecodeThread::Responder>&& responder);
 
 		/*virtual*/ bool processRequest();
 		/*virtual*/ void finishRequest(bool completed);
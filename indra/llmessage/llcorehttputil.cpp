@@ -552,9 +552,18 @@ LLSD HttpCoroRawHandler::handleSuccess(LLCore::HttpResponse * response, LLCore::
     // *TODO: https://jira.secondlife.com/browse/MAINT-5221
     
     LLSD::Binary data;
-    data.reserve(size);
-    bas >> std::noskipws;
-    data.assign(std::istream_iterator<U8>(bas), std::istream_iterator<U8>());
+    const U8 * contiguous(reinterpret_cast<const U8 *>(body->getContiguous(0, size)));
+    if (contiguous)
+    {
+        // Body of known length landed in one block, copy it in one go
+        data.assign(contiguous, contiguous + size);
+    }
+    else
+    {
+        data.reserve(size);
+        bas >> std::noskipws;
+        data.assign(std::istream_iterator<U8>(bas), std::istream_iterator<U8>());
+    }
 
     result[HttpCoroutineAdapter::HTTP_RESULTS_RAW] = data;
 
@@ -197,6 +197,7 @@ public:
 			LL_ERRS() << name << " has already been used as a variable name!" << LL_ENDL;
 		}
 		*varp = new LLMessageVariable(name, type, size);
+		mVarOffsets.push_back(mTotalSize);
 		if (((*varp)->getType() != MVT_VARIABLE)
 			&&(mTotalSize != -1))
 		{
@@ -228,6 +229,10 @@ public:
 
 	typedef LLIndexedVector<LLMessageVariable*, const char *, 8> message_variable_map_t;
 	message_variable_map_t 					mMemberVariables;
+	// Offset of each variable from the start of the block, -1 once a
+	// variable sized variable precedes it. When mTotalSize is not -1 every
+	// offset is known and the block can be decoded without walking it.
+	std::vector<S32>						mVarOffsets;
 	char									*mName;
 	EMsgBlockType							mType;
 	S32										mNumber;
@@ -42,6 +42,115 @@
 #include "llrand.h"
 #include "message.h"
 #include "u64.h"
+#include "llthread.h"
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////
+// LLPacketReceiveThread drains the socket into a single producer / single
+// consumer ring of fixed size slots. The thread only advances mHead and the
+// consumer only advances mTail, so no lock is needed. When the ring is full
+// the thread stops reading and leaves packets in the socket buffer.
+class LLPacketReceiveThread : public LLThread
+{
+public:
+	LLPacketReceiveThread(S32 socket);
+
+	// Oldest unconsumed packet, false if there is none. Valid until pop().
+	bool front(const char*& data, S32& size, LLHost& sender) const;
+	void pop();
+
+	bool isEmpty() const	{ return mTail.load(std::memory_order_relaxed) == mHead.load(std::memory_order_acquire); }
+
+protected:
+	void run() override;
+
+private:
+	struct Slot
+	{
+		S32		mSize;
+		LLHost	mSender;
+		char	mData[NET_BUFFER_SIZE];		/* Flawfinder: ignore */
+	};
+
+	static const U32 SLOT_COUNT = 512;		// must be a power of two
+	static const U32 SLOT_MASK = SLOT_COUNT - 1;
+	static const S32 RECEIVE_BATCH = 32;
+	static const S32 POLL_TIMEOUT_MS = 100;
+
+	S32 mSocket;
+	std::vector<Slot> mSlots;
+	std::atomic<U32> mHead;	// next slot to fill, written by the thread
+	std::atomic<U32> mTail;	// next slot to consume, written by the consumer
+};
+
+LLPacketReceiveThread::LLPacketReceiveThread(S32 socket)
+:	LLThread("Packet Receive"),
+	mSocket(socket),
+	mSlots(SLOT_COUNT),
+	mHead(0),
+	mTail(0)
+{
+}
+
+bool LLPacketReceiveThread::front(const char*& data, S32& size, LLHost& sender) const
+{
+	if (isEmpty())
+	{
+		return false;
+	}
+
+	const Slot& slot = mSlots[mTail.load(std::memory_order_relaxed) & SLOT_MASK];
+	data = slot.mData;
+	size = slot.mSize;
+	sender = slot.mSender;
+	return true;
+}
+
+void LLPacketReceiveThread::pop()
+{
+	mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void LLPacketReceiveThread::run()
+{
+	char* buffers[RECEIVE_BATCH];
+	S32 sizes[RECEIVE_BATCH];
+	LLHost senders[RECEIVE_BATCH];
+
+	while (!isQuitting())
+	{
+		U32 head = mHead.load(std::memory_order_relaxed);
+		U32 free_slots = SLOT_COUNT - (head - mTail.load(std::memory_order_acquire));
+		if (!free_slots)
+		{
+			// consumer is behind, let the socket buffer absorb the burst
+			ms_sleep(1);
+			continue;
+		}
+
+		if (!wait_for_packet(mSocket, POLL_TIMEOUT_MS))
+		{
+			continue;
+		}
+
+		S32 count = llmin((S32) free_slots, RECEIVE_BATCH);
+		for (S32 i = 0; i < count; ++i)
+		{
+			buffers[i] = mSlots[(head + i) & SLOT_MASK].mData;
+		}
+
+		S32 received = receive_packets(mSocket, buffers, sizes, senders, count);
+		for (S32 i = 0; i < received; ++i)
+		{
+			Slot& slot = mSlots[(head + i) & SLOT_MASK];
+			slot.mSize = sizes[i];
+			slot.mSender = senders[i];
+		}
+
+		mHead.store(head + received, std::memory_order_release);
+	}
+}
 
 ///////////////////////////////////////////////////////////
 LLPacketRing::LLPacketRing () :
@@ -55,7 +164,11 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mReceiveThread(NULL),
+	mBatchSends(false),
+	mSendBatchCount(0),
+	mSendCalls(0)
 {
 }
 
@@ -68,6 +181,8 @@ LLPacketRing::~LLPacketRing ()
 ///////////////////////////////////////////////////////////
 void LLPacketRing::cleanup ()
 {
+	stopReceiveThread();
+
 	LLPacketBuffer *packetp;
 
 	while (!mReceiveQueue.empty())
@@ -116,6 +231,89 @@ void LLPacketRing::setOutBandwidth(const F32 bps)
 {
 	mOutThrottle.setRate(bps);
 }
+///////////////////////////////////////////////////////////
+bool LLPacketRing::startReceiveThread(S32 socket)
+{
+	if (mReceiveThread)
+	{
+		return false;
+	}
+
+	LL_INFOS() << "Starting packet receive thread" << LL_ENDL;
+	mReceiveThread = new LLPacketReceiveThread(socket);
+	mReceiveThread->start();
+	return true;
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+	if (mReceiveThread)
+	{
+		mReceiveThread->shutdown();
+		delete mReceiveThread;
+		mReceiveThread = NULL;
+	}
+}
+
+bool LLPacketRing::hasReceivedPackets() const
+{
+	return mReceiveThread && !mReceiveThread->isEmpty();
+}
+
+LLPacketBuffer* LLPacketRing::receiveBuffer(S32 socket)
+{
+	if (!mReceiveThread)
+	{
+		return new LLPacketBuffer(socket);
+	}
+
+	const char* data = NULL;
+	S32 size = 0;
+	LLHost sender;
+	if (!mReceiveThread->front(data, size, sender))
+	{
+		return new LLPacketBuffer(sender, NULL, 0);
+	}
+
+	LLPacketBuffer* packetp = new LLPacketBuffer(sender, data, size);
+	mReceiveThread->pop();
+	return packetp;
+}
+
+S32 LLPacketRing::receiveFromThread(char *datap)
+{
+	const char* data = NULL;
+	S32 packet_size = 0;
+	if (!mReceiveThread->front(data, packet_size, mLastSender))
+	{
+		return 0;
+	}
+
+	if (LLProxy::isSOCKSProxyEnabled())
+	{
+		if (packet_size > SOCKS_HEADER_SIZE)
+		{
+			// *FIX We are assuming ATYP is 0x01 (IPv4), not 0x03 (hostname) or 0x04 (IPv6)
+			packet_size -= SOCKS_HEADER_SIZE;
+			memcpy(datap, data + SOCKS_HEADER_SIZE, packet_size);
+			const proxywrap_t * header = static_cast<const proxywrap_t*>(static_cast<const void*>(data));
+			mLastSender.setAddress(header->addr);
+			mLastSender.setPort(ntohs(header->port));
+		}
+		else
+		{
+			packet_size = 0;
+		}
+	}
+	else
+	{
+		memcpy(datap, data, packet_size);
+	}
+
+	mReceiveThread->pop();
+	return packet_size;
+}
+
 ///////////////////////////////////////////////////////////
 S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
 {
@@ -167,7 +365,7 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 		while (!done)
 		{
 			LLPacketBuffer *packetp;
-			packetp = new LLPacketBuffer(socket);
+			packetp = receiveBuffer(socket);
 
 			if (packetp->getSize())
 			{
@@ -224,7 +422,11 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	else
 	{
 		// no delay, pull straight from net
-		if (LLProxy::isSOCKSProxyEnabled())
+		if (mReceiveThread)
+		{
+			packet_size = receiveFromThread(datap);
+		}
+		else if (LLProxy::isSOCKSProxyEnabled())
 		{
 			U8 buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
 			packet_size = receive_packet(socket, static_cast<char*>(static_cast<void*>(buffer)));
@@ -250,7 +452,8 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 			mLastSender = ::get_sender();
 		}
 
-		mLastReceivingIF = ::get_receiving_interface();
+		// the receive thread doesn't track the receiving interface
+		mLastReceivingIF = mReceiveThread ? LLHost() : ::get_receiving_interface();
 
 		if (packet_size)  // did we actually get a packet?
 		{
@@ -270,12 +473,12 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	return packet_size;
 }
 
-bool LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
+bool LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host, bool append_acks)
 {
 	bool status = true;
 	if (!mUseOutThrottle)
 	{
-		return sendPacketImpl(h_socket, send_buffer, buf_size, host );
+		return sendPacketImpl(h_socket, send_buffer, buf_size, host, append_acks);
 	}
 	else
 	{
@@ -305,7 +508,7 @@ bool LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LL
 			else
 			{
 				// If the queue's empty, we can just send this packet right away.
-				status =  sendPacketImpl(h_socket, send_buffer, buf_size, host );
+				status =  sendPacketImpl(h_socket, send_buffer, buf_size, host, append_acks);
 				packet_size = buf_size;
 
 				// Update the throttle
@@ -344,9 +547,24 @@ bool LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LL
 	return status;
 }
 
-bool LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host)
+bool LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host, bool append_acks)
 {
-	
+	if (mBatchSends && buf_size <= NET_BUFFER_SIZE)
+	{
+		QueuedSend& queued = mSendBatch[mSendBatchCount++];
+		queued.mHost = host;
+		queued.mSize = buf_size;
+		queued.mAppendAcks = append_acks;
+		memcpy(queued.mData + SOCKS_HEADER_SIZE, send_buffer, buf_size);
+
+		if (mSendBatchCount == (S32)mSendBatch.size())
+		{
+			return flushSends(h_socket) == 0;
+		}
+		return true;
+	}
+
+	++mSendCalls;
 	if (!LLProxy::isSOCKSProxyEnabled())
 	{
 		return send_packet(h_socket, send_buffer, buf_size, host.getAddress(), host.getPort());
@@ -369,3 +587,112 @@ bool LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 bu
 						LLProxy::getInstance()->getUDPProxy().getAddress(),
 						LLProxy::getInstance()->getUDPProxy().getPort());
 }
+
+void LLPacketRing::setBatchSends(bool batch)
+{
+	// packets still queued when batching is turned off go out with the
+	// next flushSends()
+	mBatchSends = batch;
+	if (batch && mSendBatch.empty())
+	{
+		mSendBatch.resize(SEND_BATCH_SIZE);
+	}
+}
+
+S32 LLPacketRing::appendAcks(const LLHost& host, const TPACKETID* acks, S32 count)
+{
+	const S32 MAX_ACKS = 250;
+
+	S32 appended = 0;
+	for (S32 i = 0; i < mSendBatchCount && appended < count; ++i)
+	{
+		QueuedSend& queued = mSendBatch[i];
+		if (!queued.mAppendAcks || queued.mHost != host)
+		{
+			continue;
+		}
+
+		// acks go after the message, followed by a one byte count
+		char* packet = queued.mData + SOCKS_HEADER_SIZE;
+		S32 existing = 0;
+		S32 message_size = queued.mSize;
+		if (packet[0] & LL_ACK_FLAG)
+		{
+			existing = (U8)packet[queued.mSize - 1];
+			message_size -= existing * sizeof(TPACKETID) + 1;
+		}
+
+		S32 space = (MTUBYTES - message_size) / (S32)sizeof(TPACKETID) - existing;
+		S32 to_append = llmin(llmin(space, count - appended), MAX_ACKS - existing);
+		if (to_append <= 0)
+		{
+			continue;
+		}
+
+		S32 offset = message_size + existing * sizeof(TPACKETID);
+		for (S32 j = 0; j < to_append; ++j)
+		{
+			TPACKETID packet_id = htonl(acks[appended + j]);
+			memcpy(packet + offset, &packet_id, sizeof(TPACKETID));	/* Flawfinder: ignore */
+			offset += sizeof(TPACKETID);
+		}
+		packet[offset++] = (U8)(existing + to_append);
+		packet[0] |= LL_ACK_FLAG;
+
+		S32 added_bytes = offset - queued.mSize;
+		queued.mSize = offset;
+		appended += to_append;
+
+		if (mUseOutThrottle)
+		{
+			mActualBitsOut += added_bytes * 8;
+			mOutThrottle.throttleOverflow(added_bytes * 8.f);
+		}
+	}
+	return appended;
+}
+
+S32 LLPacketRing::flushSends(int h_socket)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+
+	if (!mSendBatchCount)
+	{
+		return 0;
+	}
+
+	const char* buffers[SEND_BATCH_SIZE];
+	S32 sizes[SEND_BATCH_SIZE];
+	LLHost recipients[SEND_BATCH_SIZE];
+
+	bool socks = LLProxy::isSOCKSProxyEnabled();
+	LLHost proxy = socks ? LLProxy::getInstance()->getUDPProxy() : LLHost();
+	for (S32 i = 0; i < mSendBatchCount; ++i)
+	{
+		QueuedSend& queued = mSendBatch[i];
+		if (socks)
+		{
+			proxywrap_t *socks_header = static_cast<proxywrap_t*>(static_cast<void*>(queued.mData));
+			socks_header->rsv   = 0;
+			socks_header->addr  = queued.mHost.getAddress();
+			socks_header->port  = htons(queued.mHost.getPort());
+			socks_header->atype = ADDRESS_IPV4;
+			socks_header->frag  = 0;
+
+			buffers[i] = queued.mData;
+			sizes[i] = queued.mSize + SOCKS_HEADER_SIZE;
+			recipients[i] = proxy;
+		}
+		else
+		{
+			buffers[i] = queued.mData + SOCKS_HEADER_SIZE;
+			sizes[i] = queued.mSize;
+			recipients[i] = queued.mHost;
+		}
+	}
+
+	S32 sent = send_packets(h_socket, buffers, sizes, recipients, mSendBatchCount, mSendCalls);
+	S32 failed = mSendBatchCount - sent;
+	mSendBatchCount = 0;
+	return failed;
+}
@@ -29,6 +29,7 @@
 #define LL_LLPACKETRING_H
 
 #include <queue>
+#include <vector>
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
@@ -36,6 +37,8 @@
 #include "llthrottle.h"
 #include "net.h"
 
+class LLPacketReceiveThread;
+
 class LLPacketRing
 {
 public:
@@ -53,7 +56,29 @@ public:
 	S32  receivePacket (S32 socket, char *datap);
 	S32  receiveFromRing (S32 socket, char *datap);
 
-	bool sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
+	// Starts a thread that drains socket into a ring of preallocated packet
+	// slots, receivePacket() then only consumes packets already received.
+	// Returns false if the thread is already running.
+	bool startReceiveThread(S32 socket);
+	void stopReceiveThread();
+	bool hasReceiveThread() const				{ return mReceiveThread != NULL; }
+	// True if the receive thread holds packets not consumed yet
+	bool hasReceivedPackets() const;
+
+	// append_acks marks packets that may carry acks added by appendAcks()
+	bool sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host, bool append_acks = false);
+
+	// While batching, packets passed to sendPacket() are queued and sent
+	// together by flushSends(), or as soon as the batch is full
+	void setBatchSends(bool batch);
+	bool isBatchingSends() const				{ return mBatchSends; }
+	// Appends up to count of acks to the queued packets for host that have
+	// room for them and returns how many were appended
+	S32  appendAcks(const LLHost& host, const TPACKETID* acks, S32 count);
+	// Sends the queued packets, returns the number that failed
+	S32  flushSends(int h_socket);
+	// Number of system calls made to send packets
+	U32  getSendCalls() const					{ return mSendCalls; }
 
 	inline LLHost getLastSender();
 	inline LLHost getLastReceivingInterface();
@@ -83,8 +108,30 @@ protected:
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
+	LLPacketReceiveThread* mReceiveThread;
+
+	// 64 matches the number of datagrams send_packets() hands to a single
+	// sendmmsg() call
+	static const S32 SEND_BATCH_SIZE = 64;
+	struct QueuedSend
+	{
+		LLHost	mHost;
+		S32		mSize;
+		bool	mAppendAcks;
+		// room in front of the packet for a SOCKS header
+		char	mData[SOCKS_HEADER_SIZE + NET_BUFFER_SIZE];
+	};
+	bool mBatchSends;
+	std::vector<QueuedSend> mSendBatch;
+	S32 mSendBatchCount;
+	U32 mSendCalls;
+
 private:
-	bool sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
+	bool sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host, bool append_acks = false);
+
+	// Next packet from the socket or from the receive thread
+	LLPacketBuffer* receiveBuffer(S32 socket);
+	S32 receiveFromThread(char *datap);
 };
 
 
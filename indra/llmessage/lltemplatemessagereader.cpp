@@ -43,7 +43,9 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 	mReceiveSize(0),
 	mCurrentRMessageTemplate(NULL),
 	mCurrentRMessageData(NULL),
-	mMessageNumbers(number_template_map)
+	mMessageNumbers(number_template_map),
+	mDecodeInPlace(false),
+	mDecodedInPlace(false)
 {
 }
 
@@ -61,6 +63,9 @@ void LLTemplateMessageReader::clearMessage()
 	mCurrentRMessageTemplate = NULL;
 	delete mCurrentRMessageData;
 	mCurrentRMessageData = NULL;
+	mDecodedInPlace = false;
+	mBlockRefs.clear();
+	mVarRefs.clear();
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -72,6 +77,12 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 		return;
 	}
 
+	if (mDecodedInPlace)
+	{
+		getDataInPlace(blockname, varname, datap, size, blocknum, max_size);
+		return;
+	}
+
 	if (!mCurrentRMessageData)
 	{
 		LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
@@ -148,6 +159,134 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 	}
 }
 
+S32 LLTemplateMessageReader::findBlock(const char* blockname) const
+{
+	const LLMessageTemplate::message_block_map_t& blocks = mCurrentRMessageTemplate->mMemberBlocks;
+	for (S32 i = 0, count = (S32)blocks.size(); i < count; ++i)
+	{
+		if (blocks.begin()[i]->mName == blockname)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+S32 LLTemplateMessageReader::findVariable(S32 block, const char* varname)
+{
+	const LLMessageBlock::message_variable_map_t& vars = mCurrentRMessageTemplate->mMemberBlocks.begin()[block]->mMemberVariables;
+	LLMsgBlkRef& block_ref = mBlockRefs[block];
+	const S32 count = (S32)vars.size();
+	for (S32 n = 1; n <= count; ++n)
+	{
+		S32 i = (block_ref.mLastFound + n) % count;
+		if (vars.begin()[i]->getName() == varname)
+		{
+			block_ref.mLastFound = i;
+			return i;
+		}
+	}
+	return -1;
+}
+
+void LLTemplateMessageReader::getDataInPlace(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
+{
+	S32 block = findBlock(blockname);
+	if (block < 0 || blocknum >= mBlockRefs[block].mCount)
+	{
+		LL_ERRS() << "Block " << blockname << " #" << blocknum
+			<< " not in message " << mCurrentRMessageTemplate->mName << LL_ENDL;
+		return;
+	}
+
+	S32 var = findVariable(block, varname);
+	if (var < 0)
+	{
+		LL_ERRS() << "Variable "<< varname << " not in message "
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
+		return;
+	}
+
+	const LLMessageBlock* mbci = mCurrentRMessageTemplate->mMemberBlocks.begin()[block];
+	const S32 num_vars = (S32)mbci->mMemberVariables.size();
+	const LLMsgVarRef& var_ref = mVarRefs[mBlockRefs[block].mFirstVar + blocknum * num_vars + var];
+
+	if (size && size != var_ref.mSize)
+	{
+		LL_ERRS() << "Msg " << mCurrentRMessageTemplate->mName
+			<< " variable " << varname
+			<< " is size " << var_ref.mSize
+			<< " but copying into buffer of size " << size
+			<< LL_ENDL;
+		return;
+	}
+
+	if (max_size >= var_ref.mSize)
+	{
+#ifdef LL_BIG_ENDIAN
+		htolememcpy(datap, var_ref.mData, mbci->mMemberVariables.begin()[var]->getType(), var_ref.mSize);
+#else
+		// packet data is little endian and not aligned
+		switch (var_ref.mSize)
+		{
+		case 1:
+			*((U8*)datap) = *var_ref.mData;
+			break;
+		case 2:
+			memcpy(datap, var_ref.mData, 2);
+			break;
+		case 4:
+			memcpy(datap, var_ref.mData, 4);
+			break;
+		case 8:
+			memcpy(datap, var_ref.mData, 8);
+			break;
+		case 12:
+			memcpy(datap, var_ref.mData, 12);
+			break;
+		case 16:
+			memcpy(datap, var_ref.mData, 16);
+			break;
+		default:
+			memcpy(datap, var_ref.mData, var_ref.mSize);
+			break;
+		}
+#endif
+	}
+	else
+	{
+		LL_WARNS() << "Msg " << mCurrentRMessageTemplate->mName
+			<< " variable " << varname
+			<< " is size " << var_ref.mSize
+			<< " but truncated to max size of " << max_size
+			<< LL_ENDL;
+
+		memcpy(datap, var_ref.mData, max_size);
+	}
+}
+
+S32 LLTemplateMessageReader::getSizeInPlace(const char *blockname, S32 blocknum, const char *varname)
+{
+	S32 block = findBlock(blockname);
+	if (block < 0 || blocknum >= mBlockRefs[block].mCount)
+	{	// don't crash
+		LL_INFOS() << "Block " << blockname << " not in message "
+			<< mCurrentRMessageTemplate->mName << LL_ENDL;
+		return LL_BLOCK_NOT_IN_MESSAGE;
+	}
+
+	S32 var = findVariable(block, varname);
+	if (var < 0)
+	{	// don't crash
+		LL_INFOS() << "Variable " << varname << " not in message "
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
+		return LL_VARIABLE_NOT_IN_BLOCK;
+	}
+
+	const S32 num_vars = (S32)mCurrentRMessageTemplate->mMemberBlocks.begin()[block]->mMemberVariables.size();
+	return mVarRefs[mBlockRefs[block].mFirstVar + blocknum * num_vars + var].mSize;
+}
+
 S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 {
 	// is there a message ready to go?
@@ -157,6 +296,12 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 		return -1;
 	}
 
+	if (mDecodedInPlace)
+	{
+		S32 block = findBlock(blockname);
+		return block < 0 ? 0 : mBlockRefs[block].mCount;
+	}
+
 	if (!mCurrentRMessageData)
 	{
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -184,6 +329,18 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
 		return LL_MESSAGE_ERROR;
 	}
 
+	if (mDecodedInPlace)
+	{
+		S32 size = getSizeInPlace(blockname, 0, varname);
+		if (size >= 0 && mCurrentRMessageTemplate->mMemberBlocks[(char *)blockname]->mType != MBT_SINGLE)
+		{	// This is a serious error - crash
+			LL_ERRS() << "Block " << blockname << " isn't type MBT_SINGLE,"
+				" use getSize with blocknum argument!" << LL_ENDL;
+			return LL_MESSAGE_ERROR;
+		}
+		return size;
+	}
+
 	if (!mCurrentRMessageData)
 	{	// This is a serious error - crash
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -232,6 +389,11 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
 		return LL_MESSAGE_ERROR;
 	}
 
+	if (mDecodedInPlace)
+	{
+		return getSizeInPlace(blockname, blocknum, varname);
+	}
+
 	if (!mCurrentRMessageData)
 	{	// This is a serious error - crash
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -548,6 +710,7 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 	llassert( mCurrentRMessageTemplate);
 	llassert( !mCurrentRMessageData );
 	delete mCurrentRMessageData; // just to make sure
+	mDecodedInPlace = false;
 
 	// The offset tells us how may bytes to skip after the end of the
 	// message name.
@@ -710,49 +873,201 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 		return false;
 	}
 
-	{
-		static LLTimer decode_timer;
+	return dispatchMessage(sender);
+}
 
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+// decode a given message without copying its variables, see setDecodeInPlace()
+bool LLTemplateMessageReader::decodeInPlace(const U8* buffer, const LLHost& sender)
+{
+	LL_RECORD_BLOCK_TIME(FTM_PROCESS_MESSAGES);
+
+	llassert( mReceiveSize >= 0 );
+	llassert( mCurrentRMessageTemplate);
+
+	// stands in for fixed size variables that run off the end of the packet
+	static const U8 zeroes[MAX_BUFFER_SIZE] = { 0 };
+
+	U8 offset = buffer[PHL_OFFSET];
+	S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
+
+	mBlockRefs.resize(mCurrentRMessageTemplate->mMemberBlocks.size());
+	mVarRefs.clear();
+	S32 total_blocks = 0;
+
+	S32 block_index = 0;
+	for (LLMessageTemplate::message_block_map_t::const_iterator iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
+		 iter != mCurrentRMessageTemplate->mMemberBlocks.end();
+		 ++iter, ++block_index)
+	{
+		const LLMessageBlock* mbci = *iter;
+		S32 repeat_number = 0;
+		if (mbci->mType == MBT_SINGLE)
 		{
-			decode_timer.reset();
+			repeat_number = 1;
 		}
-
-		if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
+		else if (mbci->mType == MBT_MULTIPLE)
 		{
-			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
+			repeat_number = mbci->mNumber;
 		}
-
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		else if (mbci->mType == MBT_VARIABLE)
 		{
-			F32 decode_time = decode_timer.getElapsedTimeF32();
-
-			if (gMessageSystem->getTimingCallback())
+			// missing variable blocks at the end of a message are legal
+			if (decode_pos < mReceiveSize)
 			{
-				(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
-								decode_time,
-								gMessageSystem->getTimingCallbackData());
+				repeat_number = buffer[decode_pos];
+				decode_pos++;
 			}
+		}
+		else
+		{
+			LL_ERRS() << "Unknown block type" << LL_ENDL;
+			return false;
+		}
 
-			if (LLMessageReader::getTimeDecodes())
-			{
-				mCurrentRMessageTemplate->mDecodeTimeThisFrame += decode_time;
+		const S32 num_vars = (S32)mbci->mMemberVariables.size();
+		LLMsgBlkRef& block_ref = mBlockRefs[block_index];
+		block_ref.mCount = repeat_number;
+		block_ref.mFirstVar = (S32)mVarRefs.size();
+		block_ref.mLastFound = -1;
+		total_blocks += repeat_number;
 
-				mCurrentRMessageTemplate->mTotalDecoded++;
-				mCurrentRMessageTemplate->mTotalDecodeTime += decode_time;
+		mVarRefs.resize(mVarRefs.size() + repeat_number * num_vars);
+		LLMsgVarRef* var_ref = mVarRefs.data() + block_ref.mFirstVar;
 
-				if( mCurrentRMessageTemplate->mMaxDecodeTimePerMsg < decode_time )
+		for (S32 i = 0; i < repeat_number; i++)
+		{
+			if (mbci->mTotalSize != -1 && decode_pos + mbci->mTotalSize <= mReceiveSize)
+			{
+				// all variables are fixed size, use the offsets computed
+				// when the template was built
+				for (S32 v = 0; v < num_vars; ++v, ++var_ref)
 				{
-					mCurrentRMessageTemplate->mMaxDecodeTimePerMsg = decode_time;
+					var_ref->mData = buffer + decode_pos + mbci->mVarOffsets[v];
+					var_ref->mSize = mbci->mMemberVariables.begin()[v]->getSize();
 				}
+				decode_pos += mbci->mTotalSize;
+				continue;
+			}
 
+			for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = mbci->mMemberVariables.begin();
+				 var_iter != mbci->mMemberVariables.end(); ++var_iter, ++var_ref)
+			{
+				const LLMessageVariable& mvci = **var_iter;
+				S32 data_size = mvci.getSize();
 
-				if(decode_time > LLMessageReader::getTimeDecodesSpamThreshold())
+				if (mvci.getType() == MVT_VARIABLE)
 				{
-					LL_DEBUGS() << "--------- Message " << mCurrentRMessageTemplate->mName << " decode took " << decode_time << " seconds. (" <<
-						mCurrentRMessageTemplate->mMaxDecodeTimePerMsg << " max, " <<
-						(mCurrentRMessageTemplate->mTotalDecodeTime / mCurrentRMessageTemplate->mTotalDecoded) << " avg)" << LL_ENDL;
+					// the template gives the size of the length field
+					U32 tsize = 0;
+					if ((decode_pos + data_size) > mReceiveSize)
+					{
+						logRanOffEndOfPacket(sender, decode_pos, data_size);
+					}
+					else
+					{
+						switch(data_size)
+						{
+						case 1:
+							tsize = buffer[decode_pos];
+							break;
+						case 2:
+							{
+								U16 tsizeh = 0;
+								htolememcpy(&tsizeh, &buffer[decode_pos], MVT_U16, 2);
+								tsize = tsizeh;
+							}
+							break;
+						case 4:
+							htolememcpy(&tsize, &buffer[decode_pos], MVT_U32, 4);
+							break;
+						default:
+							LL_ERRS() << "Attempting to read variable field with unknown size of " << data_size << LL_ENDL;
+							break;
+						}
+					}
+					decode_pos += data_size;
+
+					if (decode_pos + (S32)tsize > mReceiveSize)
+					{
+						logRanOffEndOfPacket(sender, decode_pos, tsize);
+						tsize = 0;
+					}
+					var_ref->mData = buffer + decode_pos;
+					var_ref->mSize = tsize;
+					decode_pos += tsize;
 				}
+				else
+				{
+					if ((decode_pos + data_size) > mReceiveSize)
+					{
+						logRanOffEndOfPacket(sender, decode_pos, data_size);
+						var_ref->mData = zeroes;
+					}
+					else
+					{
+						var_ref->mData = buffer + decode_pos;
+					}
+					var_ref->mSize = data_size;
+					decode_pos += data_size;
+				}
+			}
+		}
+	}
+
+	mDecodedInPlace = true;
+
+	if (!total_blocks && !mCurrentRMessageTemplate->mMemberBlocks.empty())
+	{
+		LL_DEBUGS() << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << LL_ENDL;
+		return false;
+	}
+
+	return dispatchMessage(sender);
+}
+
+bool LLTemplateMessageReader::dispatchMessage(const LLHost& sender)
+{
+	static LLTimer decode_timer;
+
+	if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+	{
+		decode_timer.reset();
+	}
+
+	if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
+	{
+		LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
+	}
+
+	if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+	{
+		F32 decode_time = decode_timer.getElapsedTimeF32();
+
+		if (gMessageSystem->getTimingCallback())
+		{
+			(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
+							decode_time,
+							gMessageSystem->getTimingCallbackData());
+		}
+
+		if (LLMessageReader::getTimeDecodes())
+		{
+			mCurrentRMessageTemplate->mDecodeTimeThisFrame += decode_time;
+
+			mCurrentRMessageTemplate->mTotalDecoded++;
+			mCurrentRMessageTemplate->mTotalDecodeTime += decode_time;
+
+			if( mCurrentRMessageTemplate->mMaxDecodeTimePerMsg < decode_time )
+			{
+				mCurrentRMessageTemplate->mMaxDecodeTimePerMsg = decode_time;
+			}
+
+
+			if(decode_time > LLMessageReader::getTimeDecodesSpamThreshold())
+			{
+				LL_DEBUGS() << "--------- Message " << mCurrentRMessageTemplate->mName << " decode took " << decode_time << " seconds. (" <<
+					mCurrentRMessageTemplate->mMaxDecodeTimePerMsg << " max, " <<
+					(mCurrentRMessageTemplate->mTotalDecodeTime / mCurrentRMessageTemplate->mTotalDecoded) << " avg)" << LL_ENDL;
 			}
 		}
 	}
@@ -798,6 +1113,10 @@ bool LLTemplateMessageReader::validateMessage(const U8* buffer,
 bool LLTemplateMessageReader::readMessage(const U8* buffer,
 										  const LLHost& sender)
 {
+	if (mDecodeInPlace)
+	{
+		return decodeInPlace(buffer, sender);
+	}
 	return decodeData(buffer, sender);
 }
 
@@ -835,5 +1154,42 @@ void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
     {
         return;
     }
+	if (mDecodedInPlace)
+	{
+		LLMsgData* message_data = buildMessageData();
+		builder.copyFromMessageData(*message_data);
+		delete message_data;
+		return;
+	}
 	builder.copyFromMessageData(*mCurrentRMessageData);
 }
+
+LLMsgData* LLTemplateMessageReader::buildMessageData() const
+{
+	LLMsgData* message_data = new LLMsgData(mCurrentRMessageTemplate->mName);
+
+	S32 block_index = 0;
+	for (LLMessageTemplate::message_block_map_t::const_iterator iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
+		 iter != mCurrentRMessageTemplate->mMemberBlocks.end();
+		 ++iter, ++block_index)
+	{
+		const LLMessageBlock* mbci = *iter;
+		const LLMsgBlkRef& block_ref = mBlockRefs[block_index];
+		const LLMsgVarRef* var_ref = mVarRefs.data() + block_ref.mFirstVar;
+		for (S32 i = 0; i < block_ref.mCount; ++i)
+		{
+			LLMsgBlkData* block_data = new LLMsgBlkData(mbci->mName, block_ref.mCount);
+			block_data->mName = mbci->mName + i;
+			message_data->addBlock(block_data);
+
+			for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = mbci->mMemberVariables.begin();
+				 var_iter != mbci->mMemberVariables.end(); ++var_iter, ++var_ref)
+			{
+				const LLMessageVariable& mvci = **var_iter;
+				block_data->addVariable(mvci.getName(), mvci.getType());
+				block_data->addData(mvci.getName(), var_ref->mData, var_ref->mSize, mvci.getType());
+			}
+		}
+	}
+	return message_data;
+}
@@ -30,6 +30,7 @@
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
 class LLMessageTemplate;
 class LLMsgData;
@@ -107,8 +108,31 @@ public:
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
+
+	// In place decoding records where each variable lies in the packet
+	// instead of copying every variable into an LLMsgData, and the get*
+	// methods read straight from the packet. The buffer passed to
+	// readMessage() must then stay valid until clearMessage().
+	void setDecodeInPlace(bool in_place)	{ mDecodeInPlace = in_place; }
+	bool getDecodeInPlace() const			{ return mDecodeInPlace; }
 	
 private:
+	// Location of one decoded variable in the packet
+	struct LLMsgVarRef
+	{
+		const U8*	mData;
+		S32			mSize;
+	};
+
+	// Decoded instances of one template block. Variable v of instance i
+	// is mVarRefs[mFirstVar + i * block variable count + v].
+	struct LLMsgBlkRef
+	{
+		S32	mCount;
+		S32	mFirstVar;
+		S32	mLastFound;	// index of the variable found last, getters
+						// usually ask for variables in template order
+	};
 
 	void getData(const char *blockname, const char *varname, void *datap, 
 				 S32 size = 0, S32 blocknum = 0, S32 max_size = S32_MAX);
@@ -119,11 +143,28 @@ private:
 	void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
 	bool decodeData(const U8* buffer, const LLHost& sender );
+	bool decodeInPlace(const U8* buffer, const LLHost& sender);
+	bool dispatchMessage(const LLHost& sender);
+
+	// Index of blockname in the current template, -1 if there is none
+	S32 findBlock(const char* blockname) const;
+	// Index of varname in the template block, -1 if there is none
+	S32 findVariable(S32 block, const char* varname);
+	void getDataInPlace(const char *blockname, const char *varname, void *datap,
+						S32 size, S32 blocknum, S32 max_size);
+	S32 getSizeInPlace(const char *blockname, S32 blocknum, const char *varname);
+	// Rebuilds the LLMsgData of an in place decoded message
+	LLMsgData* buildMessageData() const;
 
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
 	LLMsgData* mCurrentRMessageData;
 	message_template_number_map_t& mMessageNumbers;
+
+	bool mDecodeInPlace;
+	bool mDecodedInPlace;
+	std::vector<LLMsgBlkRef> mBlockRefs;	// one per template block
+	std::vector<LLMsgVarRef> mVarRefs;
 };
 
 #endif // LL_LLTEMPLATEMESSAGEREADER_H
@@ -0,0 +1,171 @@
+/**
+ * @file llzerocode.cpp
+ * @brief Zero run length coding of message bodies.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llzerocode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LL_ZEROCODE_SSE2 1
+#include <immintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+#else
+#define LL_ZEROCODE_SSE2 0
+#endif
+
+namespace
+{
+#if LL_ZEROCODE_SSE2
+	inline S32 lowest_set_bit(U32 mask)
+	{
+#if LL_WINDOWS
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (S32) index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+#endif
+
+	// Returns the offset of the first byte of data whose zero-ness matches
+	// zero, or size if there is none. With SSE2 compares 16 bytes at a
+	// time, so literal spans and runs are skipped without a branch per
+	// byte. Elsewhere (e.g. arm64) it's a byte at a time.
+	inline S32 find_run_end(const U8* data, S32 size, bool zero)
+	{
+		S32 i = 0;
+#if LL_ZEROCODE_SSE2
+		const __m128i zeroes = _mm_setzero_si128();
+		// bits set in the compare mask are zero bytes; flip them when
+		// looking for the end of a zero run
+		const U32 flip = zero ? 0xffff : 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			U32 mask = ((U32) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zeroes))) ^ flip;
+			if (mask)
+			{
+				return i + lowest_set_bit(mask);
+			}
+		}
+#endif
+		for (; i < size; ++i)
+		{
+			if ((data[i] == 0) != zero)
+			{
+				break;
+			}
+		}
+		return i;
+	}
+}
+
+S32 ll_nonzero_run(const U8* data, S32 size)
+{
+	return find_run_end(data, size, false);
+}
+
+S32 ll_zero_run(const U8* data, S32 size)
+{
+	return find_run_end(data, size, true);
+}
+
+S32 ll_zero_code(const U8* in, S32 size, U8* out)
+{
+	const U8* end = in + size;
+	U8* outptr = out;
+	while (in < end)
+	{
+		S32 literal = ll_nonzero_run(in, (S32)(end - in));
+		memcpy(outptr, in, literal);
+		outptr += literal;
+		in += literal;
+		if (in == end)
+		{
+			break;
+		}
+
+		S32 zeroes = ll_zero_run(in, (S32)(end - in));
+		in += zeroes;
+		for (; zeroes >= 255; zeroes -= 255)
+		{
+			*outptr++ = 0;
+			*outptr++ = 255;
+		}
+		if (zeroes)
+		{
+			*outptr++ = 0;
+			*outptr++ = (U8) zeroes;
+		}
+	}
+	return (S32)(outptr - out);
+}
+
+S32 ll_zero_code_expand(const U8* in, S32 size, U8* out, S32 capacity)
+{
+	const U8* end = in + size;
+	U8* outptr = out;
+	U8* out_end = out + capacity;
+	while (in < end)
+	{
+		S32 literal = ll_nonzero_run(in, (S32)(end - in));
+		if (literal)
+		{
+			if (out_end - outptr < literal)
+			{
+				return -1;
+			}
+			memcpy(outptr, in, literal);
+			outptr += literal;
+			in += literal;
+			continue;
+		}
+
+		// a zero starts a run, each following zero adds 256 and the
+		// first nonzero byte after it is the remaining count
+		++in;
+		S32 zeroes = 1;
+		for (; in < end && !*in; ++in)
+		{
+			zeroes += 256;
+		}
+		if (in < end)
+		{
+			zeroes += *in++ - 1;
+		}
+
+		if (out_end - outptr < zeroes)
+		{
+			return -1;
+		}
+		memset(outptr, 0, zeroes);
+		outptr += zeroes;
+	}
+	return (S32)(outptr - out);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file llzerocode.h
+ * @brief Zero run length coding of message bodies.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLZEROCODE_H
+#define LL_LLZEROCODE_H
+
+// Sequential zero bytes are encoded as 0 [U8 count], with 0 0 ... [count]
+// representing wrap (each extra 0 adds 256 zeroes). These work on the
+// message body only; callers copy the packet header themselves.
+
+// Returns the number of nonzero bytes at the start of data
+S32 ll_nonzero_run(const U8* data, S32 size);
+
+// Returns the number of zero bytes at the start of data
+S32 ll_zero_run(const U8* data, S32 size);
+
+// Encodes size bytes of in into out, which must have room for 2 * size
+// bytes. Returns the encoded size.
+S32 ll_zero_code(const U8* in, S32 size, U8* out);
+
+// Expands size bytes of zero coded in into out, which holds capacity bytes.
+// Returns the expanded size, or -1 if it would not fit.
+S32 ll_zero_code_expand(const U8* in, S32 size, U8* out, S32 capacity);
+
+#endif // LL_LLZEROCODE_H
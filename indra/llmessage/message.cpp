@@ -78,6 +78,7 @@
 #include "lltransfertargetvfile.h"
 #include "llcorehttputil.h"
 #include "llpounceable.h"
+#include "llzerocode.h"
 
 // Constants
 //const char* MESSAGE_LOG_FILENAME = "message.log";
@@ -230,6 +231,8 @@ LLMessageSystem::LLMessageSystem(const std::string& filename, U32 port,
 	mMessageBuilder = NULL;
 
 	mTemplateMessageReader = new LLTemplateMessageReader(mMessageNumbers);
+	// mTrueReceiveBuffer and mEncodedRecvBuffer outlive each message
+	mTemplateMessageReader->setDecodeInPlace(true);
 	mLLSDMessageReader = new LLSDMessageReader();
 
 	// initialize various bits of net info
@@ -322,8 +325,13 @@ LLMessageSystem::~LLMessageSystem()
 	for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
 	mMessageNumbers.clear();
 	
+	// the receive thread must not outlive the socket
+	mPacketRing.stopReceiveThread();
+
 	if (!mbError)
 	{
+		// e.g. a logout request sent after the last processAcks()
+		flushSends();
 		end_net(mSocket);
 	}
 	mSocket = 0;
@@ -361,6 +369,21 @@ void LLMessageSystem::clearReceiveState()
 
 bool LLMessageSystem::poll(F32 seconds)
 {
+	if (mPacketRing.hasReceiveThread())
+	{
+		// the receive thread drains the socket, look at what it queued
+		LLTimer timer;
+		while (!mPacketRing.hasReceivedPackets())
+		{
+			if (timer.getElapsedTimeF32() >= seconds)
+			{
+				return false;
+			}
+			ms_sleep(1);
+		}
+		return true;
+	}
+
 	S32 num_socks;
 	apr_status_t status;
 	status = apr_poll(&(mPollInfop->mPollFD), 1, &num_socks,(U64)(seconds*1000000.f));
@@ -773,6 +796,10 @@ void LLMessageSystem::processAcks(LockMessageChecker&, F32 collect_time)
 		//resend any necessary packets
 		mCircuitInfo.resendUnackedPackets(mUnackedListDepth, mUnackedListSize);
 
+		// piggyback waiting acks on this frame's packets before sending the
+		// leftovers in PacketAck messages
+		appendQueuedAcks();
+
 		//cycle through ack list for each host we need to send acks to
 		mCircuitInfo.sendAcks(collect_time);
 
@@ -816,6 +843,47 @@ void LLMessageSystem::processAcks(LockMessageChecker&, F32 collect_time)
 		mResendDumpTime = mt_sec;
 		mCircuitInfo.dumpResends();
 	}
+
+	// everything sent this frame goes out together
+	flushSends();
+}
+
+void LLMessageSystem::appendQueuedAcks()
+{
+	if (!mPacketRing.isBatchingSends())
+	{
+		return;
+	}
+
+	for (LLCircuit::circuit_data_map::iterator it = mCircuitInfo.mSendAckMap.begin();
+		 it != mCircuitInfo.mSendAckMap.end(); ++it)
+	{
+		LLCircuitData* cdp = it->second;
+		if (cdp->mAcks.empty())
+		{
+			continue;
+		}
+
+		S32 appended = mPacketRing.appendAcks(cdp->mHost, &cdp->mAcks[0], (S32)cdp->mAcks.size());
+		if (appended > 0)
+		{
+			cdp->mAcks.erase(cdp->mAcks.begin(), cdp->mAcks.begin() + appended);
+			if (cdp->mAcks.empty())
+			{
+				// sendAcks() drops the circuit from the ack map
+				cdp->mAckCreationTime = 0.f;
+			}
+
+			S32 bytes = appended * sizeof(TPACKETID);
+			cdp->addBytesOut((S32Bytes)bytes);
+			mTotalBytesOut += bytes;
+		}
+	}
+}
+
+void LLMessageSystem::flushSends()
+{
+	mSendPacketFailureCount += mPacketRing.flushSends(mSocket);
 }
 
 void LLMessageSystem::copyMessageReceivedToSend()
@@ -1270,7 +1338,8 @@ S32 LLMessageSystem::sendMessage(const LLHost &host)
 	}
 
 	bool success;
-	success = mPacketRing.sendPacket(mSocket, (char *)buf_ptr, buffer_length, host);
+	success = mPacketRing.sendPacket(mSocket, (char *)buf_ptr, buffer_length, host,
+									 mMessageBuilder->getMessageName() != _PREHASH_PacketAck);
 
 	if (!success)
 	{
@@ -2367,7 +2436,6 @@ void process_deny_trusted_circuit(LLMessageSystem *msg, void **)
 
 void dump_prehash_files()
 {
-	U32 i;
 	std::string filename("../../indra/llmessage/message_prehash.h");
 	LLFILE* fp = LLFile::fopen(filename, "w");	/* Flawfinder: ignore */
 	if (fp)
@@ -2389,11 +2457,11 @@ void dump_prehash_files()
 			" */\n",
 			gMessageSystem->mMessageFileVersionNumber);
 		fprintf(fp, "\n\nextern F32 const gPrehashVersionNumber;\n\n");
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
+		for (const LLInternedString& name : LLMessageStringTable::getInstance()->mNames)
 		{
-			if (!LLMessageStringTable::getInstance()->mEmpty[i] && LLMessageStringTable::getInstance()->mString[i][0] != '.')
+			if (name.c_str()[0] != '.')
 			{
-				fprintf(fp, "extern char const* const _PREHASH_%s;\n", LLMessageStringTable::getInstance()->mString[i]);
+				fprintf(fp, "extern char const* const _PREHASH_%s;\n", name.c_str());
 			}
 		}
 		fprintf(fp, "\n\n#endif\n");
@@ -2419,11 +2487,11 @@ void dump_prehash_files()
 		fprintf(fp, "#include \"linden_common.h\"\n");
 		fprintf(fp, "#include \"message.h\"\n\n");
 		fprintf(fp, "\n\nF32 const gPrehashVersionNumber = %.3ff;\n\n", gMessageSystem->mMessageFileVersionNumber);
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
+		for (const LLInternedString& name : LLMessageStringTable::getInstance()->mNames)
 		{
-			if (!LLMessageStringTable::getInstance()->mEmpty[i] && LLMessageStringTable::getInstance()->mString[i][0] != '.')
+			if (name.c_str()[0] != '.')
 			{
-				fprintf(fp, "char const* const _PREHASH_%s = LLMessageStringTable::getInstance()->getString(\"%s\");\n", LLMessageStringTable::getInstance()->mString[i], LLMessageStringTable::getInstance()->mString[i]);
+				fprintf(fp, "char const* const _PREHASH_%s = LLMessageStringTable::getInstance()->getString(\"%s\");\n", name.c_str(), name.c_str());
 			}
 		}
 		fclose(fp);
@@ -2600,6 +2668,8 @@ void LLMessageSystem::summarizeLogs(std::ostream& str)
 	str << buffer << std::endl << std::endl;
 	buffer = llformat( "SendPacket failures:       %20d", mSendPacketFailureCount);
 	str << buffer << std::endl;
+	buffer = llformat( "Packet send calls:         %20u (%5.2f packets/call)", mPacketRing.getSendCalls(), (F32) mPacketsOut / ((F32) mPacketRing.getSendCalls() + 1));
+	str << buffer << std::endl;
 	buffer = llformat( "Dropped packets:           %20d", mDroppedPackets);
 	str << buffer << std::endl;
 	buffer = llformat( "Resent packets:            %20d", mResentPackets);
@@ -2838,72 +2908,20 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 	
 	*data[0] &= (~LL_ZERO_CODE_FLAG);
 
-	S32 count = (*data_size);  
-	
-	U8 *inptr = (U8 *)*data;
-	U8 *outptr = (U8 *)mEncodedRecvBuffer;
-
-// skip the packet id field
+	// skip the packet id field
+	memcpy(mEncodedRecvBuffer, *data, LL_PACKET_ID_SIZE);
 
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	S32 expanded = ll_zero_code_expand(*data + LL_PACKET_ID_SIZE, in_size - LL_PACKET_ID_SIZE,
+									   mEncodedRecvBuffer + LL_PACKET_ID_SIZE,
+									   MAX_BUFFER_SIZE - LL_PACKET_ID_SIZE);
+	if (expanded < 0)
 	{
-		count--;
-		*outptr++ = *inptr++;
+		LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size" << LL_ENDL;
+		callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
 	}
 
-// reconstruct encoded packet, keeping track of net size gain
-
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-	while (count--)
-	{
-		if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
-		{
-			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
-			callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-			outptr = mEncodedRecvBuffer;					
-			break;
-		}
-		if (!((*outptr++ = *inptr++)))
-		{
-			while (((count--)) && (!(*inptr)))
-			{
-				*outptr++ = *inptr++;
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
-  				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;
-					count = -1;
-					break;
-  				}
-				memset(outptr,0,255);
-				outptr += 255;
-			}
-			
-			if (count < 0)
-			{
-				break;
-			}
-
-			else
-			{
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
-				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;					
-				}
-				memset(outptr,0,(*inptr) - 1);
-				outptr += ((*inptr) - 1);
-				inptr++;
-			}
-		}		
-	}
-	
 	*data = mEncodedRecvBuffer;
-	*data_size = (S32)(outptr - mEncodedRecvBuffer);
+	*data_size = expanded < 0 ? 0 : expanded + LL_PACKET_ID_SIZE;
 	mUncompressedBytesIn += *data_size;
 
 	return(in_size);
@@ -36,6 +36,7 @@
 
 #include "llerror.h"
 #include "net.h"
+#include "llinternedstring.h"
 #include "llstringtable.h"
 #include "llcircuit.h"
 #include "lltimer.h"
@@ -56,7 +57,6 @@
 #include LLCOROS_MUTEX_HEADER
 
 const U32 MESSAGE_MAX_STRINGS_LENGTH = 64;
-const U32 MESSAGE_NUMBER_OF_HASH_BUCKETS = 8192;
 
 const S32 MESSAGE_MAX_PER_FRAME = 400;
 
@@ -66,11 +66,12 @@ class LLMessageStringTable : public LLSingleton<LLMessageStringTable>
 	~LLMessageStringTable();
 
 public:
+	// The interned copy of str, so message, block and variable names can
+	// be compared by pointer. Names are cut to MESSAGE_MAX_STRINGS_LENGTH - 1.
 	char *getString(const char *str);
 
-	U32	 mUsed;
-	bool mEmpty[MESSAGE_NUMBER_OF_HASH_BUCKETS];
-	char mString[MESSAGE_NUMBER_OF_HASH_BUCKETS][MESSAGE_MAX_STRINGS_LENGTH];	/* Flawfinder: ignore */
+	// Every name handed out, in the order first asked for
+	std::set<LLInternedString> mNames;
 };
 
 
@@ -411,6 +412,9 @@ public:
 	bool	poll(F32 seconds); // Number of seconds that we want to block waiting for data, returns if data was received
 	bool	checkMessages(LockMessageChecker&, S64 frame_count = 0 );
 	void	processAcks(LockMessageChecker&, F32 collect_time = 0.f);
+	// Sends the packets queued while the packet ring batches sends, acks
+	// waiting on a circuit are appended to its queued packets first
+	void	flushSends();
 
 	bool	isMessageFast(const char *msg);
 	bool	isMessage(const char *msg)
@@ -845,6 +849,9 @@ private:
 	void		logValidMsg(LLCircuitData *cdp, const LLHost& sender, bool recv_reliable, bool recv_resent, bool recv_acks );
 	void		logRanOffEndOfPacket( const LLHost& sender );
 
+	// Moves acks waiting on circuits onto packets queued for them
+	void		appendQueuedAcks();
+
 	class LLMessageCountInfo
 	{
 	public:
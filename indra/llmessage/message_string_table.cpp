@@ -29,27 +29,8 @@
 #include "llerror.h"
 #include "message.h"
 
-inline U32	message_hash_my_string(const char *str)
-{
-	U32 retval = 0;
-	while (*str++)
-	{
-		retval += *str;
-		retval <<= 1;
-	}
-	return (retval % MESSAGE_NUMBER_OF_HASH_BUCKETS);
-}
-
-
-
 LLMessageStringTable::LLMessageStringTable()
-:	mUsed(0)
 {
-	for (U32 i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
-	{
-		mEmpty[i] = true;
-		mString[i][0] = 0;
-	}
 }
 
 
@@ -59,33 +40,8 @@ LLMessageStringTable::~LLMessageStringTable()
 
 char* LLMessageStringTable::getString(const char *str)
 {
-	U32 hash_value = message_hash_my_string(str);
-	while (!mEmpty[hash_value])
-	{
-		if (!strncmp(str, mString[hash_value], MESSAGE_MAX_STRINGS_LENGTH))
-		{
-			return mString[hash_value];
-		}
-		else
-		{
-			hash_value++;
-			hash_value %= MESSAGE_NUMBER_OF_HASH_BUCKETS;
-		}
-	}
-	// not found, so add!
-	strncpy(mString[hash_value], str, MESSAGE_MAX_STRINGS_LENGTH);	/* Flawfinder: ignore */
-	mString[hash_value][MESSAGE_MAX_STRINGS_LENGTH - 1] = 0;
-	mEmpty[hash_value] = false;
-	mUsed++;
-	if (mUsed >= MESSAGE_NUMBER_OF_HASH_BUCKETS - 1)
-	{
-		U32 i;
-		LL_INFOS() << "Dumping string table before crashing on HashTable full!" << LL_ENDL;
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
-		{
-			LL_INFOS() << "Entry #" << i << ": " << mString[i] << LL_ENDL;
-		}
-	}
-	return mString[hash_value];
+	LLInternedString name(std::string_view(str, strnlen(str, MESSAGE_MAX_STRINGS_LENGTH - 1)));
+	mNames.insert(name);
+	// interned strings are never freed or moved
+	return const_cast<char*>(name.c_str());
 }
-
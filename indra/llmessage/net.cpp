@@ -36,6 +36,7 @@
 #else
 	#include <sys/types.h>
 	#include <sys/socket.h>
+	#include <sys/select.h>
 	#include <netinet/in.h>
 	#include <arpa/inet.h>
 	#include <fcntl.h>
@@ -183,6 +184,19 @@ U32 ip_string_to_u32(const char* ip_string)
 }
 
 
+bool wait_for_packet(int hSocket, S32 timeout_ms)
+{
+	fd_set read_set;
+	FD_ZERO(&read_set);
+	FD_SET(hSocket, &read_set);
+
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+	return select(hSocket + 1, &read_set, NULL, NULL, &timeout) > 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // Windows Versions
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -341,6 +355,29 @@ S32 receive_packet(int hSocket, char * receiveBuffer)
 	return nRet;
 }
 
+S32 receive_packets(int hSocket, char** buffers, S32* sizes, LLHost* senders, S32 count)
+{
+	S32 received = 0;
+	while (received < count)
+	{
+		SOCKADDR_IN src_addr;
+		int addr_size = sizeof(src_addr);
+		int nRet = recvfrom(hSocket, buffers[received], NET_BUFFER_SIZE, 0, (struct sockaddr*)&src_addr, &addr_size);
+		if (nRet == SOCKET_ERROR)
+		{
+			if (WSAEWOULDBLOCK != WSAGetLastError() && WSAECONNRESET != WSAGetLastError())
+			{
+				LL_INFOS() << "receive_packets() failed, Error: " << WSAGetLastError() << LL_ENDL;
+			}
+			break;
+		}
+		sizes[received] = nRet;
+		senders[received] = LLHost(src_addr.sin_addr.s_addr, ntohs(src_addr.sin_port));
+		++received;
+	}
+	return received;
+}
+
 // Returns TRUE on success.
 bool send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort)
 {
@@ -379,6 +416,20 @@ bool send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, i
 	return (nRet != SOCKET_ERROR);
 }
 
+S32 send_packets(int hSocket, const char** buffers, const S32* sizes, const LLHost* recipients, S32 count, U32& calls)
+{
+	S32 sent = 0;
+	for (S32 i = 0; i < count; ++i)
+	{
+		++calls;
+		if (send_packet(hSocket, buffers[i], sizes[i], recipients[i].getAddress(), recipients[i].getPort()))
+		{
+			++sent;
+		}
+	}
+	return sent;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // Linux Versions
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -537,6 +588,58 @@ int receive_packet(int hSocket, char * receiveBuffer)
 	return nRet;
 }
 
+S32 receive_packets(int hSocket, char** buffers, S32* sizes, LLHost* senders, S32 count)
+{
+	const S32 MAX_BATCH = 64;
+	count = llmin(count, MAX_BATCH);
+
+#if LL_LINUX
+	struct mmsghdr msgs[MAX_BATCH];
+	struct iovec iovecs[MAX_BATCH];
+	struct sockaddr_in src_addrs[MAX_BATCH];
+
+	memset(msgs, 0, sizeof(struct mmsghdr) * count);
+	for (S32 i = 0; i < count; ++i)
+	{
+		iovecs[i].iov_base = buffers[i];
+		iovecs[i].iov_len = NET_BUFFER_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &src_addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+	}
+
+	int nRet = recvmmsg(hSocket, msgs, count, MSG_DONTWAIT, NULL);
+	if (nRet <= 0)
+	{
+		return 0;
+	}
+
+	for (S32 i = 0; i < nRet; ++i)
+	{
+		sizes[i] = msgs[i].msg_len;
+		senders[i] = LLHost(src_addrs[i].sin_addr.s_addr, ntohs(src_addrs[i].sin_port));
+	}
+	return nRet;
+#else
+	S32 received = 0;
+	while (received < count)
+	{
+		struct sockaddr_in src_addr;
+		socklen_t addr_size = sizeof(src_addr);
+		int nRet = recvfrom(hSocket, buffers[received], NET_BUFFER_SIZE, 0, (struct sockaddr*)&src_addr, &addr_size);
+		if (nRet == -1)
+		{
+			break;
+		}
+		sizes[received] = nRet;
+		senders[received] = LLHost(src_addr.sin_addr.s_addr, ntohs(src_addr.sin_port));
+		++received;
+	}
+	return received;
+#endif
+}
+
 bool send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient, int nPort)
 {
 	int		ret;
@@ -597,6 +700,77 @@ bool send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 	return success;
 }
 
+S32 send_packets(int hSocket, const char** buffers, const S32* sizes, const LLHost* recipients, S32 count, U32& calls)
+{
+#if LL_LINUX
+	const S32 MAX_BATCH = 64;
+	struct mmsghdr msgs[MAX_BATCH];
+	struct iovec iovecs[MAX_BATCH];
+	struct sockaddr_in dst_addrs[MAX_BATCH];
+
+	S32 sent = 0;
+	for (S32 first = 0; first < count; first += MAX_BATCH)
+	{
+		S32 batch = llmin(count - first, MAX_BATCH);
+		memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+		memset(dst_addrs, 0, sizeof(struct sockaddr_in) * batch);
+		for (S32 i = 0; i < batch; ++i)
+		{
+			const LLHost& recipient = recipients[first + i];
+			dst_addrs[i].sin_family = AF_INET;
+			dst_addrs[i].sin_addr.s_addr = recipient.getAddress();
+			dst_addrs[i].sin_port = htons(recipient.getPort());
+			iovecs[i].iov_base = (void*)buffers[first + i];
+			iovecs[i].iov_len = sizes[first + i];
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &dst_addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+		}
+
+		// sendmmsg() stops at the first datagram that fails, retry it the
+		// way send_packet() does and give up on it after three attempts
+		S32 done = 0;
+		S32 send_attempts = 0;
+		while (done < batch)
+		{
+			++calls;
+			int ret = sendmmsg(hSocket, msgs + done, batch - done, 0);
+			if (ret > 0)
+			{
+				done += ret;
+				sent += ret;
+				send_attempts = 0;
+			}
+			else if ((errno == EAGAIN || errno == ECONNREFUSED) && ++send_attempts < 3)
+			{
+				LL_INFOS() << "sendmmsg() reported " << strerror(errno) << ", resending (attempt " << send_attempts << ")" << LL_ENDL;
+			}
+			else
+			{
+				LL_INFOS() << "sendmmsg() failed: " << errno << ", " << strerror(errno) << LL_ENDL;
+				LL_INFOS() << inet_ntoa(dst_addrs[done].sin_addr) << ":" << ntohs(dst_addrs[done].sin_port) << LL_ENDL;
+				// drop the datagram that failed and carry on with the rest
+				++done;
+				send_attempts = 0;
+			}
+		}
+	}
+	return sent;
+#else
+	S32 sent = 0;
+	for (S32 i = 0; i < count; ++i)
+	{
+		++calls;
+		if (send_packet(hSocket, buffers[i], sizes[i], recipients[i].getAddress(), recipients[i].getPort()))
+		{
+			++sent;
+		}
+	}
+	return sent;
+#endif
+}
+
 #endif
 
 //EOF
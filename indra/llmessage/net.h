@@ -43,8 +43,22 @@ void	end_net(S32& socket_out);
 // returns size of packet or -1 in case of error
 S32		receive_packet(int hSocket, char * receiveBuffer);
 
+// Thread safe receive: reads up to count datagrams into buffers (each at
+// least NET_BUFFER_SIZE bytes) with one system call where the platform
+// supports it. Sizes and senders are written to sizes and senders.
+// Returns the number of datagrams read, 0 if none were waiting.
+S32		receive_packets(int hSocket, char** buffers, S32* sizes, LLHost* senders, S32 count);
+
+// Waits up to timeout_ms for hSocket to become readable
+bool	wait_for_packet(int hSocket, S32 timeout_ms);
+
 bool	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
+// Sends count datagrams, each to its own recipient, with as few system calls
+// as the platform allows. calls is incremented by the number of system calls
+// made. Returns the number of datagrams handed to the socket.
+S32		send_packets(int hSocket, const char** buffers, const S32* sizes, const LLHost* recipients, S32 count, U32& calls);
+
 //void	get_sender(char * tmp);
 LLHost	get_sender();
 U32		get_sender_port();
@@ -0,0 +1,301 @@
+/**
+ * @file llpacketring_test.cpp
+ * @brief LLPacketRing receive thread and send batching tests, loopback
+ *        replay benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketring.h"
+
+#include "../test/lltut.h"
+#include "packetcapture.h"
+
+#include "llhost.cpp"
+#include "llpacketbuffer.cpp"
+#include "net.cpp"
+
+#include "llfile.h"
+#include "lltimer.h"
+#include "message.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+// test doubles
+bool LLProxy::sUDPProxyEnabled = false;
+LLProxy::LLProxy() {}
+LLProxy::~LLProxy() {}
+void LLProxy::initSingleton() {}
+
+LLThrottle::LLThrottle(const F32 rate) {}
+void LLThrottle::setRate(const F32 rate) {}
+bool LLThrottle::checkOverflow(const F32 amount) { return false; }
+bool LLThrottle::throttleOverflow(const F32 amount) { return false; }
+
+namespace
+{
+	// Sends packets to port on the loopback interface from a second socket
+	class LoopbackSender
+	{
+	public:
+		LoopbackSender(S32 port)
+		:	mSocket(-1),
+			mPort(port),
+			mLoopback(ip_string_to_u32(LOOPBACK_ADDRESS_STRING))
+		{
+			int local_port = NET_USE_OS_ASSIGNED_PORT;
+			start_net(mSocket, local_port);
+		}
+
+		~LoopbackSender()
+		{
+			end_net(mSocket);
+		}
+
+		bool send(const char* data, S32 size)
+		{
+			return send_packet(mSocket, data, size, mLoopback, mPort);
+		}
+
+	private:
+		S32 mSocket;
+		S32 mPort;
+		U32 mLoopback;
+	};
+}
+
+namespace tut
+{
+	struct packetring_data
+	{
+		S32 mSocket;
+		S32 mPort;
+
+		packetring_data()
+		:	mSocket(-1),
+			mPort(NET_USE_OS_ASSIGNED_PORT)
+		{
+			start_net(mSocket, mPort);
+		}
+
+		~packetring_data()
+		{
+			end_net(mSocket);
+		}
+
+		// Receives until count packets arrived or timeout expired, returns
+		// the payloads in arrival order
+		std::vector<std::string> receive(LLPacketRing& ring, size_t count, F32 timeout)
+		{
+			std::vector<std::string> packets;
+			char buffer[NET_BUFFER_SIZE];
+			LLTimer timer;
+			while (packets.size() < count && timer.getElapsedTimeF32() < timeout)
+			{
+				S32 size = ring.receivePacket(mSocket, buffer);
+				if (size > 0)
+				{
+					packets.push_back(std::string(buffer, size));
+				}
+				else
+				{
+					ms_sleep(1);
+				}
+			}
+			return packets;
+		}
+	};
+	typedef test_group<packetring_data> packetring_group;
+	typedef packetring_group::object packetring_object;
+	packetring_group packetring("LLPacketRing");
+
+	template<> template<>
+	void packetring_object::test<1>()
+	{
+		set_test_name("receive thread delivers packets in order");
+
+		LLPacketRing ring;
+		ensure("thread started", ring.startReceiveThread(mSocket));
+		ensure("second start refused", !ring.startReceiveThread(mSocket));
+
+		LoopbackSender sender(mPort);
+		const S32 COUNT = 100;
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			std::string payload = llformat("packet %d", i);
+			sender.send(payload.data(), payload.size());
+		}
+
+		std::vector<std::string> packets = receive(ring, COUNT, 5.f);
+		ensure_equals("packet count", packets.size(), (size_t) COUNT);
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			ensure_equals("packet order", packets[i], llformat("packet %d", i));
+		}
+		ensure("sender recorded", ring.getLastSender().getAddress() == ip_string_to_u32(LOOPBACK_ADDRESS_STRING));
+
+		ring.stopReceiveThread();
+		ensure("thread stopped", !ring.hasReceiveThread());
+	}
+
+	template<> template<>
+	void packetring_object::test<2>()
+	{
+		set_test_name("receive thread wraps around a full ring");
+
+		LLPacketRing ring;
+		ring.startReceiveThread(mSocket);
+
+		// more packets than ring slots, sent before anything is consumed
+		LoopbackSender sender(mPort);
+		const S32 COUNT = 1500;
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			U32 value = i;
+			sender.send(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		std::vector<std::string> packets = receive(ring, COUNT, 10.f);
+		ensure_equals("packet count", packets.size(), (size_t) COUNT);
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			U32 value = 0;
+			memcpy(&value, packets[i].data(), sizeof(value));
+			ensure_equals("packet order", value, (U32) i);
+		}
+	}
+
+	template<> template<>
+	void packetring_object::test<3>()
+	{
+		set_test_name("batched sends with appended acks");
+
+		LLPacketRing ring;
+		ring.setBatchSends(true);
+
+		LLHost self(ip_string_to_u32(LOOPBACK_ADDRESS_STRING), mPort);
+		char message[16];
+		memset(message, 0, sizeof(message));
+		ensure("queued", ring.sendPacket(mSocket, message, sizeof(message), self, true));
+		ensure("queued", ring.sendPacket(mSocket, message, sizeof(message), self, false));
+		ensure_equals("no send calls before flush", ring.getSendCalls(), 0U);
+
+		const TPACKETID acks[] = { 7, 8, 9 };
+		ensure_equals("acks appended", ring.appendAcks(self, acks, 3), 3);
+		ensure_equals("more acks appended", ring.appendAcks(self, acks, 1), 1);
+		ensure_equals("flush", ring.flushSends(mSocket), 0);
+
+		std::vector<std::string> packets = receive(ring, 2, 5.f);
+		ensure_equals("packet count", packets.size(), (size_t) 2);
+
+		const std::string& acked = packets[0];
+		ensure_equals("acked size", acked.size(), sizeof(message) + 4 * sizeof(TPACKETID) + 1);
+		ensure("ack flag", acked[0] & LL_ACK_FLAG);
+		ensure_equals("ack count", (S32)(U8)acked[acked.size() - 1], 4);
+		TPACKETID last_ack = 0;
+		memcpy(&last_ack, &acked[acked.size() - 1 - sizeof(TPACKETID)], sizeof(TPACKETID));
+		ensure_equals("last ack", ntohl(last_ack), (TPACKETID) 7);
+
+		ensure_equals("unacked size", packets[1].size(), sizeof(message));
+	}
+
+	template<> template<>
+	void packetring_object::test<4>()
+	{
+		set_test_name("loopback replay benchmark");
+
+		// Set to a capture file (see load_packet_capture()) or to "synthetic"
+		const char* capture = getenv("LL_UDP_REPLAY_BENCHMARK");
+		if (!capture || !*capture)
+		{
+			skip("set LL_UDP_REPLAY_BENCHMARK to run the replay benchmark");
+		}
+
+		std::vector<std::string> stream;
+		if (std::string(capture) != "synthetic")
+		{
+			stream = load_packet_capture(capture, NET_BUFFER_SIZE);
+			ensure("capture loaded", !stream.empty());
+		}
+		else
+		{
+			// region entry is dominated by near MTU sized object updates
+			for (S32 i = 0; i < 20000; ++i)
+			{
+				stream.push_back(std::string(MTUBYTES, (char) i));
+			}
+		}
+
+		for (S32 threaded = 0; threaded < 2; ++threaded)
+		{
+			LLPacketRing ring;
+			if (threaded)
+			{
+				ring.startReceiveThread(mSocket);
+			}
+
+			// replay as fast as the sender can go
+			std::atomic<bool> sent(false);
+			std::thread replay([this, &stream, &sent]()
+				{
+					LoopbackSender sender(mPort);
+					for (const std::string& packet : stream)
+					{
+						sender.send(packet.data(), packet.size());
+					}
+					sent = true;
+				});
+
+			char buffer[NET_BUFFER_SIZE];
+			size_t received = 0;
+			U64 bytes = 0;
+			LLTimer timer;
+			LLTimer idle;
+			while (received < stream.size() && (!sent || idle.getElapsedTimeF32() < 0.5f))
+			{
+				S32 size = ring.receivePacket(mSocket, buffer);
+				if (size > 0)
+				{
+					++received;
+					bytes += size;
+					idle.reset();
+				}
+			}
+			F64 seconds = timer.getElapsedTimeF64();
+			replay.join();
+
+			std::cout << "\n" << (threaded ? "receive thread" : "main thread   ") << ": "
+					  << received << "/" << stream.size() << " packets, "
+					  << received / seconds << " packets/s, "
+					  << bytes * 8 / seconds / 1000000.0 << " Mbit/s" << std::endl;
+
+			// let the socket drain before the next run
+			while (ring.receivePacket(mSocket, buffer) > 0 || wait_for_packet(mSocket, 100))
+			{
+			}
+		}
+	}
+}
@@ -0,0 +1,409 @@
+/**
+ * @file llzerocode_test.cpp
+ * @brief Zero coding tests against the original byte at a time coder,
+ *        throughput benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llzerocode.h"
+
+#include "../test/lltut.h"
+#include "packetcapture.h"
+
+#include "llfile.h"
+#include "lltimer.h"
+#include "message.h"
+
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+	// The coders as they were in LLTemplateMessageBuilder and
+	// LLMessageSystem, minus the stats, working on whole packets
+
+	S32 reference_zero_code(const U8* data, S32 data_size, U8* out)
+	{
+		S32 count = data_size;
+		U8 num_zeroes = 0;
+		const U8* inptr = data;
+		U8* outptr = out;
+
+		for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+		{
+			count--;
+			*outptr++ = *inptr++;
+		}
+
+		while (count--)
+		{
+			if (!(*inptr))
+			{
+				if (num_zeroes)
+				{
+					if (++num_zeroes > 254)
+					{
+						*outptr++ = num_zeroes;
+						num_zeroes = 0;
+					}
+				}
+				else
+				{
+					*outptr++ = 0;
+					num_zeroes = 1;
+				}
+				inptr++;
+			}
+			else
+			{
+				if (num_zeroes)
+				{
+					*outptr++ = num_zeroes;
+					num_zeroes = 0;
+				}
+				*outptr++ = *inptr++;
+			}
+		}
+
+		if (num_zeroes)
+		{
+			*outptr++ = num_zeroes;
+		}
+		return (S32)(outptr - out);
+	}
+
+	// Returns the expanded size, or -1 where the original reported
+	// MX_WROTE_PAST_BUFFER_SIZE
+	S32 reference_zero_code_expand(const U8* data, S32 data_size, U8* out)
+	{
+		S32 count = data_size;
+		const U8* inptr = data;
+		U8* outptr = out;
+		bool overflow = false;
+
+		for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+		{
+			count--;
+			*outptr++ = *inptr++;
+		}
+
+		while (count--)
+		{
+			if (outptr > (&out[MAX_BUFFER_SIZE-1]))
+			{
+				overflow = true;
+				break;
+			}
+			if (!((*outptr++ = *inptr++)))
+			{
+				while (((count--)) && (!(*inptr)))
+				{
+					*outptr++ = *inptr++;
+					if (outptr > (&out[MAX_BUFFER_SIZE-256]))
+					{
+						overflow = true;
+						count = -1;
+						break;
+					}
+					memset(outptr,0,255);
+					outptr += 255;
+				}
+
+				if (count < 0)
+				{
+					break;
+				}
+				else
+				{
+					if (outptr > (&out[MAX_BUFFER_SIZE-(*inptr)]))
+					{
+						overflow = true;
+						outptr = out;
+					}
+					memset(outptr,0,(*inptr) - 1);
+					outptr += ((*inptr) - 1);
+					inptr++;
+				}
+			}
+		}
+		return overflow ? -1 : (S32)(outptr - out);
+	}
+
+	// How LLMessageSystem::zeroCodeExpand() drives ll_zero_code_expand()
+	S32 zero_code_expand(const U8* data, S32 data_size, U8* out)
+	{
+		memcpy(out, data, LL_PACKET_ID_SIZE);
+		S32 expanded = ll_zero_code_expand(data + LL_PACKET_ID_SIZE, data_size - LL_PACKET_ID_SIZE,
+										   out + LL_PACKET_ID_SIZE, MAX_BUFFER_SIZE - LL_PACKET_ID_SIZE);
+		return expanded < 0 ? -1 : expanded + LL_PACKET_ID_SIZE;
+	}
+
+	S32 zero_code(const U8* data, S32 data_size, U8* out)
+	{
+		memcpy(out, data, LL_PACKET_ID_SIZE);
+		return ll_zero_code(data + LL_PACKET_ID_SIZE, data_size - LL_PACKET_ID_SIZE,
+							out + LL_PACKET_ID_SIZE) + LL_PACKET_ID_SIZE;
+	}
+
+	// Builds a message shaped packet: literal spans broken up by zero runs
+	// of every interesting length, including ones past the 255 and 256 wraps
+	std::vector<U8> random_packet(std::mt19937& rng, S32 size)
+	{
+		std::vector<U8> packet(size);
+		std::uniform_int_distribution<S32> byte(1, 255);
+		std::uniform_int_distribution<S32> span(0, 40);
+		std::uniform_int_distribution<S32> kind(0, 9);
+		S32 i = 0;
+		while (i < size)
+		{
+			S32 literal = std::min(span(rng), size - i);
+			for (S32 j = 0; j < literal; ++j)
+			{
+				packet[i++] = (U8) byte(rng);
+			}
+
+			S32 zeroes;
+			switch (kind(rng))
+			{
+			case 0:		zeroes = 255; break;
+			case 1:		zeroes = 256; break;
+			case 2:		zeroes = 257 + span(rng) * 20; break;
+			case 3:		zeroes = 16 + span(rng); break;
+			default:	zeroes = span(rng) / 8; break;
+			}
+			zeroes = std::min(zeroes, size - i);
+			memset(&packet[i], 0, zeroes);
+			i += zeroes;
+		}
+		return packet;
+	}
+}
+
+namespace tut
+{
+	struct zerocode_data
+	{
+		U8 mExpected[2 * MAX_BUFFER_SIZE];
+		U8 mActual[2 * MAX_BUFFER_SIZE];
+	};
+	typedef test_group<zerocode_data> zerocode_group;
+	typedef zerocode_group::object zerocode_object;
+	zerocode_group zerocode("LLZeroCode");
+
+	template<> template<>
+	void zerocode_object::test<1>()
+	{
+		set_test_name("run scanning");
+
+		U8 data[64];
+		memset(data, 1, sizeof(data));
+		ensure_equals("all nonzero", ll_nonzero_run(data, sizeof(data)), (S32) sizeof(data));
+		ensure_equals("no zero run", ll_zero_run(data, sizeof(data)), 0);
+
+		for (S32 i = 0; i < (S32) sizeof(data); ++i)
+		{
+			data[i] = 0;
+			ensure_equals("zero position", ll_nonzero_run(data, sizeof(data)), i);
+			ensure_equals("bounded by size", ll_nonzero_run(data, i), i);
+			data[i] = 1;
+		}
+
+		memset(data, 0, sizeof(data));
+		data[37] = 5;
+		ensure_equals("zero run", ll_zero_run(data, sizeof(data)), 37);
+		ensure_equals("zero run to end", ll_zero_run(data + 38, sizeof(data) - 38), (S32) sizeof(data) - 38);
+	}
+
+	template<> template<>
+	void zerocode_object::test<2>()
+	{
+		set_test_name("encoding matches the original coder");
+
+		std::mt19937 rng(20240117);
+		std::uniform_int_distribution<S32> size(LL_PACKET_ID_SIZE, MAX_BUFFER_SIZE);
+		for (S32 i = 0; i < 2000; ++i)
+		{
+			std::vector<U8> packet = random_packet(rng, i < 200 ? LL_PACKET_ID_SIZE + i : size(rng));
+			S32 expected = reference_zero_code(packet.data(), packet.size(), mExpected);
+			S32 actual = zero_code(packet.data(), packet.size(), mActual);
+			ensure_equals("encoded size", actual, expected);
+			ensure("encoded bytes", !memcmp(mActual, mExpected, actual));
+
+			// and round trips
+			std::vector<U8> encoded(mActual, mActual + actual);
+			S32 expanded = zero_code_expand(encoded.data(), encoded.size(), mActual);
+			ensure_equals("round trip size", expanded, (S32) packet.size());
+			ensure("round trip bytes", !memcmp(mActual, packet.data(), expanded));
+		}
+	}
+
+	template<> template<>
+	void zerocode_object::test<3>()
+	{
+		set_test_name("expansion matches the original decoder");
+
+		std::mt19937 rng(20240118);
+		std::uniform_int_distribution<S32> size(LL_MINIMUM_VALID_PACKET_SIZE, MTUBYTES);
+		std::uniform_int_distribution<S32> byte(0, 255);
+		std::uniform_int_distribution<S32> density(1, 8);
+		for (S32 i = 0; i < 20000; ++i)
+		{
+			// arbitrary input, biased towards zeroes so that wraps, trailing
+			// markers and overflows all turn up
+			std::vector<U8> packet(size(rng));
+			S32 zero_odds = density(rng);
+			for (U8& b : packet)
+			{
+				b = (byte(rng) % zero_odds) ? (U8) byte(rng) : 0;
+			}
+
+			S32 expected = reference_zero_code_expand(packet.data(), packet.size(), mExpected);
+			S32 actual = zero_code_expand(packet.data(), packet.size(), mActual);
+			if (actual < 0)
+			{
+				// anything that doesn't fit was refused by the original too
+				ensure_equals("overflow", expected, -1);
+			}
+			else if (expected >= 0)
+			{
+				ensure_equals("expanded size", actual, expected);
+				ensure("expanded bytes", !memcmp(mActual, mExpected, actual));
+			}
+		}
+	}
+
+	template<> template<>
+	void zerocode_object::test<4>()
+	{
+		set_test_name("expansion edge cases");
+
+		const U8 header[LL_PACKET_ID_SIZE] = { 0x80, 0, 0, 0, 1, 0 };
+		struct { std::vector<U8> body; S32 zeroes; } cases[] = {
+			{ { 0 }, 1 },					// trailing marker
+			{ { 0, 0 }, 257 },				// trailing wrap
+			{ { 0, 0, 0, 3 }, 515 },		// wraps then count
+			{ { 0, 255 }, 255 },
+			{ { 0, 1 }, 1 },
+		};
+		for (auto& c : cases)
+		{
+			std::vector<U8> packet(header, header + LL_PACKET_ID_SIZE);
+			packet.insert(packet.end(), c.body.begin(), c.body.end());
+			S32 expected = reference_zero_code_expand(packet.data(), packet.size(), mExpected);
+			S32 actual = zero_code_expand(packet.data(), packet.size(), mActual);
+			ensure_equals("expected zeroes", expected, LL_PACKET_ID_SIZE + c.zeroes);
+			ensure_equals("expanded size", actual, expected);
+		}
+
+		// a run that would expand past the receive buffer
+		std::vector<U8> packet(header, header + LL_PACKET_ID_SIZE);
+		packet.insert(packet.end(), 40, 0);
+		ensure_equals("overflow refused", zero_code_expand(packet.data(), packet.size(), mActual), -1);
+	}
+
+	template<> template<>
+	void zerocode_object::test<5>()
+	{
+		set_test_name("throughput benchmark");
+
+		// Set to a capture file (see load_packet_capture()) or to "synthetic"
+		const char* capture = getenv("LL_ZEROCODE_BENCHMARK");
+		if (!capture || !*capture)
+		{
+			skip("set LL_ZEROCODE_BENCHMARK to run the zero coding benchmark");
+		}
+
+		// raw captures are what arrives off the wire, zero coded or not;
+		// the synthetic corpus is message bodies before encoding
+		std::vector<std::vector<U8> > encoded;
+		std::vector<std::vector<U8> > decoded;
+		if (std::string(capture) != "synthetic")
+		{
+			for (const std::string& data : load_packet_capture(capture, MAX_BUFFER_SIZE))
+			{
+				if (data.size() < LL_MINIMUM_VALID_PACKET_SIZE || !(data[0] & LL_ZERO_CODE_FLAG))
+				{
+					continue;
+				}
+				std::vector<U8> packet(data.begin(), data.end());
+				S32 size = zero_code_expand(packet.data(), packet.size(), mActual);
+				if (size > 0)
+				{
+					encoded.push_back(packet);
+					decoded.push_back(std::vector<U8>(mActual, mActual + size));
+				}
+			}
+			ensure("capture has zero coded packets", !encoded.empty());
+		}
+		else
+		{
+			std::mt19937 rng(20240119);
+			for (S32 i = 0; i < 20000; ++i)
+			{
+				decoded.push_back(random_packet(rng, MTUBYTES));
+				S32 size = zero_code(decoded.back().data(), MTUBYTES, mActual);
+				encoded.push_back(std::vector<U8>(mActual, mActual + size));
+			}
+		}
+
+		U64 decoded_bytes = 0;
+		for (const std::vector<U8>& packet : decoded)
+		{
+			decoded_bytes += packet.size();
+		}
+
+		const S32 PASSES = 20;
+		for (S32 reference = 1; reference >= 0; --reference)
+		{
+			LLTimer timer;
+			for (S32 pass = 0; pass < PASSES; ++pass)
+			{
+				for (const std::vector<U8>& packet : decoded)
+				{
+					reference ? reference_zero_code(packet.data(), packet.size(), mExpected)
+							  : zero_code(packet.data(), packet.size(), mActual);
+				}
+			}
+			F64 encode_seconds = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (S32 pass = 0; pass < PASSES; ++pass)
+			{
+				for (const std::vector<U8>& packet : encoded)
+				{
+					reference ? reference_zero_code_expand(packet.data(), packet.size(), mExpected)
+							  : zero_code_expand(packet.data(), packet.size(), mActual);
+				}
+			}
+			F64 expand_seconds = timer.getElapsedTimeF64();
+
+			F64 megabytes = decoded_bytes * PASSES / 1000000.0;
+			std::cout << "\n" << (reference ? "byte at a time" : "vectorized    ") << ": "
+					  << decoded.size() << " packets, encode "
+					  << megabytes / encode_seconds << " MB/s, expand "
+					  << megabytes / expand_seconds << " MB/s" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/**
+ * @file   packetcapture.h
+ * @brief  Reads UDP captures replayed by the llmessage benchmarks
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_PACKETCAPTURE_H)
+#define LL_PACKETCAPTURE_H
+
+#include "llfile.h"
+
+#include <string>
+#include <vector>
+
+// Reads a capture of length prefixed datagrams: a little endian U16 size
+// followed by the payload, repeated. Stops at a packet larger than
+// max_size or cut short by the end of the file.
+inline std::vector<std::string> load_packet_capture(const std::string& filename, size_t max_size)
+{
+	std::vector<std::string> packets;
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (!fp)
+	{
+		return packets;
+	}
+
+	U8 header[2];
+	while (fread(header, 1, 2, fp) == 2)
+	{
+		U16 size = header[0] | (header[1] << 8);
+		std::string packet(size, '\0');
+		if (size > max_size || fread(&packet[0], 1, size, fp) != size)
+		{
+			break;
+		}
+		packets.push_back(packet);
+	}
+	fclose(fp);
+	return packets;
+}
+
+#endif /* ! defined(LL_PACKETCAPTURE_H) */
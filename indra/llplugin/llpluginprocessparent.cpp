@@ -227,7 +227,7 @@ void LLPluginProcessParent::requestShutdown()
     // our idle() method.  Tie into the event loop here to do that until we are good
     // and finished.
     LL_DEBUGS("LLPluginProcessParent") << "listening on \"mainloop\"" << LL_ENDL;
-    mPolling = LLEventPumps::instance().obtain("mainloop")
+    mPolling = ll_mainloop_channel()
         .listen(namestream.str(), boost::bind(&LLPluginProcessParent::pollTick, this));
 
 }
@@ -41,6 +41,7 @@
 #include "llthread.h"
 #include "llsd.h"
 #include "llevents.h"
+#include "lleventchannel.h"
 
 class LLPluginProcessParentOwner : public std::enable_shared_from_this < LLPluginProcessParentOwner > 
 {
@@ -220,7 +221,7 @@ private:
 	void servicePoll();
 	static LLThread *sReadThread;
 
-    LLTempBoundListener mPolling;
+    LLTempChannelConnection mPolling;
     bool pollTick();
 
 	LLMutex mIncomingQueueMutex;
@@ -71,17 +71,6 @@ std::string colladaVersion[VERSIONTYPE_COUNT+1] =
 	"Unsupported"
 };
 
-static const std::string lod_suffix[LLModel::NUM_LODS] =
-{
-	"_LOD0",
-	"_LOD1",
-	"_LOD2",
-	"",
-	"_PHYS",
-};
-
-const U32 LIMIT_MATERIALS_OUTPUT = 12;
-
 bool get_dom_sources(const domInputLocalOffset_Array& inputs, S32& pos_offset, S32& tc_offset, S32& norm_offset, S32 &idx_stride,
 	domSource* &pos_source, domSource* &tc_source, domSource* &norm_source)
 {
@@ -911,18 +900,6 @@ LLDAELoader::~LLDAELoader()
 {
 }
 
-struct ModelSort
-{
-	bool operator()(const LLPointer< LLModel >& lhs, const LLPointer< LLModel >& rhs)
-	{
-        if (lhs->mSubmodelID < rhs->mSubmodelID)
-        {
-            return true;
-        }
-		return LLStringUtil::compareInsensitive(lhs->mLabel, rhs->mLabel) < 0;
-	}
-};
-
 bool LLDAELoader::OpenFile(const std::string& filename)
 {
 	setLoadState( READING_FILE );
@@ -1095,25 +1072,7 @@ bool LLDAELoader::OpenFile(const std::string& filename)
 		}
 	}
 
-	std::sort(mModelList.begin(), mModelList.end(), ModelSort());
-
-	model_list::iterator model_iter = mModelList.begin();
-	while (model_iter != mModelList.end())
-	{
-		LLModel* mdl = *model_iter;
-		U32 material_count = mdl->mMaterialList.size();
-		LL_INFOS() << "Importing " << mdl->mLabel << " model with " << material_count << " material references" << LL_ENDL;
-		std::vector<std::string>::iterator mat_iter = mdl->mMaterialList.begin();
-		std::vector<std::string>::iterator end_iter = material_count > LIMIT_MATERIALS_OUTPUT
-														? mat_iter + LIMIT_MATERIALS_OUTPUT
-														: mdl->mMaterialList.end();
-		while (mat_iter != end_iter)
-		{
-			LL_INFOS() << mdl->mLabel << " references " << (*mat_iter) << LL_ENDL;
-			mat_iter++;
-		}
-		model_iter++;
-	}
+	sortModelList();
 
 	count = db->getElementCount(NULL, COLLADA_TYPE_SKIN);
 	for (daeInt idx = 0; idx < count; ++idx)
@@ -2097,77 +2056,15 @@ void LLDAELoader::processElement( daeElement* element, bool& badElement, DAE* da
 				{
 					LLModel* model = *i;
 
-					LLMatrix4 transformation = mTransform;
-				
-					if (mTransform.determinant() < 0)
-					{ //negative scales are not supported
-						LL_INFOS() << "Negative scale detected, unsupported transform.  domInstance_geometry: " << getElementLabel(instance_geo) << LL_ENDL;
-                        LLSD args;
-                        args["Message"] = "NegativeScaleTrans";
-                        args["LABEL"] = getElementLabel(instance_geo);
-                        mWarningsArray.append(args);
-
-						badElement = true;
-					}
-
 					LLModelLoader::material_map materials = getMaterials(model, instance_geo, dae);
 
-					// adjust the transformation to compensate for mesh normalization
-					LLVector3 mesh_scale_vector;
-					LLVector3 mesh_translation_vector;
-					model->getNormalizedScaleTranslation(mesh_scale_vector, mesh_translation_vector);
-
-					LLMatrix4 mesh_translation;
-					mesh_translation.setTranslation(mesh_translation_vector);
-					mesh_translation *= transformation;
-					transformation = mesh_translation;
-					
-					LLMatrix4 mesh_scale;
-					mesh_scale.initScale(mesh_scale_vector);
-					mesh_scale *= transformation;
-					transformation = mesh_scale;
-
-					if (transformation.determinant() < 0)
-					{ //negative scales are not supported
-						LL_INFOS() << "Negative scale detected, unsupported post-normalization transform.  domInstance_geometry: " << getElementLabel(instance_geo) << LL_ENDL;
-                        LLSD args;
-                        args["Message"] = "NegativeScaleNormTrans";
-                        args["LABEL"] = getElementLabel(instance_geo);
-                        mWarningsArray.append(args);
-						badElement = true;
-					}
-
-					std::string label;
-					
+					std::string lodless_label;
 					if (model->mLabel.empty())
 					{
-						label = getLodlessLabel(instance_geo);
-
-						llassert(!label.empty());
-
-						if (model->mSubmodelID)
-						{
-							label += (char)((int)'a' + model->mSubmodelID);
-						}
-
-						model->mLabel = label + lod_suffix[mLod];
-					}
-					else
-					{
-						// Don't change model's name if possible, it will play havoc with scenes that already use said model.
-						size_t ext_pos = getSuffixPosition(model->mLabel);
-						if (ext_pos != -1)
-						{
-							label = model->mLabel.substr(0, ext_pos);
-						}
-						else
-						{
-							label = model->mLabel;
-						}
+						lodless_label = getLodlessLabel(instance_geo);
 					}
 
-					mScene[transformation].push_back(LLModelInstance(model, label, transformation, materials));
-					stretch_extents(model, transformation, mExtents[0], mExtents[1], mFirstTransform);
+					addModelInstance(model, materials, getElementLabel(instance_geo), lodless_label, badElement);
 					i++;
 				}
 			}
@@ -2207,6 +2104,79 @@ void LLDAELoader::processElement( daeElement* element, bool& badElement, DAE* da
 	}
 }
 
+void LLDAELoader::addModelInstance(LLModel* model, const LLModelLoader::material_map& materials, const std::string& instance_label, const std::string& lodless_label, bool& badElement)
+{
+	LLMatrix4 transformation = mTransform;
+
+	if (mTransform.determinant() < 0)
+	{ //negative scales are not supported
+		LL_INFOS() << "Negative scale detected, unsupported transform.  domInstance_geometry: " << instance_label << LL_ENDL;
+        LLSD args;
+        args["Message"] = "NegativeScaleTrans";
+        args["LABEL"] = instance_label;
+        mWarningsArray.append(args);
+
+		badElement = true;
+	}
+
+	// adjust the transformation to compensate for mesh normalization
+	LLVector3 mesh_scale_vector;
+	LLVector3 mesh_translation_vector;
+	model->getNormalizedScaleTranslation(mesh_scale_vector, mesh_translation_vector);
+
+	LLMatrix4 mesh_translation;
+	mesh_translation.setTranslation(mesh_translation_vector);
+	mesh_translation *= transformation;
+	transformation = mesh_translation;
+
+	LLMatrix4 mesh_scale;
+	mesh_scale.initScale(mesh_scale_vector);
+	mesh_scale *= transformation;
+	transformation = mesh_scale;
+
+	if (transformation.determinant() < 0)
+	{ //negative scales are not supported
+		LL_INFOS() << "Negative scale detected, unsupported post-normalization transform.  domInstance_geometry: " << instance_label << LL_ENDL;
+        LLSD args;
+        args["Message"] = "NegativeScaleNormTrans";
+        args["LABEL"] = instance_label;
+        mWarningsArray.append(args);
+		badElement = true;
+	}
+
+	std::string label;
+
+	if (model->mLabel.empty())
+	{
+		label = lodless_label;
+
+		llassert(!label.empty());
+
+		if (model->mSubmodelID)
+		{
+			label += (char)((int)'a' + model->mSubmodelID);
+		}
+
+		model->mLabel = label + getLodSuffix(mLod);
+	}
+	else
+	{
+		// Don't change model's name if possible, it will play havoc with scenes that already use said model.
+		size_t ext_pos = getSuffixPosition(model->mLabel);
+		if (ext_pos != -1)
+		{
+			label = model->mLabel.substr(0, ext_pos);
+		}
+		else
+		{
+			label = model->mLabel;
+		}
+	}
+
+	mScene[transformation].push_back(LLModelInstance(model, label, transformation, materials));
+	stretch_extents(model, transformation, mExtents[0], mExtents[1], mFirstTransform);
+}
+
 std::map<std::string, LLImportMaterial> LLDAELoader::getMaterials(LLModel* model, domInstance_geometry* instance_geo, DAE* dae)
 {
 	std::map<std::string, LLImportMaterial> materials;
@@ -2536,9 +2506,6 @@ bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& mo
 	LLModel* ret = new LLModel(volume_params, 0.f);
 
 	std::string model_name = getLodlessLabel(mesh);
-	ret->mLabel = model_name + lod_suffix[mLod];
-
-	llassert(!ret->mLabel.empty());
 
 	// Like a monkey, ready to be shot into space
 	//
@@ -2548,67 +2515,7 @@ bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& mo
 	//
 	addVolumeFacesFromDomMesh(ret, mesh, mWarningsArray);
 
-	U32 volume_faces = ret->getNumVolumeFaces();
-
-	// Side-steps all manner of issues when splitting models
-	// and matching lower LOD materials to base models
-	//
-	ret->sortVolumeFacesByMaterialName();
-
-	bool normalized = false;
-
-    int submodelID = 0;
-
-	// remove all faces that definitely won't fit into one model and submodel limit
-	U32 face_limit = (submodel_limit + 1) * LL_SCULPT_MESH_MAX_FACES;
-	if (face_limit < volume_faces)
-	{
-		ret->setNumVolumeFaces(face_limit);
-	}
-
-	LLVolume::face_list_t remainder;
-	do 
-	{
-		// Insure we do this once with the whole gang and not per-model
-		//
-		if (!normalized && !mNoNormalize)
-		{			
-			normalized = true;
-			ret->normalizeVolumeFaces();
-		}
-
-		ret->trimVolumeFacesToSize(LL_SCULPT_MESH_MAX_FACES, &remainder);
-
-		if (!mNoOptimize)
-		{
-			ret->remapVolumeFaces();
-		}
-
-		volume_faces = remainder.size();
-
-		models_out.push_back(ret);
-
-		// If we have left-over volume faces, create another model
-		// to absorb them...
-		//
-		if (volume_faces)
-		{
-			LLModel* next = new LLModel(volume_params, 0.f);
-			next->mSubmodelID = ++submodelID;
-			next->mLabel = model_name + (char)((int)'a' + next->mSubmodelID) + lod_suffix[mLod];
-			next->getVolumeFaces() = remainder;
-			next->mNormalizedScale = ret->mNormalizedScale;
-			next->mNormalizedTranslation = ret->mNormalizedTranslation;
-			if ( ret->mMaterialList.size() > LL_SCULPT_MESH_MAX_FACES)
-			{
-				next->mMaterialList.assign(ret->mMaterialList.begin() + LL_SCULPT_MESH_MAX_FACES, ret->mMaterialList.end());
-			}
-			ret = next;
-		}
-
-		remainder.clear();
-
-	} while (volume_faces);	
+	splitModel(ret, model_name, models_out, submodel_limit);
 
 	return true;
 }
@@ -99,13 +99,16 @@ protected:
 	//
 	bool loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& models_out, U32 submodel_limit);
 
+	// Adds an instance of model at mTransform to mScene
+	void addModelInstance(LLModel* model, const LLModelLoader::material_map& materials, const std::string& instance_label, const std::string& lodless_label, bool& badElement);
+
 	static std::string getElementLabel(daeElement *element);
 	static size_t getSuffixPosition(std::string label);
 	static std::string getLodlessLabel(daeElement *element);
 
 	static std::string preprocessDAE(std::string filename);
 
-private:
+protected:
 	U32 mGeneratedModelLimit; // Attempt to limit amount of generated submodels
 	bool mPreprocessDAE;
 
@@ -0,0 +1,1993 @@
+/**
+ * @file lldaestreamloader.cpp
+ * @brief LLDAEStreamLoader class implementation
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldaestreamloader.h"
+
+#include "llfile.h"
+#include "llmodel.h"
+#include "lluri.h"
+#include "llxmlparser.h"
+#include "threadpool.h"
+#include "workqueue.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <set>
+
+// Size of the chunks handed to expat
+static const size_t STREAM_CHUNK_SIZE = 256 * 1024;
+
+struct LLDAEStreamInput
+{
+	std::string mSemantic;
+	std::string mSource;	// id, without the leading '#'
+	S32 mOffset = 0;
+};
+
+typedef std::vector<LLDAEStreamInput> stream_input_list_t;
+
+struct LLDAEStreamPrimitive
+{
+	bool mPolylist = false;
+	std::string mMaterial;
+	stream_input_list_t mInputs;
+	std::vector<U32> mVCount;
+	std::vector<U32> mP;
+};
+
+// Raw arrays of one <geometry>, filled in by the parser and turned into
+// models by LLDAEStreamLoader::convertMesh()
+struct LLDAEStreamMesh
+{
+	std::string mGeometryId;
+	std::string mLabel;
+	bool mHasMesh = false;
+	bool mFailed = false;
+
+	std::map<std::string, std::vector<F32> > mSources;
+	std::map<std::string, stream_input_list_t> mVertices;
+	std::vector<LLDAEStreamPrimitive> mPrimitives;
+
+	// Results, owned by the loader once collected
+	std::vector<LLModel*> mModels;
+	LLSD mWarnings;
+};
+
+struct LLDAEStreamEffect
+{
+	std::string mLabel;
+	bool mHasDiffuse = false;
+	bool mHasTexture = false;
+	std::string mTexture;
+	bool mHasDiffuseColor = false;
+	LLColor4 mDiffuseColor;
+	LLColor4 mEmissionColor;
+	// <surface><init_from> values of every <newparam>
+	std::vector<std::vector<std::string> > mNewparams;
+};
+
+struct LLDAEStreamInstance
+{
+	LLMatrix4 mTransform;
+	std::string mUrl;
+	std::string mLabel;
+	// instance_material symbol/target pairs, in document order
+	std::vector<std::pair<std::string, std::string> > mBindings;
+};
+
+namespace
+{
+	// Mirrors the regex LLDAELoader::preprocessDAE() applies to quoted
+	// strings: values made of word characters and spaces get underscores
+	// instead of spaces.
+	std::string preprocess_value(const char* value)
+	{
+		std::string result(value);
+		bool has_space = false;
+		for (char& c : result)
+		{
+			unsigned char uc = (unsigned char)c;
+			if (isspace(uc))
+			{
+				has_space = true;
+			}
+			else if (!isalnum(uc) && !strchr("_.@#$-", c))
+			{
+				return result;
+			}
+		}
+
+		if (has_space)
+		{
+			for (char& c : result)
+			{
+				if (c == ' ')
+				{
+					c = '_';
+				}
+			}
+		}
+		return result;
+	}
+
+	std::string strip_fragment(const std::string& url)
+	{
+		if (!url.empty() && url[0] == '#')
+		{
+			return url.substr(1);
+		}
+		return url;
+	}
+
+	void parse_floats(const std::string& text, F64* values, U32 count)
+	{
+		const char* s = text.c_str();
+		for (U32 i = 0; i < count; ++i)
+		{
+			char* end = NULL;
+			values[i] = strtod(s, &end);
+			if (end == s)
+			{
+				// Short array, zero fill the rest
+				for (; i < count; ++i)
+				{
+					values[i] = 0.0;
+				}
+				break;
+			}
+			s = end;
+		}
+	}
+
+	LLColor4 parse_color(const std::string& text)
+	{
+		F64 v[4];
+		parse_floats(text, v, 4);
+		return LLColor4(v[0], v[1], v[2], v[3]);
+	}
+
+	// Counts <mesh> elements without parsing, the submodel limit has to be
+	// known before the first mesh gets converted
+	S32 count_mesh_elements(const std::string& filename)
+	{
+		LLFILE* fp = LLFile::fopen(filename, "rb");
+		if (!fp)
+		{
+			return 0;
+		}
+
+		static const char tag[] = "<mesh";
+		const size_t tag_len = sizeof(tag) - 1;
+
+		S32 count = 0;
+		std::vector<char> buffer(STREAM_CHUNK_SIZE + tag_len);
+		size_t carry = 0;
+		size_t read = 0;
+		while ((read = fread(buffer.data() + carry, 1, STREAM_CHUNK_SIZE, fp)) > 0)
+		{
+			size_t len = carry + read;
+			size_t i = 0;
+			for (; i + tag_len < len; ++i)
+			{
+				if (buffer[i] == '<' && !strncmp(&buffer[i], tag, tag_len))
+				{
+					char next = buffer[i + tag_len];
+					if (next == '>' || next == '/' || isspace((unsigned char)next))
+					{
+						++count;
+					}
+				}
+			}
+			carry = len - i;
+			memmove(buffer.data(), buffer.data() + i, carry);
+		}
+		LLFile::close(fp);
+		return count;
+	}
+
+	void add_stream_face(
+		std::vector<LLVolumeFace>& face_list,
+		std::vector<std::string>& materials,
+		const std::string& material,
+		LLVolumeFace& face,
+		std::vector<LLVolumeFace::VertexData>& verts,
+		std::vector<U16>& indices,
+		bool has_normals,
+		bool has_tc)
+	{
+		materials.push_back(material);
+		face_list.push_back(face);
+		face_list.rbegin()->fillFromLegacyData(verts, indices);
+		LLVolumeFace& new_face = *face_list.rbegin();
+		if (!has_normals)
+		{
+			new_face.mNormals = NULL;
+		}
+
+		if (!has_tc)
+		{
+			new_face.mTexCoords = NULL;
+		}
+	}
+
+	// Same lookup as get_dom_sources() in lldaeloader.cpp
+	bool get_stream_sources(const LLDAEStreamMesh& mesh, const stream_input_list_t& inputs,
+		S32& pos_offset, S32& tc_offset, S32& norm_offset, S32& idx_stride,
+		const std::vector<F32>*& pos_source, const std::vector<F32>*& tc_source, const std::vector<F32>*& norm_source)
+	{
+		idx_stride = 0;
+
+		auto find_source = [&mesh](const std::string& id) -> const std::vector<F32>*
+		{
+			auto it = mesh.mSources.find(id);
+			return it != mesh.mSources.end() ? &it->second : NULL;
+		};
+
+		for (const LLDAEStreamInput& input : inputs)
+		{
+			idx_stride = llmax(input.mOffset, idx_stride);
+
+			if (input.mSemantic == "VERTEX")
+			{ //found vertex array
+				auto vertices = mesh.mVertices.find(input.mSource);
+				if (vertices == mesh.mVertices.end())
+				{
+					return false;
+				}
+
+				for (const LLDAEStreamInput& v_inp : vertices->second)
+				{
+					if (v_inp.mSemantic == "POSITION")
+					{
+						pos_offset = input.mOffset;
+						pos_source = find_source(v_inp.mSource);
+					}
+
+					if (v_inp.mSemantic == "NORMAL")
+					{
+						norm_offset = input.mOffset;
+						norm_source = find_source(v_inp.mSource);
+					}
+				}
+			}
+
+			if (input.mSemantic == "NORMAL")
+			{
+				//found normal array for this triangle list
+				norm_offset = input.mOffset;
+				norm_source = find_source(input.mSource);
+			}
+			else if (input.mSemantic == "TEXCOORD")
+			{ //found texCoords
+				tc_offset = input.mOffset;
+				tc_source = find_source(input.mSource);
+			}
+		}
+
+		idx_stride += 1;
+
+		return true;
+	}
+
+	// Returns true when every index read from idx at the given offset
+	// points inside an array of stride sized elements
+	bool check_stream_indices(const std::vector<U32>& idx, S32 offset, S32 idx_stride, const std::vector<F32>* source, U32 stride)
+	{
+		if (!source)
+		{
+			return true;
+		}
+
+		size_t elements = source->size() / stride;
+		for (size_t i = offset; i < idx.size(); i += idx_stride)
+		{
+			if (idx[i] >= elements)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	LLModel::EModelStatus load_face_from_stream_triangles(
+		std::vector<LLVolumeFace>& face_list,
+		std::vector<std::string>& materials,
+		const LLDAEStreamMesh& mesh,
+		const LLDAEStreamPrimitive& tri,
+		LLSD& log_msg)
+	{
+		LLVolumeFace face;
+		std::vector<LLVolumeFace::VertexData> verts;
+		std::vector<U16> indices;
+
+		S32 pos_offset = -1;
+		S32 tc_offset = -1;
+		S32 norm_offset = -1;
+
+		const std::vector<F32>* pos_source = NULL;
+		const std::vector<F32>* tc_source = NULL;
+		const std::vector<F32>* norm_source = NULL;
+
+		S32 idx_stride = 0;
+
+		if (!get_stream_sources(mesh, tri.mInputs, pos_offset, tc_offset, norm_offset, idx_stride, pos_source, tc_source, norm_source))
+		{
+			LLSD args;
+			args["Message"] = "ParsingErrorBadElement";
+			log_msg.append(args);
+			return LLModel::BAD_ELEMENT;
+		}
+
+		if (!pos_source)
+		{
+			LL_WARNS() << "Unable to process mesh without position data; invalid model;  invalid model." << LL_ENDL;
+			LLSD args;
+			args["Message"] = "ParsingErrorPositionInvalidModel";
+			log_msg.append(args);
+			return LLModel::BAD_ELEMENT;
+		}
+
+		const std::vector<U32>& idx = tri.mP;
+		const std::vector<F32>& v = *pos_source;
+
+		if (v.size() < 3)
+		{
+			return LLModel::BAD_ELEMENT;
+		}
+
+		// VFExtents change
+		face.mExtents[0].set(v[0], v[1], v[2]);
+		face.mExtents[1].set(v[0], v[1], v[2]);
+
+		if (idx_stride <= 0
+			|| pos_offset >= idx_stride
+			|| (tc_source && tc_offset >= idx_stride)
+			|| (norm_source && norm_offset >= idx_stride))
+		{
+			LL_WARNS() << "Invalid pos_offset " << pos_offset << ", tc_offset " << tc_offset << " or norm_offset " << norm_offset << LL_ENDL;
+			return LLModel::BAD_ELEMENT;
+		}
+
+		// The DOM loader trusts indices blindly, don't read past the arrays
+		// of broken files
+		U32 idx_count = idx.size() - idx.size() % idx_stride;
+		if (!check_stream_indices(idx, pos_offset, idx_stride, pos_source, 3)
+			|| !check_stream_indices(idx, tc_offset, idx_stride, tc_source, 2)
+			|| !check_stream_indices(idx, norm_offset, idx_stride, norm_source, 3))
+		{
+			LL_WARNS() << "Index out of range in " << mesh.mLabel << LL_ENDL;
+			LLSD args;
+			args["Message"] = "ParsingErrorBadElement";
+			log_msg.append(args);
+			return LLModel::BAD_ELEMENT;
+		}
+
+		LLVolumeFace::VertexMapData::PointMap point_map;
+
+		for (U32 i = 0; i < idx_count; i += idx_stride)
+		{
+			LLVolumeFace::VertexData cv;
+			cv.setPosition(LLVector4a(v[idx[i+pos_offset]*3+0],
+								v[idx[i+pos_offset]*3+1],
+								v[idx[i+pos_offset]*3+2]));
+
+			if (tc_source)
+			{
+				const std::vector<F32>& tc = *tc_source;
+				cv.mTexCoord.setVec(tc[idx[i+tc_offset]*2+0],
+									tc[idx[i+tc_offset]*2+1]);
+			}
+
+			if (norm_source)
+			{
+				const std::vector<F32>& n = *norm_source;
+				cv.setNormal(LLVector4a(n[idx[i+norm_offset]*3+0],
+									n[idx[i+norm_offset]*3+1],
+									n[idx[i+norm_offset]*3+2]));
+			}
+
+			bool found = false;
+
+			LLVolumeFace::VertexMapData::PointMap::iterator point_iter;
+			point_iter = point_map.find(LLVector3(cv.getPosition().getF32ptr()));
+
+			if (point_iter != point_map.end())
+			{
+				for (U32 j = 0; j < point_iter->second.size(); ++j)
+				{
+					// We have a matching loc
+					//
+					if ((point_iter->second)[j] == cv)
+					{
+						U16 shared_index	= (point_iter->second)[j].mIndex;
+
+						// Don't share verts within the same tri, degenerate
+						//
+						U32 indx_size = indices.size();
+						U32 verts_new_tri = indx_size % 3;
+						if ((verts_new_tri < 1 || indices[indx_size - 1] != shared_index)
+							&& (verts_new_tri < 2 || indices[indx_size - 2] != shared_index))
+						{
+							found = true;
+							indices.push_back(shared_index);
+						}
+						break;
+					}
+				}
+			}
+
+			if (!found)
+			{
+				// VFExtents change
+				update_min_max(face.mExtents[0], face.mExtents[1], cv.getPosition());
+				verts.push_back(cv);
+				if (verts.size() >= 65535)
+				{
+					return LLModel::VERTEX_NUMBER_OVERFLOW ;
+				}
+				U16 index = (U16) (verts.size()-1);
+				indices.push_back(index);
+
+				LLVolumeFace::VertexMapData d;
+				d.setPosition(cv.getPosition());
+				d.mTexCoord = cv.mTexCoord;
+				d.setNormal(cv.getNormal());
+				d.mIndex = index;
+				if (point_iter != point_map.end())
+				{
+					point_iter->second.push_back(d);
+				}
+				else
+				{
+					point_map[LLVector3(d.getPosition().getF32ptr())].push_back(d);
+				}
+			}
+
+			if (indices.size()%3 == 0 && verts.size() >= 65532)
+			{
+				add_stream_face(face_list, materials, tri.mMaterial, face, verts, indices, norm_source != NULL, tc_source != NULL);
+
+				face = LLVolumeFace();
+				// VFExtents change
+				face.mExtents[0].set(v[0], v[1], v[2]);
+				face.mExtents[1].set(v[0], v[1], v[2]);
+
+				verts.clear();
+				indices.clear();
+				point_map.clear();
+			}
+		}
+
+		if (!verts.empty())
+		{
+			add_stream_face(face_list, materials, tri.mMaterial, face, verts, indices, norm_source != NULL, tc_source != NULL);
+		}
+
+		return LLModel::NO_ERRORS ;
+	}
+
+	LLModel::EModelStatus load_face_from_stream_polylist(
+		std::vector<LLVolumeFace>& face_list,
+		std::vector<std::string>& materials,
+		const LLDAEStreamMesh& mesh,
+		const LLDAEStreamPrimitive& poly,
+		LLSD& log_msg)
+	{
+		const std::vector<U32>& idx = poly.mP;
+
+		if (idx.empty())
+		{
+			return LLModel::NO_ERRORS ;
+		}
+
+		const std::vector<U32>& vcount = poly.mVCount;
+
+		S32 pos_offset = -1;
+		S32 tc_offset = -1;
+		S32 norm_offset = -1;
+
+		const std::vector<F32>* pos_source = NULL;
+		const std::vector<F32>* tc_source = NULL;
+		const std::vector<F32>* norm_source = NULL;
+
+		S32 idx_stride = 0;
+
+		if (!get_stream_sources(mesh, poly.mInputs, pos_offset, tc_offset, norm_offset, idx_stride, pos_source, tc_source, norm_source))
+		{
+			LL_WARNS() << "Bad element." << LL_ENDL;
+			LLSD args;
+			args["Message"] = "ParsingErrorBadElement";
+			log_msg.append(args);
+			return LLModel::BAD_ELEMENT;
+		}
+
+		// Vertices referenced by vcount have to fit in p, and positions
+		// and normals have to fit in their arrays
+		U64 total_verts = 0;
+		for (U32 count : vcount)
+		{
+			total_verts += count;
+		}
+		if ((pos_source && pos_source->size() < 3)
+			|| total_verts * idx_stride > idx.size()
+			|| (pos_source && pos_offset >= idx_stride)
+			|| (norm_source && norm_offset >= idx_stride)
+			|| (tc_source && tc_offset >= idx_stride)
+			|| !check_stream_indices(idx, pos_offset, idx_stride, pos_source, 3)
+			|| !check_stream_indices(idx, norm_offset, idx_stride, norm_source, 3))
+		{
+			LL_WARNS() << "Index out of range in " << mesh.mLabel << LL_ENDL;
+			LLSD args;
+			args["Message"] = "ParsingErrorBadElement";
+			log_msg.append(args);
+			return LLModel::BAD_ELEMENT;
+		}
+
+		LLVolumeFace face;
+
+		std::vector<U16> indices;
+		std::vector<LLVolumeFace::VertexData> verts;
+
+		static const std::vector<F32> empty;
+		const std::vector<F32>& v = pos_source ? *pos_source : empty;
+		const std::vector<F32>& tc = tc_source ? *tc_source : empty;
+		const std::vector<F32>& n = norm_source ? *norm_source : empty;
+
+		if (pos_source)
+		{
+			// VFExtents change
+			face.mExtents[0].set(v[0], v[1], v[2]);
+			face.mExtents[1].set(v[0], v[1], v[2]);
+		}
+
+		LLVolumeFace::VertexMapData::PointMap point_map;
+
+		U32 cur_idx = 0;
+		bool log_tc_msg = true;
+		for (U32 i = 0; i < vcount.size(); ++i)
+		{ //for each polygon
+			U32 first_index = 0;
+			U32 last_index = 0;
+			for (U32 j = 0; j < vcount[i]; ++j)
+			{ //for each vertex
+
+				LLVolumeFace::VertexData cv;
+
+				if (pos_source)
+				{
+					cv.getPosition().set(v[idx[cur_idx+pos_offset]*3+0],
+										v[idx[cur_idx+pos_offset]*3+1],
+										v[idx[cur_idx+pos_offset]*3+2]);
+					if (!cv.getPosition().isFinite3())
+					{
+						LL_WARNS() << "Found NaN while loading position data from DAE-Model, invalid model." << LL_ENDL;
+						LLSD args;
+						args["Message"] = "PositionNaN";
+						log_msg.append(args);
+						return LLModel::BAD_ELEMENT;
+					}
+				}
+
+				if (tc_source)
+				{
+					U64 idx_x = idx[cur_idx + tc_offset] * 2 + 0;
+					U64 idx_y = idx[cur_idx + tc_offset] * 2 + 1;
+
+					if (idx_y < tc.size())
+					{
+						cv.mTexCoord.setVec(tc[idx_x], tc[idx_y]);
+					}
+					else if (log_tc_msg)
+					{
+						log_tc_msg = false;
+						LL_WARNS() << "Texture coordinates data is not complete." << LL_ENDL;
+						LLSD args;
+						args["Message"] = "IncompleteTC";
+						log_msg.append(args);
+					}
+				}
+
+				if (norm_source)
+				{
+					cv.getNormal().set(n[idx[cur_idx+norm_offset]*3+0],
+										n[idx[cur_idx+norm_offset]*3+1],
+										n[idx[cur_idx+norm_offset]*3+2]);
+
+					if (!cv.getNormal().isFinite3())
+					{
+						LL_WARNS() << "Found NaN while loading normals from DAE-Model, invalid model." << LL_ENDL;
+						LLSD args;
+						args["Message"] = "NormalsNaN";
+						log_msg.append(args);
+
+						return LLModel::BAD_ELEMENT;
+					}
+				}
+
+				cur_idx += idx_stride;
+
+				bool found = false;
+
+				LLVolumeFace::VertexMapData::PointMap::iterator point_iter;
+				LLVector3 pos3(cv.getPosition().getF32ptr());
+				point_iter = point_map.find(pos3);
+
+				if (point_iter != point_map.end())
+				{
+					for (U32 k = 0; k < point_iter->second.size(); ++k)
+					{
+						if ((point_iter->second)[k] == cv)
+						{
+							found = true;
+							U32 index = (point_iter->second)[k].mIndex;
+							if (j == 0)
+							{
+								first_index = index;
+							}
+							else if (j == 1)
+							{
+								last_index = index;
+							}
+							else
+							{
+								// if these are the same, we have a very, very skinny triangle (coincident verts on one or more edges)
+								//
+								llassert((first_index != last_index) && (last_index != index) && (first_index != index));
+								indices.push_back(first_index);
+								indices.push_back(last_index);
+								indices.push_back(index);
+								last_index = index;
+							}
+
+							break;
+						}
+					}
+				}
+
+				if (!found)
+				{
+					// VFExtents change
+					update_min_max(face.mExtents[0], face.mExtents[1], cv.getPosition());
+					verts.push_back(cv);
+					if (verts.size() >= 65535)
+					{
+						return LLModel::VERTEX_NUMBER_OVERFLOW ;
+					}
+					U16 index = (U16) (verts.size()-1);
+
+					if (j == 0)
+					{
+						first_index = index;
+					}
+					else if (j == 1)
+					{
+						last_index = index;
+					}
+					else
+					{
+						// detect very skinny degenerate triangles with collapsed edges
+						//
+						llassert((first_index != last_index) && (last_index != index) && (first_index != index));
+						indices.push_back(first_index);
+						indices.push_back(last_index);
+						indices.push_back(index);
+						last_index = index;
+					}
+
+					LLVolumeFace::VertexMapData d;
+					d.setPosition(cv.getPosition());
+					d.mTexCoord = cv.mTexCoord;
+					d.setNormal(cv.getNormal());
+					d.mIndex = index;
+					if (point_iter != point_map.end())
+					{
+						point_iter->second.push_back(d);
+					}
+					else
+					{
+						point_map[pos3].push_back(d);
+					}
+				}
+
+				if (indices.size()%3 == 0 && indices.size() >= 65532)
+				{
+					add_stream_face(face_list, materials, poly.mMaterial, face, verts, indices, norm_source != NULL, tc_source != NULL);
+
+					face = LLVolumeFace();
+					if (pos_source)
+					{
+						// VFExtents change
+						face.mExtents[0].set(v[0], v[1], v[2]);
+						face.mExtents[1].set(v[0], v[1], v[2]);
+					}
+					verts.clear();
+					indices.clear();
+					point_map.clear();
+				}
+			}
+		}
+
+		if (!verts.empty())
+		{
+			add_stream_face(face_list, materials, poly.mMaterial, face, verts, indices, norm_source != NULL, tc_source != NULL);
+		}
+
+		return LLModel::NO_ERRORS ;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLDAEStreamParser
+//-----------------------------------------------------------------------------
+
+// expat handler collecting what LLDAEStreamLoader needs out of a COLLADA
+// document. Geometries are handed to the loader as soon as they are complete,
+// everything else is small and kept until the end of the file.
+class LLDAEStreamParser : public LLXmlParser
+{
+public:
+	LLDAEStreamParser(LLDAEStreamLoader* loader, bool preprocess);
+
+	// Returns false on I/O and XML errors
+	bool parseStream(const std::string& filename);
+
+	bool mFallback;
+	std::string mFallbackReason;
+	bool mAborted;
+
+	bool mHasScene;
+	std::set<std::string> mGeometries;
+	std::map<std::string, LLDAEStreamEffect> mEffects;
+	std::map<std::string, std::string> mMaterials;	// material id -> effect id
+	std::map<std::string, std::string> mImages;		// image id -> init_from
+	std::vector<LLDAEStreamInstance> mInstances;
+
+protected:
+	virtual void startElement(const char* name, const char** atts);
+	virtual void endElement(const char* name);
+	virtual void characterData(const char* s, int len);
+
+private:
+	enum EText
+	{
+		TEXT_NONE,
+		TEXT_FLOATS,
+		TEXT_UINTS,
+		TEXT_STRING
+	};
+
+	struct Frame
+	{
+		std::string mElement;
+		std::string mName;
+		std::string mId;
+		U32 mIndex;
+		U32 mChildren;
+	};
+
+	const char* getAttribute(const char** atts, const char* name) const;
+	bool parentIs(const char* name) const;
+	std::string getLabel(size_t level) const;
+
+	void fallback(const std::string& reason);
+	void flushToken();
+	void beginScene();
+	void applyTransform(const std::string& element);
+
+	LLDAEStreamLoader* mLoader;
+	bool mPreprocess;
+
+	std::vector<Frame> mStack;
+
+	EText mTextMode;
+	std::string mText;
+	std::string mToken;
+	std::vector<F32>* mFloatTarget;
+	std::vector<U32>* mUIntTarget;
+
+	// <asset>
+	bool mHasUnit;
+	F32 mMeter;
+	bool mHasUpAxis;
+	std::string mUpAxis;
+
+	// <library_geometries>
+	std::shared_ptr<LLDAEStreamMesh> mMesh;
+	std::string mSourceId;
+	stream_input_list_t* mVertexInputs;
+
+	// <library_effects>, <library_materials>, <library_images>
+	LLDAEStreamEffect* mEffect;
+	bool mInProfile;
+	bool mInDiffuse;
+	bool mInEmission;
+	bool mHasEmission;
+	std::string mMaterialId;
+	std::string mImageId;
+
+	// <visual_scene>
+	bool mInScene;
+	LLMatrix4 mTransform;
+	std::vector<LLMatrix4> mSavedTransforms;
+	LLDAEStreamInstance* mInstance;
+	bool mInBinding;
+};
+
+LLDAEStreamParser::LLDAEStreamParser(LLDAEStreamLoader* loader, bool preprocess)
+:	mFallback(false),
+	mAborted(false),
+	mHasScene(false),
+	mLoader(loader),
+	mPreprocess(preprocess),
+	mTextMode(TEXT_NONE),
+	mFloatTarget(NULL),
+	mUIntTarget(NULL),
+	mHasUnit(false),
+	mMeter(1.f),
+	mHasUpAxis(false),
+	mVertexInputs(NULL),
+	mEffect(NULL),
+	mInProfile(false),
+	mInDiffuse(false),
+	mInEmission(false),
+	mHasEmission(false),
+	mInScene(false),
+	mInstance(NULL),
+	mInBinding(false)
+{
+}
+
+bool LLDAEStreamParser::parseStream(const std::string& filename)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (!fp)
+	{
+		LL_WARNS() << "Unable to open " << filename << LL_ENDL;
+		return false;
+	}
+
+	std::vector<char> buffer(STREAM_CHUNK_SIZE);
+	bool success = true;
+	while (true)
+	{
+		size_t read = fread(buffer.data(), 1, buffer.size(), fp);
+		bool last = read < buffer.size();
+		if (!parse(buffer.data(), (int)read, last))
+		{
+			// Stopping the parser from a handler also ends up here
+			if (!mFallback && !mAborted)
+			{
+				LL_WARNS() << "Error parsing " << filename << " at line " << getCurrentLineNumber()
+					<< ": " << getErrorString() << LL_ENDL;
+				success = false;
+			}
+			break;
+		}
+		if (last)
+		{
+			break;
+		}
+	}
+
+	LLFile::close(fp);
+	return success;
+}
+
+const char* LLDAEStreamParser::getAttribute(const char** atts, const char* name) const
+{
+	for (S32 i = 0; atts[i]; i += 2)
+	{
+		if (!strcmp(atts[i], name))
+		{
+			return atts[i + 1];
+		}
+	}
+	return NULL;
+}
+
+bool LLDAEStreamParser::parentIs(const char* name) const
+{
+	return mStack.size() > 1 && mStack[mStack.size() - 2].mElement == name;
+}
+
+// Same rules as LLDAELoader::getElementLabel()
+std::string LLDAEStreamParser::getLabel(size_t level) const
+{
+	const Frame& frame = mStack[level];
+	if (frame.mName.length())
+	{
+		return frame.mName;
+	}
+
+	if (frame.mId.length())
+	{
+		return frame.mId;
+	}
+
+	std::string index_string;
+	if (level > 0)
+	{
+		const Frame& parent = mStack[level - 1];
+
+		// retrieve index to distinguish items inside same parent
+		if (frame.mIndex > 0)
+		{
+			index_string = "_" + std::to_string(frame.mIndex);
+		}
+
+		// if parent has a name or ID, use it
+		std::string name = parent.mName;
+		if (!name.length())
+		{
+			name = parent.mId;
+		}
+
+		if (name.length())
+		{
+			// make sure that index won't mix up with pre-named lod extensions
+			size_t ext_pos = LLDAEStreamLoader::getSuffixPosition(name);
+
+			if (ext_pos == -1)
+			{
+				return name + index_string;
+			}
+			else
+			{
+				return name.insert(ext_pos, index_string);
+			}
+		}
+	}
+
+	return frame.mElement + index_string;
+}
+
+void LLDAEStreamParser::fallback(const std::string& reason)
+{
+	if (!mFallback)
+	{
+		mFallback = true;
+		mFallbackReason = reason;
+		XML_StopParser(mParser, XML_FALSE);
+	}
+}
+
+void LLDAEStreamParser::flushToken()
+{
+	if (mToken.empty())
+	{
+		return;
+	}
+
+	if (mTextMode == TEXT_FLOATS)
+	{
+		mFloatTarget->push_back((F32)strtod(mToken.c_str(), NULL));
+	}
+	else
+	{
+		mUIntTarget->push_back((U32)strtoul(mToken.c_str(), NULL, 10));
+	}
+	mToken.clear();
+}
+
+void LLDAEStreamParser::beginScene()
+{
+	// Same as the unit and up axis handling of LLDAELoader::OpenFile()
+	mTransform.setIdentity();
+
+	if (mHasUnit)
+	{
+		mTransform.mMatrix[0][0] = mMeter;
+		mTransform.mMatrix[1][1] = mMeter;
+		mTransform.mMatrix[2][2] = mMeter;
+	}
+
+	LLMatrix4 rotation;
+
+	if (mUpAxis == "X_UP")
+	{
+		rotation.initRotation(0.0f, 90.0f * DEG_TO_RAD, 0.0f);
+	}
+	else if (mUpAxis.empty() || mUpAxis == "Y_UP")
+	{
+		rotation.initRotation(90.0f * DEG_TO_RAD, 0.0f, 0.0f);
+	}
+
+	rotation *= mTransform;
+	mTransform = rotation;
+
+	mTransform.condition();
+}
+
+// Same as the transform handling of LLDAELoader::processElement()
+void LLDAEStreamParser::applyTransform(const std::string& element)
+{
+	if (element == "translate")
+	{
+		F64 value[3];
+		parse_floats(mText, value, 3);
+
+		LLMatrix4 translation;
+		translation.setTranslation(LLVector3(value[0], value[1], value[2]));
+
+		translation *= mTransform;
+		mTransform = translation;
+		mTransform.condition();
+	}
+	else if (element == "rotate")
+	{
+		F64 value[4];
+		parse_floats(mText, value, 4);
+
+		LLMatrix4 rotation;
+		rotation.initRotTrans(value[3] * DEG_TO_RAD, LLVector3(value[0], value[1], value[2]), LLVector3(0, 0, 0));
+
+		rotation *= mTransform;
+		mTransform = rotation;
+		mTransform.condition();
+	}
+	else if (element == "scale")
+	{
+		F64 value[3];
+		parse_floats(mText, value, 3);
+
+		LLVector3 scale_vector = LLVector3(value[0], value[1], value[2]);
+		scale_vector.abs(); // Set all values positive, since we don't currently support mirrored meshes
+		LLMatrix4 scaling;
+		scaling.initScale(scale_vector);
+
+		scaling *= mTransform;
+		mTransform = scaling;
+		mTransform.condition();
+	}
+	else if (element == "matrix")
+	{
+		F64 value[16];
+		parse_floats(mText, value, 16);
+
+		LLMatrix4 matrix_transform;
+
+		for (int i = 0; i < 4; i++)
+		{
+			for(int j = 0; j < 4; j++)
+			{
+				matrix_transform.mMatrix[i][j] = value[i + j*4];
+			}
+		}
+
+		matrix_transform *= mTransform;
+		mTransform = matrix_transform;
+		mTransform.condition();
+	}
+}
+
+void LLDAEStreamParser::startElement(const char* name, const char** atts)
+{
+	if (mFallback || mAborted)
+	{
+		return;
+	}
+
+	Frame frame;
+	frame.mElement = name;
+	frame.mIndex = 0;
+	frame.mChildren = 0;
+	if (!mStack.empty())
+	{
+		frame.mIndex = mStack.back().mChildren++;
+	}
+
+	// <mesh> has neither name nor id in the schema, ColladaDOM drops them
+	if (frame.mElement != "mesh")
+	{
+		const char* att = getAttribute(atts, "name");
+		if (att)
+		{
+			frame.mName = mPreprocess ? preprocess_value(att) : att;
+		}
+		att = getAttribute(atts, "id");
+		if (att)
+		{
+			frame.mId = mPreprocess ? preprocess_value(att) : att;
+		}
+	}
+	mStack.push_back(frame);
+
+	auto get_ref = [this, atts](const char* att_name) -> std::string
+	{
+		const char* att = getAttribute(atts, att_name);
+		if (!att)
+		{
+			return std::string();
+		}
+		return strip_fragment(mPreprocess ? preprocess_value(att) : std::string(att));
+	};
+
+	const std::string& element = frame.mElement;
+
+	// Features only LLDAELoader handles
+	if (element == "controller" || element == "skin" || element == "instance_controller")
+	{
+		fallback("skinned mesh");
+		return;
+	}
+	if (element == "instance_node")
+	{
+		fallback("instance_node");
+		return;
+	}
+
+	// <asset>
+	if (element == "unit" && !mHasUnit)
+	{
+		if (mInScene)
+		{
+			fallback("late unit");
+			return;
+		}
+		mHasUnit = true;
+		const char* meter = getAttribute(atts, "meter");
+		mMeter = meter ? (F32)strtod(meter, NULL) : 1.f;
+		return;
+	}
+	if (element == "up_axis" && !mHasUpAxis)
+	{
+		if (mInScene)
+		{
+			fallback("late up_axis");
+			return;
+		}
+		mTextMode = TEXT_STRING;
+		mText.clear();
+		return;
+	}
+
+	// <library_geometries>
+	if (element == "geometry")
+	{
+		mMesh = std::make_shared<LLDAEStreamMesh>();
+		mMesh->mGeometryId = frame.mId;
+		mGeometries.insert(frame.mId);
+		return;
+	}
+
+	if (mMesh)
+	{
+		if (element == "mesh" && parentIs("geometry") && !mMesh->mHasMesh)
+		{
+			mMesh->mHasMesh = true;
+			mMesh->mLabel = getLabel(mStack.size() - 1);
+			size_t ext_pos = LLDAEStreamLoader::getSuffixPosition(mMesh->mLabel);
+			if (ext_pos != -1)
+			{
+				mMesh->mLabel = mMesh->mLabel.substr(0, ext_pos);
+			}
+		}
+		else if (element == "polygons" && parentIs("mesh"))
+		{
+			fallback("polygons");
+		}
+		else if (element == "source" && parentIs("mesh"))
+		{
+			mSourceId = frame.mId;
+		}
+		else if (element == "float_array" && parentIs("source"))
+		{
+			if (!mMesh->mSources.count(mSourceId))
+			{
+				mFloatTarget = &mMesh->mSources[mSourceId];
+				const char* count = getAttribute(atts, "count");
+				if (count)
+				{
+					mFloatTarget->reserve(strtoul(count, NULL, 10));
+				}
+				mTextMode = TEXT_FLOATS;
+			}
+		}
+		else if (element == "vertices" && parentIs("mesh"))
+		{
+			mVertexInputs = &mMesh->mVertices[frame.mId];
+		}
+		else if ((element == "triangles" || element == "polylist") && parentIs("mesh"))
+		{
+			mMesh->mPrimitives.emplace_back();
+			LLDAEStreamPrimitive& prim = mMesh->mPrimitives.back();
+			prim.mPolylist = element == "polylist";
+			const char* material = getAttribute(atts, "material");
+			if (material)
+			{
+				prim.mMaterial = mPreprocess ? preprocess_value(material) : material;
+			}
+		}
+		else if (element == "input")
+		{
+			LLDAEStreamInput input;
+			const char* semantic = getAttribute(atts, "semantic");
+			input.mSemantic = semantic ? semantic : "";
+			input.mSource = get_ref("source");
+			const char* offset = getAttribute(atts, "offset");
+			input.mOffset = offset ? atoi(offset) : 0;
+
+			if (parentIs("vertices") && mVertexInputs)
+			{
+				mVertexInputs->push_back(input);
+			}
+			else if ((parentIs("triangles") || parentIs("polylist")) && !mMesh->mPrimitives.empty())
+			{
+				mMesh->mPrimitives.back().mInputs.push_back(input);
+			}
+		}
+		else if (element == "p" && (parentIs("triangles") || parentIs("polylist")) && !mMesh->mPrimitives.empty())
+		{
+			mUIntTarget = &mMesh->mPrimitives.back().mP;
+			mTextMode = TEXT_UINTS;
+		}
+		else if (element == "vcount" && parentIs("polylist") && !mMesh->mPrimitives.empty())
+		{
+			mUIntTarget = &mMesh->mPrimitives.back().mVCount;
+			mTextMode = TEXT_UINTS;
+		}
+		return;
+	}
+
+	// <library_effects>
+	if (element == "effect")
+	{
+		mEffect = &mEffects[frame.mId];
+		return;
+	}
+
+	if (mEffect)
+	{
+		// Only the first profile_COMMON of an effect is used
+		if (element == "profile_COMMON" && parentIs("effect") && !mEffect->mLabel.length())
+		{
+			mInProfile = true;
+			mEffect->mLabel = getLabel(mStack.size() - 1);
+			return;
+		}
+
+		if (!mInProfile)
+		{
+			return;
+		}
+
+		if (element == "newparam" && parentIs("profile_COMMON"))
+		{
+			mEffect->mNewparams.emplace_back();
+		}
+		else if (element == "init_from" && parentIs("surface") && !mEffect->mNewparams.empty())
+		{
+			mTextMode = TEXT_STRING;
+			mText.clear();
+		}
+		else if (element == "diffuse" && !mEffect->mHasDiffuse)
+		{
+			mEffect->mHasDiffuse = true;
+			mInDiffuse = true;
+		}
+		else if (element == "emission" && !mHasEmission)
+		{
+			mHasEmission = true;
+			mInEmission = true;
+		}
+		else if (element == "texture" && mInDiffuse && !mEffect->mHasTexture)
+		{
+			mEffect->mHasTexture = true;
+			const char* texture = getAttribute(atts, "texture");
+			if (texture)
+			{
+				mEffect->mTexture = mPreprocess ? preprocess_value(texture) : texture;
+			}
+		}
+		else if (element == "color" && (mInDiffuse || mInEmission))
+		{
+			mTextMode = TEXT_STRING;
+			mText.clear();
+		}
+		return;
+	}
+
+	// <library_materials>
+	if (element == "material")
+	{
+		mMaterialId = frame.mId;
+		return;
+	}
+	if (element == "instance_effect" && mMaterialId.length() && !mMaterials.count(mMaterialId))
+	{
+		mMaterials[mMaterialId] = get_ref("url");
+		return;
+	}
+
+	// <library_images>
+	if (element == "image")
+	{
+		mImageId = frame.mId;
+		return;
+	}
+	if (element == "init_from" && parentIs("image") && mImageId.length())
+	{
+		mTextMode = TEXT_STRING;
+		mText.clear();
+		return;
+	}
+
+	// <library_visual_scenes>, LLDAELoader only looks at the first one
+	if (element == "visual_scene" && !mHasScene)
+	{
+		mHasScene = true;
+		mInScene = true;
+		beginScene();
+		return;
+	}
+
+	if (mInScene)
+	{
+		if (element == "node")
+		{
+			mSavedTransforms.push_back(mTransform);
+		}
+		else if (parentIs("node") && (element == "translate" || element == "rotate" || element == "scale" || element == "matrix"))
+		{
+			mTextMode = TEXT_STRING;
+			mText.clear();
+		}
+		else if (element == "instance_geometry")
+		{
+			std::string url = get_ref("url");
+			const char* raw_url = getAttribute(atts, "url");
+			if (raw_url && raw_url[0] != '#')
+			{
+				fallback("external geometry reference");
+				return;
+			}
+
+			mInstances.emplace_back();
+			mInstance = &mInstances.back();
+			mInstance->mTransform = mTransform;
+			mInstance->mUrl = url;
+			mInstance->mLabel = getLabel(mStack.size() - 1);
+		}
+		else if (mInstance && element == "technique_common" && parentIs("bind_material") && mInstance->mBindings.empty())
+		{
+			mInBinding = true;
+		}
+		else if (mInstance && mInBinding && element == "instance_material")
+		{
+			const char* symbol = getAttribute(atts, "symbol");
+			mInstance->mBindings.push_back(std::make_pair(
+				std::string(symbol ? (mPreprocess ? preprocess_value(symbol) : std::string(symbol)) : ""),
+				get_ref("target")));
+		}
+	}
+}
+
+void LLDAEStreamParser::endElement(const char* name)
+{
+	if (mFallback || mAborted)
+	{
+		return;
+	}
+
+	const std::string element = mStack.back().mElement;
+
+	switch (mTextMode)
+	{
+	case TEXT_FLOATS:
+	case TEXT_UINTS:
+		flushToken();
+		mTextMode = TEXT_NONE;
+		mFloatTarget = NULL;
+		mUIntTarget = NULL;
+		break;
+
+	case TEXT_STRING:
+		mTextMode = TEXT_NONE;
+		if (element == "up_axis")
+		{
+			mHasUpAxis = true;
+			LLStringUtil::trim(mText);
+			mUpAxis = mText;
+		}
+		else if (element == "init_from" && mEffect && !mEffect->mNewparams.empty())
+		{
+			LLStringUtil::trim(mText);
+			mEffect->mNewparams.back().push_back(mText);
+		}
+		else if (element == "init_from" && mImageId.length())
+		{
+			LLStringUtil::trim(mText);
+			if (!mImages.count(mImageId))
+			{
+				mImages[mImageId] = mText;
+			}
+		}
+		else if (element == "color" && mInDiffuse && !mEffect->mHasDiffuseColor)
+		{
+			mEffect->mHasDiffuseColor = true;
+			mEffect->mDiffuseColor = parse_color(mText);
+		}
+		else if (element == "color" && mInEmission)
+		{
+			mEffect->mEmissionColor = parse_color(mText);
+			mInEmission = false;
+		}
+		else if (mInScene)
+		{
+			applyTransform(element);
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (element == "geometry" && mMesh)
+	{
+		std::shared_ptr<LLDAEStreamMesh> mesh = mMesh;
+		mMesh.reset();
+		mVertexInputs = NULL;
+		if (mesh->mHasMesh && !mLoader->queueMesh(mesh))
+		{
+			mAborted = true;
+			XML_StopParser(mParser, XML_FALSE);
+		}
+	}
+	else if (element == "effect")
+	{
+		mEffect = NULL;
+		mInProfile = false;
+		mInDiffuse = false;
+		mInEmission = false;
+		mHasEmission = false;
+	}
+	else if (element == "profile_COMMON")
+	{
+		mInProfile = false;
+	}
+	else if (element == "diffuse")
+	{
+		mInDiffuse = false;
+	}
+	else if (element == "emission")
+	{
+		mInEmission = false;
+	}
+	else if (element == "material")
+	{
+		mMaterialId.clear();
+	}
+	else if (element == "image")
+	{
+		mImageId.clear();
+	}
+	else if (element == "visual_scene" && mInScene)
+	{
+		mInScene = false;
+	}
+	else if (element == "node" && mInScene && !mSavedTransforms.empty())
+	{
+		//this element was a node, restore transform before processing siblings
+		mTransform = mSavedTransforms.back();
+		mSavedTransforms.pop_back();
+	}
+	else if (element == "instance_geometry")
+	{
+		mInstance = NULL;
+		mInBinding = false;
+	}
+	else if (element == "technique_common")
+	{
+		mInBinding = false;
+	}
+
+	mStack.pop_back();
+}
+
+void LLDAEStreamParser::characterData(const char* s, int len)
+{
+	if (mTextMode == TEXT_STRING)
+	{
+		mText.append(s, len);
+		return;
+	}
+
+	if (mTextMode != TEXT_FLOATS && mTextMode != TEXT_UINTS)
+	{
+		return;
+	}
+
+	// Numbers are converted as they come in, only a token split between two
+	// chunks gets buffered
+	const char* end = s + len;
+	while (s < end)
+	{
+		if (isspace((unsigned char)*s))
+		{
+			flushToken();
+			++s;
+			continue;
+		}
+
+		const char* start = s;
+		while (s < end && !isspace((unsigned char)*s))
+		{
+			++s;
+		}
+
+		if (s < end && mToken.empty())
+		{
+			// Whole token followed by a space, strtod() stops there
+			if (mTextMode == TEXT_FLOATS)
+			{
+				mFloatTarget->push_back((F32)strtod(start, NULL));
+			}
+			else
+			{
+				mUIntTarget->push_back((U32)strtoul(start, NULL, 10));
+			}
+		}
+		else
+		{
+			mToken.append(start, s - start);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLDAEStreamLoader
+//-----------------------------------------------------------------------------
+
+LLDAEStreamLoader::LLDAEStreamLoader(
+	std::string				filename,
+	S32						lod,
+	load_callback_t			load_cb,
+	joint_lookup_func_t		joint_lookup_func,
+	texture_load_func_t		texture_load_func,
+	state_callback_t		state_cb,
+	void*					opaque_userdata,
+	JointTransformMap&		jointTransformMap,
+	JointNameSet&			jointsFromNodes,
+	std::map<std::string, std::string>&		jointAliasMap,
+	U32						maxJointsPerMesh,
+	U32						modelLimit,
+	bool					preprocess)
+: LLDAELoader(
+		filename,
+		lod,
+		load_cb,
+		joint_lookup_func,
+		texture_load_func,
+		state_cb,
+		opaque_userdata,
+		jointTransformMap,
+		jointsFromNodes,
+		jointAliasMap,
+		maxJointsPerMesh,
+		modelLimit,
+		preprocess),
+  mMaxPending(llmax((size_t)2, 2 * LL::ThreadPoolBase::getWidth("General", 3))),
+  mSubmodelLimit(0)
+{
+}
+
+LLDAEStreamLoader::~LLDAEStreamLoader()
+{
+	discardPendingMeshes();
+}
+
+bool LLDAEStreamLoader::OpenFile(const std::string& filename)
+{
+	setLoadState( READING_FILE );
+
+	LLSD saved_warnings = mWarningsArray;
+
+	size_t dir_pos = filename.find_last_of("/\\");
+	mFileDir = dir_pos != std::string::npos ? filename.substr(0, dir_pos + 1) : std::string();
+
+	S32 count = count_mesh_elements(filename);
+	mSubmodelLimit = count > 0 ? mGeneratedModelLimit/count : 0;
+
+	mParser.reset(new LLDAEStreamParser(this, mPreprocessDAE));
+	bool parsed = mParser->parseStream(filename);
+
+	mFallbackReason.clear();
+	if (!parsed || mParser->mFallback)
+	{
+		mFallbackReason = parsed ? mParser->mFallbackReason : std::string("parsing error");
+		LL_INFOS() << "Streaming import not possible (" << mFallbackReason
+			<< "), loading " << filename << " with ColladaDOM" << LL_ENDL;
+		discardPendingMeshes();
+		mParser.reset();
+		mStreamModels.clear();
+		mModelList.clear();
+		mWarningsArray = saved_warnings;
+		return LLDAELoader::OpenFile(filename);
+	}
+
+	while (!mParser->mAborted && !mPending.empty())
+	{
+		mParser->mAborted = !collectMesh();
+	}
+
+	if (mParser->mAborted)
+	{
+		// collectMesh() reported the bad model
+		discardPendingMeshes();
+		mParser.reset();
+		mStreamModels.clear();
+		return false;
+	}
+
+	sortModelList();
+
+	if (!mParser->mHasScene)
+	{
+		LL_WARNS() << "document has no visual_scene" << LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorNoScene";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+		mParser.reset();
+		mStreamModels.clear();
+		return true;
+	}
+
+	setLoadState( DONE );
+
+	bool badElement = false;
+
+	buildStreamScene(badElement);
+
+	if ( badElement )
+	{
+		LL_INFOS()<<"Scene could not be parsed"<<LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorCantParseScene";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+	}
+
+	mParser.reset();
+	mStreamModels.clear();
+
+	return true;
+}
+
+bool LLDAEStreamLoader::queueMesh(const std::shared_ptr<LLDAEStreamMesh>& mesh)
+{
+	// Keep the amount of raw arrays alive bounded
+	while (mPending.size() >= mMaxPending)
+	{
+		if (!collectMesh())
+		{
+			return false;
+		}
+	}
+
+	std::shared_ptr<std::promise<void> > done = std::make_shared<std::promise<void> >();
+
+	PendingMesh pending;
+	pending.mMesh = mesh;
+	pending.mDone = done->get_future();
+	mPending.push_back(std::move(pending));
+
+	const LLDAEStreamLoader* loader = this;
+	auto task = [loader, mesh, done]()
+	{
+		try
+		{
+			loader->convertMesh(*mesh);
+		}
+		catch (const std::exception& e)
+		{
+			LL_WARNS() << "Failed to convert " << mesh->mLabel << ": " << e.what() << LL_ENDL;
+			mesh->mFailed = true;
+		}
+		done->set_value();
+	};
+
+	LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
+	if (!general_queue || !general_queue->postIfOpen(task))
+	{
+		// No thread pool, convert it here
+		task();
+	}
+
+	return true;
+}
+
+bool LLDAEStreamLoader::collectMesh()
+{
+	PendingMesh pending = std::move(mPending.front());
+	mPending.pop_front();
+	pending.mDone.wait();
+
+	LLDAEStreamMesh& mesh = *pending.mMesh;
+
+	if (mesh.mWarnings.isArray())
+	{
+		for (LLSD::array_const_iterator it = mesh.mWarnings.beginArray(); it != mesh.mWarnings.endArray(); ++it)
+		{
+			mWarningsArray.append(*it);
+		}
+	}
+
+	// Take ownership of everything first so nothing leaks on errors
+	std::vector<LLPointer<LLModel> > models(mesh.mModels.begin(), mesh.mModels.end());
+	mesh.mModels.clear();
+
+	if (mesh.mFailed)
+	{
+		LLSD args;
+		args["Message"] = "ParsingErrorBadElement";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+		return false;
+	}
+
+	std::vector<LLPointer<LLModel> >& mesh_models = mStreamModels[mesh.mGeometryId];
+	for (LLPointer<LLModel>& mdl : models)
+	{
+		if (mdl->getStatus() != LLModel::NO_ERRORS)
+		{
+			// setLoadState() values >= ERROR_MODEL are reserved to
+			// report errors with the model itself.
+			setLoadState(ERROR_MODEL + eLoadState(mdl->getStatus()));
+			return false;
+		}
+
+		if (validate_model(mdl))
+		{
+			mModelList.push_back(mdl);
+			mesh_models.push_back(mdl);
+		}
+	}
+
+	return true;
+}
+
+void LLDAEStreamLoader::discardPendingMeshes()
+{
+	while (!mPending.empty())
+	{
+		PendingMesh& pending = mPending.front();
+		if (pending.mDone.valid())
+		{
+			pending.mDone.wait();
+		}
+
+		for (LLModel* mdl : pending.mMesh->mModels)
+		{
+			LLPointer<LLModel> release(mdl);
+		}
+		mPending.pop_front();
+	}
+}
+
+// Worker thread: only touches the mesh and read only loader settings
+void LLDAEStreamLoader::convertMesh(LLDAEStreamMesh& mesh) const
+{
+	LLVolumeParams volume_params;
+	volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+
+	LLModel* ret = new LLModel(volume_params, 0.f);
+
+	ret->ClearFacesAndMaterials();
+
+	// Same order as addVolumeFacesFromDomMesh(): triangles, then polylists
+	LLModel::EModelStatus status = LLModel::NO_ERRORS;
+	for (const LLDAEStreamPrimitive& prim : mesh.mPrimitives)
+	{
+		if (prim.mPolylist)
+		{
+			continue;
+		}
+
+		status = load_face_from_stream_triangles(ret->getVolumeFaces(), ret->getMaterialList(), mesh, prim, mesh.mWarnings);
+		ret->mStatus = status;
+		if (status != LLModel::NO_ERRORS)
+		{
+			ret->ClearFacesAndMaterials();
+			break;
+		}
+	}
+
+	if (status == LLModel::NO_ERRORS)
+	{
+		for (const LLDAEStreamPrimitive& prim : mesh.mPrimitives)
+		{
+			if (!prim.mPolylist)
+			{
+				continue;
+			}
+
+			status = load_face_from_stream_polylist(ret->getVolumeFaces(), ret->getMaterialList(), mesh, prim, mesh.mWarnings);
+			if (status != LLModel::NO_ERRORS)
+			{
+				ret->ClearFacesAndMaterials();
+				break;
+			}
+		}
+	}
+
+	// Raw arrays are no longer needed, free them before splitting
+	mesh.mSources.clear();
+	mesh.mVertices.clear();
+	mesh.mPrimitives.clear();
+
+	splitModel(ret, mesh.mLabel, mesh.mModels, mSubmodelLimit);
+}
+
+LLModelLoader::material_map LLDAEStreamLoader::getStreamMaterials(LLModel* model, const LLDAEStreamInstance& instance) const
+{
+	material_map materials;
+	for (size_t i = 0; i < model->mMaterialList.size(); i++)
+	{
+		LLImportMaterial import_material;
+
+		for (const std::pair<std::string, std::string>& binding : instance.mBindings)
+		{
+			if (binding.first == model->mMaterialList[i]) // found the binding
+			{
+				auto material = mParser->mMaterials.find(binding.second);
+				if (material != mParser->mMaterials.end())
+				{
+					auto effect = mParser->mEffects.find(material->second);
+					if (effect != mParser->mEffects.end() && effect->second.mLabel.length())
+					{
+						import_material = effectToMaterial(effect->second);
+					}
+				}
+				break;
+			}
+		}
+
+		import_material.mBinding = model->mMaterialList[i];
+		materials[model->mMaterialList[i]] = import_material;
+	}
+
+	return materials;
+}
+
+// Same rules as LLDAELoader::profileToMaterial()
+LLImportMaterial LLDAEStreamLoader::effectToMaterial(const LLDAEStreamEffect& effect) const
+{
+	LLImportMaterial mat;
+	mat.mFullbright = false;
+
+	auto image_path = [this](const std::string& image_id, std::string& path) -> bool
+	{
+		auto image = mParser->mImages.find(image_id);
+		if (image == mParser->mImages.end())
+		{
+			return false;
+		}
+
+		std::string uri = image->second;
+		if (uri.compare(0, 7, "file://") == 0)
+		{
+			uri = uri.substr(7);
+#if LL_WINDOWS
+			// file:///C:/dir/file.png
+			if (uri.length() > 2 && uri[0] == '/' && uri[2] == ':')
+			{
+				uri = uri.substr(1);
+			}
+#endif
+		}
+		path = LLURI::unescape(uri);
+
+		// Relative paths are relative to the document
+		bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.length() > 1 && path[1] == ':'));
+		if (!absolute)
+		{
+			path = mFileDir + path;
+		}
+		return true;
+	};
+
+	if (effect.mHasTexture)
+	{
+		if (effect.mNewparams.size())
+		{
+			for (size_t i = 0; i < effect.mNewparams.size(); i++)
+			{
+				const std::vector<std::string>& init_from = effect.mNewparams[i];
+				if (init_from.size() > i)
+				{
+					std::string path;
+					if (image_path(init_from[i], path))
+					{
+						mat.mDiffuseMapFilename = path;
+						mat.mDiffuseMapLabel = effect.mLabel;
+					}
+				}
+			}
+		}
+		else if (effect.mTexture.length())
+		{
+			std::string path;
+			if (image_path(effect.mTexture, path))
+			{
+				mat.mDiffuseMapFilename = path;
+				mat.mDiffuseMapLabel = effect.mLabel;
+			}
+		}
+	}
+
+	if (effect.mHasDiffuseColor)
+	{
+		mat.mDiffuseColor = effect.mDiffuseColor;
+	}
+
+	const LLColor4& emission_color = effect.mEmissionColor;
+	if (((emission_color[0] + emission_color[1] + emission_color[2]) / 3.0) > 0.25)
+	{
+		mat.mFullbright = true;
+	}
+
+	return mat;
+}
+
+void LLDAEStreamLoader::buildStreamScene(bool& badElement)
+{
+	for (const LLDAEStreamInstance& instance : mParser->mInstances)
+	{
+		if (!mParser->mGeometries.count(instance.mUrl))
+		{
+			LL_INFOS()<<"Unable to resolve geometry URL."<<LL_ENDL;
+			LLSD args;
+			args["Message"] = "CantResolveGeometryUrl";
+			mWarningsArray.append(args);
+			badElement = true;
+			continue;
+		}
+
+		mTransform = instance.mTransform;
+
+		std::vector<LLPointer<LLModel> >& models = mStreamModels[instance.mUrl];
+		for (LLModel* model : models)
+		{
+			LLModelLoader::material_map materials = getStreamMaterials(model, instance);
+
+			std::string lodless_label;
+			if (model->mLabel.empty())
+			{
+				lodless_label = instance.mLabel;
+				size_t ext_pos = getSuffixPosition(lodless_label);
+				if (ext_pos != -1)
+				{
+					lodless_label = lodless_label.substr(0, ext_pos);
+				}
+			}
+
+			addModelInstance(model, materials, instance.mLabel, lodless_label, badElement);
+		}
+	}
+}
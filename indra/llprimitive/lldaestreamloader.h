@@ -0,0 +1,111 @@
+/**
+ * @file lldaestreamloader.h
+ * @brief LLDAEStreamLoader class definition
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDAESTREAMLOADER_H
+#define LL_LLDAESTREAMLOADER_H
+
+#include "lldaeloader.h"
+
+#include <deque>
+#include <future>
+#include <memory>
+
+struct LLDAEStreamMesh;
+struct LLDAEStreamEffect;
+struct LLDAEStreamInstance;
+class LLDAEStreamParser;
+
+// Loads static (non rigged) COLLADA files without building a ColladaDOM
+// document. The file is read in chunks by an expat based parser, every
+// <geometry> is converted to LLModels on the "General" thread pool as soon
+// as its closing tag is seen, and its raw arrays are released once done.
+// Output matches LLDAELoader. Files using features the streaming parser
+// does not handle (controllers, instance_node, <polygons>) are
+// handed over to LLDAELoader::OpenFile().
+class LLDAEStreamLoader : public LLDAELoader
+{
+public:
+	LLDAEStreamLoader(
+		std::string							filename,
+		S32									lod,
+		LLModelLoader::load_callback_t		load_cb,
+		LLModelLoader::joint_lookup_func_t	joint_lookup_func,
+		LLModelLoader::texture_load_func_t	texture_load_func,
+		LLModelLoader::state_callback_t		state_cb,
+		void*								opaque_userdata,
+		JointTransformMap&					jointTransformMap,
+		JointNameSet&						jointsFromNodes,
+        std::map<std::string, std::string>& jointAliasMap,
+        U32									maxJointsPerMesh,
+		U32									modelLimit,
+        bool								preprocess);
+	virtual ~LLDAEStreamLoader();
+
+	virtual bool OpenFile(const std::string& filename);
+
+	// Why the last OpenFile() handed the file over to LLDAELoader,
+	// empty if it was streamed
+	const std::string& getFallbackReason() const { return mFallbackReason; }
+
+protected:
+	friend class LLDAEStreamParser;
+
+	// Called by the parser for every completed <geometry>, returns false
+	// if a previously queued mesh turned out to be invalid
+	bool queueMesh(const std::shared_ptr<LLDAEStreamMesh>& mesh);
+
+	// Waits for the oldest queued conversion and moves its models
+	// to mModelList, returns false if the model is invalid
+	bool collectMesh();
+
+	// Waits for all queued conversions and drops their results
+	void discardPendingMeshes();
+
+	// Worker side: builds models out of the raw arrays of a mesh
+	void convertMesh(LLDAEStreamMesh& mesh) const;
+
+	LLModelLoader::material_map getStreamMaterials(LLModel* model, const LLDAEStreamInstance& instance) const;
+	LLImportMaterial effectToMaterial(const LLDAEStreamEffect& effect) const;
+
+	void buildStreamScene(bool& badElement);
+
+private:
+	struct PendingMesh
+	{
+		std::shared_ptr<LLDAEStreamMesh> mMesh;
+		std::future<void> mDone;
+	};
+
+	std::unique_ptr<LLDAEStreamParser> mParser;
+	std::deque<PendingMesh> mPending;
+	size_t mMaxPending;
+	U32 mSubmodelLimit;
+	std::map<std::string, std::vector<LLPointer<LLModel> > > mStreamModels;
+	std::string mFileDir;
+	std::string mFallbackReason;
+};
+
+#endif  // LL_LLDAESTREAMLOADER_H
@@ -0,0 +1,1225 @@
+/**
+ * @file llglbloader.cpp
+ * @brief LLGLBLoader class implementation
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llglbloader.h"
+
+#include "lljoint.h"
+#include "llfile.h"
+#include "llmodel.h"
+#include "llsdjson.h"
+#include "lluri.h"
+
+#include "reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const U32 GLB_MAGIC = 0x46546C67;		// "glTF"
+static const U32 GLB_VERSION = 2;
+static const U32 GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+static const U32 GLB_CHUNK_BIN = 0x004E4942;	// "BIN\0"
+
+// glTF accessor component types
+static const U32 GLTF_BYTE = 5120;
+static const U32 GLTF_UNSIGNED_BYTE = 5121;
+static const U32 GLTF_SHORT = 5122;
+static const U32 GLTF_UNSIGNED_SHORT = 5123;
+static const U32 GLTF_UNSIGNED_INT = 5125;
+static const U32 GLTF_FLOAT = 5126;
+
+static const S32 GLTF_MODE_TRIANGLES = 4;
+
+// Same face size limit the COLLADA loader splits at
+static const U32 GLB_MAX_FACE_VERTICES = 65532;
+
+// Guards against cyclic node hierarchies
+static const S32 GLB_MAX_NODE_DEPTH = 128;
+
+// A typed view of an accessor, pointing into the BIN chunk
+struct LLGLBAccessor
+{
+	const U8* mData = NULL;
+	U32 mCount = 0;
+	U32 mComponents = 0;
+	U32 mComponentType = 0;
+	U32 mStride = 0;
+	bool mNormalized = false;
+	// Tightly packed, aligned floats can be used in place
+	bool mPacked = false;
+
+	// Returns element i as floats, either in place or decoded into tmp
+	// which must hold mComponents values
+	const F32* get(U32 i, F32* tmp) const
+	{
+		if (mPacked)
+		{
+			return reinterpret_cast<const F32*>(mData) + i * mComponents;
+		}
+		decode(i, tmp);
+		return tmp;
+	}
+
+	U32 getIndex(U32 i) const
+	{
+		const U8* src = mData + i * mStride;
+		switch (mComponentType)
+		{
+		case GLTF_UNSIGNED_BYTE:
+			return *src;
+		case GLTF_UNSIGNED_SHORT:
+			{
+				U16 value;
+				memcpy(&value, src, sizeof(value));
+				return value;
+			}
+		default:
+			{
+				U32 value;
+				memcpy(&value, src, sizeof(value));
+				return value;
+			}
+		}
+	}
+
+	void decode(U32 i, F32* out) const
+	{
+		const U8* src = mData + i * mStride;
+		for (U32 c = 0; c < mComponents; ++c)
+		{
+			switch (mComponentType)
+			{
+			case GLTF_FLOAT:
+				memcpy(&out[c], src + c * 4, 4);
+				break;
+			case GLTF_BYTE:
+				{
+					F32 value = (F32) reinterpret_cast<const S8*>(src)[c];
+					out[c] = mNormalized ? llmax(value / 127.f, -1.f) : value;
+				}
+				break;
+			case GLTF_UNSIGNED_BYTE:
+				{
+					F32 value = (F32) src[c];
+					out[c] = mNormalized ? value / 255.f : value;
+				}
+				break;
+			case GLTF_SHORT:
+				{
+					S16 value;
+					memcpy(&value, src + c * 2, 2);
+					out[c] = mNormalized ? llmax((F32) value / 32767.f, -1.f) : (F32) value;
+				}
+				break;
+			case GLTF_UNSIGNED_SHORT:
+				{
+					U16 value;
+					memcpy(&value, src + c * 2, 2);
+					out[c] = mNormalized ? (F32) value / 65535.f : (F32) value;
+				}
+				break;
+			default:
+				{
+					U32 value;
+					memcpy(&value, src + c * 4, 4);
+					out[c] = (F32) value;
+				}
+				break;
+			}
+		}
+	}
+};
+
+namespace
+{
+	U32 read_u32(const U8* src)
+	{
+		// GLB is little endian, as are all supported platforms
+		U32 value;
+		memcpy(&value, src, sizeof(value));
+		return value;
+	}
+
+	U32 component_size(U32 type)
+	{
+		switch (type)
+		{
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE:
+			return 1;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT:
+			return 2;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	U32 component_count(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		if (type == "MAT4") return 16;
+		return 0;
+	}
+
+	// glTF matrices are column major with column vectors, LLMatrix4 uses
+	// row vectors so the element order matches mMatrix directly
+	LLMatrix4 matrix_from_floats(const F32* m)
+	{
+		LLMatrix4 mat;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				mat.mMatrix[i][j] = m[i*4 + j];
+			}
+		}
+		return mat;
+	}
+
+	// Copies the given vertices of a primitive into a face, ids may be NULL
+	// to copy the first count vertices in order
+	void fill_face_vertices(LLVolumeFace& face, const LLGLBAccessor& pos, const LLGLBAccessor* norm, const LLGLBAccessor* tc,
+							const U32* ids, U32 count)
+	{
+		face.resizeVertices(count);
+
+		F32 tmp[4];
+		for (U32 i = 0; i < count; ++i)
+		{
+			U32 v = ids ? ids[i] : i;
+
+			const F32* p = pos.get(v, tmp);
+			face.mPositions[i].set(p[0], p[1], p[2]);
+
+			if (i == 0)
+			{
+				face.mExtents[0] = face.mPositions[0];
+				face.mExtents[1] = face.mPositions[0];
+			}
+			else
+			{
+				update_min_max(face.mExtents[0], face.mExtents[1], face.mPositions[i]);
+			}
+
+			if (norm)
+			{
+				const F32* n = norm->get(v, tmp);
+				face.mNormals[i].set(n[0], n[1], n[2]);
+			}
+
+			if (tc)
+			{
+				// glTF puts the texture origin at the top left
+				const F32* t = tc->get(v, tmp);
+				face.mTexCoords[i].set(t[0], 1.f - t[1]);
+			}
+		}
+
+		if (!norm)
+		{
+			face.mNormals = NULL;
+		}
+
+		if (!tc)
+		{
+			face.mTexCoords = NULL;
+		}
+	}
+}
+
+LLGLBLoader::LLGLBLoader(
+	std::string				filename,
+	S32						lod,
+	load_callback_t			load_cb,
+	joint_lookup_func_t		joint_lookup_func,
+	texture_load_func_t		texture_load_func,
+	state_callback_t		state_cb,
+	void*					opaque_userdata,
+	JointTransformMap&		jointTransformMap,
+	JointNameSet&			jointsFromNodes,
+	std::map<std::string, std::string>&		jointAliasMap,
+	U32						maxJointsPerMesh,
+	U32						modelLimit)
+: LLModelLoader(
+		filename,
+		lod,
+		load_cb,
+		joint_lookup_func,
+		texture_load_func,
+		state_cb,
+		opaque_userdata,
+		jointTransformMap,
+		jointsFromNodes,
+		jointAliasMap,
+		maxJointsPerMesh),
+  mGeneratedModelLimit(modelLimit),
+  mBin(NULL),
+  mBinSize(0)
+{
+}
+
+LLGLBLoader::~LLGLBLoader()
+{
+}
+
+// static
+bool LLGLBLoader::parseContainer(const U8* data, size_t size,
+								 const char*& json, size_t& json_size,
+								 const U8*& bin, size_t& bin_size)
+{
+	json = NULL;
+	json_size = 0;
+	bin = NULL;
+	bin_size = 0;
+
+	// 12 byte header followed by the JSON chunk header
+	if (!data || size < 20
+		|| read_u32(data) != GLB_MAGIC
+		|| read_u32(data + 4) != GLB_VERSION)
+	{
+		return false;
+	}
+
+	size_t length = llmin((size_t) read_u32(data + 8), size);
+
+	size_t offset = 12;
+	while (offset + 8 <= length)
+	{
+		size_t chunk_size = read_u32(data + offset);
+		U32 chunk_type = read_u32(data + offset + 4);
+		offset += 8;
+
+		if (chunk_size > length - offset)
+		{
+			return false;
+		}
+
+		if (chunk_type == GLB_CHUNK_JSON && !json)
+		{
+			json = reinterpret_cast<const char*>(data + offset);
+			json_size = chunk_size;
+		}
+		else if (chunk_type == GLB_CHUNK_BIN && json && !bin)
+		{
+			bin = data + offset;
+			bin_size = chunk_size;
+		}
+		// unknown chunks are skipped, chunks are 4 byte aligned
+		offset += (chunk_size + 3) & ~3;
+	}
+
+	return json != NULL;
+}
+
+bool LLGLBLoader::OpenFile(const std::string& filename)
+{
+	setLoadState( READING_FILE );
+
+	size_t dir_pos = filename.find_last_of("/\\");
+	mFileDir = dir_pos != std::string::npos ? filename.substr(0, dir_pos + 1) : std::string();
+
+	// Read the whole file, accessors point straight into this buffer
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (!fp)
+	{
+		LL_WARNS() << "Unable to open " << filename << LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorCorrupt";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	long file_size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if (file_size > 0)
+	{
+		mFileData.resize(file_size);
+		if (fread(&mFileData[0], 1, file_size, fp) != (size_t) file_size)
+		{
+			mFileData.clear();
+		}
+	}
+	fclose(fp);
+
+	const char* json = NULL;
+	size_t json_size = 0;
+	if (mFileData.empty()
+		|| !parseContainer(&mFileData[0], mFileData.size(), json, json_size, mBin, mBinSize))
+	{
+		LL_INFOS() << "Error with glb - not a glTF 2.0 binary file." << LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorGLBHeader";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+		return false;
+	}
+
+	Json::Value root;
+	Json::Reader reader;
+	if (!reader.parse(json, json + json_size, root, false) || !root.isObject())
+	{
+		LL_INFOS() << "Error with glb - can't parse JSON chunk: " << reader.getFormattedErrorMessages() << LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorGLBJson";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+		return false;
+	}
+	mJson = LlsdFromJson(root);
+
+	LL_INFOS() << "glTF version " << mJson["asset"]["version"].asString()
+		<< ", generator: " << mJson["asset"]["generator"].asString() << LL_ENDL;
+
+	// glTF is Y up, meters
+	mBaseTransform.initRotation(90.0f * DEG_TO_RAD, 0.0f, 0.0f);
+	mBaseTransform.condition();
+	mTransform = mBaseTransform;
+
+	const LLSD& meshes = mJson["meshes"];
+	S32 count = meshes.size();
+
+	U32 submodel_limit = count > 0 ? mGeneratedModelLimit/count : 0;
+	for (S32 idx = 0; idx < count; ++idx)
+	{ //build map of glTF meshes to LLModel
+		LLVolumeParams volume_params;
+		volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+
+		LLModel* ret = new LLModel(volume_params, 0.f);
+		ret->ClearFacesAndMaterials();
+
+		if (!loadMesh(meshes[idx], ret))
+		{
+			LLPointer<LLModel> discard = ret;
+			LL_INFOS() << "Could not load mesh " << idx << LL_ENDL;
+			LLSD args;
+			args["Message"] = "ParsingErrorBadElement";
+			mWarningsArray.append(args);
+			setLoadState( ERROR_PARSING );
+			return true;
+		}
+
+		std::string model_name = meshes[idx]["name"].asString();
+		if (model_name.empty())
+		{
+			model_name = llformat("mesh_%d", idx);
+		}
+
+		std::vector<LLModel*> models;
+		splitModel(ret, model_name, models, submodel_limit);
+
+		for (LLModel* mdl : models)
+		{
+			if (mdl->getStatus() != LLModel::NO_ERRORS)
+			{
+				// setLoadState() values >= ERROR_MODEL are reserved to
+				// report errors with the model itself.
+				setLoadState(ERROR_MODEL + eLoadState(mdl->getStatus())) ;
+				return false; //abort
+			}
+
+			if (validate_model(mdl))
+			{
+				mModelList.push_back(mdl);
+				mMeshModels[idx].push_back(mdl);
+			}
+		}
+	}
+
+	sortModelList();
+
+	// Skinned meshes ignore their node transform, one skin per mesh like
+	// one controller per geometry in COLLADA
+	const LLSD& nodes = mJson["nodes"];
+	for (S32 i = 0; i < (S32) nodes.size(); ++i)
+	{
+		const LLSD& node = nodes[i];
+		if (!node.has("mesh") || !node.has("skin"))
+		{
+			continue;
+		}
+
+		S32 mesh = node["mesh"].asInteger();
+		S32 skin = node["skin"].asInteger();
+		if (mesh < 0 || mesh >= count || skin < 0 || skin >= (S32) mJson["skins"].size()
+			|| mMeshSkins.find(mesh) != mMeshSkins.end())
+		{
+			continue;
+		}
+		mMeshSkins[mesh] = skin;
+
+		for (LLPointer<LLModel>& mdl : mMeshModels[mesh])
+		{
+			processSkin(mdl, meshes[mesh], mJson["skins"][skin]);
+		}
+	}
+
+	LL_INFOS() << "glTF skins processed: " << mMeshSkins.size() << LL_ENDL;
+
+	S32 scene_index = mJson.has("scene") ? mJson["scene"].asInteger() : 0;
+	const LLSD& scenes = mJson["scenes"];
+	if (scene_index < 0 || scene_index >= (S32) scenes.size())
+	{
+		LL_WARNS() << "document has no scene" << LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorNoScene";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+		return true;
+	}
+
+	setLoadState( DONE );
+
+	bool badElement = false;
+
+	const LLSD& roots = scenes[scene_index]["nodes"];
+	for (S32 i = 0; i < (S32) roots.size(); ++i)
+	{
+		processNode(roots[i].asInteger(), LLMatrix4(), badElement, 0);
+	}
+
+	if ( badElement )
+	{
+		LL_INFOS()<<"Scene could not be parsed"<<LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorCantParseScene";
+		mWarningsArray.append(args);
+		setLoadState( ERROR_PARSING );
+	}
+
+	// Models hold their own copies of everything now
+	mFileData.clear();
+	mFileData.shrink_to_fit();
+	mBin = NULL;
+	mBinSize = 0;
+
+	return true;
+}
+
+bool LLGLBLoader::getAccessor(S32 index, LLGLBAccessor& accessor) const
+{
+	const LLSD& accessors = mJson["accessors"];
+	if (index < 0 || index >= (S32) accessors.size())
+	{
+		return false;
+	}
+
+	const LLSD& acc = accessors[index];
+	if (acc.has("sparse") || !acc.has("bufferView"))
+	{
+		LL_WARNS() << "Unsupported sparse or empty accessor " << index << LL_ENDL;
+		return false;
+	}
+
+	const LLSD& views = mJson["bufferViews"];
+	S32 view_index = acc["bufferView"].asInteger();
+	if (view_index < 0 || view_index >= (S32) views.size())
+	{
+		return false;
+	}
+
+	const LLSD& view = views[view_index];
+	if (view["buffer"].asInteger() != 0 || !mBin)
+	{
+		LL_WARNS() << "Accessor " << index << " does not use the GLB binary chunk" << LL_ENDL;
+		return false;
+	}
+
+	accessor.mComponentType = acc["componentType"].asInteger();
+	accessor.mComponents = component_count(acc["type"].asString());
+	accessor.mCount = acc["count"].asInteger();
+	accessor.mNormalized = acc["normalized"].asBoolean();
+
+	U32 elem_size = component_size(accessor.mComponentType) * accessor.mComponents;
+	if (!elem_size || !accessor.mCount)
+	{
+		return false;
+	}
+
+	size_t view_offset = (size_t) view["byteOffset"].asInteger();
+	size_t view_length = (size_t) view["byteLength"].asInteger();
+	size_t offset = (size_t) acc["byteOffset"].asInteger();
+	accessor.mStride = view.has("byteStride") ? view["byteStride"].asInteger() : elem_size;
+
+	if (accessor.mStride < elem_size
+		|| view_offset > mBinSize || view_length > mBinSize - view_offset
+		|| offset > view_length
+		|| (size_t) accessor.mStride * (accessor.mCount - 1) + elem_size > view_length - offset)
+	{
+		LL_WARNS() << "Accessor " << index << " is out of bounds" << LL_ENDL;
+		return false;
+	}
+
+	accessor.mData = mBin + view_offset + offset;
+	accessor.mPacked = accessor.mComponentType == GLTF_FLOAT
+		&& accessor.mStride == elem_size
+		&& ((uintptr_t) accessor.mData & 3) == 0;
+
+	return true;
+}
+
+std::string LLGLBLoader::getMaterialName(S32 index) const
+{
+	if (index < 0 || index >= (S32) mJson["materials"].size())
+	{
+		return "default";
+	}
+
+	std::string name = mJson["materials"][index]["name"].asString();
+	if (name.empty())
+	{
+		name = llformat("material_%d", index);
+	}
+	return name;
+}
+
+bool LLGLBLoader::loadMesh(const LLSD& mesh, LLModel* model)
+{
+	const LLSD& primitives = mesh["primitives"];
+	for (S32 i = 0; i < (S32) primitives.size(); ++i)
+	{
+		if (!loadPrimitive(primitives[i], model))
+		{
+			model->ClearFacesAndMaterials();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LLGLBLoader::loadPrimitive(const LLSD& primitive, LLModel* model)
+{
+	S32 mode = primitive.has("mode") ? primitive["mode"].asInteger() : GLTF_MODE_TRIANGLES;
+	if (mode != GLTF_MODE_TRIANGLES)
+	{
+		LL_WARNS() << "Skipping unsupported primitive mode " << mode << LL_ENDL;
+		LLSD args;
+		args["Message"] = "GLBUnsupportedPrimitive";
+		args["MODE"] = mode;
+		mWarningsArray.append(args);
+		return true;
+	}
+
+	const LLSD& attributes = primitive["attributes"];
+
+	LLGLBAccessor pos;
+	if (!attributes.has("POSITION")
+		|| !getAccessor(attributes["POSITION"].asInteger(), pos)
+		|| pos.mComponents != 3)
+	{
+		LL_WARNS() << "Unable to process mesh without position data; invalid model." << LL_ENDL;
+		LLSD args;
+		args["Message"] = "ParsingErrorPositionInvalidModel";
+		mWarningsArray.append(args);
+		return false;
+	}
+
+	LLGLBAccessor norm;
+	bool has_norm = attributes.has("NORMAL");
+	if (has_norm && (!getAccessor(attributes["NORMAL"].asInteger(), norm)
+					 || norm.mComponents != 3 || norm.mCount < pos.mCount))
+	{
+		return false;
+	}
+
+	LLGLBAccessor tc;
+	bool has_tc = attributes.has("TEXCOORD_0");
+	if (has_tc && (!getAccessor(attributes["TEXCOORD_0"].asInteger(), tc)
+				   || tc.mComponents != 2 || tc.mCount < pos.mCount))
+	{
+		return false;
+	}
+
+	LLGLBAccessor idx;
+	bool indexed = primitive.has("indices");
+	if (indexed && (!getAccessor(primitive["indices"].asInteger(), idx)
+					|| idx.mComponents != 1
+					|| (idx.mComponentType != GLTF_UNSIGNED_BYTE
+						&& idx.mComponentType != GLTF_UNSIGNED_SHORT
+						&& idx.mComponentType != GLTF_UNSIGNED_INT)))
+	{
+		return false;
+	}
+
+	U32 index_count = indexed ? idx.mCount : pos.mCount;
+	index_count -= index_count % 3;
+	if (!index_count)
+	{
+		return true;
+	}
+
+	if (indexed)
+	{
+		for (U32 i = 0; i < index_count; ++i)
+		{
+			if (idx.getIndex(i) >= pos.mCount)
+			{
+				LL_WARNS() << "Index out of range in glTF primitive" << LL_ENDL;
+				return false;
+			}
+		}
+	}
+
+	const std::string material = getMaterialName(primitive.has("material") ? primitive["material"].asInteger() : -1);
+	const LLGLBAccessor* norm_ptr = has_norm ? &norm : NULL;
+	const LLGLBAccessor* tc_ptr = has_tc ? &tc : NULL;
+
+	std::vector<LLVolumeFace>& faces = model->getVolumeFaces();
+	std::vector<std::string>& materials = model->getMaterialList();
+
+	if (pos.mCount <= GLB_MAX_FACE_VERTICES)
+	{
+		// Fits in a single face, attributes and indices are copied as is
+		faces.push_back(LLVolumeFace());
+		materials.push_back(material);
+		LLVolumeFace& face = faces.back();
+
+		fill_face_vertices(face, pos, norm_ptr, tc_ptr, NULL, pos.mCount);
+
+		face.resizeIndices(index_count);
+		for (U32 i = 0; i < index_count; ++i)
+		{
+			face.mIndices[i] = (U16) (indexed ? idx.getIndex(i) : i);
+		}
+		return true;
+	}
+
+	// Too many vertices, split into faces of up to GLB_MAX_FACE_VERTICES
+	std::vector<S32> remap(pos.mCount, -1);
+	std::vector<U32> ids;
+	std::vector<U16> indices;
+
+	auto flush_face = [&]()
+	{
+		faces.push_back(LLVolumeFace());
+		materials.push_back(material);
+		LLVolumeFace& face = faces.back();
+
+		fill_face_vertices(face, pos, norm_ptr, tc_ptr, &ids[0], ids.size());
+
+		face.resizeIndices(indices.size());
+		memcpy(face.mIndices, &indices[0], indices.size() * sizeof(U16));
+
+		for (U32 id : ids)
+		{
+			remap[id] = -1;
+		}
+		ids.clear();
+		indices.clear();
+	};
+
+	for (U32 i = 0; i < index_count; i += 3)
+	{
+		U32 tri[3];
+		U32 new_verts = 0;
+		for (U32 k = 0; k < 3; ++k)
+		{
+			tri[k] = indexed ? idx.getIndex(i + k) : i + k;
+			if (remap[tri[k]] < 0 && (k == 0 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+			{
+				++new_verts;
+			}
+		}
+
+		if (ids.size() + new_verts > GLB_MAX_FACE_VERTICES)
+		{
+			flush_face();
+		}
+
+		for (U32 k = 0; k < 3; ++k)
+		{
+			if (remap[tri[k]] < 0)
+			{
+				remap[tri[k]] = ids.size();
+				ids.push_back(tri[k]);
+			}
+			indices.push_back((U16) remap[tri[k]]);
+		}
+	}
+
+	if (!ids.empty())
+	{
+		flush_face();
+	}
+
+	return true;
+}
+
+void LLGLBLoader::processSkin(LLModel* model, const LLSD& mesh, const LLSD& skin)
+{
+	llassert(model);
+
+	LLVector3 mesh_scale_vector;
+	LLVector3 mesh_translation_vector;
+	model->getNormalizedScaleTranslation(mesh_scale_vector, mesh_translation_vector);
+
+	LLMatrix4 normalized_transformation;
+	normalized_transformation.setTranslation(mesh_translation_vector);
+
+	LLMatrix4 mesh_scale;
+	mesh_scale.initScale(mesh_scale_vector);
+	mesh_scale *= normalized_transformation;
+	normalized_transformation = mesh_scale;
+
+	LLMatrix4 inverse_normalized_transformation = normalized_transformation;
+	inverse_normalized_transformation.invert();
+
+	LLMatrix4 inverse_base = mBaseTransform;
+	inverse_base.invert();
+
+	LLMeshSkinInfo& skin_info = model->mSkinInfo;
+
+	// Vertices are stored Y up, the bind shape matrix brings them into
+	// avatar space
+	LLMatrix4a trans(normalized_transformation);
+	LLMatrix4a base(mBaseTransform);
+	matMul(trans, base, skin_info.mBindShapeMatrix);
+
+	const LLSD& nodes = mJson["nodes"];
+	const LLSD& joints = skin["joints"];
+
+	LLGLBAccessor ibm;
+	bool has_ibm = skin.has("inverseBindMatrices")
+		&& getAccessor(skin["inverseBindMatrices"].asInteger(), ibm)
+		&& ibm.mComponents == 16
+		&& ibm.mCount >= joints.size();
+
+	for (S32 i = 0; i < (S32) joints.size(); ++i)
+	{
+		std::string name = nodes[joints[i].asInteger()]["name"].asString();
+		if (mJointMap.find(name) != mJointMap.end())
+		{
+			name = mJointMap[name];
+		}
+		skin_info.mJointNames.push_back(name);
+		skin_info.mJointNums.push_back(-1);
+
+		// Same change of basis as the vertices: avatar space to Y up,
+		// inverse bind, then back to avatar space
+		LLMatrix4 mat = inverse_base;
+		if (has_ibm)
+		{
+			F32 tmp[16];
+			mat *= matrix_from_floats(ibm.get(i, tmp));
+		}
+		mat *= mBaseTransform;
+		skin_info.mInvBindMatrix.push_back(LLMatrix4a(mat));
+	}
+
+	// Joint positions come from the local translation of every joint node
+	for (S32 i = 0; i < (S32) nodes.size(); ++i)
+	{
+		std::string name = nodes[i]["name"].asString();
+		if (!isNodeAJoint(name.c_str()))
+		{
+			continue;
+		}
+
+		LLVector3 translation = getNodeTransform(nodes[i]).getTranslation();
+		LLMatrix4 joint_transform;
+		joint_transform.setTranslation(translation * mBaseTransform);
+		mJointList[name] = joint_transform;
+
+		if (std::find(mJointsFromNode.begin(), mJointsFromNode.end(), name) == mJointsFromNode.end())
+		{
+			mJointsFromNode.push_front(name);
+		}
+	}
+
+	critiqueRigForUploadApplicability( skin_info.mJointNames );
+
+	// FIXME: see LLDAELoader::processDomModel(), conflicting joint
+	// offsets of multiple meshes may not preview correctly.
+	LLUUID fake_mesh_id;
+	fake_mesh_id.generate();
+
+	//Set the joint translations on the avatar
+	JointMap :: const_iterator masterJointIt = mJointMap.begin();
+	JointMap :: const_iterator masterJointItEnd = mJointMap.end();
+	for (;masterJointIt!=masterJointItEnd;++masterJointIt )
+	{
+		std::string lookingForJoint = (*masterJointIt).first.c_str();
+
+		if ( mJointList.find( lookingForJoint ) != mJointList.end() )
+		{
+			LLMatrix4 jointTransform = mJointList[lookingForJoint];
+			LLJoint* pJoint = mJointLookupFunc(lookingForJoint,mOpaqueData);
+			if ( pJoint )
+			{
+				const LLVector3& joint_pos = jointTransform.getTranslation();
+				if (pJoint->aboveJointPosThreshold(joint_pos))
+				{
+					bool override_changed; // not used
+					pJoint->addAttachmentPosOverride(joint_pos, fake_mesh_id, "", override_changed);
+					if (skin_info.mLockScaleIfJointPosition)
+					{
+						pJoint->addAttachmentScaleOverride(pJoint->getDefaultScale(), fake_mesh_id, "");
+					}
+				}
+			}
+			else
+			{
+				//Most likely an error in the asset.
+				LL_WARNS()<<"Tried to apply joint position from .glb, but it did not exist in the avatar rig." << LL_ENDL;
+			}
+		}
+	}
+
+	//Alternate bind matrices in the order of the joint buffer, see LLDAELoader::processDomModel()
+	const int jointCnt = skin_info.mJointNames.size();
+	for ( int i=0; i<jointCnt; ++i )
+	{
+		const std::string& lookingForJoint = skin_info.mJointNames[i];
+		if (mJointMap.find(lookingForJoint) != mJointMap.end()
+			&& skin_info.mInvBindMatrix.size() > i)
+		{
+			LLMatrix4 newInverse = LLMatrix4(skin_info.mInvBindMatrix[i].getF32ptr());
+			newInverse.setTranslation( mJointList[lookingForJoint].getTranslation() );
+			skin_info.mAlternateBindMatrix.push_back( LLMatrix4a(newInverse) );
+		}
+		else
+		{
+			LL_DEBUGS("Mesh")<<"Possibly misnamed/missing joint [" <<lookingForJoint.c_str()<<"] "<<LL_ENDL;
+		}
+	}
+
+	U32 bind_count = skin_info.mAlternateBindMatrix.size();
+	if (bind_count > 0 && bind_count != jointCnt)
+	{
+		LL_WARNS("Mesh") << "Model " << model->mLabel << " has invalid joint bind matrix list." << LL_ENDL;
+	}
+
+	//grab positions and weights of every primitive
+	const LLSD& primitives = mesh["primitives"];
+	for (S32 p = 0; p < (S32) primitives.size(); ++p)
+	{
+		const LLSD& attributes = primitives[p]["attributes"];
+
+		LLGLBAccessor pos, joint_acc, weight_acc;
+		if (!getAccessor(attributes["POSITION"].asInteger(), pos)
+			|| pos.mComponents != 3
+			|| !attributes.has("JOINTS_0") || !attributes.has("WEIGHTS_0")
+			|| !getAccessor(attributes["JOINTS_0"].asInteger(), joint_acc)
+			|| !getAccessor(attributes["WEIGHTS_0"].asInteger(), weight_acc)
+			|| joint_acc.mComponents != 4 || weight_acc.mComponents != 4
+			|| joint_acc.mCount < pos.mCount || weight_acc.mCount < pos.mCount)
+		{
+			continue;
+		}
+
+		F32 tmp[4];
+		F32 joint_tmp[4];
+		F32 weight_tmp[4];
+		for (U32 v = 0; v < pos.mCount; ++v)
+		{
+			const F32* p3 = pos.get(v, tmp);
+
+			//transform from glTF space to volume space
+			LLVector3 position(p3[0], p3[1], p3[2]);
+			position = position * inverse_normalized_transformation;
+			model->mPosition.push_back(position);
+
+			//create list of weights that influence this vertex
+			const F32* j4 = joint_acc.get(v, joint_tmp);
+			const F32* w4 = weight_acc.get(v, weight_tmp);
+
+			LLModel::weight_list weight_list;
+			for (U32 k = 0; k < 4; ++k)
+			{
+				S32 joint_idx = (S32) j4[k];
+				if (w4[k] > 0.f && joint_idx >= 0 && joint_idx < jointCnt)
+				{
+					weight_list.push_back(LLModel::JointWeight(joint_idx, w4[k]));
+				}
+			}
+
+			//sort by joint weight
+			std::sort(weight_list.begin(), weight_list.end(), LLModel::CompareWeightGreater());
+
+			F32 total = 0.f;
+			for (U32 i = 0; i < weight_list.size(); ++i)
+			{
+				total += weight_list[i].mWeight;
+			}
+
+			if (total > 0.f && total != 1.f)
+			{ //normalize weights
+				F32 scale = 1.f/total;
+				for (U32 i = 0; i < weight_list.size(); ++i)
+				{
+					weight_list[i].mWeight *= scale;
+				}
+			}
+
+			model->mSkinWeights[position] = weight_list;
+		}
+	}
+
+	//add instance to scene for this model
+
+	LLMatrix4 transformation;
+	transformation.initScale(mesh_scale_vector);
+	transformation.setTranslation(mesh_translation_vector);
+	transformation *= mBaseTransform;
+
+	std::map<std::string, LLImportMaterial> materials;
+	for (U32 i = 0; i < model->mMaterialList.size(); ++i)
+	{
+		materials[model->mMaterialList[i]] = LLImportMaterial();
+	}
+	mScene[transformation].push_back(LLModelInstance(model, model->mLabel, transformation, materials));
+	stretch_extents(model, transformation, mExtents[0], mExtents[1], mFirstTransform);
+}
+
+// static
+LLMatrix4 LLGLBLoader::getNodeTransform(const LLSD& node)
+{
+	if (node.has("matrix") && node["matrix"].size() == 16)
+	{
+		F32 m[16];
+		for (S32 i = 0; i < 16; ++i)
+		{
+			m[i] = (F32) node["matrix"][i].asReal();
+		}
+		return matrix_from_floats(m);
+	}
+
+	// T * R * S applied to column vectors, S * R * T for LLMatrix4
+	LLMatrix4 transform;
+	if (node.has("scale") && node["scale"].size() == 3)
+	{
+		const LLSD& s = node["scale"];
+		transform.initScale(LLVector3((F32) s[0].asReal(), (F32) s[1].asReal(), (F32) s[2].asReal()));
+	}
+
+	if (node.has("rotation") && node["rotation"].size() == 4)
+	{
+		const LLSD& r = node["rotation"];
+		LLMatrix4 rotation(LLQuaternion((F32) r[0].asReal(), (F32) r[1].asReal(), (F32) r[2].asReal(), (F32) r[3].asReal()));
+		transform *= rotation;
+	}
+
+	if (node.has("translation") && node["translation"].size() == 3)
+	{
+		const LLSD& t = node["translation"];
+		LLMatrix4 translation;
+		translation.setTranslation((F32) t[0].asReal(), (F32) t[1].asReal(), (F32) t[2].asReal());
+		transform *= translation;
+	}
+
+	return transform;
+}
+
+void LLGLBLoader::processNode(S32 node_index, const LLMatrix4& parent_transform, bool& badElement, S32 depth)
+{
+	const LLSD& nodes = mJson["nodes"];
+	if (node_index < 0 || node_index >= (S32) nodes.size() || depth > GLB_MAX_NODE_DEPTH)
+	{
+		LL_WARNS() << "Invalid node " << node_index << LL_ENDL;
+		badElement = true;
+		return;
+	}
+
+	const LLSD& node = nodes[node_index];
+
+	// this node's transform is applied before its parent's
+	LLMatrix4 transform = getNodeTransform(node);
+	transform *= parent_transform;
+
+	if (node.has("mesh") && !node.has("skin"))
+	{
+		S32 mesh = node["mesh"].asInteger();
+		std::map<S32, std::vector<LLPointer<LLModel> > >::iterator iter = mMeshModels.find(mesh);
+		if (iter != mMeshModels.end())
+		{
+			std::string label = node["name"].asString();
+			if (label.empty())
+			{
+				label = llformat("node_%d", node_index);
+			}
+
+			mTransform = transform;
+			mTransform *= mBaseTransform;
+			mTransform.condition();
+
+			for (LLPointer<LLModel>& model : iter->second)
+			{
+				addModelInstance(model, mTransform, label, badElement);
+			}
+		}
+	}
+
+	const LLSD& children = node["children"];
+	for (S32 i = 0; i < (S32) children.size(); ++i)
+	{
+		processNode(children[i].asInteger(), transform, badElement, depth + 1);
+	}
+}
+
+void LLGLBLoader::addModelInstance(LLModel* model, const LLMatrix4& transform, const std::string& label, bool& badElement)
+{
+	LLMatrix4 transformation = transform;
+
+	if (transform.determinant() < 0)
+	{ //negative scales are not supported
+		LL_INFOS() << "Negative scale detected, unsupported transform.  node: " << label << LL_ENDL;
+		LLSD args;
+		args["Message"] = "NegativeScaleTrans";
+		args["LABEL"] = label;
+		mWarningsArray.append(args);
+
+		badElement = true;
+	}
+
+	// adjust the transformation to compensate for mesh normalization
+	LLVector3 mesh_scale_vector;
+	LLVector3 mesh_translation_vector;
+	model->getNormalizedScaleTranslation(mesh_scale_vector, mesh_translation_vector);
+
+	LLMatrix4 mesh_translation;
+	mesh_translation.setTranslation(mesh_translation_vector);
+	mesh_translation *= transformation;
+	transformation = mesh_translation;
+
+	LLMatrix4 mesh_scale;
+	mesh_scale.initScale(mesh_scale_vector);
+	mesh_scale *= transformation;
+	transformation = mesh_scale;
+
+	if (transformation.determinant() < 0)
+	{ //negative scales are not supported
+		LL_INFOS() << "Negative scale detected, unsupported post-normalization transform.  node: " << label << LL_ENDL;
+		LLSD args;
+		args["Message"] = "NegativeScaleNormTrans";
+		args["LABEL"] = label;
+		mWarningsArray.append(args);
+		badElement = true;
+	}
+
+	// model labels already carry the LOD suffix, see splitModel()
+	std::string instance_label = model->mLabel;
+	const std::string& suffix = getLodSuffix(mLod);
+	if (instance_label.length() > suffix.length()
+		&& instance_label.compare(instance_label.length() - suffix.length(), suffix.length(), suffix) == 0)
+	{
+		instance_label.erase(instance_label.length() - suffix.length());
+	}
+
+	material_map materials = getMaterials(model);
+	mScene[transformation].push_back(LLModelInstance(model, instance_label, transformation, materials));
+	stretch_extents(model, transformation, mExtents[0], mExtents[1], mFirstTransform);
+}
+
+LLModelLoader::material_map LLGLBLoader::getMaterials(LLModel* model)
+{
+	material_map materials;
+
+	const LLSD& gltf_materials = mJson["materials"];
+	for (size_t i = 0; i < model->mMaterialList.size(); i++)
+	{
+		const std::string& name = model->mMaterialList[i];
+
+		LLImportMaterial import_material;
+		for (S32 j = 0; j < (S32) gltf_materials.size(); ++j)
+		{
+			if (getMaterialName(j) == name)
+			{
+				import_material = gltfToMaterial(j);
+				break;
+			}
+		}
+
+		import_material.mBinding = name;
+		materials[name] = import_material;
+	}
+
+	return materials;
+}
+
+LLImportMaterial LLGLBLoader::gltfToMaterial(S32 index)
+{
+	LLImportMaterial mat;
+	mat.mFullbright = false;
+
+	const LLSD& material = mJson["materials"][index];
+	const LLSD& pbr = material["pbrMetallicRoughness"];
+
+	if (pbr.has("baseColorFactor") && pbr["baseColorFactor"].size() == 4)
+	{
+		const LLSD& c = pbr["baseColorFactor"];
+		mat.mDiffuseColor.set((F32) c[0].asReal(), (F32) c[1].asReal(), (F32) c[2].asReal(), (F32) c[3].asReal());
+	}
+
+	if (pbr.has("baseColorTexture"))
+	{
+		S32 texture = pbr["baseColorTexture"]["index"].asInteger();
+		const LLSD& source = mJson["textures"][texture]["source"];
+		const LLSD& image = mJson["images"][source.asInteger()];
+
+		std::string uri = image["uri"].asString();
+		if (source.isDefined() && !uri.empty() && uri.compare(0, 5, "data:") != 0)
+		{
+			std::string path = LLURI::unescape(uri);
+
+			// Relative paths are relative to the document
+			bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.length() > 1 && path[1] == ':'));
+			if (!absolute)
+			{
+				path = mFileDir + path;
+			}
+
+			mat.mDiffuseMapFilename = path;
+			mat.mDiffuseMapLabel = getMaterialName(index);
+		}
+		else if (source.isDefined())
+		{
+			LL_WARNS() << "Image embedded in glb is not supported, material " << getMaterialName(index) << LL_ENDL;
+			LLSD args;
+			args["Message"] = "GLBEmbeddedImage";
+			args["LABEL"] = getMaterialName(index);
+			mWarningsArray.append(args);
+		}
+	}
+
+	const LLSD& emissive = material["emissiveFactor"];
+	if (emissive.size() == 3
+		&& ((emissive[0].asReal() + emissive[1].asReal() + emissive[2].asReal()) / 3.0) > 0.25)
+	{
+		mat.mFullbright = true;
+	}
+
+	return mat;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file llglbloader.h
+ * @brief LLGLBLoader class definition
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLGLBLOADER_H
+#define LL_LLGLBLOADER_H
+
+#include "llmodelloader.h"
+
+class LLModel;
+struct LLGLBAccessor;
+
+// Loads binary glTF 2.0 (.glb) files. The whole file is read into memory
+// once; vertex attributes and indices are read straight out of the BIN
+// chunk into LLVolumeFace arrays without intermediate copies. Only
+// triangle primitives are supported. Skins are mapped to LLMeshSkinInfo
+// the same way LLDAELoader maps COLLADA controllers.
+class LLGLBLoader : public LLModelLoader
+{
+public:
+	LLGLBLoader(
+		std::string							filename,
+		S32									lod,
+		LLModelLoader::load_callback_t		load_cb,
+		LLModelLoader::joint_lookup_func_t	joint_lookup_func,
+		LLModelLoader::texture_load_func_t	texture_load_func,
+		LLModelLoader::state_callback_t		state_cb,
+		void*								opaque_userdata,
+		JointTransformMap&					jointTransformMap,
+		JointNameSet&						jointsFromNodes,
+        std::map<std::string, std::string>& jointAliasMap,
+        U32									maxJointsPerMesh,
+		U32									modelLimit);
+	virtual ~LLGLBLoader();
+
+	virtual bool OpenFile(const std::string& filename);
+
+	// Splits a GLB container into its JSON and BIN chunks. Returns false if
+	// data is not a valid glTF 2.0 binary file. bin is NULL when the file
+	// has no BIN chunk.
+	static bool parseContainer(const U8* data, size_t size,
+							   const char*& json, size_t& json_size,
+							   const U8*& bin, size_t& bin_size);
+
+protected:
+	bool getAccessor(S32 index, LLGLBAccessor& accessor) const;
+
+	// Builds the faces of a glTF mesh into model, returns false on
+	// malformed data
+	bool loadMesh(const LLSD& mesh, LLModel* model);
+	bool loadPrimitive(const LLSD& primitive, LLModel* model);
+
+	// Fills model->mSkinInfo, mPosition and mSkinWeights from a glTF skin
+	void processSkin(LLModel* model, const LLSD& mesh, const LLSD& skin);
+
+	void processNode(S32 node_index, const LLMatrix4& parent_transform, bool& badElement, S32 depth);
+	void addModelInstance(LLModel* model, const LLMatrix4& transform, const std::string& label, bool& badElement);
+
+	LLModelLoader::material_map getMaterials(LLModel* model);
+	LLImportMaterial gltfToMaterial(S32 index);
+	std::string getMaterialName(S32 index) const;
+
+	static LLMatrix4 getNodeTransform(const LLSD& node);
+
+protected:
+	U32 mGeneratedModelLimit; // Attempt to limit amount of generated submodels
+
+private:
+	LLSD mJson;
+	std::vector<U8> mFileData;
+	const U8* mBin;
+	size_t mBinSize;
+	std::string mFileDir;
+
+	// Y up to Z up rotation applied to the whole scene
+	LLMatrix4 mBaseTransform;
+
+	std::map<S32, std::vector<LLPointer<LLModel> > > mMeshModels;
+	// Meshes that are used by a skinned node, indexed by mesh
+	std::map<S32, S32> mMeshSkins;
+};
+
+#endif  // LL_LLGLBLOADER_H
@@ -195,6 +195,16 @@ public:
 
 protected:
 
+	// Names, normalizes and splits a freshly loaded model into as many
+	// models as needed to fit faces into LL_SCULPT_MESH_MAX_FACES
+	void splitModel(LLModel* model, const std::string& model_name, std::vector<LLModel*>& models_out, U32 submodel_limit) const;
+
+	// Sorts mModelList the way the upload floater expects it
+	void sortModelList();
+
+	// "_LOD0", "_PHYS", etc. as appended to model labels
+	static const std::string& getLodSuffix(S32 lod);
+
 	LLModelLoader::load_callback_t		mLoadCallback;
 	LLModelLoader::joint_lookup_func_t	mJointLookupFunc;
 	LLModelLoader::texture_load_func_t	mTextureLoadFunc;
@@ -0,0 +1,448 @@
+/**
+ * @file lldaestreamloader_test.cpp
+ * @brief LLDAEStreamLoader unit tests, checked against LLDAELoader
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../lldaestreamloader.h"
+#include "../lldaeloader.h"
+
+#include "llfile.h"
+#include "lljoint.h"
+#include "llsdutil.h"
+#include "stringize.h"
+
+#include <sstream>
+
+namespace
+{
+	// Loaders report their state through the callback only
+	void state_cb(U32 state, void* opaque)
+	{
+		*static_cast<U32*>(opaque) = state;
+	}
+
+	// No avatar to apply joint offsets to
+	LLJoint* no_joint(const std::string&, void*)
+	{
+		return NULL;
+	}
+
+	// One face more than a model holds, so the grid gets split once
+	const S32 GRID_QUADS = LL_SCULPT_MESH_MAX_FACES + 1;
+
+	const char* const DAE_HEADER =
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<COLLADA xmlns=\"http://www.collada.org/2005/11/COLLADASchema\" version=\"1.4.1\">\n"
+		"<asset><unit name=\"centimeter\" meter=\"0.01\"/><up_axis>Z_UP</up_axis></asset>\n";
+
+	// One lambert effect and material per grid quad, mat0 is used by the box too
+	std::string effects_and_materials()
+	{
+		std::ostringstream out;
+		out << "<library_effects>\n";
+		for (S32 i = 0; i < GRID_QUADS; ++i)
+		{
+			out << "<effect id=\"fx" << i << "\"><profile_COMMON><technique sid=\"common\"><lambert>"
+				<< "<diffuse><color>" << (i % 2) << " " << (i % 3) / 2.f << " " << i / (F32) GRID_QUADS << " 1</color></diffuse>"
+				<< "</lambert></technique></profile_COMMON></effect>\n";
+		}
+		out << "</library_effects>\n<library_materials>\n";
+		for (S32 i = 0; i < GRID_QUADS; ++i)
+		{
+			out << "<material id=\"mat" << i << "\" name=\"mat" << i << "\"><instance_effect url=\"#fx" << i << "\"/></material>\n";
+		}
+		out << "</library_materials>\n";
+		return out.str();
+	}
+
+	std::string float_source(const std::string& id, const std::vector<F32>& values, S32 stride)
+	{
+		static const char* const PARAMS[] = { "X", "Y", "Z" };
+		static const char* const UV_PARAMS[] = { "S", "T" };
+
+		std::ostringstream out;
+		out << "<source id=\"" << id << "\"><float_array id=\"" << id << "-array\" count=\"" << values.size() << "\">";
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			out << (i ? " " : "") << values[i];
+		}
+		out << "</float_array><technique_common><accessor source=\"#" << id << "-array\" count=\""
+			<< values.size() / stride << "\" stride=\"" << stride << "\">";
+		for (S32 i = 0; i < stride; ++i)
+		{
+			out << "<param name=\"" << (stride == 2 ? UV_PARAMS[i] : PARAMS[i]) << "\" type=\"float\"/>";
+		}
+		out << "</accessor></technique_common></source>\n";
+		return out.str();
+	}
+
+	// Positions and normals of a unit cube, faces as position/normal index quads
+	const F32 CUBE_POSITIONS[] = { 0,0,0, 1,0,0, 1,1,0, 0,1,0, 0,0,1, 1,0,1, 1,1,1, 0,1,1 };
+	const F32 CUBE_NORMALS[] = { 0,0,-1, 0,0,1, 0,-1,0, 1,0,0, 0,1,0, -1,0,0 };
+	const U32 CUBE_QUADS[6][4] = { {0,3,2,1}, {4,5,6,7}, {0,1,5,4}, {1,2,6,5}, {2,3,7,6}, {3,0,4,7} };
+
+	// A cube, using <triangles> or one <polygons> entry per side
+	std::string cube_geometry(bool polygons)
+	{
+		std::ostringstream out;
+		out << "<geometry id=\"box-mesh\" name=\"box\"><mesh>\n"
+			<< float_source("box-pos", std::vector<F32>(std::begin(CUBE_POSITIONS), std::end(CUBE_POSITIONS)), 3)
+			<< float_source("box-nrm", std::vector<F32>(std::begin(CUBE_NORMALS), std::end(CUBE_NORMALS)), 3)
+			<< "<vertices id=\"box-vtx\"><input semantic=\"POSITION\" source=\"#box-pos\"/></vertices>\n";
+		const char* inputs =
+			"<input semantic=\"VERTEX\" source=\"#box-vtx\" offset=\"0\"/>"
+			"<input semantic=\"NORMAL\" source=\"#box-nrm\" offset=\"1\"/>";
+		if (polygons)
+		{
+			out << "<polygons material=\"sym0\" count=\"6\">" << inputs;
+			for (U32 side = 0; side < 6; ++side)
+			{
+				out << "<p>";
+				for (U32 corner = 0; corner < 4; ++corner)
+				{
+					out << CUBE_QUADS[side][corner] << " " << side << " ";
+				}
+				out << "</p>";
+			}
+			out << "</polygons>\n";
+		}
+		else
+		{
+			out << "<triangles material=\"sym0\" count=\"12\">" << inputs << "<p>";
+			static const U32 FAN[] = { 0, 1, 2, 0, 2, 3 };
+			for (U32 side = 0; side < 6; ++side)
+			{
+				for (U32 corner : FAN)
+				{
+					out << CUBE_QUADS[side][corner] << " " << side << " ";
+				}
+			}
+			out << "</p></triangles>\n";
+		}
+		out << "</mesh></geometry>\n";
+		return out.str();
+	}
+
+	// A row of textured quads, each with its own material so that
+	// the model has to be split in two
+	std::string grid_geometry()
+	{
+		std::vector<F32> positions, uvs;
+		for (S32 i = 0; i <= GRID_QUADS; ++i)
+		{
+			positions.insert(positions.end(), { (F32) i, 0.f, 0.f, (F32) i, 1.f, 0.f });
+			uvs.insert(uvs.end(), { i / (F32) GRID_QUADS, 0.f, i / (F32) GRID_QUADS, 1.f });
+		}
+		const F32 normal[] = { 0, 0, 1 };
+
+		std::ostringstream out;
+		out << "<geometry id=\"grid-mesh\" name=\"grid\"><mesh>\n"
+			<< float_source("grid-pos", positions, 3)
+			<< float_source("grid-nrm", std::vector<F32>(std::begin(normal), std::end(normal)), 3)
+			<< float_source("grid-uv", uvs, 2)
+			<< "<vertices id=\"grid-vtx\"><input semantic=\"POSITION\" source=\"#grid-pos\"/></vertices>\n";
+		for (S32 i = 0; i < GRID_QUADS; ++i)
+		{
+			const S32 v = i * 2;
+			out << "<polylist material=\"sym" << i << "\" count=\"1\">"
+				<< "<input semantic=\"VERTEX\" source=\"#grid-vtx\" offset=\"0\"/>"
+				<< "<input semantic=\"NORMAL\" source=\"#grid-nrm\" offset=\"1\"/>"
+				<< "<input semantic=\"TEXCOORD\" source=\"#grid-uv\" offset=\"2\" set=\"0\"/>"
+				<< "<vcount>4</vcount><p>"
+				<< v << " 0 " << v << " " << v + 2 << " 0 " << v + 2 << " "
+				<< v + 3 << " 0 " << v + 3 << " " << v + 1 << " 0 " << v + 1
+				<< "</p></polylist>\n";
+		}
+		out << "</mesh></geometry>\n";
+		return out.str();
+	}
+
+	std::string bind_materials(S32 count)
+	{
+		std::ostringstream out;
+		out << "<bind_material><technique_common>";
+		for (S32 i = 0; i < count; ++i)
+		{
+			out << "<instance_material symbol=\"sym" << i << "\" target=\"#mat" << i << "\"/>";
+		}
+		out << "</technique_common></bind_material>";
+		return out.str();
+	}
+
+	// Two instances of the cube with different transforms and one of the grid
+	std::string static_scene()
+	{
+		std::ostringstream out;
+		out << "<library_visual_scenes><visual_scene id=\"Scene\" name=\"Scene\">\n"
+			<< "<node id=\"box1\" name=\"box1\"><translate>10 20 30</translate><rotate>0 0 1 90</rotate><scale>2 2 2</scale>"
+			<< "<instance_geometry url=\"#box-mesh\">" << bind_materials(1) << "</instance_geometry></node>\n"
+			<< "<node id=\"parent\" name=\"parent\"><translate>0 0 50</translate>"
+			<< "<node id=\"box2\" name=\"box2\"><matrix>1 0 0 5 0 0 -1 0 0 1 0 0 0 0 0 1</matrix>"
+			<< "<instance_geometry url=\"#box-mesh\">" << bind_materials(1) << "</instance_geometry></node></node>\n"
+			<< "<node id=\"grid1\" name=\"grid1\"><scale>1 3 1</scale>"
+			<< "<instance_geometry url=\"#grid-mesh\">" << bind_materials(GRID_QUADS) << "</instance_geometry></node>\n"
+			<< "</visual_scene></library_visual_scenes>\n"
+			<< "<scene><instance_visual_scene url=\"#Scene\"/></scene>\n";
+		return out.str();
+	}
+
+	std::string build_static_dae(bool polygons)
+	{
+		return std::string(DAE_HEADER)
+			+ effects_and_materials()
+			+ "<library_geometries>\n" + cube_geometry(polygons) + grid_geometry() + "</library_geometries>\n"
+			+ static_scene()
+			+ "</COLLADA>\n";
+	}
+
+	// The cube bound to a single joint
+	std::string build_skinned_dae()
+	{
+		std::ostringstream out;
+		out << DAE_HEADER
+			<< effects_and_materials()
+			<< "<library_geometries>\n" << cube_geometry(false) << "</library_geometries>\n"
+			<< "<library_controllers><controller id=\"box-skin\"><skin source=\"#box-mesh\">"
+			<< "<bind_shape_matrix>1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1</bind_shape_matrix>"
+			<< "<source id=\"box-joints\"><Name_array id=\"box-joints-array\" count=\"1\">mPelvis</Name_array>"
+			<< "<technique_common><accessor source=\"#box-joints-array\" count=\"1\" stride=\"1\"><param name=\"JOINT\" type=\"name\"/></accessor></technique_common></source>"
+			<< "<source id=\"box-bind\"><float_array id=\"box-bind-array\" count=\"16\">1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1</float_array>"
+			<< "<technique_common><accessor source=\"#box-bind-array\" count=\"1\" stride=\"16\"><param name=\"TRANSFORM\" type=\"float4x4\"/></accessor></technique_common></source>"
+			<< "<source id=\"box-weights\"><float_array id=\"box-weights-array\" count=\"1\">1</float_array>"
+			<< "<technique_common><accessor source=\"#box-weights-array\" count=\"1\" stride=\"1\"><param name=\"WEIGHT\" type=\"float\"/></accessor></technique_common></source>"
+			<< "<joints><input semantic=\"JOINT\" source=\"#box-joints\"/><input semantic=\"INV_BIND_MATRIX\" source=\"#box-bind\"/></joints>"
+			<< "<vertex_weights count=\"8\"><input semantic=\"JOINT\" source=\"#box-joints\" offset=\"0\"/><input semantic=\"WEIGHT\" source=\"#box-weights\" offset=\"1\"/>"
+			<< "<vcount>1 1 1 1 1 1 1 1</vcount><v>0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0</v></vertex_weights>"
+			<< "</skin></controller></library_controllers>\n"
+			<< "<library_visual_scenes><visual_scene id=\"Scene\" name=\"Scene\">"
+			<< "<node id=\"mPelvis\" name=\"mPelvis\" sid=\"mPelvis\" type=\"JOINT\"/>"
+			<< "<node id=\"box1\" name=\"box1\"><instance_controller url=\"#box-skin\"><skeleton>#mPelvis</skeleton>"
+			<< bind_materials(1) << "</instance_controller></node>"
+			<< "</visual_scene></library_visual_scenes>\n"
+			<< "<scene><instance_visual_scene url=\"#Scene\"/></scene>\n"
+			<< "</COLLADA>\n";
+		return out.str();
+	}
+
+	std::string write_temp_file(const std::string& name, const std::string& data)
+	{
+		std::string filename = std::string(LLFile::tmpdir()) + name;
+		LLFILE* fp = LLFile::fopen(filename, "wb");
+		if (fp)
+		{
+			fwrite(data.data(), 1, data.size(), fp);
+			fclose(fp);
+		}
+		return filename;
+	}
+
+	bool close_enough(const LLVector4a& a, const LLVector4a& b)
+	{
+		for (S32 i = 0; i < 3; ++i)
+		{
+			if (llabs(a[i] - b[i]) > 0.0001f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool close_enough(const LLMatrix4& a, const LLMatrix4& b)
+	{
+		for (S32 i = 0; i < 4; ++i)
+		{
+			for (S32 j = 0; j < 4; ++j)
+			{
+				if (llabs(a.mMatrix[i][j] - b.mMatrix[i][j]) > 0.0001f)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+namespace tut
+{
+	struct daestreamloader_data
+	{
+		JointTransformMap mJointTransforms;
+		JointNameSet mJointsFromNodes;
+		std::map<std::string, std::string> mJointAliases;
+		U32 mStreamState = LLModelLoader::STARTING;
+		U32 mDOMState = LLModelLoader::STARTING;
+
+		LLDAEStreamLoader* createStreamLoader(const std::string& filename)
+		{
+			return new LLDAEStreamLoader(filename, LLModel::LOD_HIGH,
+										 LLModelLoader::load_callback_t(),
+										 no_joint,
+										 LLModelLoader::texture_load_func_t(),
+										 state_cb, &mStreamState,
+										 mJointTransforms, mJointsFromNodes, mJointAliases,
+										 LL_MAX_JOINTS_PER_MESH_OBJECT, 1000, false);
+		}
+
+		LLDAELoader* createDAELoader(const std::string& filename)
+		{
+			return new LLDAELoader(filename, LLModel::LOD_HIGH,
+								   LLModelLoader::load_callback_t(),
+								   no_joint,
+								   LLModelLoader::texture_load_func_t(),
+								   state_cb, &mDOMState,
+								   mJointTransforms, mJointsFromNodes, mJointAliases,
+								   LL_MAX_JOINTS_PER_MESH_OBJECT, 1000, false);
+		}
+
+		// Checks that both loaders produced the same models and scene
+		void ensureSameOutput(const LLModelLoader& stream, const LLModelLoader& dom)
+		{
+			ensure_equals("load state", mStreamState, mDOMState);
+			ensure_equals("warnings", ll_pretty_print_sd(stream.logOut()), ll_pretty_print_sd(dom.logOut()));
+
+			ensure_equals("model count", stream.mModelList.size(), dom.mModelList.size());
+			for (size_t i = 0; i < dom.mModelList.size(); ++i)
+			{
+				const LLModel* smodel = stream.mModelList[i];
+				const LLModel* dmodel = dom.mModelList[i];
+				const std::string label = dmodel->mLabel;
+				ensure_equals("label", smodel->mLabel, label);
+				ensure_equals(label + " submodel", smodel->mSubmodelID, dmodel->mSubmodelID);
+				ensure_equals(label + " material count", smodel->mMaterialList.size(), dmodel->mMaterialList.size());
+				for (size_t m = 0; m < dmodel->mMaterialList.size(); ++m)
+				{
+					ensure_equals(label + " material", smodel->mMaterialList[m], dmodel->mMaterialList[m]);
+				}
+				ensure_equals(label + " faces", smodel->getNumVolumeFaces(), dmodel->getNumVolumeFaces());
+				for (S32 f = 0; f < dmodel->getNumVolumeFaces(); ++f)
+				{
+					const LLVolumeFace& sface = smodel->getVolumeFace(f);
+					const LLVolumeFace& dface = dmodel->getVolumeFace(f);
+					const std::string face = STRINGIZE(label << " face " << f);
+					ensure_equals(face + " vertices", sface.mNumVertices, dface.mNumVertices);
+					ensure_equals(face + " indices", sface.mNumIndices, dface.mNumIndices);
+					ensure_equals(face + " texcoords", sface.mTexCoords != NULL, dface.mTexCoords != NULL);
+					ensure(face + " min extent", close_enough(sface.mExtents[0], dface.mExtents[0]));
+					ensure(face + " max extent", close_enough(sface.mExtents[1], dface.mExtents[1]));
+				}
+			}
+
+			ensure_equals("transforms", stream.mScene.size(), dom.mScene.size());
+			LLModelLoader::scene::const_iterator sit = stream.mScene.begin();
+			for (LLModelLoader::scene::const_iterator dit = dom.mScene.begin(); dit != dom.mScene.end(); ++dit, ++sit)
+			{
+				ensure("transform", close_enough(sit->first, dit->first));
+				ensure_equals("instances", sit->second.size(), dit->second.size());
+				for (size_t i = 0; i < dit->second.size(); ++i)
+				{
+					const LLModelInstance& sinstance = sit->second[i];
+					const LLModelInstance& dinstance = dit->second[i];
+					ensure_equals("instance label", sinstance.mLabel, dinstance.mLabel);
+					ensure_equals(dinstance.mLabel + " model", sinstance.mModel->mLabel, dinstance.mModel->mLabel);
+					ensure("instance transform", close_enough(sinstance.mTransform, dinstance.mTransform));
+					ensure_equals(dinstance.mLabel + " materials", sinstance.mMaterial.size(), dinstance.mMaterial.size());
+					for (const auto& material : dinstance.mMaterial)
+					{
+						LLModelLoader::material_map::const_iterator found = sinstance.mMaterial.find(material.first);
+						ensure(dinstance.mLabel + " has " + material.first, found != sinstance.mMaterial.end());
+						ensure_equals(material.first + " color", found->second.mDiffuseColor, material.second.mDiffuseColor);
+						ensure_equals(material.first + " texture", found->second.mDiffuseMapFilename, material.second.mDiffuseMapFilename);
+					}
+				}
+			}
+		}
+	};
+	typedef test_group<daestreamloader_data> daestreamloader_group;
+	typedef daestreamloader_group::object daestreamloader_object;
+	daestreamloader_group daestreamloader("LLDAEStreamLoader");
+
+	template<> template<>
+	void daestreamloader_object::test<1>()
+	{
+		set_test_name("static scene matches LLDAELoader");
+
+		std::string filename = write_temp_file("lldaestreamloader_test.dae", build_static_dae(false));
+		LLDAEStreamLoader* stream = createStreamLoader(filename);
+		LLDAELoader* dom = createDAELoader(filename);
+
+		ensure("stream loaded", stream->OpenFile(filename));
+		ensure_equals("streamed", stream->getFallbackReason(), std::string());
+		ensure_equals("stream state", mStreamState, (U32) LLModelLoader::DONE);
+		ensure("dom loaded", dom->OpenFile(filename));
+
+		// the box, and the grid split in two; the grid halves are
+		// normalized separately so they end up under different transforms
+		ensure_equals("models", stream->mModelList.size(), (size_t) 3);
+		ensure_equals("transforms", stream->mScene.size(), (size_t) 4);
+		ensureSameOutput(*stream, *dom);
+
+		delete stream;
+		delete dom;
+		LLFile::remove(filename);
+	}
+
+	template<> template<>
+	void daestreamloader_object::test<2>()
+	{
+		set_test_name("<polygons> falls back to LLDAELoader");
+
+		std::string filename = write_temp_file("lldaestreamloader_polygons.dae", build_static_dae(true));
+		LLDAEStreamLoader* stream = createStreamLoader(filename);
+		LLDAELoader* dom = createDAELoader(filename);
+
+		ensure("stream loaded", stream->OpenFile(filename));
+		ensure_equals("fell back", stream->getFallbackReason(), std::string("polygons"));
+		ensure("dom loaded", dom->OpenFile(filename));
+		ensureSameOutput(*stream, *dom);
+
+		delete stream;
+		delete dom;
+		LLFile::remove(filename);
+	}
+
+	template<> template<>
+	void daestreamloader_object::test<3>()
+	{
+		set_test_name("skinned mesh falls back to LLDAELoader");
+
+		std::string filename = write_temp_file("lldaestreamloader_skinned.dae", build_skinned_dae());
+		LLDAEStreamLoader* stream = createStreamLoader(filename);
+		LLDAELoader* dom = createDAELoader(filename);
+
+		bool stream_loaded = stream->OpenFile(filename);
+		ensure_equals("fell back", stream->getFallbackReason(), std::string("skinned mesh"));
+		ensure_equals("same result", stream_loaded, dom->OpenFile(filename));
+		ensureSameOutput(*stream, *dom);
+
+		delete stream;
+		delete dom;
+		LLFile::remove(filename);
+	}
+}
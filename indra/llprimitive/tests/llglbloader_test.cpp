@@ -0,0 +1,297 @@
+/**
+ * @file llglbloader_test.cpp
+ * @brief LLGLBLoader unit tests and import benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llglbloader.h"
+#include "../lldaeloader.h"
+
+#include "llfile.h"
+#include "lljoint.h"
+#include "llmemory.h"
+#include "lltimer.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	// Loaders report their state through the callback only
+	void state_cb(U32 state, void* opaque)
+	{
+		*static_cast<U32*>(opaque) = state;
+	}
+
+	void append_u32(std::string& out, U32 value)
+	{
+		out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	// Builds a GLB holding a single textured quad
+	std::string build_quad_glb()
+	{
+		const F32 positions[] = { 0,0,0,  1,0,0,  1,1,0,  0,1,0 };
+		const F32 normals[] = { 0,0,1,  0,0,1,  0,0,1,  0,0,1 };
+		const F32 uvs[] = { 0,0,  1,0,  1,1,  0,1 };
+		const U16 indices[] = { 0,1,2,  0,2,3 };
+
+		std::string bin;
+		bin.append(reinterpret_cast<const char*>(positions), sizeof(positions));
+		bin.append(reinterpret_cast<const char*>(normals), sizeof(normals));
+		bin.append(reinterpret_cast<const char*>(uvs), sizeof(uvs));
+		bin.append(reinterpret_cast<const char*>(indices), sizeof(indices));
+		while (bin.size() % 4)
+		{
+			bin.push_back('\0');
+		}
+
+		std::string json =
+			"{\"asset\":{\"version\":\"2.0\"},"
+			"\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+			"\"nodes\":[{\"name\":\"quad\",\"mesh\":0,\"translation\":[1,2,3]}],"
+			"\"materials\":[{\"name\":\"red\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,0,0,1]}}],"
+			"\"meshes\":[{\"name\":\"quad\",\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3,\"material\":0}]}],"
+			"\"accessors\":["
+			"{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+			"{\"bufferView\":1,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+			"{\"bufferView\":2,\"componentType\":5126,\"count\":4,\"type\":\"VEC2\"},"
+			"{\"bufferView\":3,\"componentType\":5123,\"count\":6,\"type\":\"SCALAR\"}],"
+			"\"bufferViews\":["
+			"{\"buffer\":0,\"byteOffset\":0,\"byteLength\":48},"
+			"{\"buffer\":0,\"byteOffset\":48,\"byteLength\":48},"
+			"{\"buffer\":0,\"byteOffset\":96,\"byteLength\":32},"
+			"{\"buffer\":0,\"byteOffset\":128,\"byteLength\":12}],"
+			"\"buffers\":[{\"byteLength\":140}]}";
+		while (json.size() % 4)
+		{
+			json.push_back(' ');
+		}
+
+		std::string glb;
+		append_u32(glb, 0x46546C67);
+		append_u32(glb, 2);
+		append_u32(glb, 12 + 8 + json.size() + 8 + bin.size());
+		append_u32(glb, json.size());
+		append_u32(glb, 0x4E4F534A);
+		glb += json;
+		append_u32(glb, bin.size());
+		append_u32(glb, 0x004E4942);
+		glb += bin;
+		return glb;
+	}
+
+	std::string write_temp_file(const std::string& data)
+	{
+		std::string filename = std::string(LLFile::tmpdir()) + "llglbloader_test.glb";
+		LLFILE* fp = LLFile::fopen(filename, "wb");
+		if (fp)
+		{
+			fwrite(data.data(), 1, data.size(), fp);
+			fclose(fp);
+		}
+		return filename;
+	}
+
+	// Samples the resident set size while alive and keeps the highest value
+	class RSSSampler
+	{
+	public:
+		RSSSampler()
+		:	mBase(LLMemory::getCurrentRSS()),
+			mPeak(mBase),
+			mDone(false),
+			mThread([this]()
+			{
+				while (!mDone)
+				{
+					U64 rss = LLMemory::getCurrentRSS();
+					if (rss > mPeak)
+					{
+						mPeak = rss;
+					}
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			})
+		{
+		}
+
+		// Peak growth over the RSS at construction, in bytes
+		U64 stop()
+		{
+			mDone = true;
+			mThread.join();
+			return mPeak > mBase ? mPeak - mBase : 0;
+		}
+
+	private:
+		U64 mBase;
+		std::atomic<U64> mPeak;
+		std::atomic<bool> mDone;
+		std::thread mThread;
+	};
+}
+
+namespace tut
+{
+	struct glbloader_data
+	{
+		JointTransformMap mJointTransforms;
+		JointNameSet mJointsFromNodes;
+		std::map<std::string, std::string> mJointAliases;
+		U32 mLoadState = LLModelLoader::STARTING;
+
+		LLGLBLoader* createGLBLoader(const std::string& filename)
+		{
+			return new LLGLBLoader(filename, LLModel::LOD_HIGH,
+								   LLModelLoader::load_callback_t(),
+								   LLModelLoader::joint_lookup_func_t(),
+								   LLModelLoader::texture_load_func_t(),
+								   state_cb, &mLoadState,
+								   mJointTransforms, mJointsFromNodes, mJointAliases,
+								   LL_MAX_JOINTS_PER_MESH_OBJECT, 1000);
+		}
+
+		LLDAELoader* createDAELoader(const std::string& filename)
+		{
+			return new LLDAELoader(filename, LLModel::LOD_HIGH,
+								   LLModelLoader::load_callback_t(),
+								   LLModelLoader::joint_lookup_func_t(),
+								   LLModelLoader::texture_load_func_t(),
+								   state_cb, &mLoadState,
+								   mJointTransforms, mJointsFromNodes, mJointAliases,
+								   LL_MAX_JOINTS_PER_MESH_OBJECT, 1000, false);
+		}
+
+		// Loads filename with loader, returns seconds spent and peak RSS growth
+		F64 timeLoad(LLModelLoader* loader, const std::string& filename, U64& peak_rss)
+		{
+			RSSSampler sampler;
+			LLTimer timer;
+			bool loaded = loader->OpenFile(filename);
+			F64 seconds = timer.getElapsedTimeF64();
+			peak_rss = sampler.stop();
+			ensure(filename + " loaded", loaded && mLoadState == LLModelLoader::DONE);
+			return seconds;
+		}
+	};
+	typedef test_group<glbloader_data> glbloader_group;
+	typedef glbloader_group::object glbloader_object;
+	glbloader_group glbloader("LLGLBLoader");
+
+	template<> template<>
+	void glbloader_object::test<1>()
+	{
+		set_test_name("GLB container parsing");
+
+		std::string glb = build_quad_glb();
+		const U8* data = reinterpret_cast<const U8*>(glb.data());
+
+		const char* json = NULL;
+		size_t json_size = 0;
+		const U8* bin = NULL;
+		size_t bin_size = 0;
+		ensure("valid glb", LLGLBLoader::parseContainer(data, glb.size(), json, json_size, bin, bin_size));
+		ensure("json chunk", json != NULL && json[0] == '{');
+		ensure_equals("bin size", bin_size, (size_t) 140);
+
+		std::string bad = glb;
+		bad[0] = 'x';
+		ensure("bad magic", !LLGLBLoader::parseContainer(reinterpret_cast<const U8*>(bad.data()), bad.size(), json, json_size, bin, bin_size));
+
+		ensure("truncated", !LLGLBLoader::parseContainer(data, 16, json, json_size, bin, bin_size));
+	}
+
+	template<> template<>
+	void glbloader_object::test<2>()
+	{
+		set_test_name("GLB quad import");
+
+		std::string filename = write_temp_file(build_quad_glb());
+		LLGLBLoader* loader = createGLBLoader(filename);
+
+		ensure("loaded", loader->OpenFile(filename));
+		ensure_equals("state", mLoadState, (U32) LLModelLoader::DONE);
+		ensure_equals("model count", loader->mModelList.size(), (size_t) 1);
+
+		LLModel* model = loader->mModelList[0];
+		ensure_equals("label", model->mLabel, std::string("quad_LOD3"));
+		ensure_equals("face count", model->getNumVolumeFaces(), 1);
+		ensure_equals("material", model->mMaterialList[0], std::string("red"));
+
+		const LLVolumeFace& face = model->getVolumeFace(0);
+		ensure_equals("vertices", face.mNumVertices, 4);
+		ensure_equals("indices", face.mNumIndices, 6);
+		ensure("normals", face.mNormals != NULL);
+		ensure("texcoords", face.mTexCoords != NULL);
+		// v is flipped to the bottom left origin
+		ensure_equals("uv flip", face.mTexCoords[0].mV[1], 1.f);
+
+		ensure_equals("instances", loader->mScene.size(), (size_t) 1);
+		const LLModelInstance& instance = loader->mScene.begin()->second[0];
+		ensure_equals("instance label", instance.mLabel, std::string("quad"));
+		ensure_equals("diffuse color", instance.mMaterial.find("red")->second.mDiffuseColor, LLColor4(1.f, 0.f, 0.f, 1.f));
+
+		delete loader;
+		LLFile::remove(filename);
+	}
+
+	template<> template<>
+	void glbloader_object::test<3>()
+	{
+		set_test_name("GLB vs DAE import benchmark");
+
+		// Set to the path of a model exported both as <path>.glb and <path>.dae
+		const char* base = getenv("LL_MODEL_IMPORT_BENCHMARK");
+		if (!base || !*base)
+		{
+			skip("set LL_MODEL_IMPORT_BENCHMARK to run the import benchmark");
+		}
+
+		std::string glb_file = std::string(base) + ".glb";
+		std::string dae_file = std::string(base) + ".dae";
+
+		// GLB first so that DAE allocations don't inflate its peak
+		U64 glb_rss = 0;
+		LLGLBLoader* glb_loader = createGLBLoader(glb_file);
+		F64 glb_time = timeLoad(glb_loader, glb_file, glb_rss);
+		size_t glb_models = glb_loader->mModelList.size();
+		delete glb_loader;
+
+		U64 dae_rss = 0;
+		LLDAELoader* dae_loader = createDAELoader(dae_file);
+		F64 dae_time = timeLoad(dae_loader, dae_file, dae_rss);
+		size_t dae_models = dae_loader->mModelList.size();
+		delete dae_loader;
+
+		std::cout << "\nImport of " << base << ":\n"
+				  << "  glb: " << glb_time * 1000.0 << " ms, peak RSS +" << glb_rss / 1024 << " KB, " << glb_models << " models\n"
+				  << "  dae: " << dae_time * 1000.0 << " ms, peak RSS +" << dae_rss / 1024 << " KB, " << dae_models << " models" << std::endl;
+	}
+}
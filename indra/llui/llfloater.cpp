@@ -3287,7 +3287,7 @@ bool LLFloater::initFloaterXML(LLXMLNodePtr node, LLView *parent, const std::str
 			Params output_params;
 			parser.readXUI(node, output_params, LLUICtrlFactory::getInstance()->getCurFileName());
 			setupParamsForExport(output_params, parent);
-			output_node->setName(node->getName()->mString);
+			output_node->setName(node->getName().c_str());
 			parser.writeXUI(output_node, output_params, LLInitParam::default_parse_rules(), &default_params);
 			return true;
 		}
@@ -3317,7 +3317,7 @@ bool LLFloater::initFloaterXML(LLXMLNodePtr node, LLView *parent, const std::str
 	{
 		Params output_params(params);
 		setupParamsForExport(output_params, parent);
-		output_node->setName(node->getName()->mString);
+		output_node->setName(node->getName().c_str());
 		parser.writeXUI(output_node, output_params, LLInitParam::default_parse_rules(), &default_params);
 	}
 
@@ -531,7 +531,7 @@ bool LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 				parser.readXUI(node, params, LLUICtrlFactory::getInstance()->getCurFileName());
 				Params output_params(params);
 				setupParamsForExport(output_params, parent);
-				output_node->setName(node->getName()->mString);
+				output_node->setName(node->getName().c_str());
 				parser.writeXUI(output_node, output_params, LLInitParam::default_parse_rules(), &default_params);
 				return true;
 			}
@@ -562,7 +562,7 @@ bool LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 		{
 			Params output_params(params);
 			setupParamsForExport(output_params, parent);
-			output_node->setName(node->getName()->mString);
+			output_node->setName(node->getName().c_str());
 			parser.writeXUI(output_node, output_params, LLInitParam::default_parse_rules(), &default_params);
 		}
 		
@@ -128,18 +128,18 @@ void LLUICtrlFactory::createChildren(LLView* viewp, LLXMLNodePtr node, const wid
 		if (!instance().createFromXML(child_node, viewp, LLStringUtil::null, registry, outputChild))
 		{
 			// child_node is not a valid child for the current parent
-			std::string child_name = std::string(child_node->getName()->mString);
+			std::string child_name = std::string(child_node->getName().c_str());
 			if (LLDefaultChildRegistry::instance().getValue(child_name))
 			{
 				// This means that the registry assocaited with the parent widget does not have an entry
 				// for the child widget
 				// You might need to add something like:
 				// static ParentWidgetRegistry::Register<ChildWidgetType> register("child_widget_name");
-				LL_WARNS() << child_name << " is not a valid child of " << node->getName()->mString << LL_ENDL;
+				LL_WARNS() << child_name << " is not a valid child of " << node->getName().c_str() << LL_ENDL;
 			}
 			else
 			{
-				LL_WARNS() << "Could not create widget named " << child_node->getName()->mString << LL_ENDL;
+				LL_WARNS() << "Could not create widget named " << child_node->getName().c_str() << LL_ENDL;
 			}
 		}
 
@@ -183,7 +183,7 @@ S32 LLUICtrlFactory::saveToXML(LLView* viewp, const std::string& filename)
 
 LLView *LLUICtrlFactory::createFromXML(LLXMLNodePtr node, LLView* parent, const std::string& filename, const widget_registry_t& registry, LLXMLNodePtr output_node)
 {
-	std::string ctrl_type = node->getName()->mString;
+	std::string ctrl_type = node->getName().c_str();
 	LLStringUtil::toLower(ctrl_type);
 
 	const LLWidgetCreatorFunc* funcp = registry.getValue(ctrl_type);
@@ -234,7 +234,7 @@ void LLUICtrlFactory::setCtrlParent(LLView* view, LLView* parent, S32 tab_group)
 //static 
 void LLUICtrlFactory::copyName(LLXMLNodePtr src, LLXMLNodePtr dest)
 {
-	dest->setName(src->getName()->mString);
+	dest->setName(src->getName().c_str());
 }
 
 template<typename T>
@@ -682,7 +682,7 @@ void LLXUIParser::readXUI(LLXMLNodePtr node, LLInitParam::BaseBlock& block, cons
 {
 	LL_RECORD_BLOCK_TIME(FTM_PARSE_XUI);
 	mNameStack.clear();
-	mRootNodeName = node->getName()->mString;
+	mRootNodeName = node->getName().c_str();
 	mCurFileName = filename;
 	mCurReadDepth = 0;
 	setParseSilently(silent);
@@ -748,7 +748,7 @@ bool LLXUIParser::readXUIImpl(LLXMLNodePtr nodep, LLInitParam::BaseBlock& block)
 	mCurReadDepth++;
 	for(LLXMLNodePtr childp = nodep->getFirstChild(); childp.notNull();)
 	{
-		std::string child_name(childp->getName()->mString);
+		std::string child_name(childp->getName().c_str());
 		S32 num_tokens_pushed = 0;
 
 		// for non "dotted" child nodes	check to see if child node maps to another widget type
@@ -836,7 +836,7 @@ bool LLXUIParser::readAttributes(LLXMLNodePtr nodep, LLInitParam::BaseBlock& blo
 		++attribute_it)
 	{
 		S32 num_tokens_pushed = 0;
-		std::string attribute_name(attribute_it->first->mString);
+		std::string attribute_name(attribute_it->first.c_str());
 		mCurReadNode = attribute_it->second;
 
 		tokenizer name_tokens(attribute_name, sep);
@@ -967,7 +967,7 @@ bool LLXUIParser::writeStringValue(Parser& parser, const void* val_ptr, name_sta
 			|| string_val->size() > MAX_STRING_ATTRIBUTE_SIZE)
 		{
 			// don't write strings with newlines into attributes
-			std::string attribute_name = node->getName()->mString;
+			std::string attribute_name = node->getName().c_str();
 			LLXMLNodePtr parent_node = node->mParent;
 			parent_node->deleteChild(node);
 			// write results in text contents of node
@@ -1273,7 +1273,7 @@ bool LLXUIParser::writeSDValue(Parser& parser, const void* val_ptr, name_stack_t
 		if (string_val.find('\n') != std::string::npos || string_val.size() > MAX_STRING_ATTRIBUTE_SIZE)
 		{
 			// don't write strings with newlines into attributes
-			std::string attribute_name = node->getName()->mString;
+			std::string attribute_name = node->getName().c_str();
 			LLXMLNodePtr parent_node = node->mParent;
 			parent_node->deleteChild(node);
 			// write results in text contents of node
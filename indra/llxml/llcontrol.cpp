@@ -421,8 +421,11 @@ LLPointer<LLControlVariable> LLControlGroup::getControl(std::string_view name)
 		incrCount(name);
 	}
 
-	ctrl_name_table_t::iterator iter = mNameTable.find(name.data());
-	return iter == mNameTable.end() ? LLPointer<LLControlVariable>() : iter->second;
+	// find() never adds to the interned strings, so an unknown name costs
+	// no more than a known one
+	LLInternedString key(LLInternedString::find(name));
+	LLControlVariable** control = key.notNull() ? mInternedTable.find(key) : nullptr;
+	return control ? LLPointer<LLControlVariable>(*control) : LLPointer<LLControlVariable>();
 }
 
 
@@ -530,6 +533,7 @@ void LLControlGroup::cleanup()
 		}
 	}
 
+	mInternedTable.clear();
 	mNameTable.clear();
 }
 
@@ -592,6 +596,7 @@ LLControlVariable* LLControlGroup::declareControl(const std::string& name, eCont
 	LLControlVariable* control = new LLControlVariable(name, type, initial_val, comment, sanity_type, sanity_value, sanity_comment, persist, can_backup, hidefromsettingseditor);
 	// </FS:Zi>
 	mNameTable[name] = control;	
+	mInternedTable[LLInternedString(name)] = control;
 	return control;
 }
 
@@ -33,6 +33,8 @@
 #include "llrect.h"
 #include "llrefcount.h"
 #include "llinstancetracker.h"
+#include "llflathashmap.h"
+#include "llinternedstring.h"
 
 #include <vector>
 
@@ -225,6 +227,10 @@ class LLControlGroup : public LLInstanceTracker<LLControlGroup, std::string>
 protected:
 	typedef std::map<std::string, LLControlVariablePtr > ctrl_name_table_t;
 	ctrl_name_table_t mNameTable;
+	// The same controls by interned name, for getControl(), which is called
+	// with the same few hundred names every frame. mNameTable owns them.
+	typedef LLFlatHashMap<LLInternedString, LLControlVariable*> ctrl_interned_table_t;
+	ctrl_interned_table_t mInternedTable;
 	static const std::string mTypeString[TYPE_COUNT];
 	static const std::string mSanityTypeString[SANITY_TYPE_COUNT];
 
@@ -63,7 +63,7 @@ LLXMLNode::LLXMLNode() :
 	mAttributes(),
 	mPrev(NULL),
 	mNext(NULL),
-	mName(nullptr),
+	mName(),
 	mValue(""), 
 	mDefault(NULL)
 {
@@ -88,10 +88,10 @@ LLXMLNode::LLXMLNode(const char* name, bool is_attribute) :
 	mValue(""), 
 	mDefault(NULL)
 {
-    mName = gStringTable.addStringEntry(name);
+    mName = LLInternedString(name);
 }
 
-LLXMLNode::LLXMLNode(LLStringTableEntry* name, bool is_attribute) : 
+LLXMLNode::LLXMLNode(LLInternedString name, bool is_attribute) : 
 	mID(""),
 	mParser(nullptr),
 	mIsAttribute(is_attribute),
@@ -195,7 +195,7 @@ LLXMLNode::~LLXMLNode()
 
 bool LLXMLNode::isNull()
 {	
-	return (mName == nullptr);
+	return mName.isNull();
 }
 
 // protected
@@ -304,11 +304,11 @@ void LLXMLNode::addChild(LLXMLNodePtr& new_child)
 // virtual 
 LLXMLNodePtr LLXMLNode::createChild(const char* name, bool is_attribute)
 {
-	return createChild(gStringTable.addStringEntry(name), is_attribute);
+	return createChild(LLInternedString(name), is_attribute);
 }
 
 // virtual 
-LLXMLNodePtr LLXMLNode::createChild(LLStringTableEntry* name, bool is_attribute)
+LLXMLNodePtr LLXMLNode::createChild(LLInternedString name, bool is_attribute)
 {
 	LLXMLNodePtr ret(new LLXMLNode(name, is_attribute));
 	ret->mID.clear();
@@ -586,7 +586,7 @@ bool LLXMLNode::updateNode(
 
 	for(itor = update_node->mAttributes.begin(); itor != update_node->mAttributes.end(); ++itor)
 	{
-		const LLStringTableEntry* attribNameEntry = (*itor).first;
+		LLInternedString attribNameEntry = (*itor).first;
 		LLXMLNodePtr updateAttribNode = (*itor).second;
 
 		LLXMLNodePtr attribNode;
@@ -914,7 +914,7 @@ void LLXMLNode::writeToOstream(std::ostream& output_stream, const std::string& i
 	bool has_default_length = mDefault.isNull()?false:(mLength == mDefault->mLength);
 
 	// stream the name
-	output_stream << indent << "<" << mName->mString << "\n";
+	output_stream << indent << "<" << mName.c_str() << "\n";
 
 	if (use_type_decorations)
 	{
@@ -1001,7 +1001,7 @@ void LLXMLNode::writeToOstream(std::ostream& output_stream, const std::string& i
 			LLXMLNodePtr child = (*attr_itr).second;
 			if (child->mDefault.isNull() || child->mDefault->mValue != child->mValue)
 			{
-				std::string attr = child->mName->mString;
+				std::string attr = child->mName.c_str();
 				if (use_type_decorations
 					&& (attr == "id" ||
 						attr == "type" ||
@@ -1046,16 +1046,16 @@ void LLXMLNode::writeToOstream(std::ostream& output_stream, const std::string& i
 			std::string contents = getTextContents();
 			output_stream << indent << "    " << escapeXML(contents) << "\n";
 		}
-		output_stream << indent << "</" << mName->mString << ">\n";
+		output_stream << indent << "</" << mName.c_str() << ">\n";
 	}
 }
 
 void LLXMLNode::findName(const std::string& name, LLXMLNodeList &results)
 {
-    LLStringTableEntry* name_entry = gStringTable.checkStringEntry(name);
+    LLInternedString name_entry = LLInternedString::find(name);
 	if (name_entry == mName)
 	{
-		results.insert(std::make_pair(this->mName->mString, this));
+		results.insert(std::make_pair(this->mName.c_str(), this));
 		return;
 	}
 	if (mChildren.notNull())
@@ -1070,11 +1070,11 @@ void LLXMLNode::findName(const std::string& name, LLXMLNodeList &results)
 	}
 }
 
-void LLXMLNode::findName(LLStringTableEntry* name, LLXMLNodeList &results)
+void LLXMLNode::findName(LLInternedString name, LLXMLNodeList &results)
 {
 	if (name == mName)
 	{
-		results.insert(std::make_pair(this->mName->mString, this));
+		results.insert(std::make_pair(this->mName.c_str(), this));
 		return;
 	}
 	if (mChildren.notNull())
@@ -1093,7 +1093,7 @@ void LLXMLNode::findID(const std::string& id, LLXMLNodeList &results)
 {
 	if (id == mID)
 	{
-		results.insert(std::make_pair(this->mName->mString, this));
+		results.insert(std::make_pair(this->mName.c_str(), this));
 		return;
 	}
 	if (mChildren.notNull())
@@ -1155,10 +1155,10 @@ void LLXMLNode::scrubToTree(LLXMLNode *tree)
 
 bool LLXMLNode::getChild(const char* name, LLXMLNodePtr& node, bool use_default_if_missing)
 {
-    return getChild(gStringTable.checkStringEntry(name), node, use_default_if_missing);
+    return getChild(LLInternedString::find(name), node, use_default_if_missing);
 }
 
-bool LLXMLNode::getChild(const LLStringTableEntry* name, LLXMLNodePtr& node, bool use_default_if_missing)
+bool LLXMLNode::getChild(LLInternedString name, LLXMLNodePtr& node, bool use_default_if_missing)
 {
 	if (mChildren.notNull())
 	{
@@ -1179,10 +1179,10 @@ bool LLXMLNode::getChild(const LLStringTableEntry* name, LLXMLNodePtr& node, boo
 
 void LLXMLNode::getChildren(const char* name, LLXMLNodeList &children, bool use_default_if_missing) const
 {
-    getChildren(gStringTable.checkStringEntry(name), children, use_default_if_missing);
+    getChildren(LLInternedString::find(name), children, use_default_if_missing);
 }
 
-void LLXMLNode::getChildren(const LLStringTableEntry* name, LLXMLNodeList &children, bool use_default_if_missing) const
+void LLXMLNode::getChildren(LLInternedString name, LLXMLNodeList &children, bool use_default_if_missing) const
 {
 	if (mChildren.notNull())
 	{
@@ -1197,7 +1197,7 @@ void LLXMLNode::getChildren(const LLStringTableEntry* name, LLXMLNodeList &child
 				{
 					break;
 				}
-				children.insert(std::make_pair(child->mName->mString, child));
+				children.insert(std::make_pair(child->mName.c_str(), child));
 				child_itr++;
 			}
 		}
@@ -1209,7 +1209,7 @@ void LLXMLNode::getChildren(const LLStringTableEntry* name, LLXMLNodeList &child
 }
 
 // recursively walks the tree and returns all children at all nesting levels matching the name
-void LLXMLNode::getDescendants(const LLStringTableEntry* name, LLXMLNodeList &children) const
+void LLXMLNode::getDescendants(LLInternedString name, LLXMLNodeList &children) const
 {
 	if (mChildren.notNull())
 	{
@@ -1219,7 +1219,7 @@ void LLXMLNode::getDescendants(const LLStringTableEntry* name, LLXMLNodeList &ch
 			LLXMLNodePtr child = (*child_itr).second;
 			if (name == child->mName)
 			{
-				children.insert(std::make_pair(child->mName->mString, child));
+				children.insert(std::make_pair(child->mName.c_str(), child));
 			}
 			// and check each child as well
 			child->getDescendants(name, children);
@@ -1229,10 +1229,10 @@ void LLXMLNode::getDescendants(const LLStringTableEntry* name, LLXMLNodeList &ch
 
 bool LLXMLNode::getAttribute(const char* name, LLXMLNodePtr& node, bool use_default_if_missing)
 {
-    return getAttribute(gStringTable.checkStringEntry(name), node, use_default_if_missing);
+    return getAttribute(LLInternedString::find(name), node, use_default_if_missing);
 }
 
-bool LLXMLNode::getAttribute(const LLStringTableEntry* name, LLXMLNodePtr& node, bool use_default_if_missing)
+bool LLXMLNode::getAttribute(LLInternedString name, LLXMLNodePtr& node, bool use_default_if_missing)
 {
 	LLXMLAttribList::const_iterator child_itr = mAttributes.find(name);
 	if (child_itr != mAttributes.end())
@@ -1250,7 +1250,7 @@ bool LLXMLNode::getAttribute(const LLStringTableEntry* name, LLXMLNodePtr& node,
 
 bool LLXMLNode::setAttributeString(const char* attr, const std::string& value)
 {
-	LLStringTableEntry* name = gStringTable.checkStringEntry(attr);
+	LLInternedString name = LLInternedString::find(attr);
 	LLXMLAttribList::const_iterator child_itr = mAttributes.find(name);
 	if (child_itr != mAttributes.end())
 	{
@@ -1734,7 +1734,7 @@ U32 LLXMLNode::getBoolValue(U32 expected_length, BOOL *array)
 	if (ret_length != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getBoolValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << ret_length << LL_ENDL;
 	}
 #endif
@@ -1787,7 +1787,7 @@ U32 LLXMLNode::getByteValue(U32 expected_length, U8 *array, Encoding encoding)
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getByteValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -1840,7 +1840,7 @@ U32 LLXMLNode::getIntValue(U32 expected_length, S32 *array, Encoding encoding)
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getIntValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -1894,7 +1894,7 @@ U32 LLXMLNode::getUnsignedValue(U32 expected_length, U32 *array, Encoding encodi
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getUnsignedValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -1948,7 +1948,7 @@ U32 LLXMLNode::getLongValue(U32 expected_length, U64 *array, Encoding encoding)
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getLongValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -1994,7 +1994,7 @@ U32 LLXMLNode::getFloatValue(U32 expected_length, F32 *array, Encoding encoding)
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getFloatValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -2039,7 +2039,7 @@ U32 LLXMLNode::getDoubleValue(U32 expected_length, F64 *array, Encoding encoding
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getDoubleValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -2087,7 +2087,7 @@ U32 LLXMLNode::getStringValue(U32 expected_length, std::string *array)
 	if (num_returned_strings != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getStringValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << num_returned_strings << LL_ENDL;
 	}
 #endif
@@ -2132,7 +2132,7 @@ U32 LLXMLNode::getUUIDValue(U32 expected_length, LLUUID *array)
 	if (i != expected_length)
 	{
 		LL_DEBUGS() << "LLXMLNode::getUUIDValue() failed for node named '" 
-			<< mName->mString << "' -- expected " << expected_length << " but "
+			<< mName.c_str() << "' -- expected " << expected_length << " but "
 			<< "only found " << i << LL_ENDL;
 	}
 #endif
@@ -2596,7 +2596,7 @@ void LLXMLNode::findDefault(LLXMLNode *defaults_list)
 	if (defaults_list)
 	{
 		LLXMLNodeList children;
-		defaults_list->getChildren(mName->mString, children);
+		defaults_list->getChildren(mName.c_str(), children);
 
 		LLXMLNodeList::const_iterator children_itr;
 		LLXMLNodeList::const_iterator children_end = children.end();
@@ -2636,7 +2636,7 @@ bool LLXMLNode::deleteChildren(const std::string& name)
 	return removed_count > 0;
 }
 
-bool LLXMLNode::deleteChildren(LLStringTableEntry* name)
+bool LLXMLNode::deleteChildren(LLInternedString name)
 {
 	U32 removed_count = 0;
 	LLXMLNodeList node_list;
@@ -2668,10 +2668,10 @@ void LLXMLNode::setAttributes(LLXMLNode::ValueType type, U32 precision, LLXMLNod
 
 void LLXMLNode::setName(const std::string& name)
 {
-	setName(gStringTable.addStringEntry(name));
+	setName(LLInternedString(name));
 }
 
-void LLXMLNode::setName(LLStringTableEntry* name)
+void LLXMLNode::setName(LLInternedString name)
 {
 	LLXMLNode* old_parent = mParent;
 	if (mParent)
@@ -2900,7 +2900,7 @@ void LLXMLNode::createUnitTest(S32 max_num_children)
 				for (U32 value=0; value<array_size; ++value)
 				{
 					random_node_array[value] = get_rand_node(root);
-					const char *node_name = random_node_array[value]->mName->mString;
+					const char *node_name = random_node_array[value]->mName.c_str();
 					for (U32 pos=0; pos<strlen(node_name); ++pos)		/* Flawfinder: ignore */
 					{
 						U32 hash_contrib = U32(node_name[pos]) << ((pos % 4) * 8);
@@ -2925,7 +2925,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 {
 	if (mChildren.isNull())
 	{
-		error_buffer.append(llformat("ERROR Node %s: No children found.\n", mName->mString));
+		error_buffer.append(llformat("ERROR Node %s: No children found.\n", mName.c_str()));
 		return false;
 	}
 
@@ -2949,14 +2949,14 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		{
 			if (!node->performUnitTest(error_buffer))
 			{
-				error_buffer.append(llformat("Child test failed for %s.\n", mName->mString));
+				error_buffer.append(llformat("Child test failed for %s.\n", mName.c_str()));
 				//return false;
 			}
 			continue;
 		}
 		if (node->mLength < 1 || node->mLength > 30)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Invalid array length %d, child %s.\n", mName->mString, node->mLength, node->mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: Invalid array length %d, child %s.\n", mName.c_str(), node->mLength, node->mName.c_str()));
 			return false;
 		}
 		switch (node->mType)
@@ -2969,7 +2969,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 				BOOL bool_array[30];
 				if (node->getBoolValue(node->mLength, bool_array) < node->mLength)
 				{
-					error_buffer.append(llformat("ERROR Node %s: Could not read boolean array, child %s.\n", mName->mString, node->mName->mString));
+					error_buffer.append(llformat("ERROR Node %s: Could not read boolean array, child %s.\n", mName.c_str(), node->mName.c_str()));
 					return false;
 				}
 				for (U32 pos=0; pos<(U32)node->mLength; ++pos)
@@ -2988,7 +2988,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 					U32 integer_array[30];
 					if (node->getUnsignedValue(node->mLength, integer_array, node->mEncoding) < node->mLength)
 					{
-						error_buffer.append(llformat("ERROR Node %s: Could not read integer array, child %s.\n", mName->mString, node->mName->mString));
+						error_buffer.append(llformat("ERROR Node %s: Could not read integer array, child %s.\n", mName.c_str(), node->mName.c_str()));
 						return false;
 					}
 					for (U32 pos=0; pos<(U32)node->mLength; ++pos)
@@ -3001,7 +3001,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 					U64 integer_array[30];
 					if (node->getLongValue(node->mLength, integer_array, node->mEncoding) < node->mLength)
 					{
-						error_buffer.append(llformat("ERROR Node %s: Could not read long integer array, child %s.\n", mName->mString, node->mName->mString));
+						error_buffer.append(llformat("ERROR Node %s: Could not read long integer array, child %s.\n", mName.c_str(), node->mName.c_str()));
 						return false;
 					}
 					for (U32 pos=0; pos<(U32)node->mLength; ++pos)
@@ -3018,7 +3018,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 					F32 float_array[30];
 					if (node->getFloatValue(node->mLength, float_array, node->mEncoding) < node->mLength)
 					{
-						error_buffer.append(llformat("ERROR Node %s: Could not read float array, child %s.\n", mName->mString, node->mName->mString));
+						error_buffer.append(llformat("ERROR Node %s: Could not read float array, child %s.\n", mName.c_str(), node->mName.c_str()));
 						return false;
 					}
 					for (U32 pos=0; pos<(U32)node->mLength; ++pos)
@@ -3032,7 +3032,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 					F64 float_array[30];
 					if (node->getDoubleValue(node->mLength, float_array, node->mEncoding) < node->mLength)
 					{
-						error_buffer.append(llformat("ERROR Node %s: Could not read float array, child %s.\n", mName->mString, node->mName->mString));
+						error_buffer.append(llformat("ERROR Node %s: Could not read float array, child %s.\n", mName.c_str(), node->mName.c_str()));
 						return false;
 					}
 					for (U32 pos=0; pos<(U32)node->mLength; ++pos)
@@ -3050,7 +3050,7 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 				LLUUID uuid_array[30];
 				if (node->getUUIDValue(node->mLength, uuid_array) < node->mLength)
 				{
-					error_buffer.append(llformat("ERROR Node %s: Could not read uuid array, child %s.\n", mName->mString, node->mName->mString));
+					error_buffer.append(llformat("ERROR Node %s: Could not read uuid array, child %s.\n", mName.c_str(), node->mName.c_str()));
 					return false;
 				}
 				for (U32 pos=0; pos<(U32)node->mLength; ++pos)
@@ -3067,12 +3067,12 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 				LLXMLNode *node_array[30];
 				if (node->getNodeRefValue(node->mLength, node_array) < node->mLength)
 				{
-					error_buffer.append(llformat("ERROR Node %s: Could not read node ref array, child %s.\n", mName->mString, node->mName->mString));
+					error_buffer.append(llformat("ERROR Node %s: Could not read node ref array, child %s.\n", mName.c_str(), node->mName.c_str()));
 					return false;
 				}
 				for (U32 pos=0; pos<node->mLength; ++pos)
 				{
-					const char *node_name = node_array[pos]->mName->mString;
+					const char *node_name = node_array[pos]->mName.c_str();
 					for (U32 pos2=0; pos2<strlen(node_name); ++pos2)		/* Flawfinder: ignore */
 					{
 						U32 hash_contrib = U32(node_name[pos2]) << ((pos2 % 4) * 8);
@@ -3092,12 +3092,12 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		if (!getAttribute("integer_checksum", checksum_node, FALSE) || 
 			checksum_node->getUnsignedValue(1, &node_integer_checksum, ENCODING_HEX) != 1)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Integer checksum missing.\n", mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: Integer checksum missing.\n", mName.c_str()));
 			return false;
 		}
 		if (node_integer_checksum != integer_checksum)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Integer checksum mismatch: read %X / calc %X.\n", mName->mString, node_integer_checksum, integer_checksum));
+			error_buffer.append(llformat("ERROR Node %s: Integer checksum mismatch: read %X / calc %X.\n", mName.c_str(), node_integer_checksum, integer_checksum));
 			return false;
 		}
 	}
@@ -3107,14 +3107,14 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		if (!getAttribute("long_checksum", checksum_node, FALSE) || 
 			checksum_node->getLongValue(1, &node_long_checksum, ENCODING_HEX) != 1)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Long Integer checksum missing.\n", mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: Long Integer checksum missing.\n", mName.c_str()));
 			return false;
 		}
 		if (node_long_checksum != long_checksum)
 		{
 			U32 *pp1 = (U32 *)&node_long_checksum;
 			U32 *pp2 = (U32 *)&long_checksum;
-			error_buffer.append(llformat("ERROR Node %s: Long Integer checksum mismatch: read %08X%08X / calc %08X%08X.\n", mName->mString, pp1[1], pp1[0], pp2[1], pp2[0]));
+			error_buffer.append(llformat("ERROR Node %s: Long Integer checksum mismatch: read %08X%08X / calc %08X%08X.\n", mName.c_str(), pp1[1], pp1[0], pp2[1], pp2[0]));
 			return false;
 		}
 	}
@@ -3124,12 +3124,12 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		if (!getAttribute("bool_true_count", checksum_node, FALSE) || 
 			checksum_node->getUnsignedValue(1, &node_bool_true_count, ENCODING_HEX) != 1)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Boolean checksum missing.\n", mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: Boolean checksum missing.\n", mName.c_str()));
 			return false;
 		}
 		if (node_bool_true_count != bool_true_count)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Boolean checksum mismatch: read %X / calc %X.\n", mName->mString, node_bool_true_count, bool_true_count));
+			error_buffer.append(llformat("ERROR Node %s: Boolean checksum mismatch: read %X / calc %X.\n", mName.c_str(), node_bool_true_count, bool_true_count));
 			return false;
 		}
 	}
@@ -3139,12 +3139,12 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		if (!getAttribute("uuid_checksum", checksum_node, FALSE) || 
 			checksum_node->getUUIDValue(1, &node_uuid_checksum) != 1)
 		{
-			error_buffer.append(llformat("ERROR Node %s: UUID checksum missing.\n", mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: UUID checksum missing.\n", mName.c_str()));
 			return false;
 		}
 		if (node_uuid_checksum != uuid_checksum)
 		{
-			error_buffer.append(llformat("ERROR Node %s: UUID checksum mismatch: read %s / calc %s.\n", mName->mString, node_uuid_checksum.asString().c_str(), uuid_checksum.asString().c_str()));
+			error_buffer.append(llformat("ERROR Node %s: UUID checksum mismatch: read %s / calc %s.\n", mName.c_str(), node_uuid_checksum.asString().c_str(), uuid_checksum.asString().c_str()));
 			return false;
 		}
 	}
@@ -3154,12 +3154,12 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		if (!getAttribute("noderef_checksum", checksum_node, FALSE) || 
 			checksum_node->getUnsignedValue(1, &node_noderef_checksum, ENCODING_HEX) != 1)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Node Ref checksum missing.\n", mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: Node Ref checksum missing.\n", mName.c_str()));
 			return false;
 		}
 		if (node_noderef_checksum != noderef_checksum)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Node Ref checksum mismatch: read %X / calc %X.\n", mName->mString, node_noderef_checksum, noderef_checksum));
+			error_buffer.append(llformat("ERROR Node %s: Node Ref checksum mismatch: read %X / calc %X.\n", mName.c_str(), node_noderef_checksum, noderef_checksum));
 			return false;
 		}
 	}
@@ -3169,12 +3169,12 @@ bool LLXMLNode::performUnitTest(std::string &error_buffer)
 		if (!getAttribute("float_checksum", checksum_node, FALSE) || 
 			checksum_node->getUnsignedValue(1, &node_float_checksum, ENCODING_HEX) != 1)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Float checksum missing.\n", mName->mString));
+			error_buffer.append(llformat("ERROR Node %s: Float checksum missing.\n", mName.c_str()));
 			return false;
 		}
 		if (node_float_checksum != float_checksum)
 		{
-			error_buffer.append(llformat("ERROR Node %s: Float checksum mismatch: read %X / calc %X.\n", mName->mString, node_float_checksum, float_checksum));
+			error_buffer.append(llformat("ERROR Node %s: Float checksum mismatch: read %X / calc %X.\n", mName.c_str(), node_float_checksum, float_checksum));
 			return false;
 		}
 	}
@@ -41,6 +41,7 @@
 #include "llrefcount.h"
 #include "llpointer.h"
 #include "llstring.h"
+#include "llinternedstring.h"
 #include "llstringtable.h"
 #include "llfile.h"
 #include "lluuid.h"
@@ -54,14 +55,9 @@ class LLColor4U;
 
 struct CompareAttributes
 {
-	bool operator()(const LLStringTableEntry* const lhs, const LLStringTableEntry* const rhs) const
+	bool operator()(LLInternedString lhs, LLInternedString rhs) const
 	{	
-		if (lhs == NULL)
-			return true;
-		if (rhs == NULL)
-			return false;
-
-		return strcmp(lhs->mString, rhs->mString) < 0;
+		return strcmp(lhs.c_str(), rhs.c_str()) < 0;
 	}
 };
 
@@ -71,8 +67,8 @@ struct CompareAttributes
 class LLXMLNode;
 typedef LLPointer<LLXMLNode> LLXMLNodePtr;
 typedef std::multimap<std::string, LLXMLNodePtr > LLXMLNodeList;
-typedef std::multimap<const LLStringTableEntry *, LLXMLNodePtr > LLXMLChildList;
-typedef std::map<const LLStringTableEntry *, LLXMLNodePtr, CompareAttributes> LLXMLAttribList;
+typedef std::multimap<LLInternedString, LLXMLNodePtr > LLXMLChildList;
+typedef std::map<LLInternedString, LLXMLNodePtr, CompareAttributes> LLXMLAttribList;
 
 class LLColor4;
 class LLColor4U;
@@ -119,7 +115,7 @@ protected:
 public:
 	LLXMLNode();
 	LLXMLNode(const char* name, bool is_attribute);
-	LLXMLNode(LLStringTableEntry* name, bool is_attribute);
+	LLXMLNode(LLInternedString name, bool is_attribute);
 	LLXMLNode(const LLXMLNode& rhs);
 	LLXMLNodePtr deepCopy();
 
@@ -161,12 +157,12 @@ public:
 
     // Utility
     void findName(const std::string& name, LLXMLNodeList &results);
-    void findName(LLStringTableEntry* name, LLXMLNodeList &results);
+    void findName(LLInternedString name, LLXMLNodeList &results);
     void findID(const std::string& id, LLXMLNodeList &results);
 
 
     virtual LLXMLNodePtr createChild(const char* name, bool is_attribute);
-    virtual LLXMLNodePtr createChild(LLStringTableEntry* name, bool is_attribute);
+    virtual LLXMLNodePtr createChild(LLInternedString name, bool is_attribute);
 
 
     // Getters
@@ -211,24 +207,24 @@ public:
     const std::string& getValue() const { return mValue; }
 	std::string getSanitizedValue() const;
 	std::string getTextContents() const;
-    const LLStringTableEntry* getName() const { return mName; }
-	bool hasName(const char* name) const { return mName == gStringTable.checkStringEntry(name); }
-	bool hasName(const std::string& name) const { return mName == gStringTable.checkStringEntry(name.c_str()); }
+    LLInternedString getName() const { return mName; }
+	bool hasName(const char* name) const { return mName == LLInternedString::find(name); }
+	bool hasName(const std::string& name) const { return mName == LLInternedString::find(name); }
     const std::string& getID() const { return mID; }
 
     U32 getChildCount() const;
     // getChild returns a Null LLXMLNode (not a NULL pointer) if there is no such child.
     // This child has no value so any getTYPEValue() calls on it will return 0.
     bool getChild(const char* name, LLXMLNodePtr& node, bool use_default_if_missing = true);
-    bool getChild(const LLStringTableEntry* name, LLXMLNodePtr& node, bool use_default_if_missing = true);
+    bool getChild(LLInternedString name, LLXMLNodePtr& node, bool use_default_if_missing = true);
     void getChildren(const char* name, LLXMLNodeList &children, bool use_default_if_missing = true) const;
-    void getChildren(const LLStringTableEntry* name, LLXMLNodeList &children, bool use_default_if_missing = true) const;
+    void getChildren(LLInternedString name, LLXMLNodeList &children, bool use_default_if_missing = true) const;
 	
 	// recursively finds all children at any level matching name
-	void getDescendants(const LLStringTableEntry* name, LLXMLNodeList &children) const;
+	void getDescendants(LLInternedString name, LLXMLNodeList &children) const;
 
 	bool getAttribute(const char* name, LLXMLNodePtr& node, bool use_default_if_missing = true);
-	bool getAttribute(const LLStringTableEntry* name, LLXMLNodePtr& node, bool use_default_if_missing = true);
+	bool getAttribute(LLInternedString name, LLXMLNodePtr& node, bool use_default_if_missing = true);
 
 	S32 getLineNumber();
 
@@ -265,7 +261,7 @@ public:
 	void setNodeRefValue(U32 length, const LLXMLNode **array);
 	void setValue(const std::string& value);
 	void setName(const std::string& name);
-	void setName(LLStringTableEntry* name);
+	void setName(LLInternedString name);
 
 	void setLineNumber(S32 line_number);
 
@@ -284,7 +280,7 @@ public:
 	void scrubToTree(LLXMLNode *tree);
 
 	bool deleteChildren(const std::string& name);
-	bool deleteChildren(LLStringTableEntry* name);
+	bool deleteChildren(LLInternedString name);
 	void setAttributes(ValueType type, U32 precision, Encoding encoding, U32 length);
 // 	void appendValue(const std::string& value); // Unused
 
@@ -319,7 +315,7 @@ public:
 	static bool sStripWhitespaceValues;
 	
 protected:
-	LLStringTableEntry *mName;		// The name of this node
+	LLInternedString mName;		// The name of this node
 
 	// The value of this node (use getters/setters only)
 	// Values are not XML-escaped in memory
@@ -122,7 +122,8 @@ static void ssl_verification_changed();
 LLAppCoreHttp::HttpClass::HttpClass()
 	: mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
 	  mConnLimit(0U),
-	  mPipelined(false)
+	  mPipelined(false),
+	  mMultiplexed(false)
 {}
 
 
@@ -131,7 +132,9 @@ LLAppCoreHttp::LLAppCoreHttp()
 	  mStopHandle(LLCORE_HTTP_HANDLE_INVALID),
 	  mStopRequested(0.0),
 	  mStopped(false),
-	  mPipelined(true)
+	  mPipelined(true),
+	  mMultiplexed(true),
+	  mHedgeDelay(0U)
 {}
 
 
@@ -258,6 +261,24 @@ void LLAppCoreHttp::init()
 		}
 	}
 
+	// HTTP/2 for the pipelined (CDN) classes.  Init-time only, a
+	// class can't leave the shared connections while requests are
+	// running on them.
+	static const std::string http_multiplexing("HttpMultiplexing");
+	if (gSavedSettings.controlExists(http_multiplexing))
+	{
+		mMultiplexed = gSavedSettings.getbool(http_multiplexing);
+		LL_INFOS("Init") << "HTTP/2 multiplexing " << (mMultiplexed ? "enabled" : "disabled") << "!" << LL_ENDL;
+	}
+
+	// Hedged CDN requests.  Init-time only.
+	static const std::string http_hedge_delay("HttpHedgeDelay");
+	if (gSavedSettings.controlExists(http_hedge_delay))
+	{
+		mHedgeDelay = gSavedSettings.getU32(http_hedge_delay);
+		LL_INFOS("Init") << "HTTP hedge delay " << mHedgeDelay << " mS" << LL_ENDL;
+	}
+
 	// Need a request object to handle dynamic options before setting them
 	mRequest = new LLCore::HttpRequest;
 
@@ -415,6 +436,36 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 				}
 			}
 
+			if (init_data[i].mPipelined && mHedgeDelay)
+			{
+				// CDN fetches are idempotent, hedge the slow ones
+				status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_HEDGE_DELAY,
+																	mHttpClasses[app_policy].mPolicy,
+																	long(mHedgeDelay),
+																	NULL);
+				if (! status)
+				{
+					LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+									 << " hedge delay.  Reason:  " << status.toString()
+									 << LL_ENDL;
+				}
+			}
+
+			if (init_data[i].mPipelined)
+			{
+				// Keep a failing CDN from being hit with a retry
+				// for every texture and mesh it drops
+				status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_RETRY_BUDGET,
+																	mHttpClasses[app_policy].mPolicy,
+																	1L,
+																	NULL);
+				if (! status)
+				{
+					LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+									 << " retry budget.  Reason:  " << status.toString()
+									 << LL_ENDL;
+				}
+			}
 		}
 
 		// Init- or run-time settings.  Must use the queued request API.
@@ -449,6 +500,8 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 					mHttpClasses[app_policy].mPipelined = to_pipeline;
 				}
 			}
+
+			mHttpClasses[app_policy].mMultiplexed = mMultiplexed && init_data[i].mPipelined;
 		}
 		
 		// Get target connection concurrency value
@@ -510,6 +563,24 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 									  << " concurrency.  New value:  " << setting
 									  << LL_ENDL;
 					mHttpClasses[app_policy].mConnLimit = setting;
+					if (mHttpClasses[app_policy].mMultiplexed)
+					{
+						// Multiplexed classes are limited by streams
+						// rather than connections, allow as many as
+						// pipelining would have had in flight.
+						const long stream_limit(setting * PIPELINING_DEPTH);
+						handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_STREAM_LIMIT,
+														   mHttpClasses[app_policy].mPolicy,
+														   stream_limit,
+														   LLCore::HttpHandler::ptr_t());
+						if (LLCORE_HTTP_HANDLE_INVALID == handle)
+						{
+							status = mRequest->getStatus();
+							LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+											 << " stream limit.  Reason:  " << status.toString()
+											 << LL_ENDL;
+						}
+					}
 					if (initial && setting != init_data[i].mDefault)
 					{
 						LL_INFOS("Init") << "Application settings overriding default " << init_data[i].mUsage
@@ -70,6 +70,7 @@
 #endif
 #include "lltexturestats.h"
 #include "lltrace.h"
+#include "lltraceeventlog.h"
 #include "lltracethreadrecorder.h"
 #include "llviewerwindow.h"
 #include "llviewerdisplay.h"
@@ -155,11 +156,14 @@
 #include <boost/lexical_cast.hpp>
 
 #include "llviewerinput.h"
-#include "lllfsthread.h"
+#include "llfileioservice.h"
+#include "llframeallocator.h"
+#include "llheaptracker.h"
 #include "llworkerthread.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
 #include "llimageworker.h"
+#include "lleventchannel.h"
 #include "llevents.h"
 
 // The files below handle dependencies from cleanup.
@@ -558,6 +562,10 @@ static void settings_to_globals()
 	gDebugWindowProc = gSavedSettings.getbool("DebugWindowProc");
 	gShowObjectUpdates = gSavedSettings.getbool("ShowObjectUpdates");
     LLWorldMapView::setScaleSetting(gSavedSettings.getF32("MapScale"));
+	if (gSavedSettings.getU32("HeapTrackerSampleInterval"))
+	{
+		LLHeapTracker::setSampleInterval(gSavedSettings.getU32("HeapTrackerSampleInterval"));
+	}
 	
 #if LL_DARWIN
 	gRetinaSupport = gSavedSettings.getbool("RenderRetina");
@@ -602,6 +610,39 @@ public:
 	}
 };
 
+// Streams every thread's block timer and stat events to a binary
+// file, see scripts/metrics/lltrace_conv.py to view it.
+class LLTraceEventLogThread : public LLThread
+{
+public:
+	std::string mFile;
+
+	LLTraceEventLogThread() : LLThread("trace event log")
+	{
+		mFile = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "viewer.lltrace");
+	}
+
+	void run()
+	{
+		llofstream os(mFile.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		LLTrace::EventLog::writeHeader(os);
+
+		while (!LLAppViewer::instance()->isQuitting())
+		{
+			LLTrace::EventLog::write(os);
+			os.flush();
+			ms_sleep(32);
+		}
+
+		LLTrace::EventLog::stop();
+		LLTrace::EventLog::write(os);
+		os.close();
+
+		LL_INFOS() << "Wrote trace events to " << mFile << ", "
+				   << LLTrace::EventLog::getDropCount() << " dropped" << LL_ENDL;
+	}
+};
+
 //virtual
 bool LLAppViewer::initSLURLHandler()
 {
@@ -655,6 +696,7 @@ LLAppViewer::LLAppViewer()
 	mRandomizeFramerate(LLCachedControl<bool>(gSavedSettings,"Randomize Framerate", FALSE)),
 	mPeriodicSlowFrame(LLCachedControl<bool>(gSavedSettings,"Periodic Slow Frame", FALSE)),
 	mFastTimerLogThread(NULL),
+	mTraceEventLogThread(NULL),
 	mSettingsLocationList(NULL),
 	mIsFirstRun(false),
 	mSaveSettingsOnExit(true)		// <FS:Zi> Backup Settings
@@ -874,6 +916,10 @@ bool LLAppViewer::init()
 		LLError::setFatalFunction([rc](const std::string&){ _exit(rc); });
 	}
 
+	// Also needs gSavedSettings.  Keeps worker threads that log heavily
+	// (e.g. with debug tags on) from serializing on the log file.
+	LLError::setAsyncLogging(gSavedSettings.getBOOL("AsyncLogging"));
+
 	// <FS:Ansariel> Get rid of unused LLAllocator
     //mAlloc.setProfilingEnabled(gSavedSettings.getBOOL("MemProfiling"));
 
@@ -1424,7 +1470,6 @@ static LLTrace::BlockTimerStatHandle FTM_TEXTURE_CACHE("Texture Cache");
 static LLTrace::BlockTimerStatHandle FTM_DECODE("Image Decode");
 static LLTrace::BlockTimerStatHandle FTM_FETCH("Image Fetch");
 
-static LLTrace::BlockTimerStatHandle FTM_LFS("LFS Thread");
 static LLTrace::BlockTimerStatHandle FTM_PAUSE_THREADS("Pause Threads");
 static LLTrace::BlockTimerStatHandle FTM_IDLE("Idle");
 static LLTrace::BlockTimerStatHandle FTM_PUMP("Pump");
@@ -1483,8 +1528,7 @@ bool LLAppViewer::doFrame()
         LLWorld::createInstance();
     }
 
-	LLEventPump& mainloop(LLEventPumps::instance().obtain("mainloop"));
-	LLSD newFrame;
+	LLEventChannel<>& mainloop(ll_mainloop_channel());
 
     if (LLFloaterReg::instanceVisible("block_timers"))
     {
@@ -1533,13 +1577,17 @@ bool LLAppViewer::doFrame()
 		}
 
 
-		// canonical per-frame event
-		mainloop.post(newFrame);
-
-		// give listeners a chance to run
-		llcoro::suspend();
-		// if one of our coroutines threw an uncaught exception, rethrow it now
-		LLCoros::instance().rethrow();
+		{
+			LL_HEAP_CATEGORY("Main Loop Listeners");
+			// canonical per-frame event: typed listeners, then the
+			// "mainloop" LLEventPump
+			mainloop.post();
+
+			// give listeners a chance to run
+			llcoro::suspend();
+			// if one of our coroutines threw an uncaught exception, rethrow it now
+			LLCoros::instance().rethrow();
+		}
 
 
 		if (!LLApp::isExiting())
@@ -1577,6 +1625,7 @@ bool LLAppViewer::doFrame()
 
 				{
 					//LL_RECORD_BLOCK_TIME(FTM_IDLE);
+					LL_HEAP_CATEGORY("Idle");
 					idle();
 				}
 
@@ -1606,7 +1655,10 @@ bool LLAppViewer::doFrame()
 				pingMainloopTimeout("Main:Display");
 				gGLActive = true;
 
-				display();
+				{
+					LL_HEAP_CATEGORY("Display");
+					display();
+				}
 
 				{
 					LL_PROFILE_ZONE_NAMED_CATEGORY_APP( "df Snapshot" )
@@ -1680,7 +1732,6 @@ bool LLAppViewer::doFrame()
 			}
 
 			S32 total_work_pending = 0;
-			S32 total_io_pending = 0;
 			{
 				S32 work_pending = 0;
 				S32 io_pending = 0;
@@ -1688,10 +1739,7 @@ bool LLAppViewer::doFrame()
 
 				work_pending += updateTextureThreads(max_time);
 
-				{
-					LL_RECORD_BLOCK_TIME(FTM_LFS);
- 					io_pending += LLLFSThread::updateClass(1);
-				}
+				io_pending += S32(LLFileIOService::instance().getPending());
 
 				if (io_pending > 1000)
 				{
@@ -1699,7 +1747,6 @@ bool LLAppViewer::doFrame()
 				}
 
 				total_work_pending += work_pending ;
-				total_io_pending += io_pending ;
 
 			}
 
@@ -1715,12 +1762,6 @@ bool LLAppViewer::doFrame()
 				LLAppViewer::getImageDecodeThread()->pause();
 				LLAppViewer::getTextureFetch()->pause();
 			}
-			if(!total_io_pending) //pause file threads if nothing to process.
-			{
-				LL_PROFILE_ZONE_NAMED_CATEGORY_APP( "df LLVFSThread" )
-				LLLFSThread::sLocal->pause();
-			}
-
 			//texture fetching debugger
 			if(LLTextureFetchDebugger::isEnabled())
 			{
@@ -1762,6 +1803,9 @@ bool LLAppViewer::doFrame()
 		LL_INFOS() << "Exiting main_loop" << LL_ENDL;
 	}
 
+	// frame temporaries are done with
+	LLFrameArena::endFrame();
+
     LL_PROFILER_FRAME_END
 
 	return ! LLApp::isRunning();
@@ -1789,7 +1833,7 @@ void LLAppViewer::flushLFSIO()
 {
 	while (1)
 	{
-		S32 pending = LLLFSThread::updateClass(0);
+		size_t pending = LLFileIOService::instance().getPending();
 		if (!pending)
 		{
 			break;
@@ -1863,6 +1907,7 @@ bool LLAppViewer::cleanup()
 
 	release_start_screen(); // just in case
 
+	LLError::setAsyncLogging(false); // write anything queued, log synchronously from here on
 	LLError::logToFixedBuffer(NULL); // stop the fixed buffer recorder
 
 	LL_INFOS() << "Cleaning Up" << LL_ENDL;
@@ -2183,7 +2228,7 @@ bool LLAppViewer::cleanup()
 		pending += LLAppViewer::getTextureCache()->update(1); // unpauses the worker thread
 		pending += LLAppViewer::getImageDecodeThread()->update(1); // unpauses the image thread
 		pending += LLAppViewer::getTextureFetch()->update(1); // unpauses the texture fetch thread
-		pending += LLLFSThread::updateClass(0);
+		pending += S32(LLFileIOService::instance().getPending());
 		F64 idle_time = idleTimer.getElapsedTimeF64();
 		if(!pending)
 		{
@@ -2237,6 +2282,8 @@ bool LLAppViewer::cleanup()
     sImageDecodeThread = NULL;
 	delete mFastTimerLogThread;
 	mFastTimerLogThread = NULL;
+	delete mTraceEventLogThread;
+	mTraceEventLogThread = NULL;
 	delete sPurgeDiskCacheThread;
 	sPurgeDiskCacheThread = NULL;
     delete mGeneralThreadPool;
@@ -2267,7 +2314,12 @@ bool LLAppViewer::cleanup()
 	LLUIImageList::getInstance()->cleanUp();
 
 	SUBSYSTEM_CLEANUP(LLImage);
-	SUBSYSTEM_CLEANUP(LLLFSThread);
+	LLFileIOService::deleteSingleton();
+
+#if LL_REFCOUNT_AUDIT
+	// the session's heaviest reference counting, with the worker threads done
+	LLRefCountAudit::log();
+#endif
 
 	LL_INFOS() << "Misc Cleanup" << LL_ENDL;
 
@@ -2335,7 +2387,15 @@ void LLAppViewer::initGeneralThread()
         return;
     }
 
-    mGeneralThreadPool = new LL::ThreadPool("General", 3);
+    // Same sizing either way, ThreadPoolSizes overrides both
+    if (gSavedSettings.getBOOL("ThreadPoolWorkStealing"))
+    {
+        mGeneralThreadPool = new LL::WorkStealingThreadPool("General", 3);
+    }
+    else
+    {
+        mGeneralThreadPool = new LL::ThreadPool("General", 3);
+    }
     mGeneralThreadPool->start();
 }
 
@@ -2345,7 +2405,7 @@ bool LLAppViewer::initThreads()
 
 	LLImage::initClass(gSavedSettings.getbool("TextureNewByteRange"),gSavedSettings.getS32("TextureReverseByteRange"));
 
-	LLLFSThread::initClass(false);
+	LLFileIOService::createInstance();
 
 	// Image decoding
 	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(true);
@@ -2363,6 +2423,14 @@ bool LLAppViewer::initThreads()
 		mFastTimerLogThread->start();
 	}
 
+	if (gSavedSettings.getBOOL("TraceEventLog"))
+	{
+		// From here, names this thread "main"
+		LLTrace::EventLog::start();
+		mTraceEventLogThread = new LLTraceEventLogThread();
+		mTraceEventLogThread->start();
+	}
+
 	// Mesh streaming and caching
 	gMeshRepo.init();
 
@@ -5421,7 +5489,6 @@ void LLAppViewer::outOfMemorySoftQuit()
         // Pause decoding and mesh repositorie
         getTextureCache()->pause();
         getTextureFetch()->pause();
-        LLLFSThread::sLocal->pause();
         gLogoutTimer.reset();
         mQuitRequested = true;
 
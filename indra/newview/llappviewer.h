@@ -302,7 +302,7 @@ private:
 	static LLImageDecodeThread* sImageDecodeThread; 
 	static LLTextureFetch* sTextureFetch;
 	static LLPurgeDiskCacheThread* sPurgeDiskCacheThread;
-    LL::ThreadPool* mGeneralThreadPool;
+    LL::ThreadPoolBase* mGeneralThreadPool;
 
 	S32 mNumSessions;
 
@@ -329,6 +329,7 @@ private:
 
 	// For performance and metric gathering
 	class LLThread*	mFastTimerLogThread;
+	class LLThread*	mTraceEventLogThread;
 
 	// for tracking viewer<->region circuit death
 	bool mAgentRegionLastAlive;
@@ -0,0 +1,157 @@
+/**
+ * @file llfloaterheapprofile.cpp
+ * @brief Shows where the heap tracker sees live memory, debug use only
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llfloaterheapprofile.h"
+
+#include "lldir.h"
+#include "llnotificationsutil.h"
+#include "llscrolllistctrl.h"
+#include "lltexteditor.h"
+#include "llviewercontrol.h"
+
+// sites shown in the list, the dump has more
+static const size_t TOP_SITES = 50;
+
+LLFloaterHeapProfile::LLFloaterHeapProfile(const LLSD& key)
+	: LLFloater(key),
+	mSiteList(NULL),
+	mStackText(NULL)
+{
+	mCommitCallbackRegistrar.add("HeapProfile.Refresh", boost::bind(&LLFloaterHeapProfile::refreshSites, this));
+	mCommitCallbackRegistrar.add("HeapProfile.Reset", boost::bind(&LLFloaterHeapProfile::onClickReset, this));
+	mCommitCallbackRegistrar.add("HeapProfile.Dump", boost::bind(&LLFloaterHeapProfile::onClickDump, this));
+	mCommitCallbackRegistrar.add("HeapProfile.SelectSite", boost::bind(&LLFloaterHeapProfile::onSelectSite, this));
+}
+
+LLFloaterHeapProfile::~LLFloaterHeapProfile()
+{
+}
+
+bool LLFloaterHeapProfile::postBuild()
+{
+	mSiteList = getChild<LLScrollListCtrl>("site_list");
+	mStackText = getChild<LLTextEditor>("stack_text");
+	return true;
+}
+
+void LLFloaterHeapProfile::onOpen(const LLSD& key)
+{
+	refreshSites();
+}
+
+void LLFloaterHeapProfile::refreshSites()
+{
+	LLStringUtil::format_map_t args;
+	args["[INTERVAL]"] = llformat("%u", (U32)LLHeapTracker::getSampleInterval());
+	args["[LIVE]"] = llformat("%.1f", LLHeapTracker::getLiveBytes() / (1024.0 * 1024.0));
+	if (!LLHeapTracker::isAvailable())
+	{
+		getChild<LLUICtrl>("status_text")->setValue(getString("unavailable"));
+	}
+	else if (!LLHeapTracker::getSampleInterval())
+	{
+		getChild<LLUICtrl>("status_text")->setValue(getString("stopped", args));
+	}
+	else
+	{
+		getChild<LLUICtrl>("status_text")->setValue(getString("sampling", args));
+	}
+
+	// categories first, then the call sites, biggest first
+	mSites = LLHeapTracker::getTopSites(TOP_SITES);
+	mSiteList->deleteAllItems();
+	mStackText->clear();
+	for (const LLHeapTracker::category_list_t::value_type& category : LLHeapTracker::getCategories())
+	{
+		LLSD row;
+		row["id"] = -1;
+		row["columns"][0]["column"] = "live";
+		row["columns"][0]["value"] = llformat("%.0f", category.second / 1024.0);
+		row["columns"][1]["column"] = "count";
+		row["columns"][1]["value"] = "";
+		row["columns"][2]["column"] = "category";
+		row["columns"][2]["value"] = category.first;
+		row["columns"][2]["font"]["style"] = "BOLD";
+		row["columns"][3]["column"] = "site";
+		row["columns"][3]["value"] = getString("all_sites");
+		mSiteList->addElement(row);
+	}
+
+	for (size_t i = 0; i < mSites.size(); ++i)
+	{
+		const LLHeapTracker::Site& site(mSites[i]);
+		LLSD row;
+		row["id"] = (S32)i;
+		row["columns"][0]["column"] = "live";
+		row["columns"][0]["value"] = llformat("%.0f", site.mLiveBytes / 1024.0);
+		row["columns"][1]["column"] = "count";
+		row["columns"][1]["value"] = llformat("%.0f", site.mLiveCount);
+		row["columns"][2]["column"] = "category";
+		row["columns"][2]["value"] = site.mCategory;
+		row["columns"][3]["column"] = "site";
+		row["columns"][3]["value"] = site.mFrames.empty() ? std::string() : site.mFrames.front();
+		mSiteList->addElement(row);
+	}
+}
+
+void LLFloaterHeapProfile::onSelectSite()
+{
+	LLScrollListItem* item = mSiteList->getFirstSelected();
+	S32 index = item ? item->getValue().asInteger() : -1;
+	if (index < 0 || index >= (S32)mSites.size())
+	{
+		mStackText->clear();
+		return;
+	}
+
+	const LLHeapTracker::Site& site(mSites[index]);
+	std::string text = llformat("%.0f KB allocated in all, %u live samples\n",
+								site.mTotalBytes / 1024.0, site.mSamples);
+	for (const std::string& frame : site.mFrames)
+	{
+		text += frame + "\n";
+	}
+	mStackText->setText(text);
+}
+
+void LLFloaterHeapProfile::onClickReset()
+{
+	LLHeapTracker::reset();
+	refreshSites();
+}
+
+void LLFloaterHeapProfile::onClickDump()
+{
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "heap_profile.txt");
+	if (LLHeapTracker::dump(filename))
+	{
+		LLSD args;
+		args["MESSAGE"] = getString("dumped") + " " + filename;
+		LLNotificationsUtil::add("SystemMessageTip", args);
+	}
+}
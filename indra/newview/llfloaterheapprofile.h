@@ -0,0 +1,57 @@
+/**
+ * @file llfloaterheapprofile.h
+ * @brief Shows where the heap tracker sees live memory, debug use only
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFLOATERHEAPPROFILE_H
+#define LL_LLFLOATERHEAPPROFILE_H
+
+#include "llfloater.h"
+#include "llheaptracker.h"
+
+class LLScrollListCtrl;
+class LLTextEditor;
+
+class LLFloaterHeapProfile : public LLFloater
+{
+	friend class LLFloaterReg;
+public:
+	virtual bool postBuild();
+	virtual void onOpen(const LLSD& key);
+
+private:
+	LLFloaterHeapProfile(const LLSD& key);
+	virtual ~LLFloaterHeapProfile();
+
+	void refreshSites();
+	void onClickReset();
+	void onClickDump();
+	void onSelectSite();
+
+	LLScrollListCtrl*			mSiteList;
+	LLTextEditor*				mStackText;
+	LLHeapTracker::site_list_t	mSites;
+};
+
+#endif // LL_LLFLOATERHEAPPROFILE_H
@@ -139,6 +139,7 @@ mAvatarTabIndex(0)
 	mLastMouseY = 0;
 	mStatusLock = new LLMutex();
 	mModelPreview = NULL;
+	mDecompRequestCount = 0;
 
 	mLODMode[LLModel::LOD_HIGH] = LLModelPreview::LOD_FROM_FILE;
 	for (U32 i = 0; i < LLModel::LOD_HIGH; i++)
@@ -1037,6 +1038,7 @@ void LLFloaterModelPreview::onPhysicsStageExecute(LLUICtrl* ctrl, void* data)
 				sInstance->mCurRequest.insert(request);
 				gMeshRepo.mDecompThread->submitRequest(request);
 			}
+			sInstance->mDecompRequestCount = sInstance->mCurRequest.size();
 		}
 
 		if (stage == "Decompose")
@@ -1945,6 +1947,15 @@ void LLFloaterModelPreview::DecompRequest::completed()
 			}
 
 			sInstance->mCurRequest.erase(this);
+
+			// models complete independently, report how many are done
+			if (!sInstance->mCurRequest.empty())
+			{
+				LLStringUtil::format_map_t args;
+				args["[DONE]"] = llformat("%d", sInstance->mDecompRequestCount - (S32) sInstance->mCurRequest.size());
+				args["[TOTAL]"] = llformat("%d", sInstance->mDecompRequestCount);
+				sInstance->setStatusMessage(sInstance->getString("decomposition_progress", args));
+			}
 		}
 	}
 	else if (sInstance)
@@ -191,6 +191,8 @@ protected:
 	static S32		sUploadAmount;
 	
 	std::set<LLPointer<DecompRequest> > mCurRequest;
+	//number of models submitted by the last physics stage
+	S32 mDecompRequestCount;
 	std::string mStatusMessage;
 
 	//use "disabled" as false by default
@@ -70,6 +70,7 @@
 #include "bufferarray.h"
 #include "bufferstream.h"
 #include "llfasttimer.h"
+#include "hbxxh.h"
 #include "llcorehttputil.h"
 #include "lltrans.h"
 #include "llstatusbar.h"
@@ -166,14 +167,15 @@
 //   LLMeshRepoThread::mMutex
 //   LLMeshRepoThread::mHeaderMutex
 //   LLMeshRepoThread::mSignal (LLCondition)
-//   LLPhysicsDecomp::mSignal (LLCondition)
 //   LLPhysicsDecomp::mMutex
+//   LLPhysicsDecomp::mLibraryMutex
 //   LLMeshUploadThread::mMutex
 //
 // Mutex Order Rules
 //
 //   1.  LLMeshRepoThread::mMutex before LLMeshRepoThread::mHeaderMutex
 //   2.  LLMeshRepository::mMeshMutex before LLMeshRepoThread::mMutex
+//   3.  LLPhysicsDecomp::mLibraryMutex before LLPhysicsDecomp::mMutex
 //   (There are more rules, haven't been extracted.)
 //
 // Data Member Access/Locking
@@ -214,6 +216,7 @@
 //   LLMeshRepository:
 //
 //     sBytesReceived                  none            rw.repo.none, ro.main.none [1]
+//     sBytesCopied                    "
 //     sMeshRequestCount               "
 //     sHTTPRequestCount               "
 //     sHTTPLargeRequestCount          "
@@ -373,6 +376,7 @@ const long UPLOAD_RETRY_LIMIT = 0L;
 const S32 MAX_MESH_VERSION = 999;
 
 U32 LLMeshRepository::sBytesReceived = 0;
+U32 LLMeshRepository::sBytesCopied = 0;
 U32 LLMeshRepository::sMeshRequestCount = 0;
 U32 LLMeshRepository::sHTTPRequestCount = 0;
 U32 LLMeshRepository::sHTTPLargeRequestCount = 0;
@@ -1994,17 +1998,10 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	{
 		if (volume->getNumFaces() > 0)
 		{
-			LoadedMesh mesh(volume, mesh_params, lod);
-			{
-				LLMutexLock lock(mMutex);
-				mLoadedQ.push_back(mesh);
-				// LLPointer is not thread safe, since we added this pointer into
-				// threaded list, make sure counter gets decreased inside mutex lock
-				// and won't affect mLoadedQ processing
-				volume = NULL;
-				// might be good idea to turn mesh into pointer to avoid making a copy
-				mesh.mVolume = NULL;
-			}
+			LLMutexLock lock(mMutex);
+			// LLVolume's count isn't thread safe, so hand our reference
+			// over to the queue without touching it
+			mLoadedQ.push_back(LoadedMesh(std::move(volume), mesh_params, lod));
 			return MESH_OK;
 		}
 	}
@@ -2161,6 +2158,7 @@ LLMeshUploadThread::LLMeshUploadThread(LLMeshUploadThread::instance_list& data,
     mLockScaleIfJointPosition = lock_scale_if_joint_position;
 	mMutex = new LLMutex();
 	mPendingUploads = 0;
+	mPendingDecomps = 0;
 	mFinished = false;
 	mOrigin = gAgent.getPositionAgent();
 	mHost = gAgent.getRegionHost();
@@ -2201,21 +2199,15 @@ LLMeshUploadThread::DecompRequest::DecompRequest(LLModel* mdl, LLModel* base_mod
 	
 	//copy out positions and indices
 	assignData(mdl) ;	
-
-	mThread->mFinalDecomp = this;
-	mThread->mPhysicsComplete = false;
 }
 
 void LLMeshUploadThread::DecompRequest::completed()
 {
-	if (mThread->mFinalDecomp == this)
-	{
-		mThread->mPhysicsComplete = true;
-	}
-
 	llassert(mHull.size() == 1);
 	
 	mThread->mHullMap[mBaseModel] = mHull[0];
+
+	mThread->mPendingDecomps--;
 }
 
 //called in the main thread.
@@ -2658,6 +2650,7 @@ void LLMeshUploadThread::generateHulls()
 		DecompRequest* request = new DecompRequest(physics, data.mBaseModel, this);
 		if(request->isValid())
 		{
+			mPendingDecomps++;
 			gMeshRepo.mDecompThread->submitRequest(request);
 			has_valid_requests = true ;
 		}
@@ -2671,7 +2664,7 @@ void LLMeshUploadThread::generateHulls()
 		// the decomposition thread and the upload thread and this loop
 		// wouldn't complete in turn stalling the main thread.  The check
 		// on isDiscarded() prevents that.
-		while (! mPhysicsComplete && ! isDiscarded())
+		while (mPendingDecomps > 0 && ! isDiscarded())
 		{
 			apr_sleep(100);
 		}
@@ -3133,6 +3126,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 		LLCore::BufferArray * body(response->getBody());
 		S32 body_offset(0);
 		U8 * data(NULL);
+		U8 * data_copy(NULL);
 		S32 data_size(body ? body->size() : 0);
 
 		if (data_size > 0)
@@ -3185,16 +3179,21 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 				goto common_exit;
 			}
 			
-			// *TODO: Try to get rid of data copying and add interfaces
-			// that support BufferArray directly.  Introduce a two-phase
-			// handler, optional first that takes a body, fallback second
-			// that requires a temporary allocation and data copy.
+			// Bodies of known length arrive in one block and are
+			// used in place.  Otherwise fall back to a temporary
+			// allocation and data copy.
 			body_offset = mOffset - offset;
-			data = new(std::nothrow) U8[data_size - body_offset];
+			data = (U8 *) body->getContiguous(body_offset, data_size - body_offset);
 			if (data)
 			{
+				LLMeshRepository::sBytesReceived += data_size;
+			}
+			else if ((data = new(std::nothrow) U8[data_size - body_offset]))
+			{
+				data_copy = data;
 				body->read(body_offset, (char *) data, data_size - body_offset);
 				LLMeshRepository::sBytesReceived += data_size;
+				LLMeshRepository::sBytesCopied += data_size - body_offset;
 			}
 			else
 			{
@@ -3205,7 +3204,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 
 		processData(body, body_offset, data, data_size - body_offset);
 
-		delete [] data;
+		delete [] data_copy;
 	}
 
 	// Release handler
@@ -4824,14 +4823,37 @@ bool LLMeshRepository::getCostData(LLSD& header, LLMeshCostData& data)
     return true;
 }
 
-LLPhysicsDecomp::LLPhysicsDecomp()
-: LLThread("Physics Decomp")
+// Upper bound on cached decomposition results and hull meshes
+static const size_t MAX_DECOMP_CACHE_ENTRIES = 256;
+static const size_t MAX_HULL_MESH_CACHE_ENTRIES = 4096;
+
+// Request being processed by the calling worker, for llcdCallback
+static thread_local LLPhysicsDecomp::Request* sCurRequest = NULL;
+
+// Copy of a request's inputs, used to replay a cached stage in the library
+class LLDecompReplayRequest : public LLPhysicsDecomp::Request
 {
-	mInited = false;
-	mQuitting = false;
-	mDone = false;
+public:
+	LLDecompReplayRequest(const LLPhysicsDecomp::Request& request)
+	{
+		mDecompID = request.mDecompID;
+		mStage = request.mStage;
+		mPositions = request.mPositions;
+		mIndices = request.mIndices;
+		mParams = request.mParams;
+	}
 
-	mSignal = new LLCondition();
+	S32 statusCallback(const char* status, S32 p1, S32 p2) { return 1; }
+	void completed() { }
+};
+
+LLPhysicsDecomp::LLPhysicsDecomp()
+: LL::ThreadPool("PhysicsDecomp", 2),
+	mInited(false),
+	mWidth((S32) getConfiguredWidth("PhysicsDecomp", 2)),
+	mThreadsInited(0),
+	mQuitting(false)
+{
 	mMutex = new LLMutex();
 }
 
@@ -4839,45 +4861,291 @@ LLPhysicsDecomp::~LLPhysicsDecomp()
 {
 	shutdown();
 
-	delete mSignal;
-	mSignal = NULL;
+	// requests that never ran, completed() will not be called
+	for (std::map<S32*, DecompState>::iterator iter = mDecomps.begin(); iter != mDecomps.end(); ++iter)
+	{
+		for (Request* request : iter->second.mPending)
+		{
+			request->unref();
+		}
+	}
+	while (!mCompletedQ.empty())
+	{
+		mCompletedQ.front()->unref();
+		mCompletedQ.pop();
+	}
+
 	delete mMutex;
 	mMutex = NULL;
 }
 
+void LLPhysicsDecomp::start()
+{
+	LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
+	if (decomp == NULL || mWidth <= 0)
+	{
+		// stub library. Set init to true so the main thread
+		// doesn't wait for this to finish.
+		mInited = true;
+		return;
+	}
+
+	// fill in stage ids before any worker can look them up
+	const LLCDStageData* stages = NULL;
+	S32 num_stages = decomp->getStages(&stages);
+	for (S32 i = 0; i < num_stages; i++)
+	{
+		mStageID[stages[i].mName] = i;
+	}
+
+	LL::ThreadPool::start();
+}
+
 void LLPhysicsDecomp::shutdown()
 {
-	if (mSignal)
 	{
+		LLMutexLock lock(mMutex);
 		mQuitting = true;
-		// There is only one wait(), but just in case 'broadcast'
-		mSignal->broadcast();
+	}
+	close();
+}
 
-		while (!isStopped())
-		{
-			apr_sleep(10);
-		}
+void LLPhysicsDecomp::run()
+{
+	LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
+	decomp->initThread();
+	if (++mThreadsInited == mWidth)
+	{
+		mInited = true;
 	}
+
+	LL::ThreadPool::run();
+
+	decomp->quitThread();
 }
 
 void LLPhysicsDecomp::submitRequest(LLPhysicsDecomp::Request* request)
 {
-	LLMutexLock lock(mMutex);
-	mRequestQ.push(request);
-	mSignal->signal();
+	// released in notifyCompleted(), workers never touch the ref count
+	request->ref();
+
+	S32* decomp_id = request->mDecompID;
+	bool post = false;
+	{
+		LLMutexLock lock(mMutex);
+		DecompState& state = mDecomps[decomp_id];
+		state.mPending.push_back(request);
+		if (!state.mBusy)
+		{
+			state.mBusy = true;
+			post = true;
+		}
+	}
+
+	if (post)
+	{
+		getQueue().postIfOpen([this, decomp_id]()
+			{
+				processDecomposition(decomp_id);
+			});
+	}
 }
 
 //static
 S32 LLPhysicsDecomp::llcdCallback(const char* status, S32 p1, S32 p2)
 {	
-	if (gMeshRepo.mDecompThread && gMeshRepo.mDecompThread->mCurRequest.notNull())
+	if (sCurRequest)
 	{
-		return gMeshRepo.mDecompThread->mCurRequest->statusCallback(status, p1, p2);
+		return sCurRequest->statusCallback(status, p1, p2);
 	}
 
 	return 1;
 }
 
+void LLPhysicsDecomp::processDecomposition(S32* decomp_id)
+{
+	while (true)
+	{
+		Request* request = NULL;
+		DecompState* state = NULL;
+		{
+			LLMutexLock lock(mMutex);
+			state = &mDecomps[decomp_id];
+			if (mQuitting)
+			{
+				// the destructor releases what is left
+				state->mBusy = false;
+				return;
+			}
+			if (state->mPending.empty() && state->mReplay.empty())
+			{
+				// the next request for this decomposition starts a new state
+				mDecomps.erase(decomp_id);
+				return;
+			}
+			if (!state->mPending.empty())
+			{
+				request = state->mPending.front();
+				state->mPending.pop_front();
+			}
+		}
+
+		// only this worker touches the state until it is erased
+		if (!request)
+		{
+			// nothing queued: bring the library up to date so the
+			// state can go
+			LLMutexLock lock(&mLibraryMutex);
+			LLConvexDecomposition::getInstance()->bindDecomposition(state->mID);
+			replayStages(*state);
+			continue;
+		}
+
+		sCurRequest = request;
+		processRequest(request, *state);
+		sCurRequest = NULL;
+
+		completeRequest(request);
+	}
+}
+
+void LLPhysicsDecomp::processRequest(Request* request, DecompState& state)
+{
+	LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
+
+	S32& id = *(request->mDecompID);
+	if (id == -1)
+	{
+		LLMutexLock lock(&mLibraryMutex);
+		decomp->genDecomposition(id);
+	}
+
+	bool single_hull = request->mStage == "single_hull";
+	std::map<std::string, S32>::const_iterator stage = mStageID.find(request->mStage);
+	bool first_stage = single_hull || (stage != mStageID.end() && stage->second == 0);
+
+	if (state.mID != id)
+	{ //new library decomposition, nothing to chain onto
+		state.mID = id;
+		state.mChainHash = 0;
+		state.mChainKnown = false;
+		state.mReplay.clear();
+	}
+
+	// later stages work on the output of the earlier ones, so their
+	// results depend on the whole chain
+	U64 key = request->hashInput(first_stage ? 0 : state.mChainHash);
+
+	if (first_stage)
+	{
+		state.mReplay.clear();
+		state.mChainKnown = true;
+	}
+	state.mChainHash = key;
+
+	// without the stages before it the key doesn't describe the input
+	const bool cacheable = state.mChainKnown;
+	if (cacheable && getCachedResult(key, request))
+	{
+		state.mReplay.push_back(new LLDecompReplayRequest(*request));
+		return;
+	}
+
+	LLMutexLock lock(&mLibraryMutex);
+	decomp->bindDecomposition(id);
+	replayStages(state);
+
+	if (single_hull)
+	{
+		doDecompositionSingleHull(request);
+	}
+	else if (!doDecomposition(request, true))
+	{
+		return;
+	}
+	if (cacheable)
+	{
+		cacheResult(key, request);
+	}
+}
+
+// Runs the stages served from the cache in the library, called with
+// the decomposition bound and mLibraryMutex held
+void LLPhysicsDecomp::replayStages(DecompState& state)
+{
+	LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
+	for (LLPointer<Request>& replay : state.mReplay)
+	{
+		if (replay->mStage == "single_hull")
+		{
+			LLCDMeshData mesh;
+			setMeshData(replay, mesh, true);
+			decomp->buildSingleHull();
+		}
+		else
+		{
+			doDecomposition(replay, false);
+		}
+	}
+	state.mReplay.clear();
+}
+
+U64 LLPhysicsDecomp::Request::hashInput(U64 seed) const
+{
+	HBXXH64 hash;
+	hash.update(&seed, sizeof(seed));
+	hash.update(mStage);
+	for (decomp_params::const_iterator iter = mParams.begin(); iter != mParams.end(); ++iter)
+	{
+		hash.update(iter->first);
+		hash.update(iter->second.asString());
+	}
+	if (!mPositions.empty())
+	{
+		hash.update(&mPositions[0], mPositions.size() * sizeof(LLVector3));
+	}
+	if (!mIndices.empty())
+	{
+		hash.update(&mIndices[0], mIndices.size() * sizeof(U16));
+	}
+	return hash.digest();
+}
+
+bool LLPhysicsDecomp::getCachedResult(U64 key, Request* request)
+{
+	LLMutexLock lock(mMutex);
+	std::map<U64, Result>::const_iterator iter = mResultCache.find(key);
+	if (iter == mResultCache.end())
+	{
+		return false;
+	}
+
+	request->mHull = iter->second.mHull;
+	request->mHullMesh = iter->second.mHullMesh;
+	request->setStatusMessage("FAIL");
+	return true;
+}
+
+void LLPhysicsDecomp::cacheResult(U64 key, const Request* request)
+{
+	LLMutexLock lock(mMutex);
+	if (request->mHull.empty() || mResultCache.count(key))
+	{
+		return;
+	}
+
+	Result& result = mResultCache[key];
+	result.mHull = request->mHull;
+	result.mHullMesh = request->mHullMesh;
+	mResultOrder.push_back(key);
+
+	if (mResultOrder.size() > MAX_DECOMP_CACHE_ENTRIES)
+	{
+		mResultCache.erase(mResultOrder.front());
+		mResultOrder.pop_front();
+	}
+}
+
 bool needTriangles( LLConvexDecomposition *aDC )
 {
 	if( !aDC )
@@ -4903,7 +5171,7 @@ bool needTriangles( LLConvexDecomposition *aDC )
 	return false;
 }
 
-void LLPhysicsDecomp::setMeshData(LLCDMeshData& mesh, bool vertex_based)
+void LLPhysicsDecomp::setMeshData(Request* request, LLCDMeshData& mesh, bool vertex_based)
 {
 	LLConvexDecomposition *pDeComp = LLConvexDecomposition::getInstance();
 
@@ -4913,17 +5181,17 @@ void LLPhysicsDecomp::setMeshData(LLCDMeshData& mesh, bool vertex_based)
 	if( vertex_based )
 		vertex_based = !needTriangles( pDeComp );
 
-	mesh.mVertexBase = mCurRequest->mPositions[0].mV;
+	mesh.mVertexBase = request->mPositions[0].mV;
 	mesh.mVertexStrideBytes = 12;
-	mesh.mNumVertices = mCurRequest->mPositions.size();
+	mesh.mNumVertices = request->mPositions.size();
 
 	if(!vertex_based)
 	{
 		mesh.mIndexType = LLCDMeshData::INT_16;
-		mesh.mIndexBase = &(mCurRequest->mIndices[0]);
+		mesh.mIndexBase = &(request->mIndices[0]);
 		mesh.mIndexStrideBytes = 6;
 	
-		mesh.mNumTriangles = mCurRequest->mIndices.size()/3;
+		mesh.mNumTriangles = request->mIndices.size()/3;
 	}
 
 	if ((vertex_based || mesh.mNumTriangles > 0) && mesh.mNumVertices > 2)
@@ -4941,32 +5209,29 @@ void LLPhysicsDecomp::setMeshData(LLCDMeshData& mesh, bool vertex_based)
 	}
 }
 
-void LLPhysicsDecomp::doDecomposition()
+bool LLPhysicsDecomp::doDecomposition(Request* request, bool read_results)
 {
 	LLCDMeshData mesh;
-	S32 stage = mStageID[mCurRequest->mStage];
+	std::map<std::string, S32>::const_iterator stage_iter = mStageID.find(request->mStage);
+	S32 stage = stage_iter != mStageID.end() ? stage_iter->second : 0;
 
 	if (LLConvexDecomposition::getInstance() == NULL)
 	{
 		// stub library. do nothing.
-		return;
+		return false;
 	}
 
 	//load data intoLLCD
 	if (stage == 0)
 	{
-		setMeshData(mesh, false);
+		setMeshData(request, mesh, false);
 	}
 		
 	//build parameter map
 	std::map<std::string, const LLCDParam*> param_map;
 
-	static const LLCDParam* params = NULL;
-	static S32 param_count = 0;
-	if (!params)
-	{
-		param_count = LLConvexDecomposition::getInstance()->getParameters(&params);
-	}
+	const LLCDParam* params = NULL;
+	S32 param_count = LLConvexDecomposition::getInstance()->getParameters(&params);
 	
 	for (S32 i = 0; i < param_count; ++i)
 	{
@@ -4975,7 +5240,7 @@ void LLPhysicsDecomp::doDecomposition()
 
 	U32 ret = LLCD_OK;
 	//set parameter values
-	for (decomp_params::iterator iter = mCurRequest->mParams.begin(); iter != mCurRequest->mParams.end(); ++iter)
+	for (decomp_params::iterator iter = request->mParams.begin(); iter != request->mParams.end(); ++iter)
 	{
 		const std::string& name = iter->first;
 		const LLSD& value = iter->second;
@@ -5003,7 +5268,7 @@ void LLPhysicsDecomp::doDecomposition()
 		}
 	}
 
-	mCurRequest->setStatusMessage("Executing.");
+	request->setStatusMessage("Executing.");
 
 	if (LLConvexDecomposition::getInstance() != NULL)
 	{
@@ -5016,86 +5281,97 @@ void LLPhysicsDecomp::doDecomposition()
 						   << LL_ENDL;
 		LLMutexLock lock(mMutex);
 
-		mCurRequest->mHull.clear();
-		mCurRequest->mHullMesh.clear();
+		request->mHull.clear();
+		request->mHullMesh.clear();
 
-		mCurRequest->setStatusMessage("FAIL");
-		
-		completeCurrent();
+		request->setStatusMessage("FAIL");
+		return false;
 	}
-	else
+
+	if (!read_results)
 	{
-		mCurRequest->setStatusMessage("Reading results");
+		return true;
+	}
 
-		S32 num_hulls =0;
-		if (LLConvexDecomposition::getInstance() != NULL)
-		{
-			num_hulls = LLConvexDecomposition::getInstance()->getNumHullsFromStage(stage);
-		}
-		
-		{
-			LLMutexLock lock(mMutex);
-			mCurRequest->mHull.clear();
-			mCurRequest->mHull.resize(num_hulls);
+	request->setStatusMessage("Reading results");
 
-			mCurRequest->mHullMesh.clear();
-			mCurRequest->mHullMesh.resize(num_hulls);
-		}
+	S32 num_hulls =0;
+	if (LLConvexDecomposition::getInstance() != NULL)
+	{
+		num_hulls = LLConvexDecomposition::getInstance()->getNumHullsFromStage(stage);
+	}
+	
+	{
+		LLMutexLock lock(mMutex);
+		request->mHull.clear();
+		request->mHull.resize(num_hulls);
 
-		for (S32 i = 0; i < num_hulls; ++i)
-		{
-			std::vector<LLVector3> p;
-			LLCDHull hull;
-			// if LLConvexDecomposition is a stub, num_hulls should have been set to 0 above, and we should not reach this code
-			LLConvexDecomposition::getInstance()->getHullFromStage(stage, i, &hull);
+		request->mHullMesh.clear();
+		request->mHullMesh.resize(num_hulls);
+	}
 
-			const F32* v = hull.mVertexBase;
+	for (S32 i = 0; i < num_hulls; ++i)
+	{
+		std::vector<LLVector3> p;
+		LLCDHull hull;
+		// if LLConvexDecomposition is a stub, num_hulls should have been set to 0 above, and we should not reach this code
+		LLConvexDecomposition::getInstance()->getHullFromStage(stage, i, &hull);
 
-			for (S32 j = 0; j < hull.mNumVertices; ++j)
-			{
-				LLVector3 vert(v[0], v[1], v[2]); 
-				p.push_back(vert);
-				v = (F32*) (((U8*) v) + hull.mVertexStrideBytes);
-			}
-			
-			LLCDMeshData mesh;
-			// if LLConvexDecomposition is a stub, num_hulls should have been set to 0 above, and we should not reach this code
-			LLConvexDecomposition::getInstance()->getMeshFromStage(stage, i, &mesh);
+		const F32* v = hull.mVertexBase;
 
-			get_vertex_buffer_from_mesh(mesh, mCurRequest->mHullMesh[i]);
-			
-			{
-				LLMutexLock lock(mMutex);
-				mCurRequest->mHull[i] = p;
-			}
+		for (S32 j = 0; j < hull.mNumVertices; ++j)
+		{
+			LLVector3 vert(v[0], v[1], v[2]); 
+			p.push_back(vert);
+			v = (F32*) (((U8*) v) + hull.mVertexStrideBytes);
 		}
-	
+		
+		LLCDMeshData mesh;
+		// if LLConvexDecomposition is a stub, num_hulls should have been set to 0 above, and we should not reach this code
+		LLConvexDecomposition::getInstance()->getMeshFromStage(stage, i, &mesh);
+
+		get_vertex_buffer_from_mesh(mesh, request->mHullMesh[i]);
+		
 		{
 			LLMutexLock lock(mMutex);
-			mCurRequest->setStatusMessage("FAIL");
-			completeCurrent();						
+			request->mHull[i] = p;
 		}
 	}
+
+	{
+		LLMutexLock lock(mMutex);
+		request->setStatusMessage("FAIL");
+	}
+	return true;
 }
 
-void LLPhysicsDecomp::completeCurrent()
+void LLPhysicsDecomp::completeRequest(Request* request)
 {
 	LLMutexLock lock(mMutex);
-	mCompletedQ.push(mCurRequest);
-	mCurRequest = NULL;
+	mCompletedQ.push(request);
 }
 
 void LLPhysicsDecomp::notifyCompleted()
 {
-	if (!mCompletedQ.empty())
+	std::queue<Request*> completed;
 	{
 		LLMutexLock lock(mMutex);
-		while (!mCompletedQ.empty())
+		completed.swap(mCompletedQ);
+	}
+
+	while (!completed.empty())
+	{
+		Request* req = completed.front();
+		completed.pop();
+
+		// seed the display cache so the preview doesn't rebuild hull meshes
+		for (U32 i = 0; i < req->mHull.size() && i < req->mHullMesh.size(); ++i)
 		{
-			Request* req = mCompletedQ.front();
-			req->completed();
-			mCompletedQ.pop();
+			gMeshRepo.cacheHullMesh(req->mHull[i], req->mHullMesh[i]);
 		}
+
+		req->completed();
+		req->unref();
 	}
 }
 
@@ -5127,7 +5403,7 @@ void make_box(LLPhysicsDecomp::Request * request)
 }
 
 
-void LLPhysicsDecomp::doDecompositionSingleHull()
+void LLPhysicsDecomp::doDecompositionSingleHull(Request* request)
 {
 	LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
 
@@ -5139,21 +5415,21 @@ void LLPhysicsDecomp::doDecompositionSingleHull()
 	
 	LLCDMeshData mesh;	
 
-	setMeshData(mesh, true);
+	setMeshData(request, mesh, true);
 
 	LLCDResult ret = decomp->buildSingleHull() ;
 	if (ret)
 	{
 		LL_WARNS(LOG_MESH) << "Could not execute decomposition stage when attempting to create single hull." << LL_ENDL;
-		make_box(mCurRequest);
+		make_box(request);
 	}
 	else
 	{
 		{
 			LLMutexLock lock(mMutex);
-			mCurRequest->mHull.clear();
-			mCurRequest->mHull.resize(1);
-			mCurRequest->mHullMesh.clear();
+			request->mHull.clear();
+			request->mHull.resize(1);
+			request->mHullMesh.clear();
 		}
 
 		std::vector<LLVector3> p;
@@ -5173,81 +5449,9 @@ void LLPhysicsDecomp::doDecompositionSingleHull()
 					
 		{
 			LLMutexLock lock(mMutex);
-			mCurRequest->mHull[0] = p;
+			request->mHull[0] = p;
 		}
 	}		
-
-	{
-		completeCurrent();
-		
-	}
-}
-
-
-void LLPhysicsDecomp::run()
-{
-	LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
-	if (decomp == NULL)
-	{
-		// stub library. Set init to true so the main thread
-		// doesn't wait for this to finish.
-		mInited = true;
-		return;
-	}
-
-	decomp->initThread();
-	mInited = true;
-
-	static const LLCDStageData* stages = NULL;
-	static S32 num_stages = 0;
-	
-	if (!stages)
-	{
-		num_stages = decomp->getStages(&stages);
-	}
-
-	for (S32 i = 0; i < num_stages; i++)
-	{
-		mStageID[stages[i].mName] = i;
-	}
-
-	while (!mQuitting)
-	{
-		mSignal->wait();
-		while (!mQuitting && !mRequestQ.empty())
-		{
-			{
-				LLMutexLock lock(mMutex);
-				mCurRequest = mRequestQ.front();
-				mRequestQ.pop();
-			}
-
-			S32& id = *(mCurRequest->mDecompID);
-			if (id == -1)
-			{
-				decomp->genDecomposition(id);
-			}
-			decomp->bindDecomposition(id);
-
-			if (mCurRequest->mStage == "single_hull")
-			{
-				doDecompositionSingleHull();
-			}
-			else
-			{
-				doDecomposition();
-			}		
-		}
-	}
-
-	decomp->quitThread();
-	
-	if (mSignal->isLocked())
-	{ //let go of mSignal's associated mutex
-		mSignal->unlock();
-	}
-
-	mDone = true;
 }
 
 void LLPhysicsDecomp::Request::assignData(LLModel* mdl) 
@@ -5330,46 +5534,77 @@ void LLPhysicsDecomp::Request::setStatusMessage(const std::string& msg)
 	mStatusMessage = msg;
 }
 
+// Threading:  main thread only
+bool LLMeshRepository::getHullMesh(const LLModel::hull& hull, LLModel::PhysicsMesh& mesh)
+{
+	if (hull.empty())
+	{
+		return false;
+	}
+
+	U64 key = HBXXH64::digest(&hull[0], hull.size() * sizeof(LLVector3));
+	std::unordered_map<U64, LLModel::PhysicsMesh>::const_iterator iter = mHullMeshCache.find(key);
+	if (iter != mHullMeshCache.end())
+	{
+		mesh = iter->second;
+		return true;
+	}
+
+	LLCDHull cd_hull;
+	cd_hull.mNumVertices = hull.size();
+	cd_hull.mVertexBase = hull[0].mV;
+	cd_hull.mVertexStrideBytes = 12;
+
+	LLCDMeshData cd_mesh;
+	LLCDResult res = LLCD_OK;
+	if (LLConvexDecomposition::getInstance() != NULL)
+	{
+		res = LLConvexDecomposition::getInstance()->getMeshFromHull(&cd_hull, &cd_mesh);
+	}
+	if (res != LLCD_OK)
+	{
+		return false;
+	}
+
+	get_vertex_buffer_from_mesh(cd_mesh, mesh);
+	cacheHullMesh(hull, mesh);
+	return true;
+}
+
+// Threading:  main thread only
+void LLMeshRepository::cacheHullMesh(const LLModel::hull& hull, const LLModel::PhysicsMesh& mesh)
+{
+	if (hull.empty() || mesh.empty())
+	{
+		return;
+	}
+
+	U64 key = HBXXH64::digest(&hull[0], hull.size() * sizeof(LLVector3));
+	if (!mHullMeshCache.emplace(key, mesh).second)
+	{
+		return;
+	}
+
+	mHullMeshOrder.push_back(key);
+	if (mHullMeshOrder.size() > MAX_HULL_MESH_CACHE_ENTRIES)
+	{
+		mHullMeshCache.erase(mHullMeshOrder.front());
+		mHullMeshOrder.pop_front();
+	}
+}
+
 void LLMeshRepository::buildPhysicsMesh(LLModel::Decomposition& decomp)
 {
 	decomp.mMesh.resize(decomp.mHull.size());
 
 	for (U32 i = 0; i < decomp.mHull.size(); ++i)
 	{
-		LLCDHull hull;
-		hull.mNumVertices = decomp.mHull[i].size();
-		hull.mVertexBase = decomp.mHull[i][0].mV;
-		hull.mVertexStrideBytes = 12;
-
-		LLCDMeshData mesh;
-		LLCDResult res = LLCD_OK;
-		if (LLConvexDecomposition::getInstance() != NULL)
-		{
-			res = LLConvexDecomposition::getInstance()->getMeshFromHull(&hull, &mesh);
-		}
-		if (res == LLCD_OK)
-		{
-			get_vertex_buffer_from_mesh(mesh, decomp.mMesh[i]);
-		}
+		getHullMesh(decomp.mHull[i], decomp.mMesh[i]);
 	}
 
 	if (!decomp.mBaseHull.empty() && decomp.mBaseHullMesh.empty())
 	{ //get mesh for base hull
-		LLCDHull hull;
-		hull.mNumVertices = decomp.mBaseHull.size();
-		hull.mVertexBase = decomp.mBaseHull[0].mV;
-		hull.mVertexStrideBytes = 12;
-
-		LLCDMeshData mesh;
-		LLCDResult res = LLCD_OK;
-		if (LLConvexDecomposition::getInstance() != NULL)
-		{
-			res = LLConvexDecomposition::getInstance()->getMeshFromHull(&hull, &mesh);
-		}
-		if (res == LLCD_OK)
-		{
-			get_vertex_buffer_from_mesh(mesh, decomp.mBaseHullMesh);
-		}
+		getHullMesh(decomp.mBaseHull, decomp.mBaseHullMesh);
 	}
 }
 
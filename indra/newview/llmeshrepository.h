@@ -40,6 +40,10 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <deque>
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -102,7 +106,15 @@ public:
 	}
 };
 
-class LLPhysicsDecomp : public LLThread
+// Runs convex decomposition requests on the "PhysicsDecomp" thread pool.
+// Requests for one decomposition (one model's hull set) run in submission
+// order on one worker at a time. The library keeps a single bound
+// decomposition for all threads, so everything from binding to reading
+// the results is serialized by mLibraryMutex; workers only overlap cache
+// lookups and hashing. Results are cached by a hash of the input geometry,
+// stage and parameters, so re-running an unchanged stage completes
+// immediately.
+class LLPhysicsDecomp : public LL::ThreadPool
 {
 public:
 
@@ -133,6 +145,9 @@ public:
 
 		bool isValid() const {return mPositions.size() > 2 && mIndices.size() > 2 ;}
 
+		//hash of stage, parameters and geometry chained onto seed
+		U64 hashInput(U64 seed) const;
+
 	protected:
 		//internal use
 		LLVector3 mBBox[2] ;
@@ -143,40 +158,80 @@ public:
 		bool isValidTriangle(U16 idx1, U16 idx2, U16 idx3) ;
 	};
 
-	LLCondition* mSignal;
 	LLMutex* mMutex;
 	
-	bool mInited;
-	bool mQuitting;
-	bool mDone;
+	std::atomic<bool> mInited;
 	
 	LLPhysicsDecomp();
 	~LLPhysicsDecomp();
 
+	//launch the worker threads, call from the main thread
+	void start();
 	void shutdown();
 		
 	void submitRequest(Request* request);
 	static S32 llcdCallback(const char*, S32, S32);
-	void cancel();
 
-	void setMeshData(LLCDMeshData& mesh, bool vertex_based);
-	void doDecomposition();
-	void doDecompositionSingleHull();
-
-	virtual void run();
-	
-	void completeCurrent();
 	void notifyCompleted();
 
 	std::map<std::string, S32> mStageID;
 
-	typedef std::queue<LLPointer<Request> > request_queue;
-	request_queue mRequestQ;
+	void run() override;
 
-	LLPointer<Request> mCurRequest;
+private:
+	//cached output of one stage
+	struct Result
+	{
+		LLModel::convex_hull_decomposition mHull;
+		std::vector<LLModel::PhysicsMesh> mHullMesh;
+	};
 
-	std::queue<LLPointer<Request> > mCompletedQ;
+	//scheduling state of one decomposition, keyed by Request::mDecompID
+	struct DecompState
+	{
+		std::deque<Request*> mPending;
+		bool mBusy = false;
+		//library decomposition id mChainHash refers to
+		S32 mID = -1;
+		//hash of the stages that produced the current library state
+		U64 mChainHash = 0;
+		//set by a first stage, later stages are only cached when the
+		//stages before them were seen by this state
+		bool mChainKnown = false;
+		//stages served from the cache that have not been run in the
+		//library yet, replayed before the next uncached stage
+		std::vector<LLPointer<Request> > mReplay;
+	};
+
+	void processDecomposition(S32* decomp_id);
+	void processRequest(Request* request, DecompState& state);
+	void replayStages(DecompState& state);
+
+	void setMeshData(Request* request, LLCDMeshData& mesh, bool vertex_based);
+	bool doDecomposition(Request* request, bool read_results);
+	void doDecompositionSingleHull(Request* request);
+
+	bool getCachedResult(U64 key, Request* request);
+	void cacheResult(U64 key, const Request* request);
+
+	void completeRequest(Request* request);
+
+	//dropped once a decomposition has nothing queued
+	std::map<S32*, DecompState> mDecomps;
 
+	//held from bindDecomposition() until the results are read
+	LLMutex mLibraryMutex;
+
+	std::map<U64, Result> mResultCache;
+	std::deque<U64> mResultOrder;
+
+	//requests are referenced by submitRequest() and released by
+	//notifyCompleted(), so ref counts only change outside the workers
+	std::queue<Request*> mCompletedQ;
+
+	S32 mWidth;
+	std::atomic<S32> mThreadsInited;
+	bool mQuitting;
 };
 
 class RequestStats
@@ -273,8 +328,8 @@ public:
 		LLVolumeParams mMeshParams;
 		S32 mLOD;
 
-		LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod)
-			: mVolume(volume), mMeshParams(mesh_params), mLOD(lod)
+		LoadedMesh(LLPointer<LLVolume>&& volume, const LLVolumeParams&  mesh_params, S32 lod)
+			: mVolume(std::move(volume)), mMeshParams(mesh_params), mLOD(lod)
 		{
 		}
 
@@ -421,8 +476,8 @@ public:
 		void completed();
 	};
 
-	LLPointer<DecompRequest> mFinalDecomp;
-	volatile bool	mPhysicsComplete;
+	// Requests may complete in any order, wait until all are done
+	std::atomic<S32> mPendingDecomps;
 
 	typedef std::map<LLPointer<LLModel>, std::vector<LLVector3> > hull_map;
 	hull_map		mHullMap;
@@ -550,6 +605,7 @@ public:
 
 	//metrics
 	static U32 sBytesReceived;
+	static U32 sBytesCopied;					// Received bytes that couldn't be used in place
 	static U32 sMeshRequestCount;				// Total request count, http or cached, all component types
 	static U32 sHTTPRequestCount;				// Http GETs issued (not large)
 	static U32 sHTTPLargeRequestCount;			// Http GETs issued for large requests
@@ -663,6 +719,14 @@ public:
 
 	LLPhysicsDecomp* mDecompThread;
 
+	//triangle meshes of convex hulls keyed by hull vertex hash, reused
+	//when the same physics shape is displayed again
+	std::unordered_map<U64, LLModel::PhysicsMesh> mHullMeshCache;
+	std::deque<U64> mHullMeshOrder;
+
+	bool getHullMesh(const LLModel::hull& hull, LLModel::PhysicsMesh& mesh);
+	void cacheHullMesh(const LLModel::hull& hull, const LLModel::PhysicsMesh& mesh);
+
 	LLFrameTimer     mSkinInfoCullTimer;
 	
 	class inventory_data
@@ -30,10 +30,13 @@
 
 #include "llmodelloader.h"
 #include "lldaeloader.h"
+#include "lldaestreamloader.h"
+#include "llglbloader.h"
 #include "llfloatermodelpreview.h"
 
 #include "llagent.h"
 #include "llanimationstates.h"
+#include "hbxxh.h"
 #include "llcallbacklist.h"
 #include "lldatapacker.h"
 #include "lldrawable.h"
@@ -59,6 +62,7 @@
 #include "llviewertexturelist.h"
 #include "llvoavatar.h"
 #include "pipeline.h"
+#include "workqueue.h"
 
 // ui controls (from floater)
 #include "llbutton.h"
@@ -153,6 +157,152 @@ void FindModel(LLModelLoader::scene& scene, const std::string& name_to_match, LL
     }
 }
 
+//-----------------------------------------------------------------------------
+// LLMeshSimplifyCache
+//-----------------------------------------------------------------------------
+
+// Upper bound for the memory held by cached simplification results
+static const size_t SIMPLIFY_CACHE_MAX_BYTES = 256 * 1024 * 1024;
+
+static void hash_face(HBXXH64& hash, const LLVolumeFace& face)
+{
+    hash.update(&face.mNumVertices, sizeof(face.mNumVertices));
+    hash.update(&face.mNumIndices, sizeof(face.mNumIndices));
+    if (face.mPositions)
+    {
+        hash.update(face.mPositions, face.mNumVertices * sizeof(LLVector4a));
+    }
+    if (face.mNormals)
+    {
+        hash.update(face.mNormals, face.mNumVertices * sizeof(LLVector4a));
+    }
+    if (face.mTexCoords)
+    {
+        hash.update(face.mTexCoords, face.mNumVertices * sizeof(LLVector2));
+    }
+    if (face.mIndices)
+    {
+        hash.update(face.mIndices, face.mNumIndices * sizeof(U16));
+    }
+}
+
+static size_t face_bytes(const LLVolumeFace& face)
+{
+    return face.mNumVertices * (2 * sizeof(LLVector4a) + sizeof(LLVector2)) + face.mNumIndices * sizeof(U16);
+}
+
+LLMeshSimplifyCache::LLMeshSimplifyCache()
+    : mBytes(0)
+{
+}
+
+// static
+U64 LLMeshSimplifyCache::hashGeometry(const LLModel* model, S32 face_idx)
+{
+    HBXXH64 hash;
+    if (face_idx >= 0)
+    {
+        hash_face(hash, model->getVolumeFace(face_idx));
+    }
+    else
+    {
+        for (S32 i = 0; i < model->getNumVolumeFaces(); ++i)
+        {
+            hash_face(hash, model->getVolumeFace(i));
+        }
+    }
+    return hash.digest();
+}
+
+// static
+U64 LLMeshSimplifyCache::makeKey(U64 geometry_hash, S32 face_idx, F32 indices_decimator, F32 error_threshold, S32 simplification_mode)
+{
+    HBXXH64 hash;
+    hash.update(&geometry_hash, sizeof(geometry_hash));
+    hash.update(&face_idx, sizeof(face_idx));
+    hash.update(&indices_decimator, sizeof(indices_decimator));
+    hash.update(&error_threshold, sizeof(error_threshold));
+    hash.update(&simplification_mode, sizeof(simplification_mode));
+    return hash.digest();
+}
+
+bool LLMeshSimplifyCache::get(U64 key, LLModel* target, S32 face_idx, F32& ratio)
+{
+    LLMutexLock lock(&mMutex);
+
+    auto it = mEntries.find(key);
+    if (it == mEntries.end())
+    {
+        return false;
+    }
+
+    const Entry& entry = it->second;
+    ratio = entry.mRatio;
+    if (face_idx >= 0)
+    {
+        if (!entry.mFaces.empty())
+        {
+            target->getVolumeFace(face_idx) = entry.mFaces[0];
+        }
+    }
+    else
+    {
+        for (U32 i = 0; i < entry.mFaces.size(); ++i)
+        {
+            target->getVolumeFace(i) = entry.mFaces[i];
+        }
+    }
+    return true;
+}
+
+void LLMeshSimplifyCache::put(U64 key, const LLModel* target, S32 face_idx, F32 ratio)
+{
+    Entry entry;
+    entry.mRatio = ratio;
+    entry.mBytes = 0;
+    // A failed run leaves nothing worth reusing, callers fall back to
+    // another method, so only remember that it failed.
+    if (ratio >= 0.f)
+    {
+        if (face_idx >= 0)
+        {
+            entry.mFaces.push_back(target->getVolumeFace(face_idx));
+        }
+        else
+        {
+            for (S32 i = 0; i < target->getNumVolumeFaces(); ++i)
+            {
+                entry.mFaces.push_back(target->getVolumeFace(i));
+            }
+        }
+        for (const LLVolumeFace& face : entry.mFaces)
+        {
+            entry.mBytes += face_bytes(face);
+        }
+    }
+
+    LLMutexLock lock(&mMutex);
+    if (mBytes + entry.mBytes > SIMPLIFY_CACHE_MAX_BYTES)
+    {
+        // Results are cheap to regenerate compared to running out of memory
+        // on a large upload, just start over.
+        mEntries.clear();
+        mBytes = 0;
+    }
+    auto result = mEntries.emplace(key, std::move(entry));
+    if (result.second)
+    {
+        mBytes += result.first->second.mBytes;
+    }
+}
+
+void LLMeshSimplifyCache::clear()
+{
+    LLMutexLock lock(&mMutex);
+    mEntries.clear();
+    mBytes = 0;
+}
+
 //-----------------------------------------------------------------------------
 // LLModelPreview
 //-----------------------------------------------------------------------------
@@ -171,6 +321,7 @@ LLModelPreview::LLModelPreview(S32 width, S32 height, LLFloater* fmp)
     , mFirstSkinUpdate(true)
     , mHasDegenerate(false)
     , mImporterDebug(LLCachedControl<bool>(gSavedSettings, "ImporterDebug", false))
+    , mSimplifyCache(std::make_shared<LLMeshSimplifyCache>())
 {
     mNeedsUpdate = true;
     mCameraDistance = 0.f;
@@ -214,6 +365,9 @@ LLModelPreview::~LLModelPreview()
         mModelLoader->shutdown();
     }
 
+    stopLODGeneration();
+    mLODGenerations.clear();
+
     if (mPreviewAvatar)
     {
         mPreviewAvatar->markDead();
@@ -678,6 +832,7 @@ void LLModelPreview::clearModel(S32 lod)
         return;
     }
 
+    cancelLODGeneration(lod);
     mVertexBuffer[lod].clear();
     mModel[lod].clear();
     mScene[lod].clear();
@@ -749,20 +904,56 @@ void LLModelPreview::loadModel(std::string filename, S32 lod, bool force_disable
     std::map<std::string, std::string> joint_alias_map;
     getJointAliases(joint_alias_map);
 
-    mModelLoader = new LLDAELoader(
-        filename,
-        lod,
-        &LLModelPreview::loadedCallback,
-        &LLModelPreview::lookupJointByName,
-        &LLModelPreview::loadTextures,
-        &LLModelPreview::stateChangedCallback,
-        this,
-        mJointTransformMap,
-        mJointsFromNode,
-        joint_alias_map,
-        LLSkinningUtil::getMaxJointCount(),
-        gSavedSettings.getU32("ImporterModelLimit"),
-        gSavedSettings.getbool("ImporterPreprocessDAE"));
+    if (gDirUtilp->getExtension(filename) == "glb")
+    {
+        mModelLoader = new LLGLBLoader(
+            filename,
+            lod,
+            &LLModelPreview::loadedCallback,
+            &LLModelPreview::lookupJointByName,
+            &LLModelPreview::loadTextures,
+            &LLModelPreview::stateChangedCallback,
+            this,
+            mJointTransformMap,
+            mJointsFromNode,
+            joint_alias_map,
+            LLSkinningUtil::getMaxJointCount(),
+            gSavedSettings.getU32("ImporterModelLimit"));
+    }
+    else if (gSavedSettings.getbool("ImporterStreamDAE"))
+    {
+        mModelLoader = new LLDAEStreamLoader(
+            filename,
+            lod,
+            &LLModelPreview::loadedCallback,
+            &LLModelPreview::lookupJointByName,
+            &LLModelPreview::loadTextures,
+            &LLModelPreview::stateChangedCallback,
+            this,
+            mJointTransformMap,
+            mJointsFromNode,
+            joint_alias_map,
+            LLSkinningUtil::getMaxJointCount(),
+            gSavedSettings.getU32("ImporterModelLimit"),
+            gSavedSettings.getbool("ImporterPreprocessDAE"));
+    }
+    else
+    {
+        mModelLoader = new LLDAELoader(
+            filename,
+            lod,
+            &LLModelPreview::loadedCallback,
+            &LLModelPreview::lookupJointByName,
+            &LLModelPreview::loadTextures,
+            &LLModelPreview::stateChangedCallback,
+            this,
+            mJointTransformMap,
+            mJointsFromNode,
+            joint_alias_map,
+            LLSkinningUtil::getMaxJointCount(),
+            gSavedSettings.getU32("ImporterModelLimit"),
+            gSavedSettings.getbool("ImporterPreprocessDAE"));
+    }
 
     if (force_disable_slm)
     {
@@ -810,6 +1001,7 @@ void LLModelPreview::setPhysicsFromLOD(S32 lod)
 
     if (lod >= 0 && lod <= 3)
     {
+        cancelLODGeneration(LLModel::LOD_PHYSICS);
         mPhysicsSearchLOD = lod;
         mModel[LLModel::LOD_PHYSICS] = mModel[lod];
         mScene[LLModel::LOD_PHYSICS] = mScene[lod];
@@ -847,6 +1039,7 @@ void LLModelPreview::clearIncompatible(S32 lod)
 
                 if (i == LLModel::LOD_HIGH)
                 {
+                    cancelLODGeneration(-1);
                     mBaseModel = mModel[lod];
                     mBaseScene = mScene[lod];
                     mVertexBuffer[5].clear();
@@ -928,6 +1121,8 @@ void LLModelPreview::loadModelCallback(S32 loaded_lod)
 
     if (loaded_lod == -1)
     { //populate all LoDs from model loader scene
+        cancelLODGeneration(-1);
+        mSimplifyCache->clear();
         mBaseModel.clear();
         mBaseScene.clear();
 
@@ -1032,6 +1227,7 @@ void LLModelPreview::loadModelCallback(S32 loaded_lod)
     }
     else
     { //only replace given LoD
+        cancelLODGeneration(loaded_lod);
         mModel[loaded_lod] = mModelLoader->mModelList;
         mScene[loaded_lod] = mModelLoader->mScene;
         mVertexBuffer[loaded_lod].clear();
@@ -1045,6 +1241,9 @@ void LLModelPreview::loadModelCallback(S32 loaded_lod)
                 mGenLOD = true;
             }
 
+            // lods being generated from the previous base model are stale
+            cancelLODGeneration(-1);
+            mSimplifyCache->clear();
             mBaseModel = mModel[loaded_lod];
 
             mBaseScene = mScene[loaded_lod];
@@ -1195,6 +1394,9 @@ void LLModelPreview::generateNormals()
         return;
     }
 
+    // Generating normals replaces the face arrays LOD tasks read
+    stopLODGeneration();
+
     F32 angle_cutoff = mFMP->childGetValue("crease_angle").asReal();
 
     mRequestedCreaseAngle[which_lod] = angle_cutoff;
@@ -1254,6 +1456,9 @@ void LLModelPreview::restoreNormals()
         return;
     }
 
+    // Copying the faces back replaces the arrays LOD tasks read
+    stopLODGeneration();
+
     if (!mBaseModelFacesCopy.empty())
     {
         llassert(mBaseModelFacesCopy.size() == mBaseModel.size());
@@ -1286,8 +1491,21 @@ void LLModelPreview::restoreNormals()
 // Runs per object, but likely it is a better way to run per model+submodels
 // returns a ratio of base model indices to resulting indices
 // returns -1 in case of failure
-F32 LLModelPreview::genMeshOptimizerPerModel(LLModel *base_model, LLModel *target_model, F32 indices_decimator, F32 error_threshold, eSimplificationMode simplification_mode)
+// static
+F32 LLModelPreview::genMeshOptimizerPerModel(LLModel *base_model, LLModel *target_model, F32 indices_decimator, F32 error_threshold, eSimplificationMode simplification_mode, LLMeshSimplifyCache* cache, U64 geometry_hash)
 {
+    if (cache)
+    {
+        U64 key = LLMeshSimplifyCache::makeKey(geometry_hash, -1, indices_decimator, error_threshold, simplification_mode);
+        F32 ratio = -1.f;
+        if (!cache->get(key, target_model, -1, ratio))
+        {
+            ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, simplification_mode);
+            cache->put(key, target_model, -1, ratio);
+        }
+        return ratio;
+    }
+
     // I. Weld faces together
     // Figure out buffer size
     S32 size_indices = 0;
@@ -1583,8 +1801,21 @@ F32 LLModelPreview::genMeshOptimizerPerModel(LLModel *base_model, LLModel *targe
     return (F32)size_indices / (F32)size_new_indices;
 }
 
-F32 LLModelPreview::genMeshOptimizerPerFace(LLModel *base_model, LLModel *target_model, U32 face_idx, F32 indices_decimator, F32 error_threshold, eSimplificationMode simplification_mode)
+// static
+F32 LLModelPreview::genMeshOptimizerPerFace(LLModel *base_model, LLModel *target_model, U32 face_idx, F32 indices_decimator, F32 error_threshold, eSimplificationMode simplification_mode, LLMeshSimplifyCache* cache, U64 geometry_hash)
 {
+    if (cache)
+    {
+        U64 key = LLMeshSimplifyCache::makeKey(geometry_hash, face_idx, indices_decimator, error_threshold, simplification_mode);
+        F32 ratio = -1.f;
+        if (!cache->get(key, target_model, face_idx, ratio))
+        {
+            ratio = genMeshOptimizerPerFace(base_model, target_model, face_idx, indices_decimator, error_threshold, simplification_mode);
+            cache->put(key, target_model, face_idx, ratio);
+        }
+        return ratio;
+    }
+
     const LLVolumeFace &face = base_model->getVolumeFace(face_idx);
     S32 size_indices = face.mNumIndices;
     if (size_indices < 3)
@@ -1799,6 +2030,8 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         end = which_lod;
     }
 
+    LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
+
     for (S32 lod = start; lod >= end; --lod)
     {
         if (which_lod == -1)
@@ -1815,231 +2048,395 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         mRequestedErrorThreshold[lod] = lod_error_threshold * 100;
         mRequestedLoDMode[lod] = lod_mode;
 
-        mModel[lod].clear();
-        mModel[lod].resize(mBaseModel.size());
-        mVertexBuffer[lod].clear();
-
-
+        // Settings changed, whatever is still being generated for this lod is stale
+        cancelLODGeneration(lod);
+
+        std::shared_ptr<LODGenBatch> batch = std::make_shared<LODGenBatch>();
+        batch->mLOD = lod;
+        batch->mMeshOptMode = meshopt_mode;
+        batch->mLoDLimitMode = lod_mode;
+        batch->mDecimation = decimation;
+        batch->mIndicesDecimator = indices_decimator;
+        batch->mErrorThreshold = lod_error_threshold;
+        batch->mCache = mSimplifyCache;
+
+        mLODGenerations.emplace_back();
+        LODGeneration& generation = mLODGenerations.back();
+        generation.mBatch = batch;
+        generation.mBase = mBaseModel;
+        generation.mTarget.resize(mBaseModel.size());
+
+        S32 task_count = 0;
         for (U32 mdl_idx = 0; mdl_idx < mBaseModel.size(); ++mdl_idx)
         {
             LLModel* base = mBaseModel[mdl_idx];
 
             LLVolumeParams volume_params;
             volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
-            mModel[lod][mdl_idx] = new LLModel(volume_params, 0.f);
+            LLModel* target_model = new LLModel(volume_params, 0.f);
+            generation.mTarget[mdl_idx] = target_model;
+
+            target_model->mLabel = base->mLabel + getLodSuffix(lod);
+            target_model->mSubmodelID = base->mSubmodelID;
+            target_model->setNumVolumeFaces(base->getNumVolumeFaces());
 
-            std::string name = base->mLabel + getLodSuffix(lod);
+            batch->mBase.push_back(base);
+            batch->mTarget.push_back(target_model);
 
-            mModel[lod][mdl_idx]->mLabel = name;
-            mModel[lod][mdl_idx]->mSubmodelID = base->mSubmodelID;
-            mModel[lod][mdl_idx]->setNumVolumeFaces(base->getNumVolumeFaces());
+            if (meshopt_mode == MESH_OPTIMIZER_AUTO)
+            {
+                ++task_count;
+            }
+            else if (meshopt_mode == MESH_OPTIMIZER_PRECISE || meshopt_mode == MESH_OPTIMIZER_SLOPPY)
+            {
+                task_count += base->getNumVolumeFaces();
+            }
+        }
 
-            LLModel* target_model = mModel[lod][mdl_idx];
+        // Count has to be final before the first task can complete
+        batch->mRemaining = task_count;
 
-            S32 model_meshopt_mode = meshopt_mode;
+        for (U32 mdl_idx = 0; mdl_idx < batch->mBase.size(); ++mdl_idx)
+        {
+            // Auto mode merges faces so it runs per model, the other modes
+            // work on faces independently.
+            S32 face_count = meshopt_mode == MESH_OPTIMIZER_AUTO ? 1 : 0;
+            if (meshopt_mode == MESH_OPTIMIZER_PRECISE || meshopt_mode == MESH_OPTIMIZER_SLOPPY)
+            {
+                face_count = batch->mBase[mdl_idx]->getNumVolumeFaces();
+            }
 
-            // Ideally this should run not per model,
-            // but combine all submodels with origin model as well
-            if (model_meshopt_mode == MESH_OPTIMIZER_PRECISE)
+            for (S32 i = 0; i < face_count; ++i)
             {
-                // Run meshoptimizer for each face
-                for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
+                S32 face_idx = meshopt_mode == MESH_OPTIMIZER_AUTO ? -1 : i;
+                auto task = [batch, mdl_idx, face_idx]()
                 {
-                    F32 res = genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
-                    if (res < 0)
-                    {
-                        // Mesh optimizer failed and returned an invalid model
-                        const LLVolumeFace &face = base->getVolumeFace(face_idx);
-                        LLVolumeFace &new_face = target_model->getVolumeFace(face_idx);
-                        new_face = face;
-                    }
+                    runLODGenTask(*batch, mdl_idx, face_idx);
+                };
+
+                if (!general_queue || !general_queue->postIfOpen(task))
+                {
+                    // No thread pool (viewer is shutting down), do it here
+                    task();
                 }
             }
+        }
+    }
+}
+
+bool LLModelPreview::isGeneratingLODs() const
+{
+    for (const LODGeneration& generation : mLODGenerations)
+    {
+        if (!generation.mBatch->mCancelled)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LLModelPreview::cancelLODGeneration(S32 lod)
+{
+    for (LODGeneration& generation : mLODGenerations)
+    {
+        if (lod == -1 || generation.mBatch->mLOD == lod)
+        {
+            generation.mBatch->mCancelled = true;
+        }
+    }
+}
+
+void LLModelPreview::stopLODGeneration()
+{
+    // Tasks still queued will see the cancellation and won't touch the
+    // models, but the ones already running have to finish first.
+    cancelLODGeneration(-1);
+    for (LODGeneration& generation : mLODGenerations)
+    {
+        while (generation.mBatch->mRunning > 0)
+        {
+            ms_sleep(1);
+        }
+    }
+}
+
+void LLModelPreview::processLODGenerations()
+{
+    assert_main_thread();
+
+    std::list<LODGeneration>::iterator iter = mLODGenerations.begin();
+    while (iter != mLODGenerations.end())
+    {
+        LODGenBatch& batch = *iter->mBatch;
+        if (batch.mCancelled)
+        {
+            // Queued tasks of a cancelled batch don't touch the models,
+            // so they can go as soon as nothing is running.
+            if (batch.mRunning > 0)
+            {
+                ++iter;
+                continue;
+            }
+        }
+        else if (batch.mRemaining > 0)
+        {
+            ++iter;
+            continue;
+        }
+        else
+        {
+            installLODGeneration(*iter);
+        }
+        iter = mLODGenerations.erase(iter);
+    }
+}
 
-            if (model_meshopt_mode == MESH_OPTIMIZER_SLOPPY)
+void LLModelPreview::installLODGeneration(LODGeneration& generation)
+{
+    S32 lod = generation.mBatch->mLOD;
+
+    for (U32 mdl_idx = 0; mdl_idx < generation.mBase.size(); ++mdl_idx)
+    {
+        LLModel* base = generation.mBase[mdl_idx];
+        LLModel* target_model = generation.mTarget[mdl_idx];
+
+        //blind copy skin weights and just take closest skin weight to point on
+        //decimated mesh for now (auto-generating LODs with skin weights is still a bit
+        //of an open problem).
+        target_model->mPosition = base->mPosition;
+        target_model->mSkinWeights = base->mSkinWeights;
+        target_model->mSkinInfo = base->mSkinInfo;
+
+        //copy material list
+        target_model->mMaterialList = base->mMaterialList;
+
+        if (!validate_model(target_model))
+        {
+            LL_ERRS() << "Invalid model generated when creating LODs" << LL_ENDL;
+        }
+    }
+
+    mModel[lod] = generation.mTarget;
+    mVertexBuffer[lod].clear();
+
+    //rebuild scene based on mBaseScene
+    mScene[lod].clear();
+    mScene[lod] = mBaseScene;
+
+    for (U32 i = 0; i < generation.mBase.size(); ++i)
+    {
+        LLModel* mdl = generation.mBase[i];
+        LLModel* target = mModel[lod][i];
+        if (target)
+        {
+            for (LLModelLoader::scene::iterator iter = mScene[lod].begin(); iter != mScene[lod].end(); ++iter)
             {
-                // Run meshoptimizer for each face
-                for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
+                for (U32 j = 0; j < iter->second.size(); ++j)
                 {
-                    if (genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY) < 0)
+                    if (iter->second[j].mModel == mdl)
                     {
-                        // Sloppy failed and returned an invalid model
-                        genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
+                        iter->second[j].mModel = target;
                     }
                 }
             }
+        }
+    }
 
-            if (model_meshopt_mode == MESH_OPTIMIZER_AUTO)
-            {
-                // Remove progressively more data if we can't reach the target.
-                F32 allowed_ratio_drift = 1.8f;
-                F32 precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
+    mDirty = true;
+    refresh();
+}
 
-                if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+// static
+void LLModelPreview::runLODGenTask(LODGenBatch& batch, U32 mdl_idx, S32 face_idx)
+{
+    // Announce ourselves before looking at the cancellation flag, the
+    // preview relies on that order when it releases the models.
+    ++batch.mRunning;
+    if (!batch.mCancelled)
+    {
+        LLModel* base = batch.mBase[mdl_idx];
+        LLModel* target_model = batch.mTarget[mdl_idx];
+        LLMeshSimplifyCache* cache = batch.mCache.get();
+        F32 indices_decimator = batch.mIndicesDecimator;
+        F32 lod_error_threshold = batch.mErrorThreshold;
+
+        if (face_idx < 0)
+        {
+            genMeshOptimizerAuto(batch, base, target_model);
+        }
+        else
+        {
+            U64 face_hash = LLMeshSimplifyCache::hashGeometry(base, face_idx);
+
+            if (batch.mMeshOptMode == MESH_OPTIMIZER_PRECISE)
+            {
+                F32 res = genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL, cache, face_hash);
+                if (res < 0)
                 {
-                    precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_NORMALS);
+                    // Mesh optimizer failed and returned an invalid model
+                    const LLVolumeFace &face = base->getVolumeFace(face_idx);
+                    LLVolumeFace &new_face = target_model->getVolumeFace(face_idx);
+                    new_face = face;
                 }
-
-                if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+            }
+            else if (batch.mMeshOptMode == MESH_OPTIMIZER_SLOPPY)
+            {
+                if (genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY, cache, face_hash) < 0)
                 {
-                    precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_UVS);
+                    // Sloppy failed and returned an invalid model
+                    genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL, cache, face_hash);
                 }
+            }
+        }
+    }
+    --batch.mRunning;
+    --batch.mRemaining;
+}
 
-                if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
-                {
-                    // Try sloppy variant if normal one failed to simplify model enough.
-                    // Sloppy variant can fail entirely and has issues with precision,
-                    // so code needs to do multiple attempts with different decimators.
-                    // Todo: this is a bit of a mess, needs to be refined and improved
+// static
+void LLModelPreview::genMeshOptimizerAuto(LODGenBatch& batch, LLModel* base, LLModel* target_model)
+{
+    LLMeshSimplifyCache* cache = batch.mCache.get();
+    U64 geometry_hash = LLMeshSimplifyCache::hashGeometry(base, -1);
+    F32 indices_decimator = batch.mIndicesDecimator;
+    F32 lod_error_threshold = batch.mErrorThreshold;
 
-                    F32 last_working_decimator = 0.f;
-                    F32 last_working_ratio = F32_MAX;
+    // Remove progressively more data if we can't reach the target.
+    F32 allowed_ratio_drift = 1.8f;
+    F32 precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL, cache, geometry_hash);
 
-                    F32 sloppy_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
+    if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+    {
+        precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_NORMALS, cache, geometry_hash);
+    }
 
-                    if (sloppy_ratio > 0)
-                    {
-                        // Would be better to do a copy of target_model here, but if
-                        // we need to use sloppy decimation, model should be cheap
-                        // and fast to generate and it won't affect end result
-                        last_working_decimator = indices_decimator;
-                        last_working_ratio = sloppy_ratio;
-                    }
+    if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+    {
+        precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_UVS, cache, geometry_hash);
+    }
 
-                    // Sloppy has a tendecy to error into lower side, so a request for 100
-                    // triangles turns into ~70, so check for significant difference from target decimation
-                    F32 sloppy_ratio_drift = 1.4f;
-                    if (lod_mode == LIMIT_TRIANGLES
-                        && (sloppy_ratio > indices_decimator * sloppy_ratio_drift || sloppy_ratio < 0))
-                    {
-                        // Apply a correction to compensate.
+    if (batch.mCancelled)
+    {
+        // Settings changed while we were working, result would be discarded
+        return;
+    }
 
-                        // (indices_decimator / res_ratio) by itself is likely to overshoot to a differend
-                        // side due to overal lack of precision, and we don't need an ideal result, which
-                        // likely does not exist, just a better one, so a partial correction is enough.
-                        F32 sloppy_decimator = indices_decimator * (indices_decimator / sloppy_ratio + 1) / 2;
-                        sloppy_ratio = genMeshOptimizerPerModel(base, target_model, sloppy_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
-                    }
+    if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+    {
+        // Try sloppy variant if normal one failed to simplify model enough.
+        // Sloppy variant can fail entirely and has issues with precision,
+        // so code needs to do multiple attempts with different decimators.
+        // Todo: this is a bit of a mess, needs to be refined and improved
 
-                    if (last_working_decimator > 0 && sloppy_ratio < last_working_ratio)
-                    {
-                        // Compensation didn't work, return back to previous decimator
-                        sloppy_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
-                    }
+        F32 last_working_decimator = 0.f;
+        F32 last_working_ratio = F32_MAX;
 
-                    if (sloppy_ratio < 0)
-                    {
-                        // Sloppy method didn't work, try with smaller decimation values
-                        S32 size_vertices = 0;
+        F32 sloppy_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY, cache, geometry_hash);
 
-                        for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
-                        {
-                            const LLVolumeFace &face = base->getVolumeFace(face_idx);
-                            size_vertices += face.mNumVertices;
-                        }
+        if (sloppy_ratio > 0)
+        {
+            // Would be better to do a copy of target_model here, but if
+            // we need to use sloppy decimation, model should be cheap
+            // and fast to generate and it won't affect end result
+            last_working_decimator = indices_decimator;
+            last_working_ratio = sloppy_ratio;
+        }
 
-                        // Complex models aren't supposed to get here, they are supposed
-                        // to work on a first try of sloppy due to having more viggle room.
-                        // If they didn't, something is likely wrong, no point locking the
-                        // thread in a long calculation that will fail.
-                        const U32 too_many_vertices = 27000;
-                        if (size_vertices > too_many_vertices)
-                        {
-                            LL_WARNS() << "Sloppy optimization method failed for a complex model " << target_model->getName() << LL_ENDL;
-                        }
-                        else
-                        {
-                            // Find a decimator that does work
-                            F32 sloppy_decimation_step = sqrt((F32)decimation); // example: 27->15->9->5->3
-                            F32 sloppy_decimator = indices_decimator / sloppy_decimation_step;
+        // Sloppy has a tendecy to error into lower side, so a request for 100
+        // triangles turns into ~70, so check for significant difference from target decimation
+        F32 sloppy_ratio_drift = 1.4f;
+        if (batch.mLoDLimitMode == LIMIT_TRIANGLES
+            && (sloppy_ratio > indices_decimator * sloppy_ratio_drift || sloppy_ratio < 0))
+        {
+            // Apply a correction to compensate.
 
-                            while (sloppy_ratio < 0
-                                && sloppy_decimator > precise_ratio
-                                && sloppy_decimator > 1)// precise_ratio isn't supposed to be below 1, but check just in case
-                            {
-                                sloppy_ratio = genMeshOptimizerPerModel(base, target_model, sloppy_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
-                                sloppy_decimator = sloppy_decimator / sloppy_decimation_step;
-                            }
-                        }
-                    }
+            // (indices_decimator / res_ratio) by itself is likely to overshoot to a differend
+            // side due to overal lack of precision, and we don't need an ideal result, which
+            // likely does not exist, just a better one, so a partial correction is enough.
+            F32 sloppy_decimator = indices_decimator * (indices_decimator / sloppy_ratio + 1) / 2;
+            sloppy_ratio = genMeshOptimizerPerModel(base, target_model, sloppy_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY, cache, geometry_hash);
+        }
 
-                    if (sloppy_ratio < 0 || sloppy_ratio < precise_ratio)
-                    {
-                        // Sloppy variant failed to generate triangles or is worse.
-                        // Can happen with models that are too simple as is.
+        if (last_working_decimator > 0 && sloppy_ratio < last_working_ratio)
+        {
+            // Compensation didn't work, return back to previous decimator
+            sloppy_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY, cache, geometry_hash);
+        }
 
-                        if (precise_ratio < 0)
-                        {
-                            // Precise method failed as well, just copy face over
-                            target_model->copyVolumeFaces(base);
-                            precise_ratio = 1.f;
-                        }
-                        else
-                        {
-                            // Fallback to normal method
-                            precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
-                        }
+        if (sloppy_ratio < 0)
+        {
+            // Sloppy method didn't work, try with smaller decimation values
+            S32 size_vertices = 0;
 
-                        LL_INFOS() << "Model " << target_model->getName()
-                            << " lod " << which_lod
-                            << " resulting ratio " << precise_ratio
-                            << " simplified using per model method." << LL_ENDL;
-                    }
-                    else
-                    {
-                        LL_INFOS() << "Model " << target_model->getName()
-                            << " lod " << which_lod
-                            << " resulting ratio " << sloppy_ratio
-                            << " sloppily simplified using per model method." << LL_ENDL;
-                    }
-                }
-                else
-                {
-                    LL_INFOS() << "Model " << target_model->getName()
-                        << " lod " << which_lod
-                        << " resulting ratio " << precise_ratio
-                        << " simplified using per model method." << LL_ENDL;
-                }
+            for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
+            {
+                const LLVolumeFace &face = base->getVolumeFace(face_idx);
+                size_vertices += face.mNumVertices;
             }
 
-            //blind copy skin weights and just take closest skin weight to point on
-            //decimated mesh for now (auto-generating LODs with skin weights is still a bit
-            //of an open problem).
-            target_model->mPosition = base->mPosition;
-            target_model->mSkinWeights = base->mSkinWeights;
-            target_model->mSkinInfo = base->mSkinInfo;
-
-            //copy material list
-            target_model->mMaterialList = base->mMaterialList;
-
-            if (!validate_model(target_model))
+            // Complex models aren't supposed to get here, they are supposed
+            // to work on a first try of sloppy due to having more viggle room.
+            // If they didn't, something is likely wrong, no point locking the
+            // thread in a long calculation that will fail.
+            const U32 too_many_vertices = 27000;
+            if (size_vertices > too_many_vertices)
             {
-                LL_ERRS() << "Invalid model generated when creating LODs" << LL_ENDL;
+                LL_WARNS() << "Sloppy optimization method failed for a complex model " << target_model->getName() << LL_ENDL;
+            }
+            else
+            {
+                // Find a decimator that does work
+                F32 sloppy_decimation_step = sqrt((F32)batch.mDecimation); // example: 27->15->9->5->3
+                F32 sloppy_decimator = indices_decimator / sloppy_decimation_step;
+
+                while (sloppy_ratio < 0
+                    && sloppy_decimator > precise_ratio
+                    && sloppy_decimator > 1 // precise_ratio isn't supposed to be below 1, but check just in case
+                    && !batch.mCancelled)
+                {
+                    sloppy_ratio = genMeshOptimizerPerModel(base, target_model, sloppy_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY, cache, geometry_hash);
+                    sloppy_decimator = sloppy_decimator / sloppy_decimation_step;
+                }
             }
         }
 
-        //rebuild scene based on mBaseScene
-        mScene[lod].clear();
-        mScene[lod] = mBaseScene;
-
-        for (U32 i = 0; i < mBaseModel.size(); ++i)
+        if (sloppy_ratio < 0 || sloppy_ratio < precise_ratio)
         {
-            LLModel* mdl = mBaseModel[i];
-            LLModel* target = mModel[lod][i];
-            if (target)
+            // Sloppy variant failed to generate triangles or is worse.
+            // Can happen with models that are too simple as is.
+
+            if (precise_ratio < 0)
             {
-                for (LLModelLoader::scene::iterator iter = mScene[lod].begin(); iter != mScene[lod].end(); ++iter)
-                {
-                    for (U32 j = 0; j < iter->second.size(); ++j)
-                    {
-                        if (iter->second[j].mModel == mdl)
-                        {
-                            iter->second[j].mModel = target;
-                        }
-                    }
-                }
+                // Precise method failed as well, just copy face over
+                target_model->copyVolumeFaces(base);
+                precise_ratio = 1.f;
             }
+            else
+            {
+                // Fallback to normal method
+                precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL, cache, geometry_hash);
+            }
+
+            LL_INFOS() << "Model " << target_model->getName()
+                << " lod " << batch.mLOD
+                << " resulting ratio " << precise_ratio
+                << " simplified using per model method." << LL_ENDL;
         }
+        else
+        {
+            LL_INFOS() << "Model " << target_model->getName()
+                << " lod " << batch.mLOD
+                << " resulting ratio " << sloppy_ratio
+                << " sloppily simplified using per model method." << LL_ENDL;
+        }
+    }
+    else
+    {
+        LL_INFOS() << "Model " << target_model->getName()
+            << " lod " << batch.mLOD
+            << " resulting ratio " << precise_ratio
+            << " simplified using per model method." << LL_ENDL;
     }
 }
 
@@ -2841,6 +3238,8 @@ void LLModelPreview::genBuffers(S32 lod, bool include_skin_weights)
 
 void LLModelPreview::update()
 {
+    processLODGenerations();
+
     if (mGenLOD)
     {
         bool subscribe_for_generation = mLodsQuery.empty();
@@ -2860,7 +3259,7 @@ void LLModelPreview::update()
         }
     }
 
-    if (mDirty && mLodsQuery.empty())
+    if (mDirty && mLodsQuery.empty() && !isGeneratingLODs())
     {
         mDirty = false;
         updateDimentionsAndOffsets();
@@ -2958,7 +3357,8 @@ void LLModelPreview::lookupLODModelFiles(S32 lod)
     S32 next_lod = (lod - 1 >= LLModel::LOD_IMPOSTOR) ? lod - 1 : LLModel::LOD_PHYSICS;
 
     std::string lod_filename = mLODFile[LLModel::LOD_HIGH];
-    std::string ext = ".dae";
+    // lower LODs are expected in the same format as the high LOD (.dae, .glb)
+    std::string ext = "." + gDirUtilp->getExtension(lod_filename);
     std::string lod_filename_lower(lod_filename);
     LLStringUtil::toLower(lod_filename_lower);
     std::string::size_type i = lod_filename_lower.rfind(ext);
@@ -3905,7 +4305,8 @@ bool LLModelPreview::lodQueryCallback()
     if (fmp && fmp->mModelPreview)
     {
         LLModelPreview* preview = fmp->mModelPreview;
-        if (preview->mLodsQuery.size() > 0)
+        // Generation runs on the thread pool, so queue every pending lod at once
+        while (preview->mLodsQuery.size() > 0)
         {
             S32 lod = preview->mLodsQuery.back();
             preview->mLodsQuery.pop_back();
@@ -3913,11 +4314,9 @@ bool LLModelPreview::lodQueryCallback()
 
             if (preview->mLookUpLodFiles && (lod == LLModel::LOD_HIGH))
             {
+                // Loading a lod from file cancels its generation
                 preview->lookupLODModelFiles(LLModel::LOD_HIGH);
             }
-
-            // return false to continue cycle
-            return preview->mLodsQuery.empty();
         }
     }
     // nothing to process
@@ -34,6 +34,11 @@
 #include "llmodelloader.h" //NUM_LOD
 #include "llmodel.h"
 
+#include <atomic>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
 class LLJoint;
 class LLVOAvatar;
 class LLTextBox;
@@ -111,6 +116,37 @@ static const std::string lod_label_name[NUM_LOD + 1] =
     "I went off the end of the lod_label_name array.  Me so smart."
 };
 
+// Thread-safe store of meshoptimizer results keyed by a hash of the source
+// geometry and of the simplification parameters, so that returning a LOD
+// setting to a previous value does not run the simplifier again.
+class LLMeshSimplifyCache
+{
+public:
+    LLMeshSimplifyCache();
+
+    // Hash of the geometry of a single face, or of all faces if face_idx < 0
+    static U64 hashGeometry(const LLModel* model, S32 face_idx);
+    static U64 makeKey(U64 geometry_hash, S32 face_idx, F32 indices_decimator, F32 error_threshold, S32 simplification_mode);
+
+    // On hit copies the cached faces into target (unless the cached run
+    // failed) and returns true with the ratio the simplifier returned.
+    bool get(U64 key, LLModel* target, S32 face_idx, F32& ratio);
+    void put(U64 key, const LLModel* target, S32 face_idx, F32 ratio);
+    void clear();
+
+private:
+    struct Entry
+    {
+        std::vector<LLVolumeFace> mFaces;
+        F32 mRatio;
+        size_t mBytes;
+    };
+
+    LLMutex mMutex;
+    std::unordered_map<U64, Entry> mEntries;
+    size_t mBytes;
+};
+
 class LLModelPreview : public LLViewerDynamicTexture, public LLMutex
 {
     LOG_CLASS(LLModelPreview);
@@ -161,7 +197,7 @@ public:
     void getJointAliases(JointMap& joint_map);
     void loadModel(std::string filename, S32 lod, bool force_disable_slm = false);
     void loadModelCallback(S32 lod);
-    bool lodsReady() { return !mGenLOD && mLodsQuery.empty(); }
+    bool lodsReady() { return !mGenLOD && mLodsQuery.empty() && !isGeneratingLODs(); }
     void queryLODs() { mGenLOD = true; };
     void genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 decimation = 3, bool enforce_tri_limit = false);
     void generateNormals();
@@ -250,13 +286,59 @@ private:
         MESH_OPTIMIZER_NO_TOPOLOGY,
     } eSimplificationMode;
 
+    // One pending LOD generation. genMeshOptimizerLODs() fans a batch out to
+    // the "General" thread pool as one task per model (per face for the
+    // per-face modes); workers only see the raw pointers below, the models
+    // themselves are kept alive by the owning LODGeneration on the main thread.
+    struct LODGenBatch
+    {
+        S32 mLOD;
+        S32 mMeshOptMode;
+        U32 mLoDLimitMode;
+        U32 mDecimation;
+        F32 mIndicesDecimator;
+        F32 mErrorThreshold;
+        std::vector<LLModel*> mBase;
+        std::vector<LLModel*> mTarget;
+        std::shared_ptr<LLMeshSimplifyCache> mCache;
+        std::atomic<bool> mCancelled{ false };
+        std::atomic<S32> mRemaining{ 0 }; // tasks not finished yet
+        std::atomic<S32> mRunning{ 0 };   // tasks currently inside a worker
+    };
+
+    struct LODGeneration
+    {
+        std::shared_ptr<LODGenBatch> mBatch;
+        LLModelLoader::model_list mBase;
+        LLModelLoader::model_list mTarget;
+    };
+
+    bool isGeneratingLODs() const;
+    // Cancels pending generation of given lod, -1 for all lods
+    void cancelLODGeneration(S32 lod);
+    // Cancels all generation and waits for running tasks to leave the
+    // models, after which the main thread can change their faces
+    void stopLODGeneration();
+    // Installs finished generations, called from update()
+    void processLODGenerations();
+    void installLODGeneration(LODGeneration& generation);
+
+    static void runLODGenTask(LODGenBatch& batch, U32 mdl_idx, S32 face_idx);
+    static void genMeshOptimizerAuto(LODGenBatch& batch, LLModel* base, LLModel* target);
+
     // Merges faces into single mesh, simplifies using mesh optimizer,
     // then splits back into faces.
     // Returns reached simplification ratio. -1 in case of a failure.
-    F32 genMeshOptimizerPerModel(LLModel *base_model, LLModel *target_model, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode);
+    // When a cache is passed, geometry_hash must be the hash of base_model
+    // (LLMeshSimplifyCache::hashGeometry(base_model, -1)).
+    static F32 genMeshOptimizerPerModel(LLModel *base_model, LLModel *target_model, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode, LLMeshSimplifyCache* cache = NULL, U64 geometry_hash = 0);
     // Simplifies specified face using mesh optimizer.
     // Returns reached simplification ratio. -1 in case of a failure.
-    F32 genMeshOptimizerPerFace(LLModel *base_model, LLModel *target_model, U32 face_idx, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode);
+    // Same caching rules as above, with the hash of the face.
+    static F32 genMeshOptimizerPerFace(LLModel *base_model, LLModel *target_model, U32 face_idx, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode, LLMeshSimplifyCache* cache = NULL, U64 geometry_hash = 0);
+
+    std::list<LODGeneration> mLODGenerations;
+    std::shared_ptr<LLMeshSimplifyCache> mSimplifyCache;
 
 protected:
     friend class LLModelLoader;
@@ -0,0 +1,200 @@
+/**
+ * @file llobjectupdatequeue.cpp
+ * @brief Decodes cacheable object updates off the main thread and applies
+ * them over several frames.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llobjectupdatequeue.h"
+
+#include "lldatapacker.h"
+#include "lltimer.h"
+#include "llviewerobject.h"
+#include "llviewerregion.h"
+#include "llworld.h"
+#include "workqueue.h"
+
+#include <thread>
+
+LLObjectUpdateQueue::LLObjectUpdateQueue()
+:   mNextRecord(0),
+    mPendingCount(0)
+{
+}
+
+LLObjectUpdateQueue::~LLObjectUpdateQueue()
+{
+    // batches still being decoded are kept alive by the worker
+    clear();
+}
+
+void LLObjectUpdateQueue::add(U64 region_handle, const LLUUID& full_id, U32 local_id, U32 flags, const U8* data, S32 size)
+{
+    if (!mFilling)
+    {
+        mFilling = std::make_shared<Batch>();
+        mFilling->mRegionHandle = region_handle;
+    }
+
+    mFilling->mRecords.emplace_back();
+    LLObjectUpdateRecord& record = mFilling->mRecords.back();
+    record.mFullID = full_id;
+    record.mLocalID = local_id;
+    record.mUpdateFlags = flags;
+    record.mData.assign(data, data + size);
+
+    mPendingIDs[local_id]++;
+    mPendingCount++;
+}
+
+void LLObjectUpdateQueue::submit()
+{
+    if (!mFilling)
+    {
+        return;
+    }
+
+    batch_ptr_t batch = mFilling;
+    mFilling.reset();
+    mBatches.push_back(batch);
+
+    LL::WorkQueueBase::ptr_t queue = LL::WorkQueueBase::getInstance("General");
+    if (!queue || !queue->postIfOpen([batch]() { tryDecode(*batch); }))
+    {
+        // no pool (startup, shutdown), decode right here
+        tryDecode(*batch);
+    }
+}
+
+S32 LLObjectUpdateQueue::apply(F32Milliseconds budget)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    S32 applied = 0;
+    LLTimer timer;
+    // always make some progress, however small the budget
+    while (!mBatches.empty()
+           && mBatches.front()->mState == DECODED
+           && (!applied || timer.getElapsedTimeF32() < budget))
+    {
+        applyNext();
+        applied++;
+    }
+    return applied;
+}
+
+void LLObjectUpdateQueue::flush()
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    submit();
+    while (!mBatches.empty())
+    {
+        waitDecoded(*mBatches.front());
+        applyNext();
+    }
+}
+
+void LLObjectUpdateQueue::flushIfPending(U32 local_id)
+{
+    if (mPendingIDs.find(local_id) != mPendingIDs.end())
+    {
+        // everything before it too, updates stay in arrival order
+        flush();
+    }
+}
+
+void LLObjectUpdateQueue::clear()
+{
+    mFilling.reset();
+    mBatches.clear();
+    mNextRecord = 0;
+    mPendingIDs.clear();
+    mPendingCount = 0;
+}
+
+//static
+void LLObjectUpdateQueue::decode(LLObjectUpdateRecord& record)
+{
+    LLDataPackerBinaryBuffer dp(record.mData.data(), (S32) record.mData.size());
+    LLViewerObject::unpackU32(&dp, record.mCRC, "CRC");
+    record.mParentID = LLViewerObject::extractSpatialExtents(&dp, record.mPos, record.mScale, record.mRot);
+}
+
+//static
+bool LLObjectUpdateQueue::tryDecode(Batch& batch)
+{
+    S32 expected = QUEUED;
+    if (!batch.mState.compare_exchange_strong(expected, DECODING))
+    {
+        return false;
+    }
+
+    for (LLObjectUpdateRecord& record : batch.mRecords)
+    {
+        decode(record);
+    }
+    batch.mState = DECODED;
+    return true;
+}
+
+//static
+void LLObjectUpdateQueue::waitDecoded(Batch& batch)
+{
+    if (!tryDecode(batch))
+    {
+        while (batch.mState != DECODED)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void LLObjectUpdateQueue::applyNext()
+{
+    Batch& batch = *mBatches.front();
+    LLObjectUpdateRecord& record = batch.mRecords[mNextRecord];
+
+    std::unordered_map<U32, S32>::iterator iter = mPendingIDs.find(record.mLocalID);
+    if (iter != mPendingIDs.end() && --iter->second <= 0)
+    {
+        mPendingIDs.erase(iter);
+    }
+    mPendingCount--;
+
+    // the region may have gone away since the message arrived
+    LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(batch.mRegionHandle);
+    if (regionp)
+    {
+        LLDataPackerBinaryBuffer dp(record.mData.data(), (S32) record.mData.size());
+        regionp->cacheFullUpdate(dp, record.mUpdateFlags, &record);
+    }
+
+    if (++mNextRecord >= batch.mRecords.size())
+    {
+        mBatches.pop_front();
+        mNextRecord = 0;
+    }
+}
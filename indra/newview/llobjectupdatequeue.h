@@ -0,0 +1,115 @@
+/**
+ * @file llobjectupdatequeue.h
+ * @brief Decodes cacheable object updates off the main thread and applies
+ * them over several frames.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLOBJECTUPDATEQUEUE_H
+#define LL_LLOBJECTUPDATEQUEUE_H
+
+#include "llquaternion.h"
+#include "llunits.h"
+#include "lluuid.h"
+#include "v3math.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// One ObjectData block of an ObjectUpdateCompressed message unpacked into
+// plain data, so that it can be applied without the message system.
+struct LLObjectUpdateRecord
+{
+    LLUUID          mFullID;
+    U32             mLocalID = 0;
+    U32             mCRC = 0;
+    U32             mUpdateFlags = 0;
+    U32             mParentID = 0;
+    LLVector3       mPos;
+    LLVector3       mScale;
+    LLQuaternion    mRot;
+    std::vector<U8> mData;      // packed object data, as kept by LLVOCacheEntry
+};
+
+// Full updates for cacheable objects only feed the region object caches, so
+// they don't have to be handled while their message is current. They are
+// copied out of the message on the main thread, decoded on the "General"
+// thread pool and applied in arrival order by apply(), which stops once its
+// time budget is spent. Anything that must not overtake a queued update for
+// the same object calls flushIfPending() first.
+class LLObjectUpdateQueue
+{
+public:
+    LLObjectUpdateQueue();
+    ~LLObjectUpdateQueue();
+
+    // Takes the packed data of one block of the current message, submit()
+    // hands all blocks added since the last call to the decoders.
+    void add(U64 region_handle, const LLUUID& full_id, U32 local_id, U32 flags, const U8* data, S32 size);
+    void submit();
+
+    // Applies decoded updates in order until budget runs out or the next one
+    // is still being decoded. Returns the number applied.
+    S32 apply(F32Milliseconds budget);
+
+    // Applies every queued update, decoding on the calling thread if needed
+    void flush();
+    void flushIfPending(U32 local_id);
+
+    // Drops queued updates without applying them
+    void clear();
+
+    S32 getPendingCount() const { return mPendingCount; }
+
+    // Unpacks the CRC, parent and spatial extents of record from its data.
+    // Safe to call from any thread.
+    static void decode(LLObjectUpdateRecord& record);
+
+private:
+    enum { QUEUED, DECODING, DECODED };
+
+    struct Batch
+    {
+        U64                                 mRegionHandle = 0;
+        std::vector<LLObjectUpdateRecord>   mRecords;
+        std::atomic<S32>                    mState { QUEUED };
+    };
+    typedef std::shared_ptr<Batch> batch_ptr_t;
+
+    // Decodes batch unless another thread got to it first
+    static bool tryDecode(Batch& batch);
+    static void waitDecoded(Batch& batch);
+
+    void applyNext();
+
+    batch_ptr_t                 mFilling;
+    std::deque<batch_ptr_t>     mBatches;
+    size_t                      mNextRecord;    // in mBatches.front()
+    std::unordered_map<U32, S32> mPendingIDs;
+    S32                         mPendingCount;
+};
+
+#endif // LL_LLOBJECTUPDATEQUEUE_H
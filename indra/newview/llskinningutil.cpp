@@ -33,9 +33,32 @@
 #include "llmeshrepository.h"
 #include "llvolume.h"
 #include "llrigginginfo.h"
+#include "hbxxh.h"
 
 #define DEBUG_SKINNING  LL_DEBUG
 
+namespace
+{
+    // Joint numbers resolved per joint name list. Every avatar is built from
+    // the same skeleton definition, so skins of different meshes with the
+    // same joints resolve to the same numbers whichever avatar wears them.
+    typedef std::unordered_map<U64, std::vector<S32> > joint_nums_cache_t;
+    joint_nums_cache_t sJointNumsCache;
+    const size_t MAX_JOINT_NUMS_CACHE_ENTRIES = 4096;
+
+    U64 hash_joint_names(const LLMeshSkinInfo* skin)
+    {
+        HBXXH64 hash;
+        for (const std::string& name : skin->mJointNames)
+        {
+            hash.update(name);
+            // keep {"ab","c"} and {"a","bc"} apart
+            hash.update("", 1);
+        }
+        return hash.digest();
+    }
+}
+
 void dump_avatar_and_skin_state(const std::string& reason, LLVOAvatar *avatar, const LLMeshSkinInfo *skin)
 {
 #if DEBUG_SKINNING
@@ -274,6 +297,17 @@ void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
     if (!skin->mJointNumsInitialized)
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    #if !DEBUG_SKINNING
+        U64 key = hash_joint_names(skin);
+        joint_nums_cache_t::const_iterator iter = sJointNumsCache.find(key);
+        if (iter != sJointNumsCache.end() && iter->second.size() == skin->mJointNums.size())
+        {
+            skin->mJointNums = iter->second;
+            skin->mJointNumsInitialized = true;
+            return;
+        }
+        bool all_found = true;
+    #endif
         for (U32 j = 0; j < skin->mJointNames.size(); ++j)
         {
     #if DEBUG_SKINNING     
@@ -301,11 +335,23 @@ void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
     #else
             LLJoint *joint = (skin->mJointNums[j] == -1) ? avatar->getJoint(skin->mJointNames[j]) : avatar->getJoint(skin->mJointNums[j]);
             skin->mJointNums[j] = joint ? joint->getJointNum() : 0;            
+            all_found = all_found && joint;
     #endif
             // insure we have *a* valid joint to reference
             llassert(skin->mJointNums[j] >= 0);
         }
         skin->mJointNumsInitialized = true;
+    #if !DEBUG_SKINNING
+        // don't share fallbacks, the next avatar may have the joint
+        if (all_found)
+        {
+            if (sJointNumsCache.size() >= MAX_JOINT_NUMS_CACHE_ENTRIES)
+            {
+                sJointNumsCache.clear();
+            }
+            sJointNumsCache[key] = skin->mJointNums;
+        }
+    #endif
     }
 }
 
@@ -50,7 +50,7 @@ namespace LLSkinningUtil
     LL_FORCE_INLINE void getPerVertexSkinMatrixWithIndices(
         F32*        weights,
         U8*         idx,
-        LLMatrix4a* mat,
+        const LLMatrix4a* mat,
         LLMatrix4a& final_mat,
         LLMatrix4a* src)
     {    
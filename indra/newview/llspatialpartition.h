@@ -31,6 +31,7 @@
 
 #include "lldrawable.h"
 #include "lloctree.h"
+#include "llframeallocator.h"
 #include "llpointer.h"
 #include "llrefcount.h"
 #include "llvertexbuffer.h"
@@ -69,7 +70,8 @@ void render_hull(LLModel::PhysicsMesh& mesh, const LLColor4& color, const LLColo
 
 class LLDrawInfo : public LLRefCount
 {
-    LL_ALIGN_NEW;
+    // particles and rebuilt groups make these by the thousand, keep them off the heap
+    LL_POOL_NEW(LLDrawInfo);
 protected:
 	~LLDrawInfo();	
 	
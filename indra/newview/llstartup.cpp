@@ -617,6 +617,12 @@ bool idle_startup()
 			F32 dropPercent = gSavedSettings.getF32("PacketDropPercentage");
 			msg->mPacketRing.setDropPercentage(dropPercent);
 
+			if (gSavedSettings.getbool("PacketReceiveThread"))
+			{
+				msg->mPacketRing.startReceiveThread(msg->mSocket);
+			}
+			msg->mPacketRing.setBatchSends(gSavedSettings.getbool("PacketSendBatching"));
+
             F32 inBandwidth = gSavedSettings.getF32("InBandwidth"); 
             F32 outBandwidth = gSavedSettings.getF32("OutBandwidth"); 
 			if (inBandwidth != 0.f)
@@ -32,7 +32,6 @@
 #include "lldir.h"
 #include "llimage.h"
 #include "llimagej2c.h" // for version control
-#include "lllfsthread.h"
 #include "llviewercontrol.h"
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
@@ -61,39 +60,6 @@ class LLTextureCacheWorker : public LLWorkerClass
 {
 	friend class LLTextureCache;
 
-private:
-	class ReadResponder : public LLLFSThread::Responder
-	{
-	public:
-		ReadResponder(LLTextureCache* cache, handle_t handle) : mCache(cache), mHandle(handle) {}
-		~ReadResponder() {}
-		void completed(S32 bytes)
-		{
-			mCache->lockWorkers();
-			LLTextureCacheWorker* reader = mCache->getReader(mHandle);
-			if (reader) reader->ioComplete(bytes);
-			mCache->unlockWorkers();
-		}
-		LLTextureCache* mCache;
-		LLTextureCacheWorker::handle_t mHandle;
-	};
-
-	class WriteResponder : public LLLFSThread::Responder
-	{
-	public:
-		WriteResponder(LLTextureCache* cache, handle_t handle) : mCache(cache), mHandle(handle) {}
-		~WriteResponder() {}
-		void completed(S32 bytes)
-		{
-			mCache->lockWorkers();
-			LLTextureCacheWorker* writer = mCache->getWriter(mHandle);
-			if (writer) writer->ioComplete(bytes);
-			mCache->unlockWorkers();
-		}
-		LLTextureCache* mCache;
-		LLTextureCacheWorker::handle_t mHandle;
-	};
-	
 public:
 	LLTextureCacheWorker(LLTextureCache* cache, U32 priority, const LLUUID& id,
 						 U8* data, S32 datasize, S32 offset,
@@ -111,7 +77,6 @@ public:
 		  mImageFormat(IMG_CODEC_J2C),
 		  mImageLocal(false),
 		  mResponder(responder),
-		  mFileHandle(LLLFSThread::nullHandle()),
 		  mBytesToRead(0),
 		  mBytesRead(0)
 	{
@@ -156,7 +121,6 @@ protected:
 	EImageCodec mImageFormat;
 	bool mImageLocal;
 	LLPointer<LLTextureCache::Responder> mResponder;
-	LLLFSThread::handle_t mFileHandle;
 	S32 mBytesToRead;
 	LLAtomicS32 mBytesRead;
 };
@@ -207,50 +171,6 @@ bool LLTextureCacheLocalFileWorker::doRead()
 		return true;
 	}
 
-#if USE_LFS_READ
-	if (mFileHandle == LLLFSThread::nullHandle())
-	{
-		mImageLocal = true;
-		mImageSize = local_size;
-		if (!mDataSize || mDataSize + mOffset > local_size)
-		{
-			mDataSize = local_size - mOffset;
-		}
-		if (mDataSize <= 0)
-		{
-			// no more data to read
-			mDataSize = 0;
-			return true;
-		}
-		mReadData = (U8*)ALLOCATE_MEM(LLImageBase::getPrivatePool(), mDataSize);
-		mBytesRead = -1;
-		mBytesToRead = mDataSize;
-		setPriority(LLWorkerThread::PRIORITY_LOW | mPriority);
-		mFileHandle = LLLFSThread::sLocal->read(local_filename, mReadData, mOffset, mDataSize,
-												new ReadResponder(mCache, mRequestHandle));
-		return false;
-	}
-	else
-	{
-		if (mBytesRead >= 0)
-		{
-			if (mBytesRead != mBytesToRead)
-			{
-// 				LL_WARNS() << "Error reading file from local cache: " << local_filename
-// 						<< " Bytes: " << mDataSize << " Offset: " << mOffset
-// 						<< " / " << mDataSize << LL_ENDL;
-				mDataSize = 0; // failed
-				ll_aligned_free_16(mReadData);
-				mReadData = NULL;
-			}
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	}
-#else
 	if (!mDataSize || mDataSize > local_size)
 	{
 		mDataSize = local_size;
@@ -274,7 +194,6 @@ bool LLTextureCacheLocalFileWorker::doRead()
 		mImageLocal = true;
 	}
 	return true;
-#endif
 }
 
 bool LLTextureCacheLocalFileWorker::doWrite()
@@ -293,7 +212,7 @@ public:
 						 LLTextureCache::Responder* responder) 
 			: LLTextureCacheWorker(cache, priority, id, data, datasize, offset, imagesize, responder),
 			mState(INIT),
-			mRawImage(raw),
+			mRawImage(std::move(raw)),
 			mRawDiscardLevel(discardlevel)
 	{
 	}
@@ -2021,7 +1940,7 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id, U32 prio
 	LLMutexLock lock(&mWorkersMutex);
 	LLTextureCacheWorker* worker = new LLTextureCacheRemoteWorker(this, priority, id,
 																  data, datasize, 0,
-																  imagesize, rawimage, discardlevel, responder);
+																  imagesize, std::move(rawimage), discardlevel, responder);
 	handle_t handle = worker->write();
 	mWriters[handle] = worker;
 	return handle;
@@ -2085,7 +2004,7 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 }
 
 //return the fast cache location
-bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImageRaw> raw, S32 discardlevel)
+bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLBorrowedPointer<LLImageRaw> raw, S32 discardlevel)
 {
 	//rescale image if needed
 	if (raw.isNull() || raw->isBufferInvalid() || !raw->getData())
@@ -2100,6 +2019,7 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
 	c = raw->getComponents();
 
 	S32 i = 0 ;
+	LLPointer<LLImageRaw> scaled;
 
 	// Search for a discard level that will fit into fast cache
 	while(((w >> i) * (h >> i) * c) > TEXTURE_FAST_CACHE_DATA_SIZE)
@@ -2114,15 +2034,16 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
 		if(w * h *c > 0) //valid
 		{
             // Make a duplicate to keep the original raw image untouched.
-            raw = raw->duplicate();
+            scaled = raw->duplicate();
 
-			if (raw->isBufferInvalid())
+			if (scaled->isBufferInvalid())
 			{
 				LL_WARNS() << "Invalid image duplicate buffer" << LL_ENDL;
 				return false;
 			}
 
-			raw->scale(w, h);
+			scaled->scale(w, h);
+			raw = scaled;
 
 			discardlevel += i ;
 		}
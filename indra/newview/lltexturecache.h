@@ -188,7 +188,7 @@ private:
 	
 	void openFastCache(bool first_time = false);
 	void closeFastCache(bool forced = false);
-	bool writeToFastCache(LLUUID image_id, S32 cache_id, LLPointer<LLImageRaw> raw, S32 discardlevel);	
+	bool writeToFastCache(LLUUID image_id, S32 cache_id, LLBorrowedPointer<LLImageRaw> raw, S32 discardlevel);	
 
 private:
 	// Internal
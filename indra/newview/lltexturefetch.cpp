@@ -66,6 +66,7 @@ bool LLTextureFetchDebugger::sDebuggerEnabled = false ;
 
 LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheHit("texture_cache_hit");
 LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheAttempt("texture_cache_attempt");
+LLTrace::CountStatHandle<F64> LLTextureFetch::sHttpBytesCopied("texture_http_bytes_copied", "HTTP texture bytes copied out of response bodies");
 LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > LLTextureFetch::sCacheHitRate("texture_cache_hits");
 
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheReadLatency("texture_cache_read_latency");
@@ -1806,7 +1807,20 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				mRequestedOffset += src_offset;
 			}
 
-			U8 * buffer = (U8 *)ll_aligned_malloc_16(total_size);
+			// A first fetch whose body came in one aligned block is
+			// adopted as the image data as is, anything else is
+			// assembled in a new buffer.
+			U8 * buffer(NULL);
+			size_t adopted_size(0);
+			if (! cur_size && ! src_offset)
+			{
+				buffer = (U8 *) mHttpBufferArray->detachContiguous(&adopted_size);
+				llassert_always(! buffer || adopted_size == append_size);
+			}
+			if (! buffer)
+			{
+				buffer = (U8 *)ll_aligned_malloc_16(total_size);
+			}
 			if (!buffer)
 			{
 				// abort. If we have no space for packet, we have not enough space to decode image
@@ -1836,12 +1850,16 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				mFileSize = total_size + 1 ; //flag the file is not fully loaded.
 			}
 
-			if (cur_size > 0)
+			if (! adopted_size)
 			{
-				// Copy previously collected data into buffer
-				memcpy(buffer, mFormattedImage->getData(), cur_size);
+				if (cur_size > 0)
+				{
+					// Copy previously collected data into buffer
+					memcpy(buffer, mFormattedImage->getData(), cur_size);
+				}
+				mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
+				add(LLTextureFetch::sHttpBytesCopied, (F64) append_size);
 			}
-			mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
 
 			// NOTE: setData releases current data and owns new data (buffer)
 			mFormattedImage->setData(buffer, total_size);
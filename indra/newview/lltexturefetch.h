@@ -311,6 +311,7 @@ public:
 	
     static LLTrace::CountStatHandle<F64>        sCacheHit;
     static LLTrace::CountStatHandle<F64>        sCacheAttempt;
+    static LLTrace::CountStatHandle<F64>        sHttpBytesCopied;
     static LLTrace::SampleStatHandle<F32Seconds> sCacheReadLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sTexDecodeLatency;
 	static LLTrace::SampleStatHandle<F32Seconds> sCacheWriteLatency;
@@ -32,7 +32,7 @@
 
 #include "llrect.h"
 #include "llerror.h"
-#include "lllfsthread.h"
+#include "llfileioservice.h"
 #include "llui.h"
 #include "llimageworker.h"
 #include "llrender.h"
@@ -607,7 +607,7 @@ void LLGLTexMemBar::draw()
 					LLAppViewer::getTextureFetch()->getNumRequests(), LLAppViewer::getTextureFetch()->getNumDeletes(),
 					LLAppViewer::getTextureFetch()->mPacketCount, LLAppViewer::getTextureFetch()->mBadPacketCount, 
 					LLAppViewer::getTextureCache()->getNumReads(), LLAppViewer::getTextureCache()->getNumWrites(),
-					LLLFSThread::sLocal->getPending(),
+					S32(LLFileIOService::instance().getPending()),
 					LLImageRaw::sRawImageCount,
 					LLAppViewer::getTextureFetch()->getNumHTTPRequests(),
 					LLAppViewer::getImageDecodeThread()->getPending(),
@@ -41,6 +41,7 @@
 #include "lldrawpoolterrain.h"
 #include "llflexibleobject.h"
 #include "llfeaturemanager.h"
+#include "llheaptracker.h"
 #include "llviewershadermgr.h"
 
 #include "llsky.h"
@@ -510,6 +511,12 @@ static bool handleDebugViewsChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleHeapTrackerSampleIntervalChanged(const LLSD& newvalue)
+{
+	LLHeapTracker::setSampleInterval((U32)newvalue.asInteger());
+	return true;
+}
+
 static bool handleLogFileChanged(const LLSD& newvalue)
 {
 	std::string log_filename = newvalue.asString();
@@ -897,6 +904,7 @@ void settings_setup_listeners()
 	setting_setup_signal_listener(gSavedSettings, "LoginLocation", handleLoginLocationChanged);
 	setting_setup_signal_listener(gSavedSettings, "DebugAvatarJoints", handleDebugAvatarJointsChanged);
 	setting_setup_signal_listener(gSavedSettings, "RenderAutoMuteByteLimit", handleRenderAutoMuteByteLimitChanged);
+	setting_setup_signal_listener(gSavedSettings, "HeapTrackerSampleInterval", handleHeapTrackerSampleIntervalChanged);
 
     setting_setup_signal_listener(gSavedPerAccountSettings, "AvatarHoverOffsetZ", handleAvatarHoverOffsetChanged);
 }
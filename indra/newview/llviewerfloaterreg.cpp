@@ -93,6 +93,7 @@
 // [SL:KB] - Patch: Notification-GroupCreateNotice | Checked: 2012-02-16 (Catznip-3.2)
 #include "llfloatergroupactions.h"
 // [/SL:KB]
+#include "llfloaterheapprofile.h"
 #include "llfloaterhelpbrowser.h"
 #include "llfloaterhoverheight.h"
 #include "llfloaterhowto.h"
@@ -271,6 +272,7 @@ public:
                 "forget_username",
                 "god_tools",
                 "group_picker",
+                "heap_profile",
                 "hud",
                 "incoming_call",
                 "linkreplace",
@@ -401,6 +403,7 @@ void LLViewerFloaterReg::registerFloaters()
 // [/SL:KB]
 	LLFloaterReg::add("group_picker", "floater_choose_group.xml", (LLFloaterBuildFunc)&LLFloaterReg::build<LLFloaterGroupPicker>);
 
+	LLFloaterReg::add("heap_profile", "floater_heap_profile.xml", (LLFloaterBuildFunc)&LLFloaterReg::build<LLFloaterHeapProfile>);
 	LLFloaterReg::add("help_browser", "floater_help_browser.xml", (LLFloaterBuildFunc)&LLFloaterReg::build<LLFloaterHelpBrowser>);
 	LLFloaterReg::add("edit_hover_height", "floater_edit_hover_height.xml", (LLFloaterBuildFunc)&LLFloaterReg::build<LLFloaterHoverHeight>);
 	LLFloaterReg::add("hud", "floater_hud.xml", (LLFloaterBuildFunc)&LLFloaterReg::build<LLFloaterHUD>);
@@ -3780,6 +3780,9 @@ void process_kill_object(LLMessageSystem *mesgsys, void **user_data)
 		U32	local_id;
 		mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
 
+		// a queued full update must not recreate the object after the kill
+		gObjectList.flushObjectUpdates(local_id);
+
 		LLViewerObjectList::getUUIDFromLocal(id, local_id, ip, port); 
 		if (id == LLUUID::null)
 		{
@@ -654,10 +654,17 @@ void LLViewerObject::initObjectDataMap()
 	//-------
 }
 
+//static
+U32 LLViewerObject::getObjectDataOffset(const std::string& name)
+{
+	std::map<std::string, U32>::const_iterator iter = sObjectDataMap.find(name);
+	return iter != sObjectDataMap.end() ? iter->second : 0;
+}
+
 //static 
 void LLViewerObject::unpackVector3(LLDataPackerBinaryBuffer* dp, LLVector3& value, std::string name)
 {
-	dp->shift(sObjectDataMap[name]);
+	dp->shift(getObjectDataOffset(name));
 	dp->unpackVector3(value, name.c_str());
 	dp->reset();
 }
@@ -665,7 +672,7 @@ void LLViewerObject::unpackVector3(LLDataPackerBinaryBuffer* dp, LLVector3& valu
 //static 
 void LLViewerObject::unpackUUID(LLDataPackerBinaryBuffer* dp, LLUUID& value, std::string name)
 {
-	dp->shift(sObjectDataMap[name]);
+	dp->shift(getObjectDataOffset(name));
 	dp->unpackUUID(value, name.c_str());
 	dp->reset();
 }
@@ -673,7 +680,7 @@ void LLViewerObject::unpackUUID(LLDataPackerBinaryBuffer* dp, LLUUID& value, std
 //static 
 void LLViewerObject::unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name)
 {
-	dp->shift(sObjectDataMap[name]);
+	dp->shift(getObjectDataOffset(name));
 	dp->unpackU32(value, name.c_str());
 	dp->reset();
 }
@@ -681,7 +688,7 @@ void LLViewerObject::unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::st
 //static 
 void LLViewerObject::unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name)
 {
-	dp->shift(sObjectDataMap[name]);
+	dp->shift(getObjectDataOffset(name));
 	dp->unpackU8(value, name.c_str());
 	dp->reset();
 }
@@ -689,14 +696,14 @@ void LLViewerObject::unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::stri
 //static 
 U32 LLViewerObject::unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id)
 {
-	dp->shift(sObjectDataMap["SpecialCode"]);
+	dp->shift(getObjectDataOffset("SpecialCode"));
 	U32 value;
 	dp->unpackU32(value, "SpecialCode");
 
 	parent_id = 0;
 	if(value & 0x20)
 	{
-		S32 offset = sObjectDataMap["ParentID"];
+		S32 offset = getObjectDataOffset("ParentID");
 		if(!(value & 0x80))
 		{
 			offset -= sizeof(LLVector3);
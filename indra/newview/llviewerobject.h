@@ -689,6 +689,9 @@ private:
 	U32				mFlags;
 
 	static std::map<std::string, U32> sObjectDataMap;
+	// Read only lookup into sObjectDataMap, so the unpack helpers can run
+	// off the main thread
+	static U32 getObjectDataOffset(const std::string& name);
 public:
 	// Sent to sim in UPDATE_FLAGS, received in ObjectPhysicsProperties
 	U8              mPhysicsShapeType;
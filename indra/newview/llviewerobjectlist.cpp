@@ -107,8 +107,8 @@ extern LLPipeline	gPipeline;
 
 // Statics for object lookup tables.
 U32						LLViewerObjectList::sSimulatorMachineIndex = 1; // Not zero deliberately, to speed up index check.
-std::map<U64, U32>		LLViewerObjectList::sIPAndPortToIndex;
-std::map<U64, LLUUID>	LLViewerObjectList::sIndexAndLocalIDToUUID;
+LLFlatHashMap<U64, U32>		LLViewerObjectList::sIPAndPortToIndex;
+LLFlatHashMap<U64, LLUUID>	LLViewerObjectList::sIndexAndLocalIDToUUID;
 
 LLViewerObjectList::LLViewerObjectList()
 {
@@ -156,7 +156,8 @@ void LLViewerObjectList::getUUIDFromLocal(LLUUID &id,
 
 	U64	indexid = (((U64)index) << 32) | (U64)local_id;
 
-	id = get_if_there(sIndexAndLocalIDToUUID, indexid, LLUUID::null);
+	const LLUUID* found = sIndexAndLocalIDToUUID.find(indexid);
+	id = found ? *found : LLUUID::null;
 }
 
 U64 LLViewerObjectList::getIndex(const U32 local_id,
@@ -189,16 +190,16 @@ bool LLViewerObjectList::removeFromLocalIDTable(const LLViewerObject* objectp)
 		
 		U64	indexid = (((U64)index) << 32) | (U64)local_id;
 		
-		std::map<U64, LLUUID>::iterator iter = sIndexAndLocalIDToUUID.find(indexid);
-		if (iter == sIndexAndLocalIDToUUID.end())
+		const LLUUID* found = sIndexAndLocalIDToUUID.find(indexid);
+		if (!found)
 		{
 			return false;
 		}
 		
 		// Found existing entry
-		if (iter->second == objectp->getID())
+		if (*found == objectp->getID())
 		{   // Full UUIDs match, so remove the entry
-			sIndexAndLocalIDToUUID.erase(iter);
+			sIndexAndLocalIDToUUID.erase(indexid);
 			return true;
 		}
 		// UUIDs did not match - this would zap a valid entry, so don't erase it
@@ -519,6 +520,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 	U8 compressed_dpbuffer[2048];
 	LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
 	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
+	static LLCachedControl<bool> decode_threaded(gSavedSettings, "ObjectUpdateDecodeThreaded", true);
 
 	for (i = 0; i < num_objects; i++)
 	{
@@ -561,7 +563,14 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 				else if ((flags & FLAGS_TEMPORARY_ON_REZ) == 0)
 				{
 					//send to object cache
-					regionp->cacheFullUpdate(compressed_dp, flags);
+					if (decode_threaded)
+					{
+						mUpdateQueue.add(region_handle, fullid, local_id, flags, compressed_dpbuffer, uncompressed_length);
+					}
+					else
+					{
+						regionp->cacheFullUpdate(compressed_dp, flags);
+					}
 					continue;
 				}
 			}
@@ -569,6 +578,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			{
 				update_cache = true;
 				compressed_dp.unpackU32(local_id, "LocalID");
+				flushObjectUpdates(local_id);
 				getUUIDFromLocal(fullid,
 								 local_id,
 								 gMessageSystem->getSenderIP(),
@@ -584,6 +594,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		{
 			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
 			msg_size += sizeof(U32);
+			flushObjectUpdates(local_id);
 
 			getUUIDFromLocal(fullid,
 							local_id,
@@ -608,6 +619,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			msg_size += sizeof(U32);
 			LL_DEBUGS("ObjectUpdate") << "Full Update, obj " << local_id << ", global ID " << fullid << " from " << mesgsys->getSender() << LL_ENDL;
 		}
+		// don't overtake a queued cacheable update for the same object
+		flushObjectUpdates(local_id);
 		objectp = findObject(fullid);
 
         if (compressed)
@@ -771,6 +784,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		objectp->setLastUpdateType(update_type);
 	}
 
+	mUpdateQueue.submit();
+
 	recorder.log(0.2f);
 
 	LLVOAvatar::cullAvatarsByPixelArea();
@@ -814,6 +829,9 @@ void LLViewerObjectList::processCachedObjectUpdate(LLMessageSystem *mesgsys,
 		mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
 		msg_size += sizeof(U32) * 2;
 
+		// the probe has to see the entry a queued update would create
+		flushObjectUpdates(id);
+
         LL_DEBUGS("ObjectUpdate") << "got probe for id " << id << " crc " << crc << LL_ENDL;
         dumpStack("ObjectUpdateStack");
 
@@ -945,6 +963,15 @@ void LLViewerObjectList::update(LLAgent &agent)
 
 	gAnimateTextures = gSavedSettings.getbool("AnimateTextures");
 
+	// apply object updates decoded on the thread pool, within a per frame budget
+	{
+		static LLCachedControl<F32> apply_budget(gSavedSettings, "ObjectUpdateApplyBudget", 2.f);
+		LLTimer apply_timer;
+		mUpdateQueue.apply(F32Milliseconds(apply_budget()));
+		sample(LLStatViewer::OBJECT_UPDATE_APPLY_TIME, apply_timer.getElapsedTimeF64());
+		sample(LLStatViewer::NUM_PENDING_OBJECT_UPDATES, mUpdateQueue.getPendingCount());
+	}
+
 	// update global timer
 	F32 last_time = gFrameTimeSeconds;
 	U64Microseconds time = totalTime();				 // this will become the new gFrameTime when the update is done
@@ -1494,6 +1521,8 @@ void LLViewerObjectList::killAllObjects()
 	// Used only on global destruction.
 	LLViewerObject *objectp;
 
+	mUpdateQueue.clear();
+
 	for (vobj_list_t::iterator iter = mObjects.begin(); iter != mObjects.end(); ++iter)
 	{
 		objectp = *iter;
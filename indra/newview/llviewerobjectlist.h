@@ -31,10 +31,12 @@
 #include <set>
 
 // common includes
+#include "llflathashmap.h"
 #include "llstring.h"
 #include "lltrace.h"
 
 // project includes
+#include "llobjectupdatequeue.h"
 #include "llviewerobject.h"
 #include "lleventcoro.h"
 #include "llcoros.h"
@@ -88,6 +90,8 @@ public:
 	void processObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type, bool compressed=false);
 	void processCompressedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
 	void processCachedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
+	// Applies queued cacheable updates for local_id, and everything queued before them
+	void flushObjectUpdates(U32 local_id) { mUpdateQueue.flushIfPending(local_id); }
 	void updateApparentAngles(LLAgent &agent);
 	void update(LLAgent &agent);
 
@@ -215,7 +219,7 @@ protected:
 
     uuid_set_t   mDeadObjects;
 
-	std::map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
+	LLFlatHashMap<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
 
 	//set of objects that need to update their cost
     uuid_set_t   mStaleObjectCost;
@@ -230,12 +234,15 @@ protected:
 	S32 mCurLazyUpdateIndex;
 
 	static U32 sSimulatorMachineIndex;
-	static std::map<U64, U32> sIPAndPortToIndex;
+	static LLFlatHashMap<U64, U32> sIPAndPortToIndex;
 
-	static std::map<U64, LLUUID> sIndexAndLocalIDToUUID;
+	static LLFlatHashMap<U64, LLUUID> sIndexAndLocalIDToUUID;
 
 	std::set<LLViewerObject *> mSelectPickList;
 
+	// cacheable full updates waiting to be decoded or applied
+	LLObjectUpdateQueue mUpdateQueue;
+
 	friend class LLViewerObject;
 
 private:
@@ -283,10 +290,10 @@ extern LLViewerObjectList gObjectList;
  */
 inline LLViewerObject *LLViewerObjectList::findObject(const LLUUID &id)
 {
-	std::map<LLUUID, LLPointer<LLViewerObject> >::iterator iter = mUUIDObjectMap.find(id);
-	if(iter != mUUIDObjectMap.end())
+	LLPointer<LLViewerObject>* objectp = mUUIDObjectMap.find(id);
+	if(objectp)
 	{
-		return iter->second;
+		return *objectp;
 	}
 	else
 	{
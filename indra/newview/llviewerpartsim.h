@@ -27,6 +27,7 @@
 #ifndef LL_LLVIEWERPARTSIM_H
 #define LL_LLVIEWERPARTSIM_H
 
+#include "llframeallocator.h"
 #include "llframetimer.h"
 #include "llpointer.h"
 #include "llpartdata.h"
@@ -49,6 +50,7 @@ typedef void (*LLVPCallback)(LLViewerPart &part, const F32 dt);
 
 class LLViewerPart : public LLPartData
 {
+	LL_POOL_NEW(LLViewerPart);
 public:
 	~LLViewerPart();
 public:
@@ -59,6 +59,7 @@
 #include "llstartup.h"
 #include "lltrans.h"
 #include "llurldispatcher.h"
+#include "llobjectupdatequeue.h"
 #include "llviewerobjectlist.h"
 #include "llviewerparceloverlay.h"
 #include "llviewerstatsrecorder.h"
@@ -2389,7 +2390,7 @@ void LLViewerRegion::findOrphans(U32 parent_id)
 	}
 }
 
-void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
+void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry, const LLObjectUpdateRecord* decoded)
 {
 	if(!sVOCacheCullingEnabled)
 	{
@@ -2426,7 +2427,11 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 
 		//set parent id
 		U32	parent_id = 0;
-        if (entry->getDP()) // NULL if nothing cached
+        if (decoded)
+        {
+            parent_id = decoded->mParentID;
+        }
+        else if (entry->getDP()) // NULL if nothing cached
         {
             LLViewerObject::unpackParentID(entry->getDP(), parent_id);
         }
@@ -2449,7 +2454,18 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 	LLQuaternion rot;
 
 	//decode spatial info and parent info
-	U32 parent_id = entry->getDP() ? LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot) : entry->getParentID();
+	U32 parent_id;
+	if (decoded)
+	{
+		pos = decoded->mPos;
+		scale = decoded->mScale;
+		rot = decoded->mRot;
+		parent_id = decoded->mParentID;
+	}
+	else
+	{
+		parent_id = entry->getDP() ? LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot) : entry->getParentID();
+	}
 	
 	U32 old_parent_id = entry->getParentID();
 	bool same_old_parent = false;
@@ -2558,14 +2574,22 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 	return ;
 }
 
-LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags)
+LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, const LLObjectUpdateRecord* decoded)
 {
 	eCacheUpdateResult result;
 	U32 crc;
 	U32 local_id;
 
-	LLViewerObject::unpackU32(&dp, local_id, "LocalID");
-	LLViewerObject::unpackU32(&dp, crc, "CRC");
+	if (decoded)
+	{
+		local_id = decoded->mLocalID;
+		crc = decoded->mCRC;
+	}
+	else
+	{
+		LLViewerObject::unpackU32(&dp, local_id, "LocalID");
+		LLViewerObject::unpackU32(&dp, crc, "CRC");
+	}
 
 	LLVOCacheEntry* entry = getCacheEntry(local_id, false);
 
@@ -2602,7 +2626,7 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerB
 
 // [SL:KB] - Patch: World-Derender | Checked: 2014-08-10 (Catznip-3.7)
 		if (fUpdateObj)
-			decodeBoundingInfo(entry);
+			decodeBoundingInfo(entry, decoded);
 // [/SL:KB]
 	}
 	else
@@ -2618,7 +2642,7 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerB
 		
 		mImpl->mCacheMap[local_id] = entry;
 		
-		decodeBoundingInfo(entry);
+		decodeBoundingInfo(entry, decoded);
 	}
 	entry->setUpdateFlags(flags);
 
@@ -71,6 +71,7 @@ class LLDrawable;
 class LLViewerRegionImpl;
 class LLViewerOctreeGroup;
 class LLVOCachePartition;
+struct LLObjectUpdateRecord;
 
 class LLViewerRegion: public LLCapabilityProvider // implements this interface
 {
@@ -348,8 +349,9 @@ public:
 		CACHE_UPDATE_REPLACED
 	} eCacheUpdateResult;
 
-	// handle a full update message
-	eCacheUpdateResult cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags);
+	// handle a full update message, decoded is the same update already
+	// unpacked by LLObjectUpdateQueue if there is one
+	eCacheUpdateResult cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, const LLObjectUpdateRecord* decoded = NULL);
 	eCacheUpdateResult cacheFullUpdate(LLViewerObject* objectp, LLDataPackerBinaryBuffer &dp, U32 flags);	
 	LLVOCacheEntry* getCacheEntryForOctree(U32 local_id);
 	LLVOCacheEntry* getCacheEntry(U32 local_id, bool valid = true);
@@ -451,7 +453,7 @@ private:
 	void updateVisibleEntries(F32 max_time); //update visible entries
 
 	void addCacheMiss(U32 id, LLViewerRegion::eCacheMissType miss_type);
-	void decodeBoundingInfo(LLVOCacheEntry* entry);
+	void decodeBoundingInfo(LLVOCacheEntry* entry, const LLObjectUpdateRecord* decoded = NULL);
 	bool isNonCacheableObjectCreated(U32 local_id);	
 
 public:
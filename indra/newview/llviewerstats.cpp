@@ -148,7 +148,8 @@ LLTrace::SampleStatHandle<>	FPS_SAMPLE("fpssample"),
 							SHADER_OBJECTS("shaderobjects", "Object Shaders"),
 							DRAW_DISTANCE("drawdistance", "Draw Distance"),
 							WINDOW_WIDTH("windowwidth", "Window width"),
-							WINDOW_HEIGHT("windowheight", "Window height");
+							WINDOW_HEIGHT("windowheight", "Window height"),
+							NUM_PENDING_OBJECT_UPDATES("numpendingobjectupdates", "Object updates decoded or being decoded, not yet applied");
 
 LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > 
 							PACKETS_LOST_PERCENT("packetslostpercentstat");
@@ -185,7 +186,8 @@ SimMeasurement<F64Megabytes >	SIM_PHYSICS_MEM("physicsmemoryallocated", "", LL_S
 LLTrace::SampleStatHandle<F64Milliseconds >	FRAMETIME_JITTER("frametimejitter", "Average delta between successive frame times"),
 											FRAMETIME_SLEW("frametimeslew", "Average delta between frame time and mean"),
 											FRAMETIME("frametime", "Measured frame time"),
-											SIM_PING("simpingstat");
+											SIM_PING("simpingstat"),
+											OBJECT_UPDATE_APPLY_TIME("objectupdateapplytime", "Time spent applying decoded object updates per frame");
 
 LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Meters> > AGENT_POSITION_SNAP("agentpositionsnap", "agent position corrections");
 
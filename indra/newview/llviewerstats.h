@@ -187,7 +187,8 @@ extern LLTrace::SampleStatHandle<>		FPS_SAMPLE,
 										SHADER_OBJECTS,
 										DRAW_DISTANCE,
 										WINDOW_WIDTH,
-										WINDOW_HEIGHT;
+										WINDOW_HEIGHT,
+										NUM_PENDING_OBJECT_UPDATES;
 
 extern LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > PACKETS_LOST_PERCENT;
 
@@ -218,7 +219,8 @@ extern SimMeasurement<F64Megabytes >	SIM_PHYSICS_MEM;
 
 extern LLTrace::SampleStatHandle<F64Milliseconds >	FRAMETIME_JITTER,
 													FRAMETIME_SLEW,
-													SIM_PING;
+													SIM_PING,
+													OBJECT_UPDATE_APPLY_TIME;
 
 extern LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Meters> > AGENT_POSITION_SNAP;
 
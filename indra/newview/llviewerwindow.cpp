@@ -775,7 +775,8 @@ public:
 
 			if (gMeshRepo.meshRezEnabled())
 			{
-				addText(xpos, ypos, llformat("%.3f MB Mesh Data Received", LLMeshRepository::sBytesReceived/(1024.f*1024.f)));
+				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Data Received/Copied", LLMeshRepository::sBytesReceived/(1024.f*1024.f),
+					LLMeshRepository::sBytesCopied/(1024.f*1024.f)));
 				
 				ypos += y_inc;
 				
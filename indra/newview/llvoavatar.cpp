@@ -9754,6 +9754,11 @@ const LLVOAvatar::MatrixPaletteCache& LLVOAvatar::updateSkinInfoMatrixPalette(co
         //build matrix palette
         U32 count = LLSkinningUtil::getMeshJointCount(skin);
         entry.mMatrixPalette.resize(count);
+        if (count == 0)
+        {
+            entry.mGLMp.clear();
+            return entry;
+        }
         LLSkinningUtil::initSkinningMatrixPalette(&(entry.mMatrixPalette[0]), count, skin, this);
 
         const LLMatrix4a* mat = &(entry.mMatrixPalette[0]);
@@ -4953,12 +4953,15 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
     }
 
 
-	//build matrix palette
-	static const size_t kMaxJoints = LL_MAX_JOINTS_PER_MESH_OBJECT;
-
-	LLMatrix4a mat[kMaxJoints];
+	//get matrix palette, shared with every other rigged volume and render
+	//batch of this avatar using the same skin for this frame
 	U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
-    LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
+	if (maxJoints == 0)
+	{
+		return;
+	}
+	const LLVOAvatar::MatrixPaletteCache& mpc = avatar->updateSkinInfoMatrixPalette(skin);
+	const LLMatrix4a* mat = mpc.mMatrixPalette.data();
     const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
 
     S32 rigged_vert_count = 0;
@@ -4997,7 +5000,8 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 
 			if (pos && dst_face.mExtents)
 			{
-                U32 max_joints = LLSkinningUtil::getMaxJointCount();
+                // the palette only holds the joints this skin uses
+                U32 max_joints = maxJoints;
                 rigged_vert_count += dst_face.mNumVertices;
                 rigged_face_count++;
 
@@ -6308,7 +6312,10 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 	LLFace** face_iter = faces;
 	LLFace** end_faces = faces+face_count;
 	
-	LLSpatialGroup::buffer_map_t buffer_map;
+	// vertex buffers made below, by the face that starts them, kept on the
+	// frame arena until they replace the group's buffer map at the end
+	typedef std::pair<LLFace*, LLPointer<LLVertexBuffer> > new_buffer_t;
+	std::vector<new_buffer_t, LLFrameAllocator<new_buffer_t> > new_buffers;
 
 	LLViewerTexture* last_tex = nullptr;
 
@@ -6506,7 +6513,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 		if (buffer)
 		{
 			geometryBytes += buffer->getSize() + buffer->getIndicesSize();
-			buffer_map[mask][*face_iter].push_back(buffer);
+			new_buffers.push_back(new_buffer_t(*face_iter, buffer));
 		}
 
 		//add face geometry
@@ -6863,10 +6870,11 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 		}
 	}
 
-	group->mBufferMap[mask].clear();
-	for (LLSpatialGroup::buffer_texture_map_t::iterator i = buffer_map[mask].begin(); i != buffer_map[mask].end(); ++i)
+	LLSpatialGroup::buffer_texture_map_t& buffer_map = group->mBufferMap[mask];
+	buffer_map.clear();
+	for (new_buffer_t& new_buffer : new_buffers)
 	{
-		group->mBufferMap[mask][i->first] = i->second;
+		buffer_map[new_buffer.first].push_back(std::move(new_buffer.second));
 	}
 
 	return geometryBytes;
@@ -33,6 +33,7 @@
 #include "llmessagetemplate.h"
 #include "llmath.h"
 #include "llquaternion.h"
+#include "lltimer.h"
 #include "lltemplatemessagebuilder.h"
 #include "lltemplatemessagereader.h"
 #include "message_prehash.h"
@@ -41,6 +42,8 @@
 #include "v3math.h"
 #include "v4math.h"
 
+#include <cstdlib>
+
 namespace tut
 {	
 	static LLTemplateMessageBuilder::message_template_name_map_t nameMap;
@@ -116,6 +119,50 @@ namespace tut
 			return reader;
 		}
 
+		static void ignoreMessage(LLMessageSystem*, void**)
+		{
+		}
+
+		// Template with a fixed size single block followed by a variable
+		// block with variable length data, like the object updates
+		static LLMessageTemplate* mixedTemplate()
+		{
+			defaultTemplate();
+			LLMessageTemplate* messageTemplate = new LLMessageTemplate(_PREHASH_TestMessage, 1, MFT_HIGH);
+			LLMessageBlock* single = new LLMessageBlock(_PREHASH_Test0, MBT_SINGLE);
+			single->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+			single->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_LLVector3, 12);
+			single->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_VARIABLE, 1);
+			messageTemplate->addBlock(single);
+			LLMessageBlock* repeated = new LLMessageBlock(_PREHASH_Test1, MBT_VARIABLE);
+			repeated->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U16, 2);
+			repeated->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_VARIABLE, 2);
+			repeated->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_LLUUID, 16);
+			messageTemplate->addBlock(repeated);
+			messageTemplate->setHandlerFunc(ignoreMessage, NULL);
+			return messageTemplate;
+		}
+
+		static U32 buildMixedMessage(LLMessageTemplate& messageTemplate, U8* buffer, U32 bufferSize)
+		{
+			nameMap[_PREHASH_TestMessage] = &messageTemplate;
+			LLTemplateMessageBuilder builder(nameMap);
+			builder.newMessage(_PREHASH_TestMessage);
+			builder.nextBlock(_PREHASH_Test0);
+			builder.addU32(_PREHASH_Test0, 0xdeadbeef);
+			builder.addVector3(_PREHASH_Test1, LLVector3(1.f, 2.f, 3.f));
+			builder.addString(_PREHASH_Test2, "name");
+			for (U16 i = 0; i < 3; ++i)
+			{
+				U8 data[5] = { 1, 2, 3, 4, (U8)i };
+				builder.nextBlock(_PREHASH_Test1);
+				builder.addU16(_PREHASH_Test0, i + 100);
+				builder.addBinaryData(_PREHASH_Test1, data, 4 + i);
+				builder.addUUID(_PREHASH_Test2, LLUUID("6e8c5a8e-6b4d-4d8b-9c69-2e0b3c2ba0d7"));
+			}
+			memset(buffer, 0, LL_PACKET_ID_SIZE);
+			return builder.buildMessage(buffer, bufferSize, 0);
+		}
 	};
 	
 	typedef test_group<LLTemplateMessageBuilderTestData>	LLTemplateMessageBuilderTestGroup;
@@ -967,5 +1014,264 @@ namespace tut
 		ensure_equals("Ensure unchanged buffer ", strlen(outBuffer), 0);
 		delete reader;
 	}
-}
 
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<46>()
+		// in place decode reads the same values as copying decode
+	{
+		LLMessageTemplate* messageTemplate = mixedTemplate();
+		numberMap[1] = messageTemplate;
+		U8 buffer[1024];
+		U32 builtSize = buildMixedMessage(*messageTemplate, buffer, sizeof(buffer));
+
+		LLTemplateMessageReader copying(numberMap);
+		LLTemplateMessageReader in_place(numberMap);
+		in_place.setDecodeInPlace(true);
+		LLTemplateMessageReader* readers[] = { &copying, &in_place };
+		for (LLTemplateMessageReader* reader : readers)
+		{
+			reader->validateMessage(buffer, builtSize, LLHost());
+			ensure("read", reader->readMessage(buffer, LLHost()));
+		}
+
+		U32 u32[2];
+		LLVector3 vec[2];
+		std::string str[2];
+		for (S32 r = 0; r < 2; ++r)
+		{
+			readers[r]->getU32(_PREHASH_Test0, _PREHASH_Test0, u32[r]);
+			readers[r]->getVector3(_PREHASH_Test0, _PREHASH_Test1, vec[r]);
+			readers[r]->getString(_PREHASH_Test0, _PREHASH_Test2, str[r]);
+		}
+		ensure_equals("U32", u32[1], u32[0]);
+		ensure_equals("U32 value", u32[1], (U32)0xdeadbeef);
+		ensure_equals("Vector3", vec[1], vec[0]);
+		ensure_equals("string", str[1], str[0]);
+		ensure_equals("string size", in_place.getSize(_PREHASH_Test0, _PREHASH_Test2),
+					  copying.getSize(_PREHASH_Test0, _PREHASH_Test2));
+
+		ensure_equals("block count", in_place.getNumberOfBlocks(_PREHASH_Test1), 3);
+		ensure_equals("missing block", in_place.getNumberOfBlocks(_PREHASH_Test2), 0);
+		ensure_equals("missing variable", in_place.getSize(_PREHASH_Test1, 0, _PREHASH_TestBlock1), LL_VARIABLE_NOT_IN_BLOCK);
+		for (S32 i = 0; i < 3; ++i)
+		{
+			U16 u16[2];
+			U8 data[2][8];
+			LLUUID id[2];
+			for (S32 r = 0; r < 2; ++r)
+			{
+				// ask in reverse template order to exercise the lookup
+				readers[r]->getUUID(_PREHASH_Test1, _PREHASH_Test2, id[r], i);
+				readers[r]->getBinaryData(_PREHASH_Test1, _PREHASH_Test1, data[r], 0, i, sizeof(data[r]));
+				readers[r]->getU16(_PREHASH_Test1, _PREHASH_Test0, u16[r], i);
+			}
+			ensure_equals("U16", u16[1], u16[0]);
+			ensure_equals("UUID", id[1], id[0]);
+			S32 size = in_place.getSize(_PREHASH_Test1, i, _PREHASH_Test1);
+			ensure_equals("binary size", size, copying.getSize(_PREHASH_Test1, i, _PREHASH_Test1));
+			ensure_equals("binary size value", size, 4 + i);
+			ensure("binary data", memcmp(data[0], data[1], size) == 0);
+		}
+
+		// forwarding rebuilds the same packet
+		U8 copied[2][1024];
+		U32 copiedSize[2];
+		for (S32 r = 0; r < 2; ++r)
+		{
+			LLTemplateMessageBuilder builder(nameMap);
+			builder.newMessage(_PREHASH_TestMessage);
+			readers[r]->copyToBuilder(builder);
+			memset(copied[r], 0, LL_PACKET_ID_SIZE);
+			copiedSize[r] = builder.buildMessage(copied[r], sizeof(copied[r]), 0);
+		}
+		ensure_equals("copied size", copiedSize[1], copiedSize[0]);
+		ensure("copied data", memcmp(copied[0], copied[1], copiedSize[0]) == 0);
+
+		copying.clearMessage();
+		in_place.clearMessage();
+		numberMap.erase(1);
+		delete messageTemplate;
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<47>()
+		// in place decode of fixed variables past the end of the message
+	{
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		U32 inValue = 0xbbbbbbbb;
+		LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+		builder->addU32(_PREHASH_Test0, inValue);
+		U8 buffer[1024];
+		memset(buffer, 0xaa, sizeof(buffer));
+		memset(buffer, 0, LL_PACKET_ID_SIZE);
+		U32 builtSize = builder->buildMessage(buffer, sizeof(buffer), 0);
+		delete builder;
+
+		messageTemplate.addBlock(createBlock(const_cast<char*>(_PREHASH_Test1), MVT_U32, 4, MBT_SINGLE));
+
+		numberMap[1] = &messageTemplate;
+		LLTemplateMessageReader reader(numberMap);
+		reader.setDecodeInPlace(true);
+		reader.validateMessage(buffer, builtSize, LLHost());
+		reader.readMessage(buffer, LLHost());
+		U32 outValue = 0, outValue2 = 1;
+		reader.getU32(_PREHASH_Test0, _PREHASH_Test0, outValue);
+		reader.getU32(_PREHASH_Test1, _PREHASH_Test0, outValue2);
+		ensure_equals("Ensure present value ", outValue, inValue);
+		ensure_equals("Ensure default value ", outValue2, (U32)0);
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<48>()
+		// decode benchmark for the busiest message layouts
+	{
+		if (!getenv("LL_MESSAGE_DECODE_BENCHMARK"))
+		{
+			skip("set LL_MESSAGE_DECODE_BENCHMARK to run the decode benchmark");
+		}
+		defaultTemplate();
+
+		const S32 ITERATIONS = 100000;
+		U8 buffer[MAX_BUFFER_SIZE];
+
+		// AgentUpdate: one block, all fixed size
+		LLMessageTemplate agentUpdate(_PREHASH_AgentUpdate, 4, MFT_HIGH);
+		{
+			LLMessageBlock* block = new LLMessageBlock(_PREHASH_AgentData, MBT_SINGLE);
+			block->addVariable(const_cast<char*>(_PREHASH_AgentID), MVT_LLUUID, 16);
+			block->addVariable(const_cast<char*>(_PREHASH_SessionID), MVT_LLUUID, 16);
+			block->addVariable(const_cast<char*>(_PREHASH_BodyRotation), MVT_LLQuaternion, 12);
+			block->addVariable(const_cast<char*>(_PREHASH_HeadRotation), MVT_LLQuaternion, 12);
+			block->addVariable(const_cast<char*>(_PREHASH_State), MVT_U8, 1);
+			block->addVariable(const_cast<char*>(_PREHASH_CameraCenter), MVT_LLVector3, 12);
+			block->addVariable(const_cast<char*>(_PREHASH_Far), MVT_F32, 4);
+			block->addVariable(const_cast<char*>(_PREHASH_ControlFlags), MVT_U32, 4);
+			block->addVariable(const_cast<char*>(_PREHASH_Flags), MVT_U8, 1);
+			agentUpdate.addBlock(block);
+		}
+
+		// ImprovedTerseObjectUpdate: region header plus repeated variable data
+		LLMessageTemplate terseUpdate(_PREHASH_ImprovedTerseObjectUpdate, 15, MFT_HIGH);
+		{
+			LLMessageBlock* region = new LLMessageBlock(_PREHASH_RegionData, MBT_SINGLE);
+			region->addVariable(const_cast<char*>(_PREHASH_RegionHandle), MVT_U64, 8);
+			region->addVariable(const_cast<char*>(_PREHASH_TimeDilation), MVT_U16, 2);
+			terseUpdate.addBlock(region);
+			LLMessageBlock* objects = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+			objects->addVariable(const_cast<char*>(_PREHASH_Data), MVT_VARIABLE, 1);
+			objects->addVariable(const_cast<char*>(_PREHASH_TextureEntry), MVT_VARIABLE, 2);
+			terseUpdate.addBlock(objects);
+		}
+
+		// ObjectUpdate: region header plus repeated fixed and variable data
+		LLMessageTemplate objectUpdate(_PREHASH_ObjectUpdate, 12, MFT_HIGH);
+		{
+			LLMessageBlock* region = new LLMessageBlock(_PREHASH_RegionData, MBT_SINGLE);
+			region->addVariable(const_cast<char*>(_PREHASH_RegionHandle), MVT_U64, 8);
+			region->addVariable(const_cast<char*>(_PREHASH_TimeDilation), MVT_U16, 2);
+			objectUpdate.addBlock(region);
+			LLMessageBlock* objects = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+			objects->addVariable(const_cast<char*>(_PREHASH_ID), MVT_U32, 4);
+			objects->addVariable(const_cast<char*>(_PREHASH_State), MVT_U8, 1);
+			objects->addVariable(const_cast<char*>(_PREHASH_FullID), MVT_LLUUID, 16);
+			objects->addVariable(const_cast<char*>(_PREHASH_CRC), MVT_U32, 4);
+			objects->addVariable(const_cast<char*>(_PREHASH_PCode), MVT_U8, 1);
+			objects->addVariable(const_cast<char*>(_PREHASH_Scale), MVT_LLVector3, 12);
+			objects->addVariable(const_cast<char*>(_PREHASH_Data), MVT_VARIABLE, 1);
+			objects->addVariable(const_cast<char*>(_PREHASH_TextureEntry), MVT_VARIABLE, 2);
+			objects->addVariable(const_cast<char*>(_PREHASH_NameValue), MVT_VARIABLE, 2);
+			objectUpdate.addBlock(objects);
+		}
+
+		LLMessageTemplate* templates[] = { &agentUpdate, &terseUpdate, &objectUpdate };
+		for (LLMessageTemplate* messageTemplate : templates)
+		{
+			messageTemplate->setHandlerFunc(ignoreMessage, NULL);
+			nameMap[messageTemplate->mName] = messageTemplate;
+			numberMap[messageTemplate->mMessageNumber] = messageTemplate;
+
+			LLTemplateMessageBuilder builder(nameMap);
+			builder.newMessage(messageTemplate->mName);
+			U8 data[64];
+			memset(data, 0x42, sizeof(data));
+			if (messageTemplate == &agentUpdate)
+			{
+				builder.nextBlock(_PREHASH_AgentData);
+				builder.addUUID(_PREHASH_AgentID, LLUUID::null);
+				builder.addUUID(_PREHASH_SessionID, LLUUID::null);
+				builder.addQuat(_PREHASH_BodyRotation, LLQuaternion());
+				builder.addQuat(_PREHASH_HeadRotation, LLQuaternion());
+				builder.addU8(_PREHASH_State, 0);
+				builder.addVector3(_PREHASH_CameraCenter, LLVector3(128.f, 128.f, 20.f));
+				builder.addF32(_PREHASH_Far, 128.f);
+				builder.addU32(_PREHASH_ControlFlags, 0);
+				builder.addU8(_PREHASH_Flags, 0);
+			}
+			else
+			{
+				builder.nextBlock(_PREHASH_RegionData);
+				builder.addU64(_PREHASH_RegionHandle, 0);
+				builder.addU16(_PREHASH_TimeDilation, 65535);
+				for (S32 i = 0; i < 8; ++i)
+				{
+					builder.nextBlock(_PREHASH_ObjectData);
+					if (messageTemplate == &objectUpdate)
+					{
+						builder.addU32(_PREHASH_ID, i);
+						builder.addU8(_PREHASH_State, 0);
+						builder.addUUID(_PREHASH_FullID, LLUUID::null);
+						builder.addU32(_PREHASH_CRC, 0);
+						builder.addU8(_PREHASH_PCode, 9);
+						builder.addVector3(_PREHASH_Scale, LLVector3(1.f, 1.f, 1.f));
+					}
+					builder.addBinaryData(_PREHASH_Data, data, 60);
+					builder.addBinaryData(_PREHASH_TextureEntry, data, 40);
+					if (messageTemplate == &objectUpdate)
+					{
+						builder.addString(_PREHASH_NameValue, "");
+					}
+				}
+			}
+			memset(buffer, 0, LL_PACKET_ID_SIZE);
+			U32 builtSize = builder.buildMessage(buffer, sizeof(buffer), 0);
+
+			F64 seconds[2];
+			for (S32 in_place = 0; in_place < 2; ++in_place)
+			{
+				LLTemplateMessageReader reader(numberMap);
+				reader.setDecodeInPlace(in_place);
+				LLTimer timer;
+				for (S32 n = 0; n < ITERATIONS; ++n)
+				{
+					reader.validateMessage(buffer, builtSize, LLHost());
+					reader.readMessage(buffer, LLHost());
+					// read every variable the way the handlers do
+					for (LLMessageTemplate::message_block_map_t::const_iterator block_iter = messageTemplate->mMemberBlocks.begin();
+						 block_iter != messageTemplate->mMemberBlocks.end(); ++block_iter)
+					{
+						const LLMessageBlock* block = *block_iter;
+						S32 count = reader.getNumberOfBlocks(block->mName);
+						for (S32 i = 0; i < count; ++i)
+						{
+							for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = block->mMemberVariables.begin();
+								 var_iter != block->mMemberVariables.end(); ++var_iter)
+							{
+								reader.getBinaryData(block->mName, (*var_iter)->getName(), data, 0, i, sizeof(data));
+							}
+						}
+					}
+					reader.clearMessage();
+				}
+				seconds[in_place] = timer.getElapsedTimeF64();
+			}
+
+			std::cout << "\n" << messageTemplate->mName << " (" << builtSize << " bytes): "
+					  << "copy " << seconds[0] * 1e9 / ITERATIONS << " ns, "
+					  << "in place " << seconds[1] * 1e9 / ITERATIONS << " ns per message" << std::endl;
+
+			numberMap.erase(messageTemplate->mMessageNumber);
+			nameMap.erase(messageTemplate->mName);
+		}
+	}
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""\
+@file   lltrace_conv.py
+@brief  Convert a binary trace event log (viewer.lltrace, written by
+        the Viewer when run with --traceevents) into Chrome trace
+        event JSON for chrome://tracing or https://ui.perfetto.dev
+
+$LicenseInfo:firstyear=2024&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2024, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+# The stream format is described in indra/llcommon/lltraceeventlog.cpp.
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"LLTRACE\0"
+VERSION = 1
+
+BLOCK_BEGIN, BLOCK_END, COUNT, SAMPLE, EVENT = range(1, 6)
+VALUE_TYPES = (COUNT, SAMPLE, EVENT)
+
+
+class Truncated(Exception):
+    pass
+
+
+class Reader(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def at_end(self):
+        return self.pos >= len(self.data)
+
+    def bytes(self, count):
+        if self.pos + count > len(self.data):
+            raise Truncated()
+        value = self.data[self.pos:self.pos + count]
+        self.pos += count
+        return value
+
+    def u8(self):
+        return self.bytes(1)[0]
+
+    def u32(self):
+        return struct.unpack("<I", self.bytes(4))[0]
+
+    def u64(self):
+        return struct.unpack("<Q", self.bytes(8))[0]
+
+    def f64(self):
+        return struct.unpack("<d", self.bytes(8))[0]
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.u8()
+            value |= (byte & 0x7f) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+
+    def zigzag(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def string(self):
+        return self.bytes(self.varint()).decode("utf-8", "replace")
+
+
+class Converter(object):
+    """Writes trace events as they're read so multi-minute captures
+    don't have to fit in memory as JSON objects."""
+
+    def __init__(self, out, pid):
+        self.out = out
+        self.pid = pid
+        self.first = True
+        self.names = {}
+        self.units = {}
+        self.stacks = {}        # thread -> open block names
+        self.last_ts = {}       # thread -> last timestamp, us
+        self.totals = {}        # count stat name -> running total
+        self.base = None
+        self.dropped = 0
+        self.events = 0
+
+    def emit(self, event):
+        self.out.write("\n" if self.first else ",\n")
+        self.first = False
+        json.dump(event, self.out, separators=(",", ":"))
+
+    def thread(self, tid, name):
+        self.emit(dict(ph="M", name="thread_name", pid=self.pid, tid=tid,
+                       args=dict(name=name)))
+
+    def counter(self, tid, ts, name, value):
+        label = name
+        if self.units.get(name):
+            label = "%s (%s)" % (name, self.units[name])
+        self.emit(dict(ph="C", name=label, pid=self.pid, tid=tid, ts=ts,
+                       args=dict(value=value)))
+
+    def event(self, tid, kind, name, ts, value):
+        self.events += 1
+        self.last_ts[tid] = ts
+        stack = self.stacks.setdefault(tid, [])
+        if kind == BLOCK_BEGIN:
+            stack.append(name)
+            self.emit(dict(ph="B", name=name, pid=self.pid, tid=tid, ts=ts))
+        elif kind == BLOCK_END:
+            # blocks entered before recording started end without a begin
+            if stack and stack[-1] == name:
+                stack.pop()
+                self.emit(dict(ph="E", pid=self.pid, tid=tid, ts=ts))
+        elif kind == COUNT:
+            total = self.totals.get(name, 0.0) + value
+            self.totals[name] = total
+            self.counter(tid, ts, name, total)
+        elif kind in (SAMPLE, EVENT):
+            self.counter(tid, ts, name, value)
+
+    def finish(self):
+        # close blocks still open when the capture ended
+        for tid, stack in self.stacks.items():
+            while stack:
+                stack.pop()
+                self.emit(dict(ph="E", pid=self.pid, tid=tid, ts=self.last_ts[tid]))
+
+    def convert(self, reader):
+        if reader.bytes(len(MAGIC)) != MAGIC:
+            raise ValueError("not a trace event log")
+        version = reader.u32()
+        if version != VERSION:
+            raise ValueError("unsupported version %d" % version)
+        ticks_per_us = reader.u64() / 1e6
+
+        while not reader.at_end():
+            start = reader.pos
+            try:
+                self.record(reader, ticks_per_us)
+            except Truncated:
+                sys.stderr.write("Truncated record at offset %d, stopping\n" % start)
+                break
+        self.finish()
+
+    def record(self, reader, ticks_per_us):
+        tag = chr(reader.u8())
+        if tag == "T":
+            tid = reader.varint()
+            self.thread(tid, reader.string())
+        elif tag == "N":
+            id = reader.varint()
+            reader.u8()     # type of first use
+            self.names[id] = reader.string()
+            self.units[self.names[id]] = reader.string()
+        elif tag == "E":
+            tid = reader.varint()
+            count = reader.varint()
+            # read the whole record before emitting anything from it
+            events = []
+            time = 0
+            for i in range(count):
+                kind = reader.u8()
+                name = self.names.get(reader.varint(), "?")
+                time += reader.zigzag()
+                value = reader.f64() if kind in VALUE_TYPES else None
+                events.append((kind, name, time, value))
+            for kind, name, time, value in events:
+                if self.base is None:
+                    self.base = time
+                self.event(tid, kind, name, (time - self.base) / ticks_per_us, value)
+        elif tag == "D":
+            tid = reader.varint()
+            count = reader.varint()
+            self.dropped += count
+            if tid in self.last_ts:
+                self.emit(dict(ph="i", s="t", name="%d events dropped" % count,
+                               pid=self.pid, tid=tid, ts=self.last_ts[tid]))
+        else:
+            raise ValueError("unknown record '%s' at offset %d" % (tag, reader.pos - 1))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Converts Viewer trace event logs (.lltrace) into Chrome "
+                    "trace JSON for chrome://tracing or Perfetto."
+    )
+    parser.add_argument("infilename", help="Name of .lltrace file to read")
+    parser.add_argument("outfilename", help="Name of JSON file to create")
+    parser.add_argument("--pid", type=int, default=1,
+                        help="Process id to put in the trace (default 1)")
+    args = parser.parse_args()
+
+    with open(args.infilename, "rb") as infile:
+        reader = Reader(infile.read())
+    print("Reading from %s - %d bytes" % (args.infilename, len(reader.data)))
+
+    with open(args.outfilename, "w") as outfile:
+        print("Writing to %s" % args.outfilename)
+        outfile.write('{"displayTimeUnit":"ms","traceEvents":[')
+        converter = Converter(outfile, args.pid)
+        converter.convert(reader)
+        outfile.write('\n],"otherData":%s}\n'
+                      % json.dumps(dict(events=converter.events, dropped=converter.dropped)))
+
+    print("%d events, %d dropped while recording" % (converter.events, converter.dropped))
+
+
+if __name__ == "__main__":
+    main()